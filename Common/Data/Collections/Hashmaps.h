@@ -270,7 +270,7 @@ class PrehashMap {
 		return false;
 	}
 
-	size_t size() {
+	size_t size() const {
 		return count_;
 	}
 
@@ -24,6 +24,7 @@
 #ifdef _M_SSE
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 #if PPSSPP_ARCH(ARM_NEON)
@@ -212,15 +213,100 @@ void ConvertRGBA8888ToRGB888(u8 *dst, const u32 *src, u32 numPixels) {
 	}
 }
 
+#if defined(_M_SSE)
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline void StoreRGBA8888_AVX2(u32 *dst, __m256i rg, __m256i ba) {
+	// The source was loaded with qwords in 0 2 1 3 order, so these come out in order.
+	_mm256_storeu_si256((__m256i *)dst, _mm256_unpacklo_epi16(rg, ba));
+	_mm256_storeu_si256((__m256i *)(dst + 8), _mm256_unpackhi_epi16(rg, ba));
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static u32 ConvertRGB565ToRGBA8888_AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001f);
+	const __m256i mask6 = _mm256_set1_epi16(0x003f);
+	const __m256i mask8 = _mm256_set1_epi16(0x00ff);
+	const __m256i a = _mm256_slli_epi16(mask8, 8);
+
+	const u32 simdable = numPixels & ~15;
+	for (u32 i = 0; i < simdable; i += 16) {
+		const __m256i c = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i *)(src + i)), _MM_SHUFFLE(3, 1, 2, 0));
+
+		__m256i r = _mm256_and_si256(c, mask5);
+		r = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2)), mask8);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask6);
+		g = _mm256_slli_epi16(_mm256_or_si256(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(g, 4)), 8);
+		__m256i b = _mm256_srli_epi16(c, 11);
+		b = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2)), mask8);
+
+		StoreRGBA8888_AVX2(dst32 + i, _mm256_or_si256(r, g), _mm256_or_si256(b, a));
+	}
+	return simdable;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static u32 ConvertRGBA5551ToRGBA8888_AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask5 = _mm256_set1_epi16(0x001f);
+	const __m256i mask8 = _mm256_set1_epi16(0x00ff);
+
+	const u32 simdable = numPixels & ~15;
+	for (u32 i = 0; i < simdable; i += 16) {
+		const __m256i c = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i *)(src + i)), _MM_SHUFFLE(3, 1, 2, 0));
+
+		__m256i r = _mm256_and_si256(c, mask5);
+		r = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(r, 3), _mm256_srli_epi16(r, 2)), mask8);
+		__m256i g = _mm256_and_si256(_mm256_srli_epi16(c, 5), mask5);
+		g = _mm256_slli_epi16(_mm256_or_si256(_mm256_slli_epi16(g, 3), _mm256_srli_epi16(g, 2)), 8);
+		__m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 10), mask5);
+		b = _mm256_and_si256(_mm256_or_si256(_mm256_slli_epi16(b, 3), _mm256_srli_epi16(b, 2)), mask8);
+		const __m256i a = _mm256_slli_epi16(_mm256_srai_epi16(c, 15), 8);
+
+		StoreRGBA8888_AVX2(dst32 + i, _mm256_or_si256(r, g), _mm256_or_si256(b, a));
+	}
+	return simdable;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static u32 ConvertRGBA4444ToRGBA8888_AVX2(u32 *dst32, const u16 *src, u32 numPixels) {
+	const __m256i mask4 = _mm256_set1_epi16(0x000f);
+
+	const u32 simdable = numPixels & ~15;
+	for (u32 i = 0; i < simdable; i += 16) {
+		const __m256i c = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i *)(src + i)), _MM_SHUFFLE(3, 1, 2, 0));
+
+		const __m256i r = _mm256_and_si256(c, mask4);
+		const __m256i g = _mm256_slli_epi16(_mm256_and_si256(_mm256_srli_epi16(c, 4), mask4), 8);
+		const __m256i b = _mm256_and_si256(_mm256_srli_epi16(c, 8), mask4);
+		const __m256i a = _mm256_slli_epi16(_mm256_srli_epi16(c, 12), 8);
+
+		__m256i rg = _mm256_or_si256(r, g);
+		__m256i ba = _mm256_or_si256(b, a);
+		rg = _mm256_or_si256(rg, _mm256_slli_epi16(rg, 4));
+		ba = _mm256_or_si256(ba, _mm256_slli_epi16(ba, 4));
+		StoreRGBA8888_AVX2(dst32 + i, rg, ba);
+	}
+	return simdable;
+}
+#endif
+
 void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
+	const u32 avx2Pixels = cpu_info.bAVX2 ? ConvertRGB565ToRGBA8888_AVX2(dst32, src, numPixels) : 0;
 	const __m128i mask5 = _mm_set1_epi16(0x001f);
 	const __m128i mask6 = _mm_set1_epi16(0x003f);
 	const __m128i mask8 = _mm_set1_epi16(0x00ff);
 
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
+	const __m128i *srcp = (const __m128i *)(src + avx2Pixels);
+	__m128i *dstp = (__m128i *)(dst32 + avx2Pixels);
+	u32 sseChunks = (numPixels - avx2Pixels) / 8;
 	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
 		sseChunks = 0;
 	}
@@ -251,7 +337,26 @@ void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
-	u32 i = sseChunks * 8;
+	u32 i = avx2Pixels + sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint8x8_t mask5 = vdup_n_u8(0x1f);
+	const uint8x8_t mask6 = vdup_n_u8(0x3f);
+	u32 simdable = (numPixels / 8) * 8;
+	for (u32 x = 0; x < simdable; x += 8) {
+		const uint16x8_t c = vld1q_u16(src + x);
+		const uint8x8_t r = vand_u8(vmovn_u16(c), mask5);
+		const uint8x8_t g = vand_u8(vshrn_n_u16(c, 5), mask6);
+		const uint8x8_t b = vmovn_u16(vshrq_n_u16(c, 11));
+
+		// Interleaving on store gives us RGBA.
+		uint8x8x4_t rgba;
+		rgba.val[0] = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+		rgba.val[1] = vorr_u8(vshl_n_u8(g, 2), vshr_n_u8(g, 4));
+		rgba.val[2] = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+		rgba.val[3] = vdup_n_u8(0xff);
+		vst4_u8((u8 *)(dst32 + x), rgba);
+	}
+	u32 i = simdable;
 #else
 	u32 i = 0;
 #endif
@@ -268,12 +373,13 @@ void ConvertRGB565ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 
 void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
+	const u32 avx2Pixels = cpu_info.bAVX2 ? ConvertRGBA5551ToRGBA8888_AVX2(dst32, src, numPixels) : 0;
 	const __m128i mask5 = _mm_set1_epi16(0x001f);
 	const __m128i mask8 = _mm_set1_epi16(0x00ff);
 
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
+	const __m128i *srcp = (const __m128i *)(src + avx2Pixels);
+	__m128i *dstp = (__m128i *)(dst32 + avx2Pixels);
+	u32 sseChunks = (numPixels - avx2Pixels) / 8;
 	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
 		sseChunks = 0;
 	}
@@ -305,7 +411,25 @@ void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
-	u32 i = sseChunks * 8;
+	u32 i = avx2Pixels + sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint8x8_t mask5 = vdup_n_u8(0x1f);
+	u32 simdable = (numPixels / 8) * 8;
+	for (u32 x = 0; x < simdable; x += 8) {
+		const uint16x8_t c = vld1q_u16(src + x);
+		const uint8x8_t r = vand_u8(vmovn_u16(c), mask5);
+		const uint8x8_t g = vand_u8(vshrn_n_u16(c, 5), mask5);
+		const uint8x8_t b = vand_u8(vmovn_u16(vshrq_n_u16(c, 10)), mask5);
+
+		// Interleaving on store gives us RGBA.
+		uint8x8x4_t rgba;
+		rgba.val[0] = vorr_u8(vshl_n_u8(r, 3), vshr_n_u8(r, 2));
+		rgba.val[1] = vorr_u8(vshl_n_u8(g, 3), vshr_n_u8(g, 2));
+		rgba.val[2] = vorr_u8(vshl_n_u8(b, 3), vshr_n_u8(b, 2));
+		rgba.val[3] = vmovn_u16(vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(c), 15)));
+		vst4_u8((u8 *)(dst32 + x), rgba);
+	}
+	u32 i = simdable;
 #else
 	u32 i = 0;
 #endif
@@ -322,11 +446,12 @@ void ConvertRGBA5551ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 
 void ConvertRGBA4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 #ifdef _M_SSE
+	const u32 avx2Pixels = cpu_info.bAVX2 ? ConvertRGBA4444ToRGBA8888_AVX2(dst32, src, numPixels) : 0;
 	const __m128i mask4 = _mm_set1_epi16(0x000f);
 
-	const __m128i *srcp = (const __m128i *)src;
-	__m128i *dstp = (__m128i *)dst32;
-	u32 sseChunks = numPixels / 8;
+	const __m128i *srcp = (const __m128i *)(src + avx2Pixels);
+	__m128i *dstp = (__m128i *)(dst32 + avx2Pixels);
+	u32 sseChunks = (numPixels - avx2Pixels) / 8;
 	if (((intptr_t)src & 0xF) || ((intptr_t)dst32 & 0xF)) {
 		sseChunks = 0;
 	}
@@ -354,7 +479,26 @@ void ConvertRGBA4444ToRGBA8888(u32 *dst32, const u16 *src, u32 numPixels) {
 		_mm_store_si128(&dstp[i * 2 + 0], _mm_unpacklo_epi16(rg, ba));
 		_mm_store_si128(&dstp[i * 2 + 1], _mm_unpackhi_epi16(rg, ba));
 	}
-	u32 i = sseChunks * 8;
+	u32 i = avx2Pixels + sseChunks * 8;
+#elif PPSSPP_ARCH(ARM_NEON)
+	const uint8x8_t mask4 = vdup_n_u8(0x0f);
+	u32 simdable = (numPixels / 8) * 8;
+	for (u32 x = 0; x < simdable; x += 8) {
+		const uint16x8_t c = vld1q_u16(src + x);
+		const uint8x8_t r = vand_u8(vmovn_u16(c), mask4);
+		const uint8x8_t g = vand_u8(vshrn_n_u16(c, 4), mask4);
+		const uint8x8_t b = vand_u8(vshrn_n_u16(c, 8), mask4);
+		const uint8x8_t a = vmovn_u16(vshrq_n_u16(c, 12));
+
+		// Interleaving on store gives us RGBA.
+		uint8x8x4_t rgba;
+		rgba.val[0] = vorr_u8(r, vshl_n_u8(r, 4));
+		rgba.val[1] = vorr_u8(g, vshl_n_u8(g, 4));
+		rgba.val[2] = vorr_u8(b, vshl_n_u8(b, 4));
+		rgba.val[3] = vorr_u8(a, vshl_n_u8(a, 4));
+		vst4_u8((u8 *)(dst32 + x), rgba);
+	}
+	u32 i = simdable;
 #else
 	u32 i = 0;
 #endif
@@ -0,0 +1,105 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#if PPSSPP_PLATFORM(WINDOWS)
+#include "Common/CommonWindows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+
+#include "Common/File/MappedFile.h"
+#include "Common/Log.h"
+
+bool MappedFile::Open(const Path &filename) {
+	Close();
+	if (filename.Type() != PathType::NATIVE)
+		return false;
+
+#if PPSSPP_PLATFORM(UWP)
+	// Would need the FromApp variants, and broker access.  Just read the file normally.
+	return false;
+#elif PPSSPP_PLATFORM(WINDOWS)
+	HANDLE file = CreateFileW(filename.ToWString().c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size{};
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > SIZE_MAX) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!mapping)
+		return false;
+
+	// The view keeps the mapping alive.
+	void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!view) {
+		WARN_LOG(COMMON, "Unable to map %s: %08x", filename.c_str(), (uint32_t)GetLastError());
+		return false;
+	}
+
+	data_ = (const uint8_t *)view;
+	size_ = (size_t)size.QuadPart;
+	return true;
+#else
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) {
+		close(fd);
+		return false;
+	}
+
+	// The mapping stays valid after closing the descriptor.
+	void *view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED) {
+		WARN_LOG(COMMON, "Unable to map %s", filename.c_str());
+		return false;
+	}
+
+	data_ = (const uint8_t *)view;
+	size_ = (size_t)st.st_size;
+	return true;
+#endif
+}
+
+void MappedFile::Close() {
+	if (!data_)
+		return;
+
+#if PPSSPP_PLATFORM(WINDOWS)
+	UnmapViewOfFile(data_);
+#else
+	munmap((void *)data_, size_);
+#endif
+	data_ = nullptr;
+	size_ = 0;
+}
@@ -0,0 +1,55 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/File/Path.h"
+
+// A read-only memory mapping of a whole local file, so large files can be used in place
+// without reading them in first.  Pages are only loaded from disk as they're touched.
+//
+// Not every path can be mapped (content URIs, UWP), so callers need a fallback.
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile() {
+		Close();
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator =(const MappedFile &) = delete;
+
+	bool Open(const Path &filename);
+	void Close();
+
+	bool IsOpen() const {
+		return data_ != nullptr;
+	}
+	const uint8_t *Data() const {
+		return data_;
+	}
+	size_t Size() const {
+		return size_;
+	}
+
+private:
+	const uint8_t *data_ = nullptr;
+	size_t size_ = 0;
+};
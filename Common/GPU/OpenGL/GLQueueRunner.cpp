@@ -11,6 +11,7 @@
 #include "Common/Log.h"
 #include "Common/LogReporting.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/StringUtils.h"
 #include "Common/Data/Convert/SmallDataConvert.h"
 
@@ -650,6 +651,7 @@ void GLQueueRunner::InitCreateFramebuffer(const GLRInitStep &step) {
 }
 
 void GLQueueRunner::RunSteps(const std::vector<GLRStep *> &steps, bool skipGLCalls, bool keepSteps, bool useVR) {
+	PROFILE_THIS_SCOPE("gl_steps");
 	if (skipGLCalls) {
 		if (keepSteps) {
 			return;
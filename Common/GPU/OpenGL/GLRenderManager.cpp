@@ -7,6 +7,7 @@
 
 #include "Common/Log.h"
 #include "Common/MemoryUtil.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Math/math_util.h"
 
 #if 0 // def _DEBUG
@@ -562,6 +563,7 @@ void GLRenderManager::EndSubmitFrame(int frame) {
 
 // Render thread
 void GLRenderManager::Run(int frame) {
+	PROFILE_THIS_SCOPE("gl_run");
 	BeginSubmitFrame(frame);
 
 	FrameData &frameData = frameData_[frame];
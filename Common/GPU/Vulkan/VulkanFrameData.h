@@ -23,6 +23,8 @@ struct QueueProfileContext {
 	std::string profileSummary;
 	double cpuStartTime;
 	double cpuEndTime;
+	// Time the render thread spent waiting for pipelines to compile.
+	double compileWaitTime = 0.0;
 };
 
 struct FrameDataShared {
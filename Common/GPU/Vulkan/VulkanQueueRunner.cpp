@@ -5,6 +5,7 @@
 #include "Common/GPU/Vulkan/VulkanRenderManager.h"
 #include "Common/VR/PPSSPPVR.h"
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/TimeUtil.h"
 
 using namespace PPSSPP_VK;
@@ -426,6 +427,7 @@ void VulkanQueueRunner::PreprocessSteps(std::vector<VKRStep *> &steps) {
 }
 
 void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frameData, FrameDataShared &frameDataShared, bool keepSteps) {
+	PROFILE_THIS_SCOPE("vk_steps");
 	QueueProfileContext *profile = frameData.profilingEnabled_ ? &frameData.profile : nullptr;
 
 	if (profile)
@@ -510,8 +512,11 @@ void VulkanQueueRunner::RunSteps(std::vector<VKRStep *> &steps, FrameData &frame
 		steps.clear();
 	}
 
-	if (profile)
+	if (profile) {
 		profile->cpuEndTime = time_now_d();
+		profile->compileWaitTime += compileWaitTime_;
+	}
+	compileWaitTime_ = 0.0;
 }
 
 void VulkanQueueRunner::ApplyMGSHack(std::vector<VKRStep *> &steps) {
@@ -1339,7 +1344,13 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 					graphicsPipeline->Create(vulkan_, renderPass->Get(vulkan_, rpType, fbSampleCount), rpType, fbSampleCount);
 				}
 
-				VkPipeline pipeline = graphicsPipeline->pipeline[(size_t)rpType]->BlockUntilReady();
+				Promise<VkPipeline> *promise = graphicsPipeline->pipeline[(size_t)rpType];
+				VkPipeline pipeline = promise->Poll();
+				if (!pipeline && !skipDrawsWhileCompiling_) {
+					double start = time_now_d();
+					pipeline = promise->BlockUntilReady();
+					compileWaitTime_ += time_now_d() - start;
+				}
 
 				if (pipeline != VK_NULL_HANDLE) {
 					vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
@@ -1347,6 +1358,8 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 					lastGraphicsPipeline = graphicsPipeline;
 					pipelineOK = true;
 				} else {
+					// Failed, or still compiling if skipping draws. Either way, the next bind needs to bind for real.
+					lastGraphicsPipeline = nullptr;
 					pipelineOK = false;
 				}
 
@@ -1362,7 +1375,12 @@ void VulkanQueueRunner::PerformRenderPass(const VKRStep &step, VkCommandBuffer c
 		{
 			VKRComputePipeline *computePipeline = c.compute_pipeline.pipeline;
 			if (computePipeline != lastComputePipeline) {
-				VkPipeline pipeline = computePipeline->pipeline->BlockUntilReady();
+				VkPipeline pipeline = computePipeline->pipeline->Poll();
+				if (!pipeline) {
+					double start = time_now_d();
+					pipeline = computePipeline->pipeline->BlockUntilReady();
+					compileWaitTime_ += time_now_d() - start;
+				}
 				if (pipeline != VK_NULL_HANDLE) {
 					vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 					pipelineLayout = c.pipeline.pipelineLayout;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <condition_variable>
@@ -271,6 +272,11 @@ class VulkanQueueRunner {
 		hacksEnabled_ = hacks;
 	}
 
+	// Instead of waiting for pipelines that are still compiling, skip the draws that use them.
+	void SetSkipDrawsWhileCompiling(bool skip) {
+		skipDrawsWhileCompiling_ = skip;
+	}
+
 	void NotifyCompileDone() {
 		compileDone_.notify_all();
 	}
@@ -331,6 +337,11 @@ class VulkanQueueRunner {
 	// TODO: Enable based on compat.ini.
 	uint32_t hacksEnabled_ = 0;
 
+	// Set from the emu thread, read on the render thread.
+	std::atomic<bool> skipDrawsWhileCompiling_{};
+	// Time spent waiting for pipelines during RunSteps, added to the frame's profile.
+	double compileWaitTime_ = 0.0;
+
 	// Compile done notifications.
 	std::mutex compileDoneMutex_;
 	std::condition_variable compileDone_;
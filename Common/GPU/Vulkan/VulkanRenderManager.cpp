@@ -1,9 +1,12 @@
 #include <algorithm>
 #include <cstdint>
+#include <map>
 
 #include <sstream>
 
+#include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 
@@ -26,14 +29,17 @@
 
 using namespace PPSSPP_VK;
 
+// Pipelines with different shaders compile in parallel, up to this many at a time.
+static const int MAX_COMPILE_THREADS = 4;
+
 // renderPass is an example of the "compatibility class" or RenderPassType type.
 bool VKRGraphicsPipeline::Create(VulkanContext *vulkan, VkRenderPass compatibleRenderPass, RenderPassType rpType, VkSampleCountFlagBits sampleCount) {
+	PROFILE_THIS_SCOPE("vk_pipeline");
 	bool multisample = RenderPassTypeHasMultisample(rpType);
 	if (multisample) {
-		if (sampleCount_ != VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM) {
-			_assert_(sampleCount == sampleCount_);
-		} else {
-			sampleCount_ = sampleCount;
+		VkSampleCountFlagBits expected = VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM;
+		if (!sampleCount_.compare_exchange_strong(expected, sampleCount)) {
+			_assert_(sampleCount == expected);
 		}
 	}
 
@@ -244,7 +250,8 @@ VulkanRenderManager::VulkanRenderManager(VulkanContext *vulkan)
 	: vulkan_(vulkan), queueRunner_(vulkan),
 	initTimeMs_("initTimeMs"),
 	totalGPUTimeMs_("totalGPUTimeMs"),
-	renderCPUTimeMs_("renderCPUTimeMs")
+	renderCPUTimeMs_("renderCPUTimeMs"),
+	compileWaitMs_("compileWaitMs")
 {
 	inflightFramesAtStart_ = vulkan_->GetInflightFrames();
 
@@ -291,8 +298,12 @@ bool VulkanRenderManager::CreateBackbuffers() {
 
 		INFO_LOG(G3D, "Starting Vulkan submission thread");
 		thread_ = std::thread(&VulkanRenderManager::ThreadFunc, this);
-		INFO_LOG(G3D, "Starting Vulkan compiler thread");
-		compileThread_ = std::thread(&VulkanRenderManager::CompileThreadFunc, this);
+		// Leave room for the emulation and submission threads.
+		int numCompileThreads = std::min(std::max(cpu_info.num_cores - 2, 1), MAX_COMPILE_THREADS);
+		INFO_LOG(G3D, "Starting %d Vulkan compiler threads", numCompileThreads);
+		for (int i = 0; i < numCompileThreads; i++) {
+			compileThreads_.push_back(std::thread(&VulkanRenderManager::CompileThreadFunc, this));
+		}
 	}
 	return true;
 }
@@ -323,13 +334,16 @@ void VulkanRenderManager::StopThread() {
 
 	INFO_LOG(G3D, "Vulkan submission thread joined. Frame=%d", vulkan_->GetCurFrame());
 
-	if (compileThread_.joinable()) {
+	{
 		// Lock to avoid race conditions.
 		std::lock_guard<std::mutex> guard(compileMutex_);
 		compileCond_.notify_all();
 	}
-	compileThread_.join();
-	INFO_LOG(G3D, "Vulkan compiler thread joined.");
+	for (std::thread &compileThread : compileThreads_) {
+		compileThread.join();
+	}
+	compileThreads_.clear();
+	INFO_LOG(G3D, "Vulkan compiler threads joined.");
 
 	// Eat whatever has been queued up for this frame if anything.
 	Wipe();
@@ -385,20 +399,28 @@ void VulkanRenderManager::CompileThreadFunc() {
 		std::vector<CompileQueueEntry> toCompile;
 		{
 			std::unique_lock<std::mutex> lock(compileMutex_);
-			if (compileQueue_.empty() && run_) {
+			while (compileQueue_.empty() && compileBatches_.empty() && run_) {
 				compileCond_.wait(lock);
 			}
-			toCompile = std::move(compileQueue_);
-			compileQueue_.clear();
-		}
-		if (!run_) {
-			break;
+			if (!run_) {
+				break;
+			}
+			if (!compileQueue_.empty()) {
+				BatchCompileQueue();
+				// Wake up the others if there's more work than ours.
+				if (compileBatches_.size() > 1)
+					compileCond_.notify_all();
+			}
+			toCompile = std::move(compileBatches_.front());
+			compileBatches_.pop_front();
+			if (urgentCompileBatches_ > 0)
+				urgentCompileBatches_--;
+			compileBatchesInFlight_++;
 		}
 
 		double time = time_now_d();
-		// TODO: Here we can sort the pending pipelines by vertex and fragment shaders,
-		// and split up further.
-		// Those with the same pairs of shaders should be on the same thread.
+		// These all share shaders, which drivers tend to cache, so they're best done in sequence.
+		// Other threads may wait on the same shader module promises, which is safe.
 		for (auto &entry : toCompile) {
 			switch (entry.type) {
 			case CompileQueueEntry::Type::GRAPHICS:
@@ -415,15 +437,49 @@ void VulkanRenderManager::CompileThreadFunc() {
 			INFO_LOG(G3D, "CompileThreadFunc: Creating %d pipelines took %0.3f ms", (int)toCompile.size(), delta * 1000.0f);
 		}
 
+		{
+			std::lock_guard<std::mutex> guard(compileMutex_);
+			compileBatchesInFlight_--;
+			compileDoneCond_.notify_all();
+		}
 		queueRunner_.NotifyCompileDone();
 	}
 }
 
+void VulkanRenderManager::BatchCompileQueue() {
+	// Group by shader pair, so a pipeline's variants and others using the same shaders end up on one thread.
+	// Compute pipelines have no vertex or fragment shader, and end up together.
+	std::map<std::pair<const void *, const void *>, std::vector<CompileQueueEntry>> batches;
+	for (const CompileQueueEntry &entry : compileQueue_) {
+		std::pair<const void *, const void *> key{};
+		if (entry.type == CompileQueueEntry::Type::GRAPHICS) {
+			key = std::make_pair(entry.graphics->desc->vertexShader, entry.graphics->desc->fragmentShader);
+		}
+		batches[key].push_back(entry);
+	}
+	compileQueue_.clear();
+
+	for (auto &iter : batches) {
+		std::vector<CompileQueueEntry> &batch = iter.second;
+		bool urgent = std::any_of(batch.begin(), batch.end(), [](const CompileQueueEntry &entry) {
+			return !entry.preload;
+		});
+		if (urgent) {
+			// Goes after the other urgent batches, but before any preloads.
+			compileBatches_.insert(compileBatches_.begin() + urgentCompileBatches_, std::move(batch));
+			urgentCompileBatches_++;
+		} else {
+			compileBatches_.push_back(std::move(batch));
+		}
+	}
+}
+
 void VulkanRenderManager::DrainCompileQueue() {
 	std::unique_lock<std::mutex> lock(compileMutex_);
 	compileCond_.notify_all();
-	while (!compileQueue_.empty()) {
-		queueRunner_.WaitForCompileNotification();
+	// Without any compile threads left, there's nobody to wait for.
+	while (!compileThreads_.empty() && (!compileQueue_.empty() || !compileBatches_.empty() || compileBatchesInFlight_ > 0)) {
+		compileDoneCond_.wait(lock);
 	}
 }
 
@@ -511,6 +567,9 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 				renderCPUTimeMs_.Update((frameData.profile.cpuEndTime - frameData.profile.cpuStartTime) * 1000.0);
 				renderCPUTimeMs_.Format(line, sizeof(line));
 				str << line;
+				compileWaitMs_.Update(frameData.profile.compileWaitTime * 1000.0);
+				compileWaitMs_.Format(line, sizeof(line));
+				str << line;
 				for (int i = 0; i < numQueries - 1; i++) {
 					uint64_t diff = (queryResults[i + 1] - queryResults[i]) & timestampDiffMask;
 					double milliseconds = (double)diff * timestampConversionFactor;
@@ -533,6 +592,7 @@ void VulkanRenderManager::BeginFrame(bool enableProfiling, bool enableLogProfile
 		} else {
 			frameData.profile.profileSummary = "(no GPU profile data collected)";
 		}
+		frameData.profile.compileWaitTime = 0.0;
 	}
 
 	// Must be after the fence - this performs deletes.
@@ -605,7 +665,7 @@ VKRGraphicsPipeline *VulkanRenderManager::CreateGraphicsPipeline(VKRGraphicsPipe
 			}
 
 			pipeline->pipeline[i] = Promise<VkPipeline>::CreateEmpty();
-			compileQueue_.push_back(CompileQueueEntry(pipeline, compatibleRenderPass->Get(vulkan_, rpType, sampleCount), rpType, sampleCount));
+			compileQueue_.push_back(CompileQueueEntry(pipeline, compatibleRenderPass->Get(vulkan_, rpType, sampleCount), rpType, sampleCount, cacheLoad));
 			needsCompile = true;
 		}
 		if (needsCompile)
@@ -1224,6 +1284,7 @@ void VulkanRenderManager::Wipe() {
 //
 // Can be called again after a VKRRunType::SYNC on the same frame.
 void VulkanRenderManager::Run(VKRRenderThreadTask &task) {
+	PROFILE_THIS_SCOPE("vk_run");
 	FrameData &frameData = frameData_[task.frame];
 
 	_dbg_assert_(!frameData.hasPresentCommands);
@@ -1338,4 +1399,5 @@ void VulkanRenderManager::ResetStats() {
 	initTimeMs_.Reset();
 	totalGPUTimeMs_.Reset();
 	renderCPUTimeMs_.Reset();
+	compileWaitMs_.Reset();
 }
@@ -8,6 +8,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <mutex>
 #include <thread>
 #include <queue>
@@ -142,7 +143,8 @@ struct VKRGraphicsPipeline {
 
 	std::string tag_;
 	PipelineFlags flags_;
-	VkSampleCountFlagBits sampleCount_ = VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM;
+	// Variants can be created on different compile threads at once, if they were queued at different times.
+	std::atomic<VkSampleCountFlagBits> sampleCount_{ VK_SAMPLE_COUNT_FLAG_BITS_MAX_ENUM };
 };
 
 struct VKRComputePipeline {
@@ -160,8 +162,8 @@ struct VKRComputePipeline {
 };
 
 struct CompileQueueEntry {
-	CompileQueueEntry(VKRGraphicsPipeline *p, VkRenderPass _compatibleRenderPass, RenderPassType _renderPassType, VkSampleCountFlagBits _sampleCount)
-		: type(Type::GRAPHICS), graphics(p), compatibleRenderPass(_compatibleRenderPass), renderPassType(_renderPassType), sampleCount(_sampleCount) {}
+	CompileQueueEntry(VKRGraphicsPipeline *p, VkRenderPass _compatibleRenderPass, RenderPassType _renderPassType, VkSampleCountFlagBits _sampleCount, bool _preload = false)
+		: type(Type::GRAPHICS), graphics(p), compatibleRenderPass(_compatibleRenderPass), renderPassType(_renderPassType), sampleCount(_sampleCount), preload(_preload) {}
 	CompileQueueEntry(VKRComputePipeline *p) : type(Type::COMPUTE), compute(p), renderPassType(RenderPassType::DEFAULT), sampleCount(VK_SAMPLE_COUNT_1_BIT), compatibleRenderPass(VK_NULL_HANDLE) {}  // renderpasstype here shouldn't matter
 	enum class Type {
 		GRAPHICS,
@@ -173,6 +175,8 @@ struct CompileQueueEntry {
 	VKRGraphicsPipeline *graphics = nullptr;
 	VKRComputePipeline *compute = nullptr;
 	VkSampleCountFlagBits sampleCount;
+	// Loaded from the pipeline cache, rather than needed to draw this frame.
+	bool preload = false;
 };
 
 class VulkanRenderManager {
@@ -460,6 +464,8 @@ class VulkanRenderManager {
 	void ThreadFunc();
 	void CompileThreadFunc();
 	void DrainCompileQueue();
+	// Expects compileMutex_ to be held.
+	void BatchCompileQueue();
 
 	void Run(VKRRenderThreadTask &task);
 
@@ -512,13 +518,18 @@ class VulkanRenderManager {
 	std::mutex syncMutex_;
 	std::condition_variable syncCondVar_;
 
-	// Shader compilation thread to compile while emulating the rest of the frame.
-	// Only one right now but we could use more.
-	std::thread compileThread_;
+	// Shader compilation threads to compile while emulating the rest of the frame.
+	std::vector<std::thread> compileThreads_;
 	// Sync
 	std::condition_variable compileCond_;
+	std::condition_variable compileDoneCond_;
 	std::mutex compileMutex_;
 	std::vector<CompileQueueEntry> compileQueue_;
+	// Entries from compileQueue_ grouped by shaders, each compiled by a single thread.
+	// The first urgentCompileBatches_ have pipelines needed to draw, the rest are preloads.
+	std::deque<std::vector<CompileQueueEntry>> compileBatches_;
+	size_t urgentCompileBatches_ = 0;
+	int compileBatchesInFlight_ = 0;
 
 	// pipelines to check and possibly create at the end of the current render pass.
 	std::vector<VKRGraphicsPipeline *> pipelinesToCheck_;
@@ -527,6 +538,7 @@ class VulkanRenderManager {
 	SimpleStat initTimeMs_;
 	SimpleStat totalGPUTimeMs_;
 	SimpleStat renderCPUTimeMs_;
+	SimpleStat compileWaitMs_;
 
 	std::function<void(InvalidationCallbackFlags)> invalidationCallback_;
 };
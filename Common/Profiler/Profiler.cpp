@@ -1,6 +1,8 @@
-// Ultra-lightweight category profiler with history.
+// Ultra-lightweight category profiler with history, and an always available tracer.
 
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <mutex>
 #include <vector>
 #include <cstring>
@@ -9,6 +11,7 @@
 
 #include "Common/Render/DrawBuffer.h"
 
+#include "Common/StringUtils.h"
 #include "Common/TimeUtil.h"
 #include "Common/Profiler/Profiler.h"
 #include "Common/Log.h"
@@ -262,3 +265,263 @@ void Profiler_GetHistory(int category, int thread, float *data, int count) {
 		data[i] = history[MAX_THREADS * x + thread].time_taken[category];
 	}
 }
+
+// Tracer.
+
+enum class TraceEventType : uint8_t {
+	BEGIN,
+	END,
+	COUNTER,
+	INSTANT,
+};
+
+struct TraceEvent {
+	double time;
+	const char *name;
+	double value;
+	TraceEventType type;
+	uint32_t generation;
+};
+
+// The reader copies slots while the owner may be overwriting them, so it's all atomics (relaxed, so plain
+// moves) and a sequence number to tell if the copy is whole.
+struct TraceSlot {
+	// Index of the event plus one once written, 0 while it's being written.
+	std::atomic<uint64_t> seq;
+	std::atomic<double> time;
+	std::atomic<const char *> name;
+	std::atomic<double> value;
+	std::atomic<TraceEventType> type;
+	std::atomic<uint32_t> generation;
+};
+
+struct TraceThread {
+	// Per thread, so 2.5 MB each.  Once full, the oldest events are overwritten.
+	static const uint64_t CAPACITY = 1 << 16;
+
+	TraceSlot events[CAPACITY]{};
+	// Only written by the owning thread.
+	std::atomic<uint64_t> head{ 0 };
+	int tid = 0;
+	char name[32]{};
+	// Set once the thread exits, the buffer can be reused on the next Tracer_Start().
+	std::atomic<bool> retired{ false };
+};
+
+std::atomic<bool> g_tracerActive{ false };
+// Bumped by each Tracer_Start(), events from earlier ones are left out.
+static std::atomic<uint32_t> traceGeneration{ 0 };
+
+static std::mutex tracerLock;
+static std::vector<TraceThread *> traceThreads;
+static std::vector<TraceThread *> freeTraceThreads;
+static int nextTraceTid = 1;
+static double traceStartTime;
+
+static thread_local TraceThread *curTraceThread;
+static thread_local char curTraceThreadName[32];
+
+struct TraceThreadRetirer {
+	~TraceThreadRetirer() {
+		if (curTraceThread)
+			curTraceThread->retired = true;
+	}
+};
+static thread_local TraceThreadRetirer traceThreadRetirer;
+
+static TraceThread *RegisterTraceThread() {
+	std::lock_guard<std::mutex> guard(tracerLock);
+	TraceThread *t;
+	if (!freeTraceThreads.empty()) {
+		t = freeTraceThreads.back();
+		freeTraceThreads.pop_back();
+		t->head = 0;
+		t->retired = false;
+	} else {
+		t = new TraceThread();
+	}
+	t->tid = nextTraceTid++;
+	truncate_cpy(t->name, curTraceThreadName);
+	traceThreads.push_back(t);
+
+	curTraceThread = t;
+	// Just to make sure the destructor is registered for this thread.
+	(void)&traceThreadRetirer;
+	return t;
+}
+
+static inline void RecordTraceEvent(TraceEventType type, const char *name, double value) {
+	TraceThread *t = curTraceThread;
+	if (!t)
+		t = RegisterTraceThread();
+
+	uint64_t head = t->head.load(std::memory_order_relaxed);
+	TraceSlot &e = t->events[head & (TraceThread::CAPACITY - 1)];
+	// A seqlock: the reader throws away the copy if the sequence changed around it.
+	e.seq.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	e.time.store(time_now_d(), std::memory_order_relaxed);
+	e.name.store(name, std::memory_order_relaxed);
+	e.value.store(value, std::memory_order_relaxed);
+	e.type.store(type, std::memory_order_relaxed);
+	e.generation.store(traceGeneration.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	e.seq.store(head + 1, std::memory_order_release);
+	t->head.store(head + 1, std::memory_order_release);
+}
+
+// Returns false if the slot no longer holds that event, or was being written while copying.
+static bool CopyTraceEvent(const TraceSlot &slot, uint64_t index, TraceEvent &e) {
+	const uint64_t seq = slot.seq.load(std::memory_order_acquire);
+	if (seq != index + 1)
+		return false;
+	e.time = slot.time.load(std::memory_order_relaxed);
+	e.name = slot.name.load(std::memory_order_relaxed);
+	e.value = slot.value.load(std::memory_order_relaxed);
+	e.type = slot.type.load(std::memory_order_relaxed);
+	e.generation = slot.generation.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.seq.load(std::memory_order_relaxed) == seq;
+}
+
+void Tracer_Start() {
+	std::lock_guard<std::mutex> guard(tracerLock);
+	// Threads that exited are gone for good.  The rest keep their buffers, only their owners write to them.
+	for (auto it = traceThreads.begin(); it != traceThreads.end(); ) {
+		TraceThread *t = *it;
+		if (t->retired) {
+			freeTraceThreads.push_back(t);
+			it = traceThreads.erase(it);
+		} else {
+			++it;
+		}
+	}
+	traceStartTime = time_now_d();
+	// Anything still being recorded right now gets the old generation, and is left out.
+	traceGeneration++;
+	g_tracerActive = true;
+}
+
+void Tracer_Stop() {
+	g_tracerActive = false;
+}
+
+void Tracer_Begin(const char *name) {
+	RecordTraceEvent(TraceEventType::BEGIN, name, 0.0);
+}
+
+void Tracer_End() {
+	RecordTraceEvent(TraceEventType::END, nullptr, 0.0);
+}
+
+void Tracer_Counter(const char *name, double value) {
+	RecordTraceEvent(TraceEventType::COUNTER, name, value);
+}
+
+void Tracer_Instant(const char *name) {
+	RecordTraceEvent(TraceEventType::INSTANT, name, 0.0);
+}
+
+void Tracer_SetThreadName(const char *name) {
+	truncate_cpy(curTraceThreadName, name);
+	if (curTraceThread) {
+		std::lock_guard<std::mutex> guard(tracerLock);
+		truncate_cpy(curTraceThread->name, name);
+	}
+}
+
+static void AppendJSONString(std::string &out, const char *str) {
+	out += '"';
+	for (const char *p = str; *p; ++p) {
+		if (*p == '"' || *p == '\\')
+			out += '\\';
+		if ((unsigned char)*p >= 0x20)
+			out += *p;
+	}
+	out += '"';
+}
+
+std::string Tracer_GetChromeJSON() {
+	std::lock_guard<std::mutex> guard(tracerLock);
+	const double now = time_now_d();
+
+	std::string out;
+	out.reserve(1024 * 1024);
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	char buf[256];
+	auto appendEvent = [&](const char *ph, int tid, double time, const char *name) {
+		if (!first)
+			out += ",\n";
+		first = false;
+		snprintf(buf, sizeof(buf), "{\"ph\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f", ph, tid, (time - traceStartTime) * 1000000.0);
+		out += buf;
+		if (name) {
+			out += ",\"name\":";
+			AppendJSONString(out, name);
+		}
+	};
+
+	std::vector<TraceEvent> events;
+	for (TraceThread *t : traceThreads) {
+		if (!first)
+			out += ",\n";
+		first = false;
+		snprintf(buf, sizeof(buf), "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":", t->tid);
+		out += buf;
+		if (t->name[0]) {
+			AppendJSONString(out, t->name);
+		} else {
+			snprintf(buf, sizeof(buf), "\"Thread %d\"", t->tid);
+			out += buf;
+		}
+		out += "}}";
+
+		// The thread may still be writing, so copy what we can.  Events overwritten meanwhile are dropped.
+		const uint32_t generation = traceGeneration.load(std::memory_order_relaxed);
+		uint64_t end = t->head.load(std::memory_order_acquire);
+		uint64_t start = end > TraceThread::CAPACITY ? end - TraceThread::CAPACITY : 0;
+		events.clear();
+		for (uint64_t i = start; i < end; ++i) {
+			TraceEvent e;
+			if (CopyTraceEvent(t->events[i & (TraceThread::CAPACITY - 1)], i, e) && e.generation == generation)
+				events.push_back(e);
+		}
+
+		// Older events may be gone, so we might see ends without begins.  Skip those, and
+		// close anything still open at the end.
+		int depth = 0;
+		for (size_t i = 0; i < events.size(); ++i) {
+			const TraceEvent &e = events[i];
+			switch (e.type) {
+			case TraceEventType::BEGIN:
+				appendEvent("B", t->tid, e.time, e.name);
+				out += "}";
+				depth++;
+				break;
+			case TraceEventType::END:
+				if (depth == 0)
+					break;
+				appendEvent("E", t->tid, e.time, nullptr);
+				out += "}";
+				depth--;
+				break;
+			case TraceEventType::COUNTER:
+				appendEvent("C", t->tid, e.time, e.name);
+				snprintf(buf, sizeof(buf), ",\"args\":{\"value\":%g}}", std::isfinite(e.value) ? e.value : 0.0);
+				out += buf;
+				break;
+			case TraceEventType::INSTANT:
+				appendEvent("i", t->tid, e.time, e.name);
+				out += ",\"s\":\"t\"}";
+				break;
+			}
+		}
+		for (; depth > 0; --depth) {
+			appendEvent("E", t->tid, now, nullptr);
+			out += "}";
+		}
+	}
+
+	out += "\n]}\n";
+	return out;
+}
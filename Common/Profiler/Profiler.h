@@ -1,9 +1,36 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <string>
 
 // #define USE_PROFILER
 
+// The tracer is always compiled in, and does nothing but check a flag until started.
+// Each thread records its scopes and counters to its own ring buffer, so recording never
+// takes a lock.  The result can be loaded in chrome://tracing or https://ui.perfetto.dev.
+//
+// All names must be string literals (or otherwise live forever), only the pointer is kept.
+
+extern std::atomic<bool> g_tracerActive;
+
+inline bool Tracer_IsActive() {
+	return g_tracerActive.load(std::memory_order_relaxed);
+}
+
+// Starting again drops anything recorded before.
+void Tracer_Start();
+void Tracer_Stop();
+// Returns Chrome trace event format JSON of what was recorded, best done after stopping.
+std::string Tracer_GetChromeJSON();
+
+void Tracer_Begin(const char *name);
+void Tracer_End();
+void Tracer_Counter(const char *name, double value);
+void Tracer_Instant(const char *name);
+// Called by SetCurrentThreadName(), so the trace can show it.
+void Tracer_SetThreadName(const char *name);
+
 #ifdef USE_PROFILER
 
 class DrawBuffer;
@@ -22,27 +49,61 @@ void Profiler_GetSlowestThreads(int *data, int count);
 void Profiler_GetSlowestHistory(int category, int *slowestThreads, float *data, int count);
 void Profiler_GetHistory(int category, int thread, float *data, int count);
 
+#endif
+
 class ProfileThis {
 public:
 	ProfileThis(const char *category) {
+#ifdef USE_PROFILER
 		cat_ = internal_profiler_enter(category, &thread_);
+#endif
+		traced_ = Tracer_IsActive();
+		if (traced_)
+			Tracer_Begin(category);
 	}
 	~ProfileThis() {
+		if (traced_)
+			Tracer_End();
+#ifdef USE_PROFILER
 		internal_profiler_leave(thread_, cat_);
+#endif
 	}
 private:
+#ifdef USE_PROFILER
 	int cat_;
 	int thread_;
+#endif
+	bool traced_;
 };
 
-#define PROFILE_INIT() internal_profiler_init();
-#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat);
-#define PROFILE_END_FRAME() internal_profiler_end_frame();
+#ifdef USE_PROFILER
+class ProfileUntraced {
+public:
+	ProfileUntraced(const char *category) {
+		cat_ = internal_profiler_enter(category, &thread_);
+	}
+	~ProfileUntraced() {
+		internal_profiler_leave(thread_, cat_);
+	}
+private:
+	int cat_;
+	int thread_;
+};
+#endif
 
+#ifdef USE_PROFILER
+#define PROFILE_INIT() internal_profiler_init();
+#define PROFILE_END_FRAME() { internal_profiler_end_frame(); if (Tracer_IsActive()) Tracer_Instant("frame"); }
 #else
-
 #define PROFILE_INIT()
-#define PROFILE_THIS_SCOPE(cat)
-#define PROFILE_END_FRAME()
+#define PROFILE_END_FRAME() { if (Tracer_IsActive()) Tracer_Instant("frame"); }
+#endif
 
+#define PROFILE_THIS_SCOPE(cat) ProfileThis _profile_scoped(cat);
+// For scopes entered per pixel or per vertex, which would flood the trace.  Only the category profiler sees these.
+#ifdef USE_PROFILER
+#define PROFILE_THIS_SCOPE_UNTRACED(cat) ProfileUntraced _profile_scoped(cat);
+#else
+#define PROFILE_THIS_SCOPE_UNTRACED(cat)
 #endif
+#define PROFILE_COUNTER(name, value) { if (Tracer_IsActive()) Tracer_Counter(name, (double)(value)); }
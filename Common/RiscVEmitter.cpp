@@ -1149,9 +1149,12 @@ void RiscVEmitter::SetRegToImmediate(RiscVReg rd, uint64_t value, RiscVReg temp)
 
 	auto useUpper = [&](int64_t v, void (RiscVEmitter::*upperOp)(RiscVReg, s32), bool force = false) {
 		if (SignReduce64(v, 32) == v || force) {
-			int32_t lower = (int32_t)SignReduce64(svalue, 12);
-			int32_t upper = ((v - lower) >> 12) << 12;
-			_assert_msg_(force || (int64_t)upper + lower == v, "Upper + ADDI immediate math mistake?");
+			// The low 12 bits of v, not svalue, since AUIPC adds in the pc.
+			int32_t lower = (int32_t)SignReduce64(v, 12);
+			int32_t upper = (int32_t)(((v - lower) >> 12) << 12);
+			// Near the top of the 32-bit range, rounding up the upper part overflows.
+			if (!force && (int64_t)upper + lower != v)
+				return false;
 
 			// Should be fused on some processors.
 			(this->*upperOp)(rd, upper);
@@ -4262,4 +4265,14 @@ void RiscVEmitter::C_SDSP(RiscVReg rs2, u32 uimm9) {
 	Write16(EncodeCSS(Opcode16::C2, rs2, imm5_4_3_8_7_6, Funct3::C_SDSP));
 }
 
+void RiscVCodeBlock::PoisonMemory(int offset) {
+	u32 *ptr = (u32 *)(region + offset);
+	u32 *maxptr = (u32 *)(region + region_size);
+	// If our memory isn't a multiple of u32 then this won't write the last remaining bytes with anything
+	// Less than optimal, but there would be nothing we could do but throw a runtime warning anyway.
+	// RiscV: 0x00100073 = EBREAK
+	while (ptr < maxptr)
+		*ptr++ = 0x00100073;
+}
+
 };
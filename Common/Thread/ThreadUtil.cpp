@@ -25,6 +25,7 @@
 #include <cstdint>
 
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -153,6 +154,7 @@ void SetCurrentThreadName(const char *threadName) {
 #ifdef TLS_SUPPORTED
 	curThreadName = threadName;
 #endif
+	Tracer_SetThreadName(threadName);
 }
 
 #if PPSSPP_PLATFORM(WINDOWS)
@@ -30,6 +30,8 @@
 extern const char *PPSSPP_GIT_VERSION;
 
 extern bool jitForcedOff;
+// What the CPU core was before jitForcedOff, to save it unchanged.
+extern int jitForcedOffCore;
 
 enum ChatPositions {
 	BOTTOM_LEFT = 0,
@@ -119,6 +121,7 @@ struct Config {
 	bool bHideSlowWarnings;
 	bool bHideStateWarnings;
 	bool bPreloadFunctions;
+	bool bIRBlockCache;
 	uint32_t uJitDisableFlags;
 
 	bool bSeparateSASThread;
@@ -126,6 +129,8 @@ struct Config {
 	int iLockedCPUSpeed;
 	bool bAutoSaveSymbolMap;
 	bool bCacheFullIsoInRam;
+	// In KB, per compressed disc image.
+	int iDiscFrameCacheSize;
 	int iRemoteISOPort;
 	std::string sLastRemoteISOServer;
 	int iLastRemoteISOPort;
@@ -220,6 +225,7 @@ struct Config {
 	int iTexScalingType; // 0 = xBRZ, 1 = Hybrid
 	bool bTexDeposterize;
 	bool bTexHardwareScaling;
+	int iTexScalingFrameBudget;  // Texels per frame to scale, or upload once scaled on a thread.
 	int iFpsLimit1;
 	int iFpsLimit2;
 	int iAnalogFpsLimit;
@@ -227,6 +233,7 @@ struct Config {
 	int iMaxRecent;
 	int iCurrentStateSlot;
 	int iRewindFlipFrequency;
+	int iRewindBufferSizeMB;
 	bool bUISound;
 	bool bEnableStateUndo;
 	std::string sStateLoadUndoGame;
@@ -240,6 +247,7 @@ struct Config {
 	float fGameListScrollPosition;
 	int iBloomHack; //0 = off, 1 = safe, 2 = balanced, 3 = aggressive
 	bool bSkipGPUReadbacks;
+	bool bSkipDrawsWhileCompiling;  // Vulkan: don't wait for pipelines still compiling, skip their draws.
 	int iSplineBezierQuality; // 0 = low , 1 = Intermediate , 2 = High
 	bool bHardwareTessellation;
 	bool bShaderCache;  // Hidden ini-only setting, useful for debugging shader compile times.
@@ -265,6 +273,7 @@ struct Config {
 	int iReverbVolume;
 	int iAltSpeedVolume;
 	bool bExtraAudioBuffering;  // For bluetooth
+	int iAudioResampler;
 	std::string sAudioDevice;
 	bool bAutoAudioDevice;
 
@@ -34,8 +34,19 @@ enum class CPUCore {
 	INTERPRETER = 0,
 	JIT = 1,
 	IR_JIT = 2,
+	JIT_IR = 3,
 };
 
+// Whether the core generates and runs native code, so it can only be used where JIT is allowed.
+// JIT_IR only has native backends on some architectures, elsewhere it just interprets the IR.
+inline bool CpuCoreUsesNativeJit(CPUCore core) {
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(RISCV64)
+	return core == CPUCore::JIT || core == CPUCore::JIT_IR;
+#else
+	return core == CPUCore::JIT;
+#endif
+}
+
 enum {
 	ROTATION_AUTO = 0,
 	ROTATION_LOCKED_HORIZONTAL = 1,
@@ -98,6 +109,12 @@ enum AudioBackendType {
 	AUDIO_BACKEND_WASAPI,
 };
 
+// For iAudioResampler.
+enum AudioResamplerType {
+	AUDIO_RESAMPLER_LINEAR = 0,
+	AUDIO_RESAMPLER_SINC = 1,
+};
+
 // For iIOTimingMethod.
 enum IOTimingMethods {
 	IOTIMING_FAST = 0,
@@ -15,12 +15,14 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
 #include <atomic>
 #include <climits>
 #include <cstdio>
 #include <cstring>
 #include <mutex>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "Common/Profiler/Profiler.h"
@@ -62,12 +64,29 @@ struct BaseEvent {
 
 typedef LinkedListItem<BaseEvent> Event;
 
-Event *first;
+// Pending events on the CPU thread live in a binary min-heap, ordered by time and then by
+// scheduling order so that events for the same cycle still fire first-come first-served.
+// Each event type also indexes its pending events by userdata, so unscheduling and lookups
+// don't have to walk the whole queue.
+struct QueuedEvent {
+	BaseEvent ev;
+	u64 order;
+	// Position in eventHeap.
+	int heapIndex;
+};
+
+typedef std::unordered_multimap<u64, int> TypeEventIndex;
+
+static std::vector<QueuedEvent> queuedEvents;
+static std::vector<int> freeQueuedEvents;
+static std::vector<int> eventHeap;
+static std::vector<TypeEventIndex> typeEvents;
+static u64 nextEventOrder;
+
 Event *tsFirst;
 Event *tsLast;
 
-// event pools
-Event *eventPool = 0;
+// event pool
 Event *eventTsPool = 0;
 int allocatedTsEvents = 0;
 // Optimization to skip MoveEvents when possible.
@@ -130,16 +149,6 @@ u64 GetGlobalTimeUs() {
 	return lastGlobalTimeUs + usSinceLast;
 }
 
-Event* GetNewEvent()
-{
-	if(!eventPool)
-		return new Event;
-
-	Event* ev = eventPool;
-	eventPool = ev->next;
-	return ev;
-}
-
 Event* GetNewTsEvent()
 {
 	allocatedTsEvents++;
@@ -152,12 +161,6 @@ Event* GetNewTsEvent()
 	return ev;
 }
 
-void FreeEvent(Event* ev)
-{
-	ev->next = eventPool;
-	eventPool = ev;
-}
-
 void FreeTsEvent(Event* ev)
 {
 	ev->next = eventTsPool;
@@ -208,7 +211,7 @@ void RestoreRegisterEvent(int &event_type, const char *name, TimedCallback callb
 }
 
 void UnregisterAllEvents() {
-	_dbg_assert_msg_(first == nullptr, "Unregistering events with events pending - this isn't good.");
+	_dbg_assert_msg_(eventHeap.empty(), "Unregistering events with events pending - this isn't good.");
 	event_types.clear();
 	usedEventTypes.clear();
 	restoredEventTypes.clear();
@@ -223,6 +226,7 @@ void Init()
 	lastGlobalTimeTicks = 0;
 	lastGlobalTimeUs = 0;
 	hasTsEvents = 0;
+	nextEventOrder = 0;
 	mhzChangeCallbacks.clear();
 	CPU_HZ = initialHz;
 }
@@ -233,12 +237,12 @@ void Shutdown()
 	ClearPendingEvents();
 	UnregisterAllEvents();
 
-	while(eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		delete ev;
-	}
+	queuedEvents.clear();
+	queuedEvents.shrink_to_fit();
+	freeQueuedEvents.clear();
+	freeQueuedEvents.shrink_to_fit();
+	eventHeap.shrink_to_fit();
+	typeEvents.clear();
 
 	std::lock_guard<std::mutex> lk(externalEventLock);
 	while(eventTsPool)
@@ -292,32 +296,121 @@ void ScheduleEvent_Threadsafe_Immediate(int event_type, u64 userdata)
 		ScheduleEvent_Threadsafe(0, event_type, userdata);
 }
 
-void ClearPendingEvents()
-{
-	while (first)
-	{
-		Event *e = first->next;
-		FreeEvent(first);
-		first = e;
+static inline bool EventBefore(int a, int b) {
+	const QueuedEvent &ea = queuedEvents[a];
+	const QueuedEvent &eb = queuedEvents[b];
+	if (ea.ev.time != eb.ev.time)
+		return ea.ev.time < eb.ev.time;
+	return ea.order < eb.order;
+}
+
+static inline void PlaceInHeap(int pos, int id) {
+	eventHeap[pos] = id;
+	queuedEvents[id].heapIndex = pos;
+}
+
+static void SiftUp(int pos) {
+	int id = eventHeap[pos];
+	while (pos > 0) {
+		int parent = (pos - 1) >> 1;
+		if (!EventBefore(id, eventHeap[parent]))
+			break;
+		PlaceInHeap(pos, eventHeap[parent]);
+		pos = parent;
 	}
+	PlaceInHeap(pos, id);
 }
 
-void AddEventToQueue(Event* ne)
-{
-	Event* prev = NULL;
-	Event** pNext = &first;
-	for(;;)
-	{
-		Event*& next = *pNext;
-		if(!next || ne->time < next->time)
-		{
-			ne->next = next;
-			next = ne;
+static void SiftDown(int pos) {
+	int id = eventHeap[pos];
+	int count = (int)eventHeap.size();
+	while (true) {
+		int child = pos * 2 + 1;
+		if (child >= count)
+			break;
+		if (child + 1 < count && EventBefore(eventHeap[child + 1], eventHeap[child]))
+			child++;
+		if (!EventBefore(eventHeap[child], id))
+			break;
+		PlaceInHeap(pos, eventHeap[child]);
+		pos = child;
+	}
+	PlaceInHeap(pos, id);
+}
+
+static inline const BaseEvent *FirstEvent() {
+	return eventHeap.empty() ? nullptr : &queuedEvents[eventHeap[0]].ev;
+}
+
+static void AddEventToQueue(const BaseEvent &ev) {
+	int id;
+	if (!freeQueuedEvents.empty()) {
+		id = freeQueuedEvents.back();
+		freeQueuedEvents.pop_back();
+	} else {
+		id = (int)queuedEvents.size();
+		queuedEvents.push_back(QueuedEvent{});
+	}
+
+	_dbg_assert_msg_(ev.type >= 0, "Invalid event type %d", ev.type);
+	if (ev.type >= (int)typeEvents.size())
+		typeEvents.resize(ev.type + 1);
+	typeEvents[ev.type].insert(std::make_pair(ev.userdata, id));
+
+	QueuedEvent &qe = queuedEvents[id];
+	qe.ev = ev;
+	qe.order = nextEventOrder++;
+
+	eventHeap.push_back(id);
+	SiftUp((int)eventHeap.size() - 1);
+}
+
+static void RemoveQueuedEvent(int id) {
+	QueuedEvent &qe = queuedEvents[id];
+
+	TypeEventIndex &ofType = typeEvents[qe.ev.type];
+	auto range = ofType.equal_range(qe.ev.userdata);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (it->second == id) {
+			ofType.erase(it);
 			break;
 		}
-		prev = next;
-		pNext = &prev->next;
 	}
+
+	// Swap the last event of the heap into our slot, then restore the heap property.
+	int pos = qe.heapIndex;
+	int movedHeap = eventHeap.back();
+	eventHeap.pop_back();
+	if (movedHeap != id) {
+		PlaceInHeap(pos, movedHeap);
+		if (pos > 0 && EventBefore(movedHeap, eventHeap[(pos - 1) >> 1]))
+			SiftUp(pos);
+		else
+			SiftDown(pos);
+	}
+
+	freeQueuedEvents.push_back(id);
+}
+
+// Returns the events in the order they'll fire, for debugging and save states.
+static std::vector<BaseEvent> SortedEvents() {
+	std::vector<int> ids = eventHeap;
+	std::sort(ids.begin(), ids.end(), &EventBefore);
+
+	std::vector<BaseEvent> sorted;
+	sorted.reserve(ids.size());
+	for (int id : ids)
+		sorted.push_back(queuedEvents[id].ev);
+	return sorted;
+}
+
+void ClearPendingEvents()
+{
+	eventHeap.clear();
+	freeQueuedEvents.clear();
+	queuedEvents.clear();
+	for (auto &ofType : typeEvents)
+		ofType.clear();
 }
 
 // This must be run ONLY from within the cpu thread
@@ -325,55 +418,36 @@ void AddEventToQueue(Event* ne)
 // than Advance
 void ScheduleEvent(s64 cyclesIntoFuture, int event_type, u64 userdata)
 {
-	Event *ne = GetNewEvent();
-	ne->userdata = userdata;
-	ne->type = event_type;
-	ne->time = GetTicks() + cyclesIntoFuture;
-	AddEventToQueue(ne);
+	BaseEvent ev;
+	ev.time = GetTicks() + cyclesIntoFuture;
+	ev.userdata = userdata;
+	ev.type = event_type;
+	AddEventToQueue(ev);
 }
 
 // Returns cycles left in timer.
 s64 UnscheduleEvent(int event_type, u64 userdata)
 {
 	s64 result = 0;
-	if (!first)
+	if (event_type < 0 || event_type >= (int)typeEvents.size())
 		return result;
-	while(first)
-	{
-		if (first->type == event_type && first->userdata == userdata)
-		{
-			result = first->time - GetTicks();
-
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
-		return result;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type && ptr->userdata == userdata)
-		{
-			result = ptr->time - GetTicks();
-
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
 
+	// Matches the old sorted list behavior: if there are several, report the last to fire.
+	TypeEventIndex &ofType = typeEvents[event_type];
+	bool found = false;
+	s64 lastTime = 0;
+	auto it = ofType.find(userdata);
+	while (it != ofType.end()) {
+		const BaseEvent &ev = queuedEvents[it->second].ev;
+		if (!found || ev.time > lastTime)
+			lastTime = ev.time;
+		found = true;
+		RemoveQueuedEvent(it->second);
+		it = ofType.find(userdata);
+	}
+
+	if (found)
+		result = lastTime - GetTicks();
 	return result;
 }
 
@@ -434,52 +508,18 @@ void RegisterMHzChangeCallback(MHzChangeCallback callback) {
 
 bool IsScheduled(int event_type)
 {
-	if (!first)
+	if (event_type < 0 || event_type >= (int)typeEvents.size())
 		return false;
-	Event *e = first;
-	while (e) {
-		if (e->type == event_type)
-			return true;
-		e = e->next;
-	}
-	return false;
+	return !typeEvents[event_type].empty();
 }
 
 void RemoveEvent(int event_type)
 {
-	if (!first)
-		return;
-	while(first)
-	{
-		if (first->type == event_type)
-		{
-			Event *next = first->next;
-			FreeEvent(first);
-			first = next;
-		}
-		else
-		{
-			break;
-		}
-	}
-	if (!first)
+	if (event_type < 0 || event_type >= (int)typeEvents.size())
 		return;
-	Event *prev = first;
-	Event *ptr = prev->next;
-	while (ptr)
-	{
-		if (ptr->type == event_type)
-		{
-			prev->next = ptr->next;
-			FreeEvent(ptr);
-			ptr = prev->next;
-		}
-		else
-		{
-			prev = ptr;
-			ptr = ptr->next;
-		}
-	}
+	TypeEventIndex &ofType = typeEvents[event_type];
+	while (!ofType.empty())
+		RemoveQueuedEvent(ofType.begin()->second);
 }
 
 void RemoveThreadsafeEvent(int event_type)
@@ -536,16 +576,15 @@ void RemoveAllEvents(int event_type)
 //This raise only the events required while the fifo is processing data
 void ProcessFifoWaitEvents()
 {
-	while (first)
+	while (!eventHeap.empty())
 	{
-		if (first->time <= (s64)GetTicks())
+		int id = eventHeap[0];
+		if (queuedEvents[id].ev.time <= (s64)GetTicks())
 		{
-//			LOG(CPU, "[Scheduler] %s		 (%lld, %lld) ",
-//				first->name ? first->name : "?", (u64)GetTicks(), (u64)first->time);
-			Event* evt = first;
-			first = first->next;
-			event_types[evt->type].callback(evt->userdata, (int)(GetTicks() - evt->time));
-			FreeEvent(evt);
+			// Copy it out, the callback may well schedule new events.
+			BaseEvent evt = queuedEvents[id].ev;
+			RemoveQueuedEvent(id);
+			event_types[evt.type].callback(evt.userdata, (int)(GetTicks() - evt.time));
 		}
 		else
 		{
@@ -563,20 +602,11 @@ void MoveEvents()
 	while (tsFirst)
 	{
 		Event *next = tsFirst->next;
-		AddEventToQueue(tsFirst);
+		AddEventToQueue(*tsFirst);
+		FreeTsEvent(tsFirst);
 		tsFirst = next;
 	}
 	tsLast = NULL;
-
-	// Move free events to threadsafe pool
-	while(allocatedTsEvents > 0 && eventPool)
-	{
-		Event *ev = eventPool;
-		eventPool = ev->next;
-		ev->next = eventTsPool;
-		eventTsPool = ev;
-		allocatedTsEvents--;
-	}
 }
 
 void ForceCheck()
@@ -603,6 +633,7 @@ void Advance() {
 		MoveEvents();
 	ProcessFifoWaitEvents();
 
+	const BaseEvent *first = FirstEvent();
 	if (!first) {
 		// This should never happen in PPSSPP.
 		if (slicelength < 10000) {
@@ -622,10 +653,8 @@ void Advance() {
 }
 
 void LogPendingEvents() {
-	Event *ptr = first;
-	while (ptr) {
-		//INFO_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", globalTimer, ptr->time, ptr->type);
-		ptr = ptr->next;
+	for (const BaseEvent &ev : SortedEvents()) {
+		DEBUG_LOG(CPU, "PENDING: Now: %lld Pending: %lld Type: %d", (long long)globalTimer, (long long)ev.time, ev.type);
 	}
 }
 
@@ -634,6 +663,7 @@ void Idle(int maxIdle) {
 	if (maxIdle != 0 && cyclesDown > maxIdle)
 		cyclesDown = maxIdle;
 
+	const BaseEvent *first = FirstEvent();
 	if (first && cyclesDown > 0) {
 		int cyclesExecuted = slicelength - currentMIPS->downcount;
 		int cyclesNextEvent = (int) (first->time - globalTimer);
@@ -655,23 +685,20 @@ void Idle(int maxIdle) {
 }
 
 std::string GetScheduledEventsSummary() {
-	Event *ptr = first;
 	std::string text = "Scheduled events\n";
 	text.reserve(1000);
-	while (ptr) {
-		unsigned int t = ptr->type;
+	for (const BaseEvent &ev : SortedEvents()) {
+		unsigned int t = ev.type;
 		if (t >= event_types.size()) {
 			_dbg_assert_msg_(false, "Invalid event type %d", t);
-			ptr = ptr->next;
 			continue;
 		}
 		const char *name = event_types[t].name;
 		if (!name)
 			name = "[unknown]";
 		char temp[512];
-		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ptr->time, (u32)(ptr->userdata >> 32), (u32)(ptr->userdata));
+		sprintf(temp, "%s : %i %08x%08x\n", name, (int)ev.time, (u32)(ev.userdata >> 32), (u32)(ev.userdata));
 		text += temp;
-		ptr = ptr->next;
 	}
 	return text;
 }
@@ -691,6 +718,42 @@ void Event_DoStateOld(PointerWrap &p, BaseEvent *ev)
 	usedEventTypes.insert(ev->type);
 }
 
+// Uses the same layout DoLinkedList did for the old sorted list, in firing order.
+template <void (*TDo)(PointerWrap &p, BaseEvent *ev)>
+static void DoEventQueue(PointerWrap &p) {
+	if (p.mode == PointerWrap::MODE_READ) {
+		ClearPendingEvents();
+		while (true) {
+			u8 shouldExist = 0;
+			Do(p, shouldExist);
+			if (shouldExist != 1) {
+				if (shouldExist != 0) {
+					WARN_LOG(SAVESTATE, "Savestate failure: incorrect item marker %d", shouldExist);
+					p.SetError(p.ERROR_FAILURE);
+				}
+				break;
+			}
+
+			BaseEvent ev;
+			TDo(p, &ev);
+			if (ev.type < 0 || ev.type >= (int)event_types.size()) {
+				WARN_LOG(SAVESTATE, "Savestate failure: invalid event type %d", ev.type);
+				p.SetError(p.ERROR_FAILURE);
+				break;
+			}
+			AddEventToQueue(ev);
+		}
+	} else {
+		for (BaseEvent &ev : SortedEvents()) {
+			u8 shouldExist = 1;
+			Do(p, shouldExist);
+			TDo(p, &ev);
+		}
+		u8 shouldExist = 0;
+		Do(p, shouldExist);
+	}
+}
+
 void DoState(PointerWrap &p) {
 	std::lock_guard<std::mutex> lk(externalEventLock);
 
@@ -717,10 +780,10 @@ void DoState(PointerWrap &p) {
 	restoredEventTypes.clear();
 
 	if (s >= 3) {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoState>(p, first, (Event **) NULL);
+		DoEventQueue<Event_DoState>(p);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoState>(p, tsFirst, &tsLast);
 	} else {
-		DoLinkedList<BaseEvent, GetNewEvent, FreeEvent, Event_DoStateOld>(p, first, (Event **) NULL);
+		DoEventQueue<Event_DoStateOld>(p);
 		DoLinkedList<BaseEvent, GetNewTsEvent, FreeTsEvent, Event_DoStateOld>(p, tsFirst, &tsLast);
 	}
 
@@ -0,0 +1,57 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "Common/Profiler/Profiler.h"
+#include "Core/Debugger/WebSocket/ProfilerSubscriber.h"
+
+DebuggerSubscriber *WebSocketProfilerInit(DebuggerEventHandlerMap &map) {
+	// The tracer is global, so there's no state here either.
+	map["profiler.trace.start"] = &WebSocketProfilerTraceStart;
+	map["profiler.trace.stop"] = &WebSocketProfilerTraceStop;
+
+	return nullptr;
+}
+
+// Start recording a trace (profiler.trace.start)
+//
+// Anything recorded by a previous trace is discarded.  Works whether or not a game is running.
+//
+// No parameters.
+//
+// Empty response.
+void WebSocketProfilerTraceStart(DebuggerRequest &req) {
+	Tracer_Start();
+	req.Respond();
+}
+
+// Stop recording and return the trace (profiler.trace.stop)
+//
+// No parameters.
+//
+// Response (same event name):
+//  - trace: object in Chrome trace event format, with a traceEvents array.  Can be saved as JSON
+//    and loaded in chrome://tracing or https://ui.perfetto.dev.
+//
+// Note: each thread keeps only its most recent events, so long traces lose their start.
+void WebSocketProfilerTraceStop(DebuggerRequest &req) {
+	if (!Tracer_IsActive())
+		return req.Fail("Not tracing");
+
+	Tracer_Stop();
+	JsonWriter &json = req.Respond();
+	json.writeRaw("trace", Tracer_GetChromeJSON());
+}
@@ -0,0 +1,210 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/Thread/ThreadManager.h"
+#include "Core/FileLoaders/ReadAheadFileLoader.h"
+
+class ReadAheadTask : public Task {
+public:
+	ReadAheadTask(ReadAheadFileLoader *loader, s64 blockNum) : loader_(loader), blockNum_(blockNum) {}
+
+	TaskType Type() const override {
+		return TaskType::IO_BLOCKING;
+	}
+
+	void Run() override {
+		loader_->ReadBlock(blockNum_);
+	}
+
+private:
+	ReadAheadFileLoader *loader_;
+	s64 blockNum_;
+};
+
+// Takes ownership of backend.
+ReadAheadFileLoader::ReadAheadFileLoader(FileLoader *backend)
+	: ProxiedFileLoader(backend) {
+}
+
+ReadAheadFileLoader::~ReadAheadFileLoader() {
+	std::unique_lock<std::mutex> guard(lock_);
+	// The tasks reference us, so wait for any still queued or running.
+	shuttingDown_ = true;
+	blockReady_.wait(guard, [&] { return pendingReads_ == 0; });
+
+	for (auto &it : blocks_) {
+		delete [] it.second.ptr;
+	}
+	blocks_.clear();
+}
+
+size_t ReadAheadFileLoader::ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags) {
+	if (bytes == 0)
+		return 0;
+	if ((flags & Flags::HINT_UNCACHED) != 0)
+		return backend_->ReadAt(absolutePos, bytes, data, flags);
+
+	std::unique_lock<std::mutex> guard(lock_);
+	if (filesize_ < 0)
+		filesize_ = backend_->FileSize();
+
+	Stream &stream = FindStream(absolutePos);
+	stream.readEnd = absolutePos + bytes;
+	stream.generation = ++generation_;
+	// Other reads can change the stream while we wait on blocks.
+	const bool readAhead = stream.sequentialReads >= SEQUENTIAL_READS_TRIGGER;
+
+	size_t readSize = ReadFromBlocks(guard, absolutePos, bytes, (u8 *)data);
+
+	if (readAhead) {
+		s64 nextBlock = (absolutePos + bytes) >> BLOCK_SHIFT;
+		QueueBlocks(nextBlock, nextBlock + BLOCK_READAHEAD);
+	}
+	const s64 filesize = filesize_;
+	guard.unlock();
+
+	// Whatever wasn't read ahead, we read directly (and don't keep.)  Nothing to read past the end, though.
+	if (readSize < bytes && absolutePos + (s64)readSize < filesize) {
+		readSize += backend_->ReadAt(absolutePos + readSize, bytes - readSize, (u8 *)data + readSize, flags);
+	}
+	return readSize;
+}
+
+void ReadAheadFileLoader::Prefetch(s64 absolutePos, size_t bytes) {
+	if (bytes == 0)
+		return;
+
+	std::lock_guard<std::mutex> guard(lock_);
+	if (filesize_ < 0)
+		filesize_ = backend_->FileSize();
+
+	s64 startBlock = absolutePos >> BLOCK_SHIFT;
+	s64 endBlock = (absolutePos + bytes + BLOCK_SIZE - 1) >> BLOCK_SHIFT;
+	QueueBlocks(startBlock, std::min(endBlock, startBlock + MAX_BLOCKS_PREFETCH));
+}
+
+ReadAheadFileLoader::Stream &ReadAheadFileLoader::FindStream(s64 pos) {
+	Stream *oldest = &streams_[0];
+	for (Stream &stream : streams_) {
+		// Allow small skips, i.e. a demuxer skipping a few packets.
+		if (pos >= stream.readEnd && pos - stream.readEnd < BLOCK_SIZE) {
+			stream.sequentialReads++;
+			return stream;
+		}
+		if (stream.generation < oldest->generation)
+			oldest = &stream;
+	}
+
+	// Doesn't continue any of them, so it might be the start of a new one.
+	oldest->sequentialReads = 0;
+	return *oldest;
+}
+
+size_t ReadAheadFileLoader::ReadFromBlocks(std::unique_lock<std::mutex> &guard, s64 pos, size_t bytes, u8 *data) {
+	size_t readSize = 0;
+	while (readSize < bytes) {
+		s64 blockNum = (pos + readSize) >> BLOCK_SHIFT;
+		auto it = blocks_.find(blockNum);
+		if (it == blocks_.end())
+			break;
+
+		if (!it->second.ready) {
+			// Already on its way, no point reading it twice.
+			blockReady_.wait(guard, [&] {
+				it = blocks_.find(blockNum);
+				return it == blocks_.end() || it->second.ready;
+			});
+			if (it == blocks_.end())
+				break;
+		}
+
+		const u32 offset = (u32)((pos + readSize) & (BLOCK_SIZE - 1));
+		if (!it->second.ptr || offset >= it->second.size)
+			break;
+
+		it->second.generation = ++generation_;
+		size_t toRead = std::min(bytes - readSize, (size_t)(it->second.size - offset));
+		memcpy(data + readSize, it->second.ptr + offset, toRead);
+		readSize += toRead;
+	}
+	return readSize;
+}
+
+void ReadAheadFileLoader::QueueBlocks(s64 startBlock, s64 endBlock) {
+	for (s64 blockNum = startBlock; blockNum < endBlock; ++blockNum) {
+		if ((blockNum << BLOCK_SHIFT) >= filesize_ || shuttingDown_)
+			break;
+		if (blocks_.find(blockNum) != blocks_.end())
+			continue;
+		if (!MakeSpaceForBlock())
+			break;
+
+		Block &block = blocks_[blockNum];
+		block.generation = ++generation_;
+		pendingReads_++;
+		g_threadManager.EnqueueTask(new ReadAheadTask(this, blockNum));
+	}
+}
+
+bool ReadAheadFileLoader::MakeSpaceForBlock() {
+	while (blocks_.size() >= MAX_BLOCKS_CACHED) {
+		// Drop the least recently used block that's done reading.
+		auto oldest = blocks_.end();
+		for (auto it = blocks_.begin(); it != blocks_.end(); ++it) {
+			if (it->second.ready && (oldest == blocks_.end() || it->second.generation < oldest->second.generation))
+				oldest = it;
+		}
+		if (oldest == blocks_.end())
+			return false;
+
+		delete [] oldest->second.ptr;
+		blocks_.erase(oldest);
+	}
+	return true;
+}
+
+void ReadAheadFileLoader::ReadBlock(s64 blockNum) {
+	bool skip;
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		skip = shuttingDown_;
+	}
+
+	u8 *buf = nullptr;
+	size_t readSize = 0;
+	if (!skip) {
+		buf = new u8[BLOCK_SIZE];
+		readSize = backend_->ReadAt(blockNum << BLOCK_SHIFT, BLOCK_SIZE, buf, Flags::NONE);
+		// Some backends return -1 on error.
+		if (readSize == 0 || readSize > BLOCK_SIZE) {
+			delete [] buf;
+			buf = nullptr;
+			readSize = 0;
+		}
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	Block &block = blocks_[blockNum];
+	block.ptr = buf;
+	block.size = (u32)readSize;
+	block.ready = true;
+	pendingReads_--;
+	blockReady_.notify_all();
+}
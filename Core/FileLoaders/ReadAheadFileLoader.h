@@ -0,0 +1,87 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+#include "Common/CommonTypes.h"
+#include "Core/Loaders.h"
+
+// Detects sequential reads and reads ahead of them on the thread manager, so streaming
+// videos and audio don't wait on slow storage.  Also acts on Prefetch() hints.
+// Only keeps a small window of blocks, unlike RamCachingFileLoader.
+class ReadAheadFileLoader : public ProxiedFileLoader {
+public:
+	ReadAheadFileLoader(FileLoader *backend);
+	~ReadAheadFileLoader();
+
+	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override {
+		return ReadAt(absolutePos, bytes * count, data, flags) / bytes;
+	}
+	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override;
+	void Prefetch(s64 absolutePos, size_t bytes) override;
+
+private:
+	struct Block {
+		u8 *ptr = nullptr;
+		u32 size = 0;
+		bool ready = false;
+		u64 generation = 0;
+	};
+
+	// A run of sequential reads, i.e. a video and its audio being streamed at the same time.
+	struct Stream {
+		s64 readEnd = 0;
+		int sequentialReads = 0;
+		u64 generation = 0;
+	};
+
+	// These expect lock_ to be held.
+	Stream &FindStream(s64 pos);
+	size_t ReadFromBlocks(std::unique_lock<std::mutex> &guard, s64 pos, size_t bytes, u8 *data);
+	void QueueBlocks(s64 startBlock, s64 endBlock);
+	bool MakeSpaceForBlock();
+
+	void ReadBlock(s64 blockNum);
+
+	enum {
+		BLOCK_SIZE = 65536,
+		BLOCK_SHIFT = 16,
+		MAX_BLOCKS_CACHED = 128,  // 8 MB
+		BLOCK_READAHEAD = 8,
+		MAX_BLOCKS_PREFETCH = 16,
+		// How many reads in a row must continue the last one before we start reading ahead.
+		SEQUENTIAL_READS_TRIGGER = 2,
+		// How many interleaved streams of sequential reads we can follow.
+		MAX_STREAMS = 4,
+	};
+
+	s64 filesize_ = -1;
+	std::map<s64, Block> blocks_;
+	std::mutex lock_;
+	std::condition_variable blockReady_;
+	int pendingReads_ = 0;
+	bool shuttingDown_ = false;
+	u64 generation_ = 0;
+
+	Stream streams_[MAX_STREAMS];
+
+	friend class ReadAheadTask;
+};
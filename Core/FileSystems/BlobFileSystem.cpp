@@ -101,6 +101,13 @@ PSPFileInfo BlobFileSystem::GetFileInfo(std::string filename) {
 	return info;
 }
 
+bool BlobFileSystem::GetHostPath(const std::string &inpath, Path &hostPath) {
+	if (fileLoader_->IsRemote())
+		return false;
+	hostPath = fileLoader_->GetPath();
+	return true;
+}
+
 bool BlobFileSystem::OwnsHandle(u32 handle) {
 	auto entry = entries_.find(handle);
 	return entry != entries_.end();
@@ -55,6 +55,7 @@ class BlobFileSystem : public IFileSystem {
 	u64 FreeSpace(const std::string &path) override;
 
 	bool ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) override { return false; }
+	bool GetHostPath(const std::string &inpath, Path &hostPath) override;
 
 private:
 	// File positions.
@@ -15,17 +15,26 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <atomic>
 #include <cstdio>
 #include <cstring>
 #include <algorithm>
+#include <zstd.h>
 
 #include "Common/Data/Text/I18n.h"
 #include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
 #include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
+#include "Common/StringUtils.h"
 #include "Common/Swap.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/Config.h"
 #include "Core/Loaders.h"
 #include "Core/Host.h"
 #include "Core/FileSystems/BlockDevices.h"
+#include "ext/xxhash.h"
 
 extern "C"
 {
@@ -44,6 +53,8 @@ BlockDevice *constructBlockDevice(FileLoader *fileLoader) {
 	size_t size = fileLoader->ReadAt(0, 1, 4, buffer);
 	if (size == 4 && !memcmp(buffer, "CISO", 4))
 		return new CISOFileBlockDevice(fileLoader);
+	if (size == 4 && !memcmp(buffer, "\x28\xB5\x2F\xFD", 4))
+		return new ZstdFileBlockDevice(fileLoader);
 	if (size == 4 && !memcmp(buffer, "\x00PBP", 4)) {
 		uint32_t psarOffset = 0;
 		size = fileLoader->ReadAt(0x24, 1, 4, &psarOffset);
@@ -106,6 +117,10 @@ bool FileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+void FileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	fileLoader_->Prefetch((u64)minBlock * (u64)GetBlockSize(), (size_t)count * GetBlockSize());
+}
+
 // .CSO format
 
 // compressed ISO(9660) header format
@@ -135,6 +150,18 @@ typedef struct ciso_header
 // TODO: Need much better error handling.
 
 static const u32 CSO_READ_BUFFER_SIZE = 256 * 1024;
+// Reads of at least this much whole frames are inflated on the thread manager.
+static const u32 CSO_PARALLEL_MIN_SIZE = 128 * 1024;
+// Enough work per task to be worth handing off.
+static const u32 CSO_PARALLEL_TASK_SIZE = 32 * 1024;
+// How much compressed data to read at once for parallel inflate.
+static const u32 CSO_PARALLEL_READ_SIZE = 2 * 1024 * 1024;
+static const u32 CSO_NO_FRAME = 0xFFFFFFFF;
+
+static u32 FrameCacheCount(u32 frameSize, u32 minFrames) {
+	const u64 cacheBytes = (u64)std::max(g_Config.iDiscFrameCacheSize, 0) * 1024;
+	return std::max((u32)std::min(cacheBytes / frameSize, (u64)4096), minFrames);
+}
 
 CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	: fileLoader_(fileLoader)
@@ -173,7 +200,9 @@ CISOFileBlockDevice::CISOFileBlockDevice(FileLoader *fileLoader)
 	else
 		readBuffer = new u8[frameSize + (1 << indexShift)];
 	zlibBuffer = new u8[frameSize + (1 << indexShift)];
-	zlibBufferFrame = numFrames;
+
+	frameCacheEntries_.resize(FrameCacheCount(std::max(frameSize, 1U), 1), CachedFrame{ CSO_NO_FRAME, 0 });
+	frameCache_ = new u8[(size_t)frameCacheEntries_.size() * frameSize];
 
 	const u32 indexSize = numFrames + 1;
 	const size_t headerEnd = hdr.ver > 1 ? (size_t)hdr.header_size : sizeof(hdr);
@@ -217,6 +246,7 @@ CISOFileBlockDevice::~CISOFileBlockDevice()
 	delete [] index;
 	delete [] readBuffer;
 	delete [] zlibBuffer;
+	delete [] frameCache_;
 }
 
 bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
@@ -243,13 +273,14 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 		// CSO v2+ requires blocks be uncompressed if large enough to be.  High bit means other things.
 		plain = compressedReadSize >= frameSize;
 	}
+	const u8 *cachedFrame = plain ? nullptr : FindCachedFrame(frameNumber);
 	if (plain) {
 		int readSize = (u32)fileLoader_->ReadAt(compressedReadPos + compressedOffset, 1, GetBlockSize(), outPtr, flags);
 		if (readSize < GetBlockSize())
 			memset(outPtr + readSize, 0, GetBlockSize() - readSize);
-	} else if (zlibBufferFrame == frameNumber) {
+	} else if (cachedFrame) {
 		// We already have it.  Just apply the offset and copy.
-		memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
+		memcpy(outPtr, cachedFrame + compressedOffset, GetBlockSize());
 	} else {
 		const u32 readSize = (u32)fileLoader_->ReadAt(compressedReadPos, 1, compressedReadSize, readBuffer, flags);
 
@@ -261,8 +292,10 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 			NotifyReadError();
 			return false;
 		}
+		// Don't let a full scan (like the CRC) push out frames the game is using.
+		u8 *frameBuffer = uncached ? zlibBuffer : AllocCachedFrame(frameNumber);
 		z.avail_in = readSize;
-		z.next_out = frameSize == (u32)GetBlockSize() ? outPtr : zlibBuffer;
+		z.next_out = frameBuffer;
 		z.avail_out = frameSize;
 		z.next_in = readBuffer;
 
@@ -271,6 +304,7 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 			ERROR_LOG(LOADER, "block %d: inflate : %s[%d]\n", blockNumber, (z.msg) ? z.msg : "error", status);
 			NotifyReadError();
 			inflateEnd(&z);
+			ForgetCachedFrame(frameNumber);
 			memset(outPtr, 0, GetBlockSize());
 			return false;
 		}
@@ -278,23 +312,34 @@ bool CISOFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached)
 			ERROR_LOG(LOADER, "block %d: block size error %d != %d\n", blockNumber, (u32)z.total_out, frameSize);
 			NotifyReadError();
 			inflateEnd(&z);
+			ForgetCachedFrame(frameNumber);
 			memset(outPtr, 0, GetBlockSize());
 			return false;
 		}
 		inflateEnd(&z);
 
-		if (frameSize != (u32)GetBlockSize()) {
-			zlibBufferFrame = frameNumber;
-			memcpy(outPtr, zlibBuffer + compressedOffset, GetBlockSize());
-		}
+		memcpy(outPtr, frameBuffer + compressedOffset, GetBlockSize());
 	}
 	return true;
 }
 
+void CISOFileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	if (minBlock >= numBlocks || count == 0)
+		return;
+
+	// Prefetch the compressed frames that hold these blocks.
+	const u32 lastBlock = std::min(minBlock + count, numBlocks) - 1;
+	const u64 readPos = (u64)(index[minBlock >> blockShift] & 0x7FFFFFFF) << indexShift;
+	const u64 readEnd = (u64)(index[(lastBlock >> blockShift) + 1] & 0x7FFFFFFF) << indexShift;
+	if (readEnd > readPos)
+		fileLoader_->Prefetch(readPos, (size_t)(readEnd - readPos));
+}
+
 bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	if (count == 1) {
 		return ReadBlock(minBlock, outPtr);
 	}
+	PROFILE_THIS_SCOPE("iso_read");
 	if (minBlock >= numBlocks) {
 		memset(outPtr, 0, GetBlockSize() * count);
 		return false;
@@ -308,6 +353,10 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 
 	const u32 minFrameNumber = minBlock >> blockShift;
 	const u32 lastFrameNumber = lastBlock >> blockShift;
+	if ((u64)(lastFrameNumber - minFrameNumber + 1) * frameSize >= CSO_PARALLEL_MIN_SIZE && g_threadManager.GetNumLooperThreads() > 1) {
+		return ReadBlocksParallel(minBlock, lastBlock, outPtr);
+	}
+
 	const u32 afterLastIndexPos = index[lastFrameNumber + 1] & 0x7FFFFFFF;
 	const u64 totalReadEnd = (u64)afterLastIndexPos << indexShift;
 
@@ -347,11 +396,16 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 
 		u8 *rawBuffer = &readBuffer[frameReadPos - readBufferStart];
 		const int plain = idx & 0x80000000;
+		const u8 *cachedFrame = plain || frameBlocks == blocksPerFrame ? nullptr : FindCachedFrame(frame);
 		if (plain) {
 			memcpy(outPtr, rawBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
+		} else if (cachedFrame) {
+			memcpy(outPtr, cachedFrame + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
 		} else {
+			// Keep partial frames in case we end up reusing them in a single read later.
+			u8 *frameBuffer = frameBlocks == blocksPerFrame ? outPtr : AllocCachedFrame(frame);
 			z.avail_in = frameReadSize;
-			z.next_out = frameBlocks == blocksPerFrame ? outPtr : zlibBuffer;
+			z.next_out = frameBuffer;
 			z.avail_out = frameSize;
 			z.next_in = rawBuffer;
 
@@ -359,15 +413,15 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 			if (status != Z_STREAM_END) {
 				ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d]\n", frame, (z.msg) ? z.msg : "error", status);
 				NotifyReadError();
+				ForgetCachedFrame(frame);
 				memset(outPtr, 0, frameBlocks * GetBlockSize());
 			} else if (z.total_out != frameSize) {
 				ERROR_LOG(LOADER, "Inflate frame %d: block size error %d != %d\n", frame, (u32)z.total_out, frameSize);
 				NotifyReadError();
+				ForgetCachedFrame(frame);
 				memset(outPtr, 0, frameBlocks * GetBlockSize());
 			} else if (frameBlocks != blocksPerFrame) {
-				memcpy(outPtr, zlibBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
-				// In case we end up reusing it in a single read later.
-				zlibBufferFrame = frame;
+				memcpy(outPtr, frameBuffer + frameBlockOffset * GetBlockSize(), frameBlocks * GetBlockSize());
 			}
 
 			inflateReset(&z);
@@ -381,6 +435,496 @@ bool CISOFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
 	return true;
 }
 
+bool CISOFileBlockDevice::ReadBlocksParallel(u32 minBlock, u32 lastBlock, u8 *outPtr) {
+	const u32 blocksPerFrame = 1 << blockShift;
+	const u32 blockSize = GetBlockSize();
+	bool success = true;
+
+	// Partial frames at either end go through ReadBlock and the frame cache.
+	u32 wholeStart = std::min((minBlock + blocksPerFrame - 1) & ~(blocksPerFrame - 1), lastBlock + 1);
+	u32 wholeEnd = std::max((lastBlock + 1) & ~(blocksPerFrame - 1), wholeStart);
+	for (u32 block = minBlock; block < wholeStart; ++block) {
+		success = ReadBlock(block, outPtr + (block - minBlock) * blockSize) && success;
+	}
+	for (u32 block = wholeEnd; block <= lastBlock; ++block) {
+		success = ReadBlock(block, outPtr + (block - minBlock) * blockSize) && success;
+	}
+
+	const u32 endFrame = wholeEnd >> blockShift;
+	const int framesPerTask = std::max(CSO_PARALLEL_TASK_SIZE / frameSize, (u32)1);
+	u32 frame = wholeStart >> blockShift;
+	while (frame < endFrame) {
+		// Read as many frames as fit at once, then inflate them all in parallel.
+		const u64 readPos = (u64)(index[frame] & 0x7FFFFFFF) << indexShift;
+		u32 batchEnd = frame + 1;
+		while (batchEnd < endFrame && ((u64)(index[batchEnd + 1] & 0x7FFFFFFF) << indexShift) - readPos <= CSO_PARALLEL_READ_SIZE)
+			++batchEnd;
+		const u64 readEnd = (u64)(index[batchEnd] & 0x7FFFFFFF) << indexShift;
+
+		const size_t readSize = (size_t)(readEnd - readPos);
+		// Leave room for the alignment a plain frame might read past the end.
+		if (parallelReadBuffer_.size() < readSize + frameSize)
+			parallelReadBuffer_.resize(readSize + frameSize);
+		const u8 *readBase = parallelReadBuffer_.data();
+		size_t bytesRead = fileLoader_->ReadAt(readPos, 1, readSize, parallelReadBuffer_.data());
+		if (bytesRead > readSize)
+			bytesRead = 0;
+		memset(parallelReadBuffer_.data() + bytesRead, 0, parallelReadBuffer_.size() - bytesRead);
+
+		std::atomic<bool> failed(false);
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			z_stream z{};
+			if (inflateInit2(&z, -15) != Z_OK) {
+				ERROR_LOG(LOADER, "Unable to initialize inflate: %s\n", (z.msg) ? z.msg : "?");
+				memset(outPtr + ((u64)l * blocksPerFrame - minBlock) * blockSize, 0, (size_t)(h - l) * frameSize);
+				failed = true;
+				return;
+			}
+
+			for (int f = l; f < h; ++f) {
+				const u32 idx = index[f];
+				const u64 frameReadPos = (u64)(idx & 0x7FFFFFFF) << indexShift;
+				const u64 frameReadEnd = (u64)(index[f + 1] & 0x7FFFFFFF) << indexShift;
+				const u32 frameReadSize = (u32)(frameReadEnd - frameReadPos);
+				const u8 *rawBuffer = readBase + (frameReadPos - readPos);
+				u8 *frameOut = outPtr + ((u64)f * blocksPerFrame - minBlock) * blockSize;
+
+				bool plain = (idx & 0x80000000) != 0;
+				if (ver_ >= 2)
+					plain = frameReadSize >= frameSize;
+				if (plain) {
+					memcpy(frameOut, rawBuffer, frameSize);
+					continue;
+				}
+
+				z.avail_in = frameReadSize;
+				z.next_out = frameOut;
+				z.avail_out = frameSize;
+				z.next_in = (Bytef *)rawBuffer;
+
+				int status = inflate(&z, Z_FINISH);
+				if (status != Z_STREAM_END || z.total_out != frameSize) {
+					ERROR_LOG(LOADER, "Inflate frame %d: failed - %s[%d], %d bytes\n", f, (z.msg) ? z.msg : "error", status, (u32)z.total_out);
+					memset(frameOut, 0, frameSize);
+					failed = true;
+				}
+				inflateReset(&z);
+			}
+			inflateEnd(&z);
+		}, (int)frame, (int)batchEnd, framesPerTask);
+
+		if (failed) {
+			NotifyReadError();
+			success = false;
+		}
+		frame = batchEnd;
+	}
+
+	return success;
+}
+
+const u8 *CISOFileBlockDevice::FindCachedFrame(u32 frame) {
+	auto it = frameCacheSlots_.find(frame);
+	if (it == frameCacheSlots_.end())
+		return nullptr;
+	frameCacheEntries_[it->second].lastUse = ++frameCacheGeneration_;
+	return frameCache_ + (size_t)it->second * frameSize;
+}
+
+u8 *CISOFileBlockDevice::AllocCachedFrame(u32 frame) {
+	u32 slot = 0;
+	for (u32 i = 1; i < (u32)frameCacheEntries_.size(); ++i) {
+		if (frameCacheEntries_[i].lastUse < frameCacheEntries_[slot].lastUse)
+			slot = i;
+	}
+
+	CachedFrame &entry = frameCacheEntries_[slot];
+	if (entry.frame != CSO_NO_FRAME)
+		frameCacheSlots_.erase(entry.frame);
+	entry.frame = frame;
+	entry.lastUse = ++frameCacheGeneration_;
+	frameCacheSlots_[frame] = slot;
+	return frameCache_ + (size_t)slot * frameSize;
+}
+
+void CISOFileBlockDevice::ForgetCachedFrame(u32 frame) {
+	auto it = frameCacheSlots_.find(frame);
+	if (it == frameCacheSlots_.end())
+		return;
+	frameCacheEntries_[it->second] = CachedFrame{ CSO_NO_FRAME, 0 };
+	frameCacheSlots_.erase(it);
+}
+
+// Zstd seekable format, see contrib/seekable_format/zstd_seekable_compression_format.md in zstd.
+// The data is a series of regular zstd frames, with the seek table in a skippable frame at the end:
+//   u32 skippable magic, u32 table size, entries of {u32 compressed size, u32 size, [u32 checksum]}
+// followed by the footer below.  Checksums are the low 32 bits of XXH64 of the decompressed frame.
+
+static const u32 ZSTD_SEEKABLE_SKIPPABLE_MAGIC = 0x184D2A5E;
+static const u32 ZSTD_SEEKABLE_FOOTER_MAGIC = 0x8F92EAB1;
+static const u32 ZSTD_SEEKABLE_FOOTER_SIZE = 9;
+static const u32 ZSTD_SKIPPABLE_HEADER_SIZE = 8;
+static const u8 ZSTD_SEEKABLE_CHECKSUM_FLAG = 0x80;
+
+// Frames larger than this aren't worth random access anyway, so we don't support them.
+static const u32 ZSTD_MAX_FRAME_SIZE = 4 * 1024 * 1024;
+static const u32 ZSTD_READ_BUFFER_SIZE = 1024 * 1024;
+// What we write.  Small enough that a random sector read stays cheap.
+static const u32 ZSTD_WRITE_FRAME_SIZE = 128 * 1024;
+static const u32 ZSTD_WRITE_FRAMES_PER_BATCH = 64;
+
+static u32 ReadLE32(const u8 *p) {
+	u32_le value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static void WriteLE32(std::vector<u8> &out, u32 value) {
+	u32_le le = value;
+	const u8 *p = (const u8 *)&le;
+	out.insert(out.end(), p, p + sizeof(le));
+}
+
+ZstdFileBlockDevice::ZstdFileBlockDevice(FileLoader *fileLoader)
+	: fileLoader_(fileLoader)
+{
+	dctx_ = ZSTD_createDCtx();
+
+	const s64 fileSize = fileLoader->FileSize();
+	u8 footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+	if (fileSize < ZSTD_SKIPPABLE_HEADER_SIZE + ZSTD_SEEKABLE_FOOTER_SIZE || fileLoader->ReadAt(fileSize - ZSTD_SEEKABLE_FOOTER_SIZE, 1, ZSTD_SEEKABLE_FOOTER_SIZE, footer) != ZSTD_SEEKABLE_FOOTER_SIZE) {
+		ERROR_LOG(LOADER, "Zstd image too small or unreadable: '%s'", fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+	if (ReadLE32(footer + 5) != ZSTD_SEEKABLE_FOOTER_MAGIC) {
+		ERROR_LOG(LOADER, "Zstd image has no seek table, recompress it in seekable format: '%s'", fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+
+	const u32 numFrames = ReadLE32(footer);
+	const bool hasChecksums = (footer[4] & ZSTD_SEEKABLE_CHECKSUM_FLAG) != 0;
+	const u32 entrySize = hasChecksums ? 12 : 8;
+	const u64 tableSize = (u64)numFrames * entrySize + ZSTD_SEEKABLE_FOOTER_SIZE;
+	if (tableSize + ZSTD_SKIPPABLE_HEADER_SIZE > (u64)fileSize) {
+		ERROR_LOG(LOADER, "Zstd seek table larger than file (%d frames): '%s'", numFrames, fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+
+	const u64 tablePos = fileSize - tableSize - ZSTD_SKIPPABLE_HEADER_SIZE;
+	std::vector<u8> table((size_t)(tableSize + ZSTD_SKIPPABLE_HEADER_SIZE));
+	if (fileLoader->ReadAt(tablePos, table.size(), table.data()) != table.size()) {
+		ERROR_LOG(LOADER, "Unable to read zstd seek table: '%s'", fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+	if (ReadLE32(&table[0]) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC || ReadLE32(&table[4]) != tableSize) {
+		ERROR_LOG(LOADER, "Invalid zstd seek table header: '%s'", fileLoader->GetPath().c_str());
+		NotifyReadError();
+		return;
+	}
+
+	compressedStarts_.resize(numFrames + 1);
+	decompressedStarts_.resize(numFrames + 1);
+	if (hasChecksums)
+		checksums_.resize(numFrames);
+	compressedStarts_[0] = 0;
+	decompressedStarts_[0] = 0;
+
+	u32 maxCompressedSize = 0;
+	u32 maxDecompressedSize = 0;
+	const u8 *entry = &table[ZSTD_SKIPPABLE_HEADER_SIZE];
+	for (u32 i = 0; i < numFrames; ++i, entry += entrySize) {
+		const u32 compressedSize = ReadLE32(entry);
+		const u32 decompressedSize = ReadLE32(entry + 4);
+		if (decompressedSize == 0 || decompressedSize > ZSTD_MAX_FRAME_SIZE || compressedSize == 0) {
+			ERROR_LOG(LOADER, "Zstd frame %d has unsupported size %d (compressed %d)", i, decompressedSize, compressedSize);
+			NotifyReadError();
+			compressedStarts_.clear();
+			decompressedStarts_.clear();
+			checksums_.clear();
+			return;
+		}
+		compressedStarts_[i + 1] = compressedStarts_[i] + compressedSize;
+		decompressedStarts_[i + 1] = decompressedStarts_[i] + decompressedSize;
+		if (hasChecksums)
+			checksums_[i] = ReadLE32(entry + 8);
+		maxCompressedSize = std::max(maxCompressedSize, compressedSize);
+		maxDecompressedSize = std::max(maxDecompressedSize, decompressedSize);
+	}
+
+	if (compressedStarts_[numFrames] > tablePos) {
+		ERROR_LOG(LOADER, "Expected zstd image to at least be %lld bytes, but file is %lld bytes. File: '%s'",
+			compressedStarts_[numFrames] + tableSize + ZSTD_SKIPPABLE_HEADER_SIZE, fileSize, fileLoader->GetPath().c_str());
+		NotifyReadError();
+	}
+
+	numFrames_ = numFrames;
+	numBlocks_ = (u32)(decompressedStarts_[numFrames] / GetBlockSize());
+	readBuffer_.resize(std::max(maxCompressedSize, ZSTD_READ_BUFFER_SIZE));
+	cache_.resize(FrameCacheCount(std::max(maxDecompressedSize, 1U), 2));
+	VERBOSE_LOG(LOADER, "Zstd numBlocks=%i numFrames=%i checksums=%i", numBlocks_, numFrames_, hasChecksums ? 1 : 0);
+}
+
+ZstdFileBlockDevice::~ZstdFileBlockDevice() {
+	ZSTD_freeDCtx(dctx_);
+}
+
+bool ZstdFileBlockDevice::ReadBlock(int blockNumber, u8 *outPtr, bool uncached) {
+	if ((u32)blockNumber >= numBlocks_) {
+		memset(outPtr, 0, GetBlockSize());
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	const u64 pos = (u64)blockNumber * GetBlockSize();
+	return ReadRange(pos, pos + GetBlockSize(), outPtr, uncached);
+}
+
+bool ZstdFileBlockDevice::ReadBlocks(u32 minBlock, int count, u8 *outPtr) {
+	PROFILE_THIS_SCOPE("iso_read");
+	if (minBlock >= numBlocks_) {
+		memset(outPtr, 0, GetBlockSize() * count);
+		return false;
+	}
+
+	const u32 lastBlock = std::min(minBlock + count, numBlocks_) - 1;
+	const u32 validBlocks = lastBlock + 1 - minBlock;
+	if (validBlocks < (u32)count) {
+		memset(outPtr + GetBlockSize() * validBlocks, 0, GetBlockSize() * (count - validBlocks));
+	}
+
+	std::lock_guard<std::mutex> guard(lock_);
+	const u64 pos = (u64)minBlock * GetBlockSize();
+	return ReadRange(pos, pos + (u64)validBlocks * GetBlockSize(), outPtr, false);
+}
+
+void ZstdFileBlockDevice::Prefetch(u32 minBlock, u32 count) {
+	if (minBlock >= numBlocks_ || count == 0)
+		return;
+
+	const u32 lastBlock = std::min(minBlock + count, numBlocks_) - 1;
+	const u32 minFrame = FrameForOffset((u64)minBlock * GetBlockSize());
+	const u32 lastFrame = FrameForOffset((u64)(lastBlock + 1) * GetBlockSize() - 1);
+	const u64 readPos = compressedStarts_[minFrame];
+	fileLoader_->Prefetch(readPos, (size_t)(compressedStarts_[lastFrame + 1] - readPos));
+}
+
+u32 ZstdFileBlockDevice::FrameForOffset(u64 pos) const {
+	// Frames aren't required to be the same size, so search the prefix sums.
+	auto it = std::upper_bound(decompressedStarts_.begin(), decompressedStarts_.end(), pos);
+	return (u32)(it - decompressedStarts_.begin()) - 1;
+}
+
+bool ZstdFileBlockDevice::ReadRange(u64 pos, u64 end, u8 *outPtr, bool uncached) {
+	FileLoader::Flags flags = uncached ? FileLoader::Flags::HINT_UNCACHED : FileLoader::Flags::NONE;
+	const u32 lastFrame = FrameForOffset(end - 1);
+
+	bool success = true;
+	u32 frame = FrameForOffset(pos);
+	while (frame <= lastFrame) {
+		// Read the compressed data of as many frames as fit in the buffer at once.
+		const u64 readPos = compressedStarts_[frame];
+		u32 batchEnd = frame + 1;
+		while (batchEnd <= lastFrame && compressedStarts_[batchEnd + 1] - readPos <= readBuffer_.size())
+			++batchEnd;
+
+		bool needRead = false;
+		for (u32 f = frame; f < batchEnd; ++f) {
+			if (!FindCachedFrame(f))
+				needRead = true;
+		}
+
+		const size_t readSize = (size_t)(compressedStarts_[batchEnd] - readPos);
+		if (needRead && fileLoader_->ReadAt(readPos, 1, readSize, readBuffer_.data(), flags) != readSize) {
+			ERROR_LOG(LOADER, "Zstd frames %d-%d: unable to read %d bytes", frame, batchEnd - 1, (int)readSize);
+			NotifyReadError();
+			const u64 failStart = std::max(pos, decompressedStarts_[frame]);
+			const u64 failEnd = std::min(end, decompressedStarts_[batchEnd]);
+			memset(outPtr + (failStart - pos), 0, (size_t)(failEnd - failStart));
+			success = false;
+			frame = batchEnd;
+			continue;
+		}
+
+		for (u32 f = frame; f < batchEnd; ++f) {
+			const u64 frameStart = decompressedStarts_[f];
+			const u64 frameEnd = decompressedStarts_[f + 1];
+			const u64 copyStart = std::max(pos, frameStart);
+			const u64 copyEnd = std::min(end, frameEnd);
+			u8 *dst = outPtr + (copyStart - pos);
+			const u8 *src = readBuffer_.data() + (compressedStarts_[f] - readPos);
+
+			const u8 *data = FindCachedFrame(f);
+			if (!data && copyStart == frameStart && copyEnd == frameEnd) {
+				// We want the whole frame, so decompress straight to the output and keep the cache for partial reads.
+				if (!DecompressFrame(f, src, dst)) {
+					memset(dst, 0, (size_t)(copyEnd - copyStart));
+					success = false;
+				}
+				continue;
+			}
+
+			if (!data && uncached) {
+				// Don't push frames out of the cache for a one-off read.
+				uncachedBuffer_.resize((size_t)(frameEnd - frameStart));
+				if (!DecompressFrame(f, src, uncachedBuffer_.data())) {
+					memset(dst, 0, (size_t)(copyEnd - copyStart));
+					success = false;
+					continue;
+				}
+				data = uncachedBuffer_.data();
+			} else if (!data) {
+				CachedFrame &cached = OldestCachedFrame();
+				cached.data.resize((size_t)(frameEnd - frameStart));
+				if (!DecompressFrame(f, src, cached.data.data())) {
+					cached.frame = 0xFFFFFFFF;
+					memset(dst, 0, (size_t)(copyEnd - copyStart));
+					success = false;
+					continue;
+				}
+				cached.frame = f;
+				cached.lastUse = ++cacheGeneration_;
+				data = cached.data.data();
+			}
+			memcpy(dst, data + (copyStart - frameStart), (size_t)(copyEnd - copyStart));
+		}
+
+		frame = batchEnd;
+	}
+
+	return success;
+}
+
+bool ZstdFileBlockDevice::DecompressFrame(u32 frame, const u8 *src, u8 *dst) {
+	const size_t compressedSize = (size_t)(compressedStarts_[frame + 1] - compressedStarts_[frame]);
+	const size_t frameSize = (size_t)(decompressedStarts_[frame + 1] - decompressedStarts_[frame]);
+
+	size_t result = ZSTD_decompressDCtx(dctx_, dst, frameSize, src, compressedSize);
+	if (ZSTD_isError(result)) {
+		ERROR_LOG(LOADER, "Zstd frame %d: decompress failed - %s", frame, ZSTD_getErrorName(result));
+		NotifyReadError();
+		return false;
+	}
+	if (result != frameSize) {
+		ERROR_LOG(LOADER, "Zstd frame %d: size error %d != %d", frame, (int)result, (int)frameSize);
+		NotifyReadError();
+		return false;
+	}
+	if (!checksums_.empty() && (u32)XXH64(dst, frameSize, 0) != checksums_[frame]) {
+		ERROR_LOG(LOADER, "Zstd frame %d: checksum mismatch", frame);
+		NotifyReadError();
+		return false;
+	}
+	return true;
+}
+
+const u8 *ZstdFileBlockDevice::FindCachedFrame(u32 frame) {
+	for (CachedFrame &cached : cache_) {
+		if (cached.frame == frame) {
+			cached.lastUse = ++cacheGeneration_;
+			return cached.data.data();
+		}
+	}
+	return nullptr;
+}
+
+ZstdFileBlockDevice::CachedFrame &ZstdFileBlockDevice::OldestCachedFrame() {
+	CachedFrame *oldest = &cache_[0];
+	for (CachedFrame &cached : cache_) {
+		if (cached.lastUse < oldest->lastUse)
+			oldest = &cached;
+	}
+	return *oldest;
+}
+
+bool WriteZstdDiscImage(BlockDevice *blockDevice, const Path &filename, int level, std::string *errorString) {
+	const u32 numBlocks = blockDevice->GetNumBlocks();
+	const u32 blocksPerFrame = ZSTD_WRITE_FRAME_SIZE / blockDevice->GetBlockSize();
+	const u32 numFrames = (numBlocks + blocksPerFrame - 1) / blocksPerFrame;
+	if (numFrames == 0) {
+		*errorString = "Disc image is empty";
+		return false;
+	}
+
+	FILE *f = File::OpenCFile(filename, "wb");
+	if (!f) {
+		*errorString = "Unable to open " + filename.ToVisualString() + " for writing";
+		return false;
+	}
+
+	const size_t bound = ZSTD_compressBound(ZSTD_WRITE_FRAME_SIZE);
+	std::vector<u8> input((size_t)ZSTD_WRITE_FRAMES_PER_BATCH * ZSTD_WRITE_FRAME_SIZE);
+	std::vector<u8> output(ZSTD_WRITE_FRAMES_PER_BATCH * bound);
+	std::vector<size_t> outputSizes(ZSTD_WRITE_FRAMES_PER_BATCH);
+	std::vector<u32> checksums(ZSTD_WRITE_FRAMES_PER_BATCH);
+
+	std::vector<u8> table;
+	WriteLE32(table, ZSTD_SEEKABLE_SKIPPABLE_MAGIC);
+	WriteLE32(table, numFrames * 12 + ZSTD_SEEKABLE_FOOTER_SIZE);
+
+	bool success = true;
+	for (u32 batchStart = 0; batchStart < numFrames && success; batchStart += ZSTD_WRITE_FRAMES_PER_BATCH) {
+		const u32 batchFrames = std::min(ZSTD_WRITE_FRAMES_PER_BATCH, numFrames - batchStart);
+		const u32 firstBlock = batchStart * blocksPerFrame;
+		const u32 batchBlocks = std::min(batchFrames * blocksPerFrame, numBlocks - firstBlock);
+		if (!blockDevice->ReadBlocks(firstBlock, (int)batchBlocks, input.data())) {
+			*errorString = StringFromFormat("Unable to read blocks %d-%d", firstBlock, firstBlock + batchBlocks - 1);
+			success = false;
+			break;
+		}
+
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			ZSTD_CCtx *cctx = ZSTD_createCCtx();
+			for (int i = l; i < h; ++i) {
+				const u32 frameSize = std::min(blocksPerFrame, batchBlocks - i * blocksPerFrame) * blockDevice->GetBlockSize();
+				const u8 *src = &input[(size_t)i * ZSTD_WRITE_FRAME_SIZE];
+				outputSizes[i] = ZSTD_compressCCtx(cctx, &output[i * bound], bound, src, frameSize, level);
+				checksums[i] = (u32)XXH64(src, frameSize, 0);
+			}
+			ZSTD_freeCCtx(cctx);
+		}, 0, (int)batchFrames, 1);
+
+		for (u32 i = 0; i < batchFrames; ++i) {
+			if (ZSTD_isError(outputSizes[i])) {
+				*errorString = StringFromFormat("Compression failed: %s", ZSTD_getErrorName(outputSizes[i]));
+				success = false;
+				break;
+			}
+			if (fwrite(&output[i * bound], 1, outputSizes[i], f) != outputSizes[i]) {
+				*errorString = "Unable to write to " + filename.ToVisualString();
+				success = false;
+				break;
+			}
+
+			const u32 frameSize = std::min(blocksPerFrame, batchBlocks - i * blocksPerFrame) * blockDevice->GetBlockSize();
+			WriteLE32(table, (u32)outputSizes[i]);
+			WriteLE32(table, frameSize);
+			WriteLE32(table, checksums[i]);
+		}
+	}
+
+	if (success) {
+		WriteLE32(table, numFrames);
+		table.push_back(ZSTD_SEEKABLE_CHECKSUM_FLAG);
+		WriteLE32(table, ZSTD_SEEKABLE_FOOTER_MAGIC);
+		if (fwrite(table.data(), 1, table.size(), f) != table.size()) {
+			*errorString = "Unable to write to " + filename.ToVisualString();
+			success = false;
+		}
+	}
+
+	if (fclose(f) != 0 && success) {
+		*errorString = "Unable to write to " + filename.ToVisualString();
+		success = false;
+	}
+	if (!success)
+		File::Delete(filename);
+	return success;
+}
+
 NPDRMDemoBlockDevice::NPDRMDemoBlockDevice(FileLoader *fileLoader)
 	: fileLoader_(fileLoader)
 {
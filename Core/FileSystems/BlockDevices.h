@@ -19,16 +19,22 @@
 
 // Abstractions around read-only blockdevices, such as PSP UMD discs.
 // CISOFileBlockDevice implements compressed iso images, CISO format.
+// ZstdFileBlockDevice implements zstd seekable format images.
 //
 // The ISOFileSystemReader reads from a BlockDevice, so it automatically works
 // with CISO images.
 
 #include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Core/ELF/PBPReader.h"
 
 class FileLoader;
+class Path;
+struct ZSTD_DCtx_s;
 
 class BlockDevice {
 public:
@@ -43,6 +49,8 @@ class BlockDevice {
 		}
 		return true;
 	}
+	// Hint that these blocks will likely be read soon.
+	virtual void Prefetch(u32 minBlock, u32 count) {}
 	int GetBlockSize() const { return 2048;}  // forced, it cannot be changed by subclasses
 	virtual u32 GetNumBlocks() = 0;
 	virtual bool IsDisc() = 0;
@@ -60,21 +68,82 @@ class CISOFileBlockDevice : public BlockDevice {
 	~CISOFileBlockDevice();
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	void Prefetch(u32 minBlock, u32 count) override;
 	u32 GetNumBlocks() override { return numBlocks; }
 	bool IsDisc() override { return true; }
 
 private:
+	struct CachedFrame {
+		u32 frame;
+		u64 lastUse;
+	};
+
+	bool ReadBlocksParallel(u32 minBlock, u32 lastBlock, u8 *outPtr);
+	const u8 *FindCachedFrame(u32 frame);
+	u8 *AllocCachedFrame(u32 frame);
+	void ForgetCachedFrame(u32 frame);
+
 	FileLoader *fileLoader_;
 	u32 *index;
 	u8 *readBuffer;
 	u8 *zlibBuffer;
-	u32 zlibBufferFrame;
 	u8 indexShift;
 	u8 blockShift;
 	u32 frameSize;
 	u32 numBlocks;
 	u32 numFrames;
 	int ver_;
+
+	// Recently decompressed frames, so small reads within a frame only inflate it once.
+	u8 *frameCache_ = nullptr;
+	std::vector<CachedFrame> frameCacheEntries_;
+	std::unordered_map<u32, u32> frameCacheSlots_;
+	u64 frameCacheGeneration_ = 0;
+	// For multi-frame reads decompressed on the thread manager.
+	std::vector<u8> parallelReadBuffer_;
+};
+
+// Independently compressed zstd frames, followed by a seek table (the zstd seekable format.)
+// Any zstd tool can decompress these, and the table lets us decompress only the frames we need.
+class ZstdFileBlockDevice : public BlockDevice {
+public:
+	ZstdFileBlockDevice(FileLoader *fileLoader);
+	~ZstdFileBlockDevice();
+	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
+	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	void Prefetch(u32 minBlock, u32 count) override;
+	u32 GetNumBlocks() override { return numBlocks_; }
+	bool IsDisc() override { return true; }
+
+private:
+	struct CachedFrame {
+		u32 frame = 0xFFFFFFFF;
+		u64 lastUse = 0;
+		std::vector<u8> data;
+	};
+
+	// These expect lock_ to be held.
+	bool ReadRange(u64 pos, u64 end, u8 *outPtr, bool uncached);
+	bool DecompressFrame(u32 frame, const u8 *src, u8 *dst);
+	const u8 *FindCachedFrame(u32 frame);
+	CachedFrame &OldestCachedFrame();
+
+	u32 FrameForOffset(u64 pos) const;
+
+	FileLoader *fileLoader_;
+	ZSTD_DCtx_s *dctx_ = nullptr;
+	std::mutex lock_;
+	u32 numBlocks_ = 0;
+	u32 numFrames_ = 0;
+	// Prefix sums, numFrames_ + 1 entries each.
+	std::vector<u64> compressedStarts_;
+	std::vector<u64> decompressedStarts_;
+	std::vector<u32> checksums_;
+	std::vector<u8> readBuffer_;
+	std::vector<CachedFrame> cache_;
+	u64 cacheGeneration_ = 0;
+	// For partial frames read uncached, which we don't keep.
+	std::vector<u8> uncachedBuffer_;
 };
 
 
@@ -84,6 +153,7 @@ class FileBlockDevice : public BlockDevice {
 	~FileBlockDevice();
 	bool ReadBlock(int blockNumber, u8 *outPtr, bool uncached = false) override;
 	bool ReadBlocks(u32 minBlock, int count, u8 *outPtr) override;
+	void Prefetch(u32 minBlock, u32 count) override;
 	u32 GetNumBlocks() override {return (u32)(filesize_ / GetBlockSize());}
 	bool IsDisc() override { return true; }
 
@@ -133,3 +203,6 @@ class NPDRMDemoBlockDevice : public BlockDevice {
 
 
 BlockDevice *constructBlockDevice(FileLoader *fileLoader);
+
+// Writes the contents of a block device as a ZstdFileBlockDevice image, compressing frames in parallel.
+bool WriteZstdDiscImage(BlockDevice *blockDevice, const Path &filename, int level, std::string *errorString);
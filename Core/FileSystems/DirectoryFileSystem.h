@@ -86,6 +86,10 @@ class DirectoryFileSystem : public IFileSystem {
 	u64 FreeSpace(const std::string &path) override;
 
 	bool ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) override;
+	bool GetHostPath(const std::string &inpath, Path &hostPath) override {
+		hostPath = GetLocalPath(inpath);
+		return true;
+	}
 
 private:
 	struct OpenFileEntry {
@@ -137,6 +137,8 @@ class IFileSystem {
 	virtual FileSystemFlags Flags() = 0;
 	virtual u64      FreeSpace(const std::string &path) = 0;
 	virtual bool     ComputeRecursiveDirSizeIfFast(const std::string &path, int64_t *size) = 0;
+	// Only for files that are plain local files on the host.
+	virtual bool     GetHostPath(const std::string &inpath, Path &hostPath) { return false; }
 };
 
 
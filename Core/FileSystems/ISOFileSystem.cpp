@@ -29,6 +29,8 @@
 #include "Core/Reporting.h"
 
 const int sectorSize = 2048;
+// How much of a file to prefetch when it's opened.
+static const u32 PREFETCH_ON_OPEN_SIZE = 256 * 1024;
 
 bool parseLBN(std::string filename, u32 *sectorStart, u32 *readSize) {
 	// The format of this is: "/sce_lbn" "0x"? HEX* ANY* "_size" "0x"? HEX* ANY*
@@ -357,8 +359,13 @@ int ISOFileSystem::OpenFile(std::string filename, FileAccess access, const char
 		return SCE_KERNEL_ERROR_ERRNO_FILE_NOT_FOUND;
 	}
 
-	if (entry.file == &entireISO)
+	if (entry.file == &entireISO) {
 		entry.isBlockSectorMode = true;
+	} else if (!entry.file->isDirectory && entry.file->size > 0) {
+		// Most files are read from the start, so get that going while the game sets up.
+		const u32 prefetchSize = (u32)std::min(entry.file->size, (s64)PREFETCH_ON_OPEN_SIZE);
+		blockDevice->Prefetch(entry.file->startingPosition / sectorSize, (prefetchSize + sectorSize - 1) / sectorSize);
+	}
 
 	entry.seekPos = 0;
 
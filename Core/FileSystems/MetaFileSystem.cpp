@@ -612,6 +612,18 @@ u64 MetaFileSystem::FreeSpace(const std::string &path)
 		return 0;
 }
 
+bool MetaFileSystem::GetHostPath(const std::string &inpath, Path &hostPath)
+{
+	std::lock_guard<std::recursive_mutex> guard(lock);
+	std::string of;
+	IFileSystem *system;
+	int error = MapFilePath(inpath, of, &system);
+	if (error == 0)
+		return system->GetHostPath(of, hostPath);
+	else
+		return false;
+}
+
 void MetaFileSystem::DoState(PointerWrap &p)
 {
 	std::lock_guard<std::recursive_mutex> guard(lock);
@@ -18,17 +18,19 @@
 #pragma once
 
 #include "Core/HLE/sceKernel.h"
+#include "Common/BitScan.h"
 #include "Common/Serialize/Serializer.h"
+#include "Common/Serialize/SerializeFuncs.h"
 
 struct ThreadQueueList {
 	// Number of queues (number of priority levels starting at 0.)
 	static const int NUM_QUEUES = 128;
 	// Initial number of threads a single queue can handle.
 	static const int INITIAL_CAPACITY = 32;
+	// Number of words in the bitmap of non-empty queues.
+	static const int NUM_MASK_WORDS = NUM_QUEUES / 32;
 
 	struct Queue {
-		// Next ever-been-used queue (worse priority.)
-		Queue *next;
 		// First valid item in data.
 		int first;
 		// One after last valid item in data.
@@ -51,7 +53,7 @@ struct ThreadQueueList {
 
 	ThreadQueueList() {
 		memset(queues, 0, sizeof(queues));
-		first = invalid();
+		memset(nonEmpty, 0, sizeof(nonEmpty));
 	}
 
 	~ThreadQueueList() {
@@ -75,44 +77,33 @@ struct ThreadQueueList {
 	}
 
 	inline SceUID pop_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
+		int priority = first_priority(NUM_QUEUES);
+		if (priority < NUM_QUEUES)
+			return pop(priority);
 
 		_dbg_assert_msg_(false, "ThreadQueueList should not be empty.");
 		return 0;
 	}
 
 	inline SceUID pop_first_better(u32 priority) {
-		Queue *cur = first;
 		// Don't bother looking past (worse than) this priority.
-		Queue *stop = &queues[priority];
-		while (cur < stop) {
-			if (cur->size() > 0)
-				return cur->data[cur->first++];
-			cur = cur->next;
-		}
-
+		int best = first_priority(priority);
+		if (best < (int)priority)
+			return pop(best);
 		return 0;
 	}
 
 	inline SceUID peek_first() {
-		Queue *cur = first;
-		while (cur != invalid()) {
-			if (cur->size() > 0)
-				return cur->data[cur->first];
-			cur = cur->next;
-		}
-
+		int priority = first_priority(NUM_QUEUES);
+		if (priority < NUM_QUEUES)
+			return queues[priority].data[queues[priority].first];
 		return 0;
 	}
 
 	inline void push_front(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[--cur->first] = threadID;
+		mark_non_empty(priority);
 		// If we ran out of room toward the front, add more room for next time.
 		if (cur->first == 0)
 			rebalance(priority);
@@ -121,13 +112,14 @@ struct ThreadQueueList {
 	inline void push_back(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
 		cur->data[cur->end++] = threadID;
+		mark_non_empty(priority);
 		if (cur->full())
 			rebalance(priority);
 	}
 
 	inline void remove(u32 priority, const SceUID threadID) {
 		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
+		_dbg_assert_msg_(cur->data != nullptr, "ThreadQueueList::Queue should already be linked up.");
 
 		for (int i = cur->first; i < cur->end; ++i) {
 			if (cur->data[i] == threadID) {
@@ -139,6 +131,8 @@ struct ThreadQueueList {
 
 				// Now we're one shorter.
 				--cur->end;
+				if (cur->empty())
+					mark_empty(priority);
 				return;
 			}
 		}
@@ -148,7 +142,7 @@ struct ThreadQueueList {
 
 	inline void rotate(u32 priority) {
 		Queue *cur = &queues[priority];
-		_dbg_assert_msg_(cur->next != nullptr, "ThreadQueueList::Queue should already be linked up.");
+		_dbg_assert_msg_(cur->data != nullptr, "ThreadQueueList::Queue should already be linked up.");
 
 		if (cur->size() > 1) {
 			// Grab the front and push it on the end.
@@ -164,17 +158,16 @@ struct ThreadQueueList {
 				free(queues[i].data);
 		}
 		memset(queues, 0, sizeof(queues));
-		first = invalid();
+		memset(nonEmpty, 0, sizeof(nonEmpty));
 	}
 
 	inline bool empty(u32 priority) const {
-		const Queue *cur = &queues[priority];
-		return cur->empty();
+		return (nonEmpty[priority >> 5] & mask_bit(priority)) == 0;
 	}
 
 	inline void prepare(u32 priority) {
 		Queue *cur = &queues[priority];
-		if (cur->next == nullptr)
+		if (cur->data == nullptr)
 			link(priority, INITIAL_CAPACITY);
 	}
 
@@ -208,6 +201,8 @@ struct ThreadQueueList {
 				link(i, capacity);
 				cur->first = (cur->capacity - size) / 2;
 				cur->end = cur->first + size;
+				if (size != 0)
+					mark_non_empty(i);
 			}
 
 			if (size != 0)
@@ -216,11 +211,39 @@ struct ThreadQueueList {
 	}
 
 private:
-	Queue *invalid() const {
-		return (Queue *)-1;
+	// The bits are reversed, so the best priority is the first (leading) set bit.
+	static inline u32 mask_bit(u32 priority) {
+		return 0x80000000 >> (priority & 31);
 	}
 
-	// Initialize a priority level and link to other queues.
+	inline void mark_non_empty(u32 priority) {
+		nonEmpty[priority >> 5] |= mask_bit(priority);
+	}
+
+	inline void mark_empty(u32 priority) {
+		nonEmpty[priority >> 5] &= ~mask_bit(priority);
+	}
+
+	// Returns the best priority with any threads, or limit if none are better than it.
+	inline int first_priority(u32 limit) const {
+		for (u32 word = 0; word < NUM_MASK_WORDS && word * 32 < limit; ++word) {
+			if (nonEmpty[word] != 0) {
+				u32 priority = word * 32 + clz32_nonzero(nonEmpty[word]);
+				return (int)(priority < limit ? priority : limit);
+			}
+		}
+		return (int)limit;
+	}
+
+	inline SceUID pop(int priority) {
+		Queue *cur = &queues[priority];
+		SceUID threadID = cur->data[cur->first++];
+		if (cur->empty())
+			mark_empty(priority);
+		return threadID;
+	}
+
+	// Initialize a priority level.
 	void link(u32 priority, int size) {
 		_dbg_assert_msg_(queues[priority].data == nullptr, "ThreadQueueList::Queue should only be initialized once.");
 
@@ -241,21 +264,6 @@ struct ThreadQueueList {
 		// Start smack in the middle so it can move both directions.
 		cur->first = size / 2;
 		cur->end = size / 2;
-
-		for (int i = (int)priority - 1; i >= 0; --i) {
-			// This queue is before ours, and points past us.
-			// We'll have it point to our new queue, inserting into the chain.
-			if (queues[i].next != nullptr) {
-				cur->next = queues[i].next;
-				queues[i].next = cur;
-				return;
-			}
-		}
-
-		// Never found above - that means there's no better queue yet.
-		// The new one is now first, and whoever was first is after it.
-		cur->next = first;
-		first = cur;
 	}
 
 	// Move or allocate as necessary to maintain free space on both sides.
@@ -282,8 +290,8 @@ struct ThreadQueueList {
 		}
 	}
 
-	// The first queue that's ever been used.
-	Queue *first;
+	// Bitmap of queues with any threads, see mask_bit().
+	u32 nonEmpty[NUM_MASK_WORDS];
 	// The priority level queues of thread ids.
 	Queue queues[NUM_QUEUES];
 };
@@ -20,6 +20,7 @@
 
 #include "Common/Common.h"
 #include "Common/File/Path.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Common/Data/Collections/FixedSizeQueue.h"
@@ -337,6 +338,7 @@ void __AudioSetSRCFrequency(int freq) {
 // This single sample queue is where __AudioMix should read from. If the sample queue is full, we should
 // just sleep the main emulator thread a little.
 void __AudioUpdate(bool resetRecording) {
+	PROFILE_THIS_SCOPE("audio");
 	// Audio throttle doesn't really work on the PSP since the mixing intervals are so closely tied
 	// to the CPU. Much better to throttle the frame rate on frame display and just throw away audio
 	// if the buffer somehow gets full.
@@ -1606,6 +1606,7 @@ static PSPModule *__KernelLoadELFFromPtr(const u8 *ptr, size_t elfSize, u32 load
 			module->nm.entry_addr = module->nm.module_start_func;
 
 		MIPSAnalyst::PrecompileFunctions();
+		MIPSAnalyst::PreloadModuleBlocks(module->crc, module->textStart, module->textEnd);
 
 	} else {
 		module->nm.entry_addr = -1;
@@ -1929,6 +1930,10 @@ void __KernelGPUReplay() {
 	}
 
 	if (PSP_CoreParameter().headLess && !PSP_CoreParameter().startBreak) {
+		// When benchmarking, keep going and only check the last frame.
+		if (GPURecord::ShouldReplayAgain())
+			return;
+
 		PSPPointer<u8> topaddr;
 		u32 linesize = 512;
 		__DisplayGetFramebuf(&topaddr, &linesize, nullptr, 0);
@@ -26,6 +26,7 @@
 // This should be multithreaded and improved at some point. Some discussion here:
 // https://github.com/hrydgard/ppsspp/issues/1078
 
+#include <atomic>
 #include <cstdlib>
 #include <functional>
 #include <thread>
@@ -91,36 +92,75 @@ struct SasThreadParams {
 	int rightVol;
 };
 
+// The emu thread is the only producer and the SAS thread the only consumer, so handing off a mix
+// is just a store to sasThreadState.  Neither side spins for long: after a few checks, the SAS thread
+// sleeps on sasSleep until a mix is queued, and the emu thread sleeps on sasDone until it's mixed.
 static std::thread *sasThread;
-static std::mutex sasWakeMutex;
-static std::mutex sasDoneMutex;
-static std::condition_variable sasWake;
+static std::mutex sasSleepMutex;
+static std::condition_variable sasSleep;
 static std::condition_variable sasDone;
-static volatile int sasThreadState = SasThreadState::DISABLED;
+static std::atomic<bool> sasThreadSleeping;
+static std::atomic<bool> sasDrainSleeping;
+static std::atomic<int> sasThreadState(SasThreadState::DISABLED);
 static SasThreadParams sasThreadParams;
 static int sasMixEvent = -1;
 
+// How many times each side checks the state before going to sleep.  Kept short, since waking is cheap
+// compared to burning a core.
+static const int SAS_THREAD_SPIN_COUNT = 16;
+
 int __SasThread() {
 	SetCurrentThreadName("SAS");
 
-	std::unique_lock<std::mutex> guard(sasWakeMutex);
-	while (sasThreadState != SasThreadState::DISABLED) {
-		sasWake.wait(guard);
-		if (sasThreadState == SasThreadState::QUEUED) {
-			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
+	int spins = 0;
+	while (true) {
+		int state = sasThreadState.load(std::memory_order_acquire);
+		if (state == SasThreadState::DISABLED)
+			break;
 
-			std::lock_guard<std::mutex> doneGuard(sasDoneMutex);
+		if (state == SasThreadState::QUEUED) {
+			sas->Mix(sasThreadParams.outAddr, sasThreadParams.inAddr, sasThreadParams.leftVol, sasThreadParams.rightVol);
 			sasThreadState = SasThreadState::READY;
-			sasDone.notify_one();
+			// Same handshake as __SasWakeThread(), in the other direction.
+			if (sasDrainSleeping) {
+				std::lock_guard<std::mutex> guard(sasSleepMutex);
+				sasDone.notify_one();
+			}
+			spins = 0;
+		} else if (++spins < SAS_THREAD_SPIN_COUNT) {
+			std::this_thread::yield();
+		} else {
+			// Nothing for a while, sleep until there's a mix.  See __SasWakeThread().
+			std::unique_lock<std::mutex> guard(sasSleepMutex);
+			sasThreadSleeping = true;
+			sasSleep.wait(guard, [] { return sasThreadState != SasThreadState::READY; });
+			sasThreadSleeping = false;
+			spins = 0;
 		}
 	}
 	return 0;
 }
 
+static void __SasWakeThread() {
+	// Since both are seq_cst, either the thread saw the new state before sleeping, or we see it sleeping.
+	if (sasThreadSleeping) {
+		std::lock_guard<std::mutex> guard(sasSleepMutex);
+		sasSleep.notify_one();
+	}
+}
+
 static void __SasDrain() {
-	std::unique_lock<std::mutex> guard(sasDoneMutex);
-	while (sasThreadState == SasThreadState::QUEUED)
-		sasDone.wait(guard);
+	// Normally the mix is done by now, since we wait for the estimated mix time before draining.
+	for (int i = 0; i < SAS_THREAD_SPIN_COUNT; ++i) {
+		if (sasThreadState.load(std::memory_order_acquire) != SasThreadState::QUEUED)
+			return;
+		std::this_thread::yield();
+	}
+
+	std::unique_lock<std::mutex> guard(sasSleepMutex);
+	sasDrainSleeping = true;
+	sasDone.wait(guard, [] { return sasThreadState != SasThreadState::QUEUED; });
+	sasDrainSleeping = false;
 }
 
 static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0) {
@@ -142,19 +182,16 @@ static void __SasEnqueueMix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int ri
 	sasThreadParams.leftVol = leftVol;
 	sasThreadParams.rightVol = rightVol;
 
-	// And now, notify.
-	sasWakeMutex.lock();
+	// And now, publish the params and notify.
 	sasThreadState = SasThreadState::QUEUED;
-	sasWake.notify_one();
-	sasWakeMutex.unlock();
+	__SasWakeThread();
 }
 
 static void __SasDisableThread() {
 	if (sasThreadState != SasThreadState::DISABLED) {
-		sasWakeMutex.lock();
+		__SasDrain();
 		sasThreadState = SasThreadState::DISABLED;
-		sasWake.notify_one();
-		sasWakeMutex.unlock();
+		__SasWakeThread();
 		sasThread->join();
 		delete sasThread;
 		sasThread = nullptr;
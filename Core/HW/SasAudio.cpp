@@ -17,7 +17,10 @@
 
 #include <algorithm>
 
+#include "ppsspp_config.h"
 #include "Common/Profiler/Profiler.h"
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
 
 #include "Common/Serialize/SerializeFuncs.h"
 #include "Core/MemMapHelpers.h"
@@ -28,6 +31,18 @@
 #include "Core/Core.h"
 #include "SasAudio.h"
 
+#ifdef _M_SSE
+#include <emmintrin.h>
+#endif
+
+#if PPSSPP_ARCH(ARM_NEON)
+#if defined(_MSC_VER) && PPSSPP_ARCH(ARM64)
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 // #define AUDIO_TO_FILE
 
 static const u8 f[16][2] = {
@@ -128,7 +143,8 @@ void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
 	const u8 *readp = Memory::GetPointerUnchecked(read_);
 	const u8 *origp = readp;
 
-	for (int i = 0; i < numSamples; i++) {
+	int i = 0;
+	while (i < numSamples) {
 		if (curSample == 28) {
 			if (loopAtNextBlock_) {
 				VERBOSE_LOG(SASMIX, "Looping VAG from block %d/%d to %d", curBlock_, numBlocks_, loopStartBlock_);
@@ -146,7 +162,11 @@ void VagDecoder::GetSamples(s16 *outSamples, int numSamples) {
 				return;
 			}
 		}
-		outSamples[i] = samples[curSample++];
+		// Copy out as much of the decoded block as we can at once.
+		int count = std::min(28 - curSample, numSamples - i);
+		memcpy(&outSamples[i], &samples[curSample], count * sizeof(s16));
+		curSample += count;
+		i += count;
 	}
 
 	if (readp > origp) {
@@ -402,10 +422,14 @@ void SasInstance::ClearGrainSize() {
 	delete[] sendBuffer;
 	delete[] sendBufferDownsampled;
 	delete[] sendBufferProcessed;
+	delete[] groupMixBuffer_;
+	delete[] groupSendBuffer_;
 	mixBuffer = nullptr;
 	sendBuffer = nullptr;
 	sendBufferDownsampled = nullptr;
 	sendBufferProcessed = nullptr;
+	groupMixBuffer_ = nullptr;
+	groupSendBuffer_ = nullptr;
 }
 
 void SasInstance::SetGrainSize(int newGrainSize) {
@@ -416,11 +440,16 @@ void SasInstance::SetGrainSize(int newGrainSize) {
 	delete[] sendBuffer;
 	delete[] sendBufferDownsampled;
 	delete[] sendBufferProcessed;
+	delete[] groupMixBuffer_;
+	delete[] groupSendBuffer_;
 
 	mixBuffer = new s32[grainSize * 2];
 	sendBuffer = new s32[grainSize * 2];
 	sendBufferDownsampled = new s16[grainSize];
 	sendBufferProcessed = new s16[grainSize * 2];
+	// These are cleared by each group before mixing.
+	groupMixBuffer_ = new s32[grainSize * 2 * SAS_MAX_MIX_GROUPS];
+	groupSendBuffer_ = new s32[grainSize * 2 * SAS_MAX_MIX_GROUPS];
 	memset(mixBuffer, 0, sizeof(int) * grainSize * 2);
 	memset(sendBuffer, 0, sizeof(int) * grainSize * 2);
 	memset(sendBufferDownsampled, 0, sizeof(s16) * grainSize);
@@ -501,7 +530,90 @@ bool SasVoice::HaveSamplesEnded() const {
 	}
 }
 
-void SasInstance::MixVoice(SasVoice &voice) {
+void SasMixSamplesGeneric(int *mixBuffer, int *sendBuffer, const s16 *samples, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight) {
+	for (int i = 0; i < count; i++) {
+		// We just scale by the envelope before we scale by volumes.
+		// Again, we round up by adding (1 << 14) first (*after* multiplying.)
+		int sample = ((samples[i] * envelope[i]) + (1 << 14)) >> 15;
+
+		// We mix into this 32-bit temp buffer and clip in a second loop
+		// Ideally, the shift right should be there too but for now I'm concerned about
+		// not overflowing.
+		mixBuffer[i * 2] += (sample * volumeLeft) >> 12;
+		mixBuffer[i * 2 + 1] += (sample * volumeRight) >> 12;
+		sendBuffer[i * 2] += sample * effectLeft >> 12;
+		sendBuffer[i * 2 + 1] += sample * effectRight >> 12;
+	}
+}
+
+#ifdef _M_SSE
+// Adds the 32-bit products of four samples (each repeated for left and right) and volumes, shifted down.
+static inline void MixVolumeSSE2(int *dest, __m128i samplePairs, __m128i volumes) {
+	__m128i lo = _mm_mullo_epi16(samplePairs, volumes);
+	__m128i hi = _mm_mulhi_epi16(samplePairs, volumes);
+	__m128i dest0 = _mm_loadu_si128((const __m128i *)dest);
+	__m128i dest1 = _mm_loadu_si128((const __m128i *)(dest + 4));
+	dest0 = _mm_add_epi32(dest0, _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12));
+	dest1 = _mm_add_epi32(dest1, _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12));
+	_mm_storeu_si128((__m128i *)dest, dest0);
+	_mm_storeu_si128((__m128i *)(dest + 4), dest1);
+}
+#endif
+
+void SasMixSamples(int *mixBuffer, int *sendBuffer, const s16 *samples, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight) {
+	int i = 0;
+#ifdef _M_SSE
+	const __m128i volumes = _mm_setr_epi16(volumeLeft, volumeRight, volumeLeft, volumeRight, volumeLeft, volumeRight, volumeLeft, volumeRight);
+	const __m128i effects = _mm_setr_epi16(effectLeft, effectRight, effectLeft, effectRight, effectLeft, effectRight, effectLeft, effectRight);
+	const __m128i round = _mm_set1_epi32(1 << 14);
+	for (; i + 8 <= count; i += 8) {
+		__m128i sample = _mm_loadu_si128((const __m128i *)(samples + i));
+		__m128i env0 = _mm_loadu_si128((const __m128i *)(envelope + i));
+		__m128i env1 = _mm_loadu_si128((const __m128i *)(envelope + i + 4));
+
+		// The envelope can be 0x8000, which doesn't fit in 16 bits.  So we split it in two
+		// halves and let the multiply-add sum sample * half + sample * rest.
+		__m128i half0 = _mm_srai_epi32(env0, 1);
+		__m128i half1 = _mm_srai_epi32(env1, 1);
+		__m128i halves = _mm_packs_epi32(half0, half1);
+		__m128i rests = _mm_packs_epi32(_mm_sub_epi32(env0, half0), _mm_sub_epi32(env1, half1));
+		__m128i scaled0 = _mm_madd_epi16(_mm_unpacklo_epi16(sample, sample), _mm_unpacklo_epi16(halves, rests));
+		__m128i scaled1 = _mm_madd_epi16(_mm_unpackhi_epi16(sample, sample), _mm_unpackhi_epi16(halves, rests));
+		scaled0 = _mm_srai_epi32(_mm_add_epi32(scaled0, round), 15);
+		scaled1 = _mm_srai_epi32(_mm_add_epi32(scaled1, round), 15);
+
+		// With the envelope at most 0x8000, this always fits.
+		__m128i scaled = _mm_packs_epi32(scaled0, scaled1);
+		__m128i pairsLo = _mm_unpacklo_epi16(scaled, scaled);
+		__m128i pairsHi = _mm_unpackhi_epi16(scaled, scaled);
+		MixVolumeSSE2(mixBuffer + i * 2, pairsLo, volumes);
+		MixVolumeSSE2(mixBuffer + i * 2 + 8, pairsHi, volumes);
+		MixVolumeSSE2(sendBuffer + i * 2, pairsLo, effects);
+		MixVolumeSSE2(sendBuffer + i * 2 + 8, pairsHi, effects);
+	}
+#elif PPSSPP_ARCH(ARM_NEON)
+	const int32x4_t round = vdupq_n_s32(1 << 14);
+	for (; i + 4 <= count; i += 4) {
+		int32x4_t sample = vmovl_s16(vld1_s16(samples + i));
+		int32x4_t env = vld1q_s32(envelope + i);
+		int32x4_t scaled = vshrq_n_s32(vaddq_s32(vmulq_s32(sample, env), round), 15);
+
+		int32x4x2_t mix = vld2q_s32(mixBuffer + i * 2);
+		mix.val[0] = vaddq_s32(mix.val[0], vshrq_n_s32(vmulq_n_s32(scaled, volumeLeft), 12));
+		mix.val[1] = vaddq_s32(mix.val[1], vshrq_n_s32(vmulq_n_s32(scaled, volumeRight), 12));
+		vst2q_s32(mixBuffer + i * 2, mix);
+
+		int32x4x2_t send = vld2q_s32(sendBuffer + i * 2);
+		send.val[0] = vaddq_s32(send.val[0], vshrq_n_s32(vmulq_n_s32(scaled, effectLeft), 12));
+		send.val[1] = vaddq_s32(send.val[1], vshrq_n_s32(vmulq_n_s32(scaled, effectRight), 12));
+		vst2q_s32(sendBuffer + i * 2, send);
+	}
+#endif
+
+	SasMixSamplesGeneric(mixBuffer + i * 2, sendBuffer + i * 2, samples + i, envelope + i, count - i, volumeLeft, volumeRight, effectLeft, effectRight);
+}
+
+void SasInstance::MixVoice(SasVoice &voice, SasMixScratch &scratch, int *mixDest, int *sendDest) {
 	switch (voice.type) {
 	case VOICETYPE_VAG:
 		if (voice.type == VOICETYPE_VAG && !voice.vagAddr)
@@ -527,22 +639,22 @@ void SasInstance::MixVoice(SasVoice &voice) {
 		// TODO: Special case no-resample case (and 2x and 0.5x) for speed, it's not uncommon
 
 		// Two passes: First read, then resample.
-		mixTemp_[0] = voice.resampleHist[0];
-		mixTemp_[1] = voice.resampleHist[1];
+		scratch.mixTemp[0] = voice.resampleHist[0];
+		scratch.mixTemp[1] = voice.resampleHist[1];
 
 		int voicePitch = voice.pitch;
 		u32 sampleFrac = voice.sampleFrac;
 		int samplesToRead = (sampleFrac + voicePitch * std::max(0, grainSize - delay)) >> PSP_SAS_PITCH_BASE_SHIFT;
-		if (samplesToRead > ARRAY_SIZE(mixTemp_) - 2) {
+		if (samplesToRead > ARRAY_SIZE(scratch.mixTemp) - 2) {
 			ERROR_LOG(SCESAS, "Too many samples to read (%d)! This shouldn't happen.", samplesToRead);
-			samplesToRead = ARRAY_SIZE(mixTemp_) - 2;
+			samplesToRead = ARRAY_SIZE(scratch.mixTemp) - 2;
 		}
 		int readPos = 2;
 		if (voice.envelope.NeedsKeyOn()) {
 			readPos = 0;
 			samplesToRead += 2;
 		}
-		voice.ReadSamples(&mixTemp_[readPos], samplesToRead);
+		voice.ReadSamples(&scratch.mixTemp[readPos], samplesToRead);
 		int tempPos = readPos + samplesToRead;
 
 		for (int i = 0; i < delay; ++i) {
@@ -551,39 +663,38 @@ void SasInstance::MixVoice(SasVoice &voice) {
 			voice.envelope.Step();
 		}
 
+		// Resample first, then apply the envelope and volumes to the whole grain at once.
+		const int count = std::max(0, grainSize - delay);
 		const bool needsInterp = voicePitch != PSP_SAS_PITCH_BASE || (sampleFrac & PSP_SAS_PITCH_MASK) != 0;
-		for (int i = delay; i < grainSize; i++) {
-			const int16_t *s = mixTemp_ + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+		const s16 *samples = scratch.mixTemp + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
+		if (needsInterp) {
+			for (int i = 0; i < count; i++) {
+				const int16_t *s = scratch.mixTemp + (sampleFrac >> PSP_SAS_PITCH_BASE_SHIFT);
 
-			// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
-			int sample = s[0];
-			if (needsInterp) {
+				// Linear interpolation. Good enough. Need to make resampleHist bigger if we want more.
 				int f = sampleFrac & PSP_SAS_PITCH_MASK;
-				sample = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+				scratch.resampled[i] = (s[0] * (PSP_SAS_PITCH_MASK - f) + s[1] * f) >> PSP_SAS_PITCH_BASE_SHIFT;
+				sampleFrac += voicePitch;
 			}
-			sampleFrac += voicePitch;
+			samples = scratch.resampled;
+		} else {
+			// Already one sample per output sample, we can use them as is.
+			sampleFrac += voicePitch * count;
+		}
 
-			// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
-			// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
-			int envelopeValue = voice.envelope.GetHeight();
-			voice.envelope.Step();
-			envelopeValue = (envelopeValue + (1 << 14)) >> 15;
-
-			// We just scale by the envelope before we scale by volumes.
-			// Again, we round up by adding (1 << 14) first (*after* multiplying.)
-			sample = ((sample * envelopeValue) + (1 << 14)) >> 15;
-
-			// We mix into this 32-bit temp buffer and clip in a second loop
-			// Ideally, the shift right should be there too but for now I'm concerned about
-			// not overflowing.
-			mixBuffer[i * 2] += (sample * voice.volumeLeft) >> 12;
-			mixBuffer[i * 2 + 1] += (sample * voice.volumeRight) >> 12;
-			sendBuffer[i * 2] += sample * voice.effectLeft >> 12;
-			sendBuffer[i * 2 + 1] += sample * voice.effectRight >> 12;
+		// The maximum envelope height (PSP_SAS_ENVELOPE_HEIGHT_MAX) is (1 << 30) - 1.
+		// Reduce it to 14 bits, by shifting off 15.  Round up by adding (1 << 14) first.
+		bool envelopeInRange = voice.envelope.StepHeights(scratch.envelope, count);
+		mixDest += delay * 2;
+		sendDest += delay * 2;
+		if (envelopeInRange && abs(voice.volumeLeft) <= 0x7FFF && abs(voice.volumeRight) <= 0x7FFF && abs(voice.effectLeft) <= 0x7FFF && abs(voice.effectRight) <= 0x7FFF) {
+			SasMixSamples(mixDest, sendDest, samples, scratch.envelope, count, voice.volumeLeft, voice.volumeRight, voice.effectLeft, voice.effectRight);
+		} else {
+			SasMixSamplesGeneric(mixDest, sendDest, samples, scratch.envelope, count, voice.volumeLeft, voice.volumeRight, voice.effectLeft, voice.effectRight);
 		}
 
-		voice.resampleHist[0] = mixTemp_[tempPos - 2];
-		voice.resampleHist[1] = mixTemp_[tempPos - 1];
+		voice.resampleHist[0] = scratch.mixTemp[tempPos - 2];
+		voice.resampleHist[1] = scratch.mixTemp[tempPos - 1];
 
 		voice.sampleFrac = sampleFrac - (tempPos - 2) * PSP_SAS_PITCH_BASE;
 
@@ -597,12 +708,61 @@ void SasInstance::MixVoice(SasVoice &voice) {
 	}
 }
 
+void SasInstance::MixVoicesParallel(const int *voiceIndices, int count, int numGroups) {
+	const int grainSamples = grainSize * 2;
+	auto mixGroups = [&](int lower, int upper) {
+		for (int g = lower; g < upper; g++) {
+			int *groupMix = groupMixBuffer_ + g * grainSamples;
+			int *groupSend = groupSendBuffer_ + g * grainSamples;
+			memset(groupMix, 0, grainSamples * sizeof(int));
+			memset(groupSend, 0, grainSamples * sizeof(int));
+
+			// Contiguous runs of voices, so the groups are the same from grain to grain.
+			const int start = g * count / numGroups;
+			const int end = (g + 1) * count / numGroups;
+			for (int i = start; i < end; i++) {
+				MixVoice(voices[voiceIndices[i]], scratch_[1 + g], groupMix, groupSend);
+			}
+		}
+	};
+	ParallelRangeLoop(&g_threadManager, mixGroups, 0, numGroups, 1);
+
+	// Integer sums, so this matches mixing the voices one by one.
+	for (int g = 0; g < numGroups; g++) {
+		const int *groupMix = groupMixBuffer_ + g * grainSamples;
+		const int *groupSend = groupSendBuffer_ + g * grainSamples;
+		for (int i = 0; i < grainSamples; i++) {
+			mixBuffer[i] += groupMix[i];
+			sendBuffer[i] += groupSend[i];
+		}
+	}
+}
+
 void SasInstance::Mix(u32 outAddr, u32 inAddr, int leftVol, int rightVol) {
+	// ATRAC3 voices decode through sceAtrac, which isn't thread safe, so those stay on this thread.
+	int parallelVoices[PSP_SAS_VOICES_MAX];
+	int parallelCount = 0;
 	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
 		SasVoice &voice = voices[v];
 		if (!voice.playing || voice.paused)
 			continue;
-		MixVoice(voice);
+		if (voice.type == VOICETYPE_ATRAC3)
+			MixVoice(voice, scratch_[0], mixBuffer, sendBuffer);
+		else
+			parallelVoices[parallelCount++] = v;
+	}
+
+	int numGroups = 0;
+	if (allowParallelMix) {
+		numGroups = std::min(parallelCount / SAS_MIN_VOICES_PER_MIX_GROUP, (int)SAS_MAX_MIX_GROUPS);
+		numGroups = std::min(numGroups, g_threadManager.GetNumLooperThreads());
+	}
+	if (numGroups > 1) {
+		MixVoicesParallel(parallelVoices, parallelCount, numGroups);
+	} else {
+		for (int i = 0; i < parallelCount; i++) {
+			MixVoice(voices[parallelVoices[i]], scratch_[0], mixBuffer, sendBuffer);
+		}
 	}
 
 	// Then mix the send buffer in with the rest.
@@ -959,6 +1119,17 @@ inline void ADSREnvelope::Step() {
 	}
 }
 
+bool ADSREnvelope::StepHeights(int *heights, int count) {
+	bool inRange = true;
+	for (int i = 0; i < count; i++) {
+		int height = (GetHeight() + (1 << 14)) >> 15;
+		Step();
+		heights[i] = height;
+		inRange = inRange && height >= 0 && height <= 0x8000;
+	}
+	return inRange;
+}
+
 void ADSREnvelope::KeyOn() {
 	SetState(STATE_KEYON);
 }
@@ -40,6 +40,10 @@ enum {
 	PSP_SAS_VOL_MAX = 0x1000,
 	PSP_SAS_MAX_GRAIN = 2048,   // Matches the max value of the parameter to sceSasInit
 
+	// Voices can be mixed in up to this many groups at once, with at least this many voices each.
+	SAS_MAX_MIX_GROUPS = 4,
+	SAS_MIN_VOICES_PER_MIX_GROUP = 4,
+
 	PSP_SAS_ADSR_CURVE_MODE_LINEAR_INCREASE = 0,
 	PSP_SAS_ADSR_CURVE_MODE_LINEAR_DECREASE = 1,
 	PSP_SAS_ADSR_CURVE_MODE_LINEAR_BENT = 2,
@@ -164,6 +168,9 @@ class ADSREnvelope {
 	void End();
 
 	inline void Step();
+	// Steps count times, writing the height before each step rounded to 15 bits.
+	// Returns false if any were outside 0 - 0x8000, which the fast mixer can't handle.
+	bool StepHeights(int *heights, int count);
 
 	int GetHeight() const {
 		return (int)(height_ > (s64)PSP_SAS_ENVELOPE_HEIGHT_MAX ? PSP_SAS_ENVELOPE_HEIGHT_MAX : height_);
@@ -277,6 +284,20 @@ struct SasVoice {
 	SasAtrac3 atrac3;
 };
 
+// Scales samples by their envelope heights, then by volume into the interleaved mix and send buffers.
+// Envelope heights must be within 0 - 0x8000 and volumes within s16 range.
+void SasMixSamples(int *mixBuffer, int *sendBuffer, const s16 *samples, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight);
+// Scalar version of the above, which handles any values.
+void SasMixSamplesGeneric(int *mixBuffer, int *sendBuffer, const s16 *samples, const int *envelope, int count, int volumeLeft, int volumeRight, int effectLeft, int effectRight);
+
+// Temporary buffers for mixing one voice at a time.
+struct SasMixScratch {
+	int16_t mixTemp[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	// The current voice's samples resampled to pitch, and envelope heights, for the grain.
+	alignas(16) int16_t resampled[PSP_SAS_MAX_GRAIN];
+	alignas(16) int envelope[PSP_SAS_MAX_GRAIN];
+};
+
 class SasInstance {
 public:
 	SasInstance();
@@ -299,7 +320,7 @@ class SasInstance {
 	FILE *audioDump = nullptr;
 
 	void Mix(u32 outAddr, u32 inAddr = 0, int leftVol = 0, int rightVol = 0);
-	void MixVoice(SasVoice &voice);
+	void MixVoice(SasVoice &voice, SasMixScratch &scratch, int *mixDest, int *sendDest);
 
 	// Applies reverb to send buffer, according to waveformEffect.
 	void ApplyWaveformEffect();
@@ -312,9 +333,17 @@ class SasInstance {
 
 	SasVoice voices[PSP_SAS_VOICES_MAX];
 	WaveformEffect waveformEffect;
+	// Whether voices may be mixed in groups on the thread manager.  The result is the same either way.
+	bool allowParallelMix = true;
 
 private:
+	void MixVoicesParallel(const int *voiceIndices, int count, int numGroups);
+
 	SasReverb reverb_;
 	int grainSize = 0;
-	int16_t mixTemp_[PSP_SAS_MAX_GRAIN * 4 + 2 + 8];  // some extra margin for very high pitches.
+	// The first is for the calling thread, the rest for each mix group.
+	SasMixScratch scratch_[1 + SAS_MAX_MIX_GROUPS];
+	// Partial mixes for each group, grainSize * 2 each.  Summed into mixBuffer and sendBuffer.
+	int *groupMixBuffer_ = nullptr;
+	int *groupSendBuffer_ = nullptr;
 };
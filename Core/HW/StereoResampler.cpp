@@ -32,13 +32,19 @@
 #define CONTROL_FACTOR  0.2f // in freq_shift per fifo size offset
 #define CONTROL_AVG     32.0f
 
+// Fraction of the lower Nyquist frequency the sinc filter passes.
+#define SINC_PASSBAND   0.9
+#define SINC_KAISER_BETA 8.0
+
 #include "ppsspp_config.h"
+#include <cmath>
 #include <cstring>
 #include <atomic>
 
 #include "Common/Common.h"
 #include "Common/System/System.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Log.h"
 #include "Common/TimeUtil.h"
@@ -64,7 +70,8 @@ StereoResampler::StereoResampler()
 		: m_maxBufsize(MAX_BUFSIZE_DEFAULT)
 	  , m_targetBufsize(TARGET_BUFSIZE_DEFAULT) {
 	// Need to have space for the worst case in case it changes.
-	m_buffer = new int16_t[MAX_BUFSIZE_EXTRA * 2]();
+	// The start of the buffer is mirrored after the end, so the sinc filter can read past it.
+	m_buffer = new int16_t[MAX_BUFSIZE_EXTRA * 2 + SincResampleFilter::TAPS * 2]();
 
 	// Some Android devices are v-synced to non-60Hz framerates. We simply timestretch audio to fit.
 	// TODO: should only do this if auto frameskip is off?
@@ -161,17 +168,170 @@ inline void ClampBufferToS16WithVolume(s16 *out, const s32 *in, size_t size) {
 }
 
 void StereoResampler::Clear() {
-	memset(m_buffer, 0, m_maxBufsize * 2 * sizeof(int16_t));
+	memset(m_buffer, 0, (m_maxBufsize * 2 + SincResampleFilter::TAPS * 2) * sizeof(int16_t));
+}
+
+// Zeroth order modified Bessel function of the first kind, for the Kaiser window.
+static double BesselI0(double x) {
+	double sum = 1.0;
+	double term = 1.0;
+	for (int k = 1; k < 32; ++k) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12)
+			break;
+	}
+	return sum;
+}
+
+void SincResampleFilter::Build(double cutoff) {
+	if (cutoff == cutoff_)
+		return;
+	cutoff_ = cutoff;
+
+	const int halfTaps = TAPS / 2;
+	const double windowScale = 1.0 / BesselI0(SINC_KAISER_BETA);
+	for (int phase = 0; phase <= PHASES; ++phase) {
+		double h[TAPS];
+		double sum = 0.0;
+		for (int t = 0; t < TAPS; ++t) {
+			// Distance from the output position, in input frames.
+			double d = (double)(t - (halfTaps - 1)) - (double)phase / PHASES;
+			double x = M_PI * cutoff * d;
+			double sinc = x == 0.0 ? 1.0 : sin(x) / x;
+			double r = d / halfTaps;
+			double window = r * r >= 1.0 ? 0.0 : BesselI0(SINC_KAISER_BETA * sqrt(1.0 - r * r)) * windowScale;
+			h[t] = sinc * window;
+			sum += h[t];
+		}
+
+		// Normalize to unity gain, and round the running total so the coefficients sum to exactly 1.0.
+		s16 *coefs = coefs_ + phase * TAPS;
+		double total = 0.0;
+		int rounded = 0;
+		for (int t = 0; t < TAPS; ++t) {
+			total += h[t] / sum * 32768.0;
+			int next = (int)floor(total + 0.5);
+			coefs[t] = (s16)std::min(next - rounded, 32767);
+			rounded = next;
+		}
+	}
+}
+
+void SincResampleFilter::Sample(const s16 *in, u32 frac, s16 *out) const {
+	// Round to the nearest phase, which might be the first phase of the next frame.
+	const u32 phase = (frac + (1 << (15 - PHASE_BITS))) >> (16 - PHASE_BITS);
+	const s16 *coefs = coefs_ + phase * TAPS;
+
+#ifdef _M_SSE
+	__m128i acc = _mm_setzero_si128();
+	for (int t = 0; t < TAPS; t += 8) {
+		__m128i c = _mm_load_si128((const __m128i *)(coefs + t));
+		// c0 c1 c0 c1 c2 c3 c2 c3, and the same for c4 - c7.
+		__m128i c0 = _mm_unpacklo_epi32(c, c);
+		__m128i c1 = _mm_unpackhi_epi32(c, c);
+		// Swap to L0 L1 R0 R1 L2 L3 R2 R3, so the multiply-add sums pairs of taps per channel.
+		__m128i s0 = _mm_loadu_si128((const __m128i *)(in + t * 2));
+		__m128i s1 = _mm_loadu_si128((const __m128i *)(in + t * 2 + 8));
+		s0 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s0, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		s1 = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s1, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s0, c0));
+		acc = _mm_add_epi32(acc, _mm_madd_epi16(s1, c1));
+	}
+	// Now L R L R, add the halves and round.
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_srai_epi32(_mm_add_epi32(acc, _mm_set1_epi32(1 << 14)), 15);
+	u32 packed = (u32)_mm_cvtsi128_si32(_mm_packs_epi32(acc, acc));
+	memcpy(out, &packed, sizeof(packed));
+#elif PPSSPP_ARCH(ARM_NEON)
+	int32x4_t accL = vdupq_n_s32(0);
+	int32x4_t accR = vdupq_n_s32(0);
+	for (int t = 0; t < TAPS; t += 8) {
+		int16x8_t c = vld1q_s16(coefs + t);
+		int16x8x2_t s = vld2q_s16(in + t * 2);
+		accL = vmlal_s16(accL, vget_low_s16(s.val[0]), vget_low_s16(c));
+		accL = vmlal_s16(accL, vget_high_s16(s.val[0]), vget_high_s16(c));
+		accR = vmlal_s16(accR, vget_low_s16(s.val[1]), vget_low_s16(c));
+		accR = vmlal_s16(accR, vget_high_s16(s.val[1]), vget_high_s16(c));
+	}
+	int32x2_t sumL = vadd_s32(vget_low_s32(accL), vget_high_s32(accL));
+	int32x2_t sumR = vadd_s32(vget_low_s32(accR), vget_high_s32(accR));
+	int32x2_t sum = vpadd_s32(sumL, sumR);
+	int16x4_t result = vqrshrn_n_s32(vcombine_s32(sum, sum), 15);
+	out[0] = vget_lane_s16(result, 0);
+	out[1] = vget_lane_s16(result, 1);
+#else
+	int sumL = 0;
+	int sumR = 0;
+	for (int t = 0; t < TAPS; ++t) {
+		sumL += in[t * 2] * coefs[t];
+		sumR += in[t * 2 + 1] * coefs[t];
+	}
+	out[0] = clamp_s16((sumL + (1 << 14)) >> 15);
+	out[1] = clamp_s16((sumR + (1 << 14)) >> 15);
+#endif
 }
 
 inline int16_t MixSingleSample(int16_t s1, int16_t s2, uint16_t frac) {
 	return s1 + (((s2 - s1) * frac) >> 16);
 }
 
+unsigned int StereoResampler::ResampleLinear(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 ratio) {
+	const int INDEX_MASK = (m_maxBufsize * 2 - 1);
+	unsigned int currentSample;
+	u32 frac = m_frac;
+	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+		if (((indexW - indexR) & INDEX_MASK) <= 2) {
+			// Ran out!
+			// int missing = numSamples * 2 - currentSample;
+			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
+			underrunCount_++;
+			break;
+		}
+		u32 indexR2 = indexR + 2; //next sample
+		s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
+		s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
+		s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
+		s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
+		samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
+		samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
+		frac += ratio;
+		indexR += 2 * (frac >> 16);
+		frac &= 0xffff;
+	}
+	m_frac = frac;
+	return currentSample;
+}
+
+unsigned int StereoResampler::ResampleSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 ratio, int sampleRate) {
+	// When downsampling, we need to cut off at the output's Nyquist frequency instead.
+	sincFilter_.Build(std::min(1.0, (double)sampleRate / (double)m_input_sample_rate) * SINC_PASSBAND);
+
+	const int INDEX_MASK = (m_maxBufsize * 2 - 1);
+	const u32 HISTORY = (SincResampleFilter::TAPS / 2 - 1) * 2;
+	const u32 LOOKAHEAD = (SincResampleFilter::TAPS / 2) * 2;
+	unsigned int currentSample;
+	u32 frac = m_frac;
+	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
+		if (((indexW - indexR) & INDEX_MASK) <= LOOKAHEAD) {
+			underrunCount_++;
+			break;
+		}
+		// Might run past the end into the mirrored start of the buffer.
+		sincFilter_.Sample(&m_buffer[(indexR - HISTORY) & INDEX_MASK], frac, &samples[currentSample]);
+		frac += ratio;
+		indexR += 2 * (frac >> 16);
+		frac &= 0xffff;
+	}
+	m_frac = frac;
+	return currentSample;
+}
+
 // Executed from sound stream thread, pulling sound out of the buffer.
 unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool consider_framelimit, int sample_rate) {
 	if (!samples)
 		return 0;
+	PROFILE_THIS_SCOPE("resample");
 
 	unsigned int currentSample;
 
@@ -213,29 +373,12 @@ unsigned int StereoResampler::Mix(short* samples, unsigned int numSamples, bool
 	output_sample_rate_ = (float)(m_input_sample_rate + offset);
 	const u32 ratio = (u32)(65536.0 * output_sample_rate_ / (double)sample_rate);
 	ratio_ = ratio;
-	// TODO: consider a higher-quality resampling algorithm.
 	// TODO: Add a fast path for 1:1.
-	u32 frac = m_frac;
-	for (currentSample = 0; currentSample < numSamples * 2; currentSample += 2) {
-		if (((indexW - indexR) & INDEX_MASK) <= 2) {
-			// Ran out!
-			// int missing = numSamples * 2 - currentSample;
-			// ILOG("Resampler underrun: %d (numSamples: %d, currentSample: %d)", missing, numSamples, currentSample / 2);
-			underrunCount_++;
-			break;
-		}
-		u32 indexR2 = indexR + 2; //next sample
-		s16 l1 = m_buffer[indexR & INDEX_MASK]; //current
-		s16 r1 = m_buffer[(indexR + 1) & INDEX_MASK]; //current
-		s16 l2 = m_buffer[indexR2 & INDEX_MASK]; //next
-		s16 r2 = m_buffer[(indexR2 + 1) & INDEX_MASK]; //next
-		samples[currentSample] = MixSingleSample(l1, l2, (u16)frac);
-		samples[currentSample + 1] = MixSingleSample(r1, r2, (u16)frac);
-		frac += ratio;
-		indexR += 2 * (frac >> 16);
-		frac &= 0xffff;
+	if (g_Config.iAudioResampler == AUDIO_RESAMPLER_SINC) {
+		currentSample = ResampleSinc(samples, numSamples, indexR, indexW, ratio, sample_rate);
+	} else {
+		currentSample = ResampleLinear(samples, numSamples, indexR, indexW, ratio);
 	}
-	m_frac = frac;
 
 	// Let's not count the underrun padding here.
 	outputSampleCount_ += currentSample / 2;
@@ -272,6 +415,10 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	if (PSP_CoreParameter().fastForward) {
 		cap = m_targetBufsize * 2;
 	}
+	// The sinc filter still reads a few frames behind the read position.
+	if (g_Config.iAudioResampler == AUDIO_RESAMPLER_SINC) {
+		cap -= SincResampleFilter::TAPS * 2;
+	}
 
 	// Check if we have enough free space
 	// indexW == m_indexR results in empty buffer, so indexR must always be smaller than indexW
@@ -291,6 +438,7 @@ void StereoResampler::PushSamples(const s32 *samples, unsigned int numSamples) {
 	} else {
 		ClampBufferToS16WithVolume(&m_buffer[indexW & INDEX_MASK], samples, numSamples * 2);
 	}
+	memcpy(&m_buffer[m_maxBufsize * 2], &m_buffer[0], SincResampleFilter::TAPS * 2 * sizeof(int16_t));
 
 	m_indexW += numSamples * 2;
 	lastPushSize_ = numSamples;
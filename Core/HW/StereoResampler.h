@@ -27,6 +27,27 @@
 
 struct AudioDebugStats;
 
+// Polyphase windowed sinc filter for interleaved stereo 16-bit audio.
+class SincResampleFilter {
+public:
+	enum {
+		TAPS = 16,
+		PHASE_BITS = 10,
+		PHASES = 1 << PHASE_BITS,
+	};
+
+	// The cutoff is relative to the input Nyquist frequency.
+	void Build(double cutoff);
+
+	// Reads TAPS frames from in, and writes the frame at frac (16 bits) after the frame at in + (TAPS / 2 - 1) * 2.
+	void Sample(const s16 *in, u32 frac, s16 *out) const;
+
+private:
+	double cutoff_ = 0.0;
+	// One extra phase, for fractions that round up to the next frame.
+	alignas(16) s16 coefs_[(PHASES + 1) * TAPS];
+};
+
 class StereoResampler {
 public:
 	StereoResampler();
@@ -46,16 +67,24 @@ class StereoResampler {
 	void GetAudioDebugStats(char *buf, size_t bufSize);
 	void ResetStatCounters();
 
+	// Totals since the last ResetStatCounters(), including any not yet reported in the debug stats.
+	int UnderrunCount() const { return underrunCountTotal_ + underrunCount_; }
+	int OverrunCount() const { return overrunCountTotal_ + overrunCount_; }
+	// Input frames per output frame, as last mixed.
+	float Ratio() const { return (float)ratio_ / 65536.0f; }
+
 private:
 	void UpdateBufferSize();
+	unsigned int ResampleLinear(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 ratio);
+	unsigned int ResampleSinc(short *samples, unsigned int numSamples, u32 &indexR, u32 indexW, u32 ratio, int sampleRate);
 
 	int m_maxBufsize;
 	int m_targetBufsize;
 
 	unsigned int m_input_sample_rate = 44100;
 	int16_t *m_buffer;
-	std::atomic<u32> m_indexW;
-	std::atomic<u32> m_indexR;
+	std::atomic<u32> m_indexW{};
+	std::atomic<u32> m_indexR{};
 	float m_numLeftI = 0.0f;
 
 	u32 m_frac = 0;
@@ -71,6 +100,8 @@ class StereoResampler {
 
 	int droppedSamples_ = 0;
 
+	SincResampleFilter sincFilter_;
+
 	int64_t inputSampleCount_ = 0;
 	int64_t outputSampleCount_ = 0;
 
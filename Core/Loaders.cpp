@@ -166,6 +166,9 @@ IdentifiedFileType Identify_File(FileLoader *fileLoader, std::string *errorStrin
 		// CISO are not used for many other kinds of ISO so let's just guess it's a PSP one and let it
 		// fail later...
 		return IdentifiedFileType::PSP_ISO;
+	} else if (!memcmp(&_id, "\x28\xB5\x2F\xFD", 4)) {
+		// Same for zstd, we only support seekable disc images.
+		return IdentifiedFileType::PSP_ISO;
 	}
 
 	if (id == 'FLE\x7F') {
@@ -83,6 +83,9 @@ class FileLoader {
 		return ReadAt(absolutePos, 1, bytes, data, flags);
 	}
 
+	// Hint that this range will likely be read soon.  Loaders that can read ahead may start on it.
+	virtual void Prefetch(s64 absolutePos, size_t bytes) {}
+
 	// Cancel any operations that might block, if possible.
 	virtual void Cancel() {}
 
@@ -117,6 +120,9 @@ class ProxiedFileLoader : public FileLoader {
 	Path GetPath() const override {
 		return backend_->GetPath();
 	}
+	void Prefetch(s64 absolutePos, size_t bytes) override {
+		backend_->Prefetch(absolutePos, bytes);
+	}
 	void Cancel() override {
 		backend_->Cancel();
 	}
@@ -221,7 +221,7 @@ MIPSOpcode IRFrontend::GetOffsetInstruction(int offset) {
 	return Memory::Read_Instruction(GetCompilerPC() + 4 * offset);
 }
 
-void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
+void IRFrontend::CompileToIR(u32 em_address, bool preload) {
 	js.cancel = false;
 	js.preloading = preload;
 	js.blockStart = em_address;
@@ -248,6 +248,10 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 		js.compilerPC += 4;
 		js.numInstructions++;
 	}
+}
+
+void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload) {
+	CompileToIR(em_address, preload);
 
 	if (js.cancel) {
 		// Clear the instructions to signal this was not compiled.
@@ -255,10 +259,70 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 	}
 
 	mipsBytes = js.compilerPC - em_address;
+	FinishIR(ir, !js.hadBreakpoints, &em_address, &mipsBytes, 1, instructions);
+}
+
+static IROp InvertExitCondition(IROp op) {
+	switch (op) {
+	case IROp::ExitToConstIfEq: return IROp::ExitToConstIfNeq;
+	case IROp::ExitToConstIfNeq: return IROp::ExitToConstIfEq;
+	case IROp::ExitToConstIfGtZ: return IROp::ExitToConstIfLeZ;
+	case IROp::ExitToConstIfGeZ: return IROp::ExitToConstIfLtZ;
+	case IROp::ExitToConstIfLtZ: return IROp::ExitToConstIfGeZ;
+	case IROp::ExitToConstIfLeZ: return IROp::ExitToConstIfGtZ;
+	default: return IROp::Nop;
+	}
+}
+
+// Rewrites the end of a block so that it continues into nextAddr, instead of exiting to it.
+static bool FallThroughTo(std::vector<IRInst> &insts, u32 nextAddr) {
+	size_t n = insts.size();
+	if (n == 0 || insts[n - 1].op != IROp::ExitToConst)
+		return false;
+	if (insts[n - 1].constant == nextAddr) {
+		insts.pop_back();
+		return true;
+	}
+
+	// If the not taken side of the final branch is the hot one, flip the condition.
+	// Only when nothing (like a likely delay slot) runs between the two exits.
+	if (n >= 2 && insts[n - 2].constant == nextAddr) {
+		IROp inverted = InvertExitCondition(insts[n - 2].op);
+		if (inverted != IROp::Nop) {
+			insts[n - 2].op = inverted;
+			insts[n - 2].constant = insts[n - 1].constant;
+			insts.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool IRFrontend::DoJitTrace(const std::vector<u32> &addresses, std::vector<IRInst> &instructions, std::vector<u32> &mipsBytes) {
+	IRWriter trace;
+	mipsBytes.clear();
+
+	for (size_t i = 0; i < addresses.size(); ++i) {
+		CompileToIR(addresses[i], false);
+		if (js.cancel || js.hadBreakpoints || ir.GetInstructions().empty())
+			return false;
+		mipsBytes.push_back(js.compilerPC - addresses[i]);
+
+		std::vector<IRInst> insts = ir.GetInstructions();
+		if (i + 1 < addresses.size() && !FallThroughTo(insts, addresses[i + 1]))
+			return false;
+		for (const IRInst &inst : insts)
+			trace.Write(inst);
+	}
+
+	FinishIR(trace, true, addresses.data(), mipsBytes.data(), (int)addresses.size(), instructions);
+	return true;
+}
 
+void IRFrontend::FinishIR(const IRWriter &raw, bool optimize, const u32 *addresses, const u32 *mipsBytes, int count, std::vector<IRInst> &instructions) {
 	IRWriter simplified;
-	IRWriter *code = &ir;
-	if (!js.hadBreakpoints) {
+	const IRWriter *code = &raw;
+	if (optimize) {
 		static const IRPassFunc passes[] = {
 			&ApplyMemoryValidation,
 			&RemoveLoadStoreLeftRight,
@@ -269,10 +333,10 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 			// &MergeLoadStore,
 			// &ThreeOpToTwoOp,
 		};
-		if (IRApplyPasses(passes, ARRAY_SIZE(passes), ir, simplified, opts))
+		if (IRApplyPasses(passes, ARRAY_SIZE(passes), raw, simplified, opts))
 			logBlocks = 1;
 		code = &simplified;
-		//if (ir.GetInstructions().size() >= 24)
+		//if (raw.GetInstructions().size() >= 24)
 		//	logBlocks = 1;
 	}
 
@@ -280,19 +344,21 @@ void IRFrontend::DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &m
 
 	if (logBlocks > 0 && dontLogBlocks == 0) {
 		char temp2[256];
-		NOTICE_LOG(JIT, "=============== mips %08x ===============", em_address);
-		for (u32 cpc = em_address; cpc != GetCompilerPC(); cpc += 4) {
-			temp2[0] = 0;
-			MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
-			NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
+		for (int i = 0; i < count; ++i) {
+			NOTICE_LOG(JIT, "=============== mips %08x ===============", addresses[i]);
+			for (u32 cpc = addresses[i]; cpc != addresses[i] + mipsBytes[i]; cpc += 4) {
+				temp2[0] = 0;
+				MIPSDisAsm(Memory::Read_Opcode_JIT(cpc), cpc, temp2, true);
+				NOTICE_LOG(JIT, "M: %08x   %s", cpc, temp2);
+			}
 		}
 	}
 
 	if (logBlocks > 0 && dontLogBlocks == 0) {
-		NOTICE_LOG(JIT, "=============== Original IR (%d instructions) ===============", (int)ir.GetInstructions().size());
-		for (size_t i = 0; i < ir.GetInstructions().size(); i++) {
+		NOTICE_LOG(JIT, "=============== Original IR (%d instructions) ===============", (int)raw.GetInstructions().size());
+		for (size_t i = 0; i < raw.GetInstructions().size(); i++) {
 			char buf[256];
-			DisassembleIR(buf, sizeof(buf), ir.GetInstructions()[i]);
+			DisassembleIR(buf, sizeof(buf), raw.GetInstructions()[i]);
 			NOTICE_LOG(JIT, "%s", buf);
 		}
 		NOTICE_LOG(JIT, "===============        end         =================");
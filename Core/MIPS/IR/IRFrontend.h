@@ -87,8 +87,19 @@ class IRFrontend : public MIPSFrontendInterface {
 	int Replace_fabsf() override;
 	void DoState(PointerWrap &p);
 	bool CheckRounding(u32 blockAddress);  // returns true if we need a do-over
+	bool UsesRounding() const {
+		return js.hasSetRounding != 0;
+	}
+	// For when blocks built with rounding checks are loaded from elsewhere.
+	void AssumeRounding() {
+		js.hasSetRounding = 1;
+		js.lastSetRounding = 1;
+	}
 
 	void DoJit(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
+	// Compiles a superblock from several blocks.  Each block must end by exiting to the next,
+	// either directly or through its final branch.  Returns false if they can't be joined.
+	bool DoJitTrace(const std::vector<u32> &addresses, std::vector<IRInst> &instructions, std::vector<u32> &mipsBytes);
 
 	void EatPrefix() override {
 		js.EatPrefix();
@@ -99,6 +110,9 @@ class IRFrontend : public MIPSFrontendInterface {
 	}
 
 private:
+	void CompileToIR(u32 em_address, bool preload);
+	void FinishIR(const IRWriter &raw, bool optimize, const u32 *addresses, const u32 *mipsBytes, int count, std::vector<IRInst> &instructions);
+
 	void RestoreRoundingMode(bool force = false);
 	void ApplyRoundingMode(bool force = false);
 	void UpdateRoundingMode();
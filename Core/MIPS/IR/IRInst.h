@@ -306,6 +306,7 @@ enum {
 	// Hacky way to get to other state
 	IRREG_VFPU_CTRL_BASE = 208,
 	IRREG_VFPU_CC = 211,
+	IRREG_PC = 241,
 	IRREG_LO = 242,  // offset of lo in MIPSState / 4
 	IRREG_HI = 243,
 	IRREG_FCR31 = 244,
@@ -31,6 +31,7 @@
 #include "Core/MIPS/MIPSVFPUUtils.h"
 #include "Core/MIPS/IR/IRInst.h"
 #include "Core/MIPS/IR/IRInterpreter.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
 #include "Core/System.h"
 
 #ifdef mips
@@ -1058,3 +1059,14 @@ u32 IRInterpret(MIPSState *mips, const IRInst *inst, int count) {
 	Crash();
 	return 0;
 }
+
+u32 MIPSComp::IRNativeFallback(MIPSState *mips, u64 instBits) {
+	IRInst inst[2];
+	memcpy(&inst[0], &instBits, sizeof(IRInst));
+	inst[1].op = IROp::ExitToConst;
+	inst[1].dest = 0;
+	inst[1].src1 = 0;
+	inst[1].src2 = 0;
+	inst[1].constant = IRNATIVE_FALLBACK_CONTINUE;
+	return IRInterpret(mips, inst, 2);
+}
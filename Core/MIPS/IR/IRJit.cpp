@@ -15,11 +15,14 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include <algorithm>
+#include <cstring>
 #include <set>
 
 #include "ext/xxhash.h"
 #include "Common/Profiler/Profiler.h"
 
+#include "Common/File/FileUtil.h"
 #include "Common/Log.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/StringUtils.h"
@@ -27,6 +30,7 @@
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
+#include "Core/ELF/ParamSFO.h"
 #include "Core/HLE/sceKernelMemory.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPS.h"
@@ -39,9 +43,78 @@
 #include "Core/MIPS/IR/IRInterpreter.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/Reporting.h"
+#include "Core/System.h"
 
 namespace MIPSComp {
 
+#define IRCACHE_HEADER_MAGIC 0x43425249
+// Bump whenever the file format changes.  Changes to the IR or frontend are caught by buildHash.
+#define IRCACHE_VERSION 2
+
+enum class IRCacheFlags {
+	ROUNDING = 1,
+};
+
+struct IRCacheHeader {
+	u32 magic;
+	u32 version;
+	u32 instSize;
+	u32 reserved;
+	// Different builds may generate different IR for the same code, even with the same IR ops.
+	u64 buildHash;
+	u32 disableFlags;
+	u32 flags;
+	u32 numModules;
+};
+
+struct IRCacheModuleHeader {
+	u32 moduleHash;
+	u32 textStart;
+	u32 textEnd;
+	u32 numBlocks;
+};
+
+struct IRCacheBlockHeader {
+	u32 address;
+	u32 size;
+	u64 hash;
+	u32 numInstructions;
+	u32 reserved;
+};
+
+static u64 HashOriginalCode(u32 addr, u32 size) {
+	// This is unfortunate.  In case of emuhacks, we have to make a copy.
+	std::vector<u32> buffer;
+	buffer.resize(size / 4);
+	size_t pos = 0;
+	for (u32 off = 0; off < size; off += 4) {
+		// Let's actually hash the replacement, if any.
+		MIPSOpcode instr = Memory::ReadUnchecked_Instruction(addr + off, false);
+		buffer[pos++] = instr.encoding;
+	}
+
+	return XXH3_64bits(&buffer[0], size);
+}
+
+static u64 IRCacheBuildHash() {
+	XXH3_state_t *state = XXH3_createState();
+	XXH3_64bits_reset(state);
+	XXH3_64bits_update(state, PPSSPP_GIT_VERSION, strlen(PPSSPP_GIT_VERSION));
+	// Catches local builds with changed ops, which still have the same version.
+	for (int i = 0; i < 256; ++i) {
+		const IRMeta *meta = GetIRMeta((IROp)i);
+		if (!meta)
+			continue;
+		XXH3_64bits_update(state, &meta->op, sizeof(meta->op));
+		XXH3_64bits_update(state, meta->name, strlen(meta->name));
+		XXH3_64bits_update(state, meta->types, strnlen(meta->types, sizeof(meta->types)));
+		XXH3_64bits_update(state, &meta->flags, sizeof(meta->flags));
+	}
+	u64 hash = XXH3_64bits_digest(state);
+	XXH3_freeState(state);
+	return hash;
+}
+
 IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), mips_(mipsState) {
 	// u32 size = 128 * 1024;
 	// blTrampolines_ = kernelMemory.Alloc(size, true, "trampoline");
@@ -51,9 +124,16 @@ IRJit::IRJit(MIPSState *mipsState) : frontend_(mipsState->HasDefaultPrefix()), m
 	opts.disableFlags = g_Config.uJitDisableFlags;
 	opts.unalignedLoadStore = (opts.disableFlags & (uint32_t)JitDisable::LSU_UNALIGNED) == 0;
 	frontend_.SetOptions(opts);
+	useSuperblocks_ = (opts.disableFlags & (uint32_t)JitDisable::SUPERBLOCKS) == 0;
 }
 
 IRJit::~IRJit() {
+	FlushDiskCache();
+}
+
+void IRJit::FlushDiskCache() {
+	if (diskCacheDirty_)
+		SaveDiskCache();
 }
 
 void IRJit::DoState(PointerWrap &p) {
@@ -75,7 +155,7 @@ void IRJit::InvalidateCacheAt(u32 em_address, int length) {
 void IRJit::Compile(u32 em_address) {
 	PROFILE_THIS_SCOPE("jitc");
 
-	if (g_Config.bPreloadFunctions) {
+	if (g_Config.bPreloadFunctions || g_Config.bIRBlockCache) {
 		// Look to see if we've preloaded this block.
 		int block_num = blocks_.FindPreloadBlock(em_address);
 		if (block_num != -1) {
@@ -101,6 +181,9 @@ void IRJit::Compile(u32 em_address) {
 	if (frontend_.CheckRounding(em_address)) {
 		// Our assumptions are all wrong so it's clean-slate time.
 		ClearCache();
+		// That goes for what we were going to save, too.
+		for (auto &it : diskCache_)
+			it.second.blocks.clear();
 		CompileBlock(em_address, instructions, mipsBytes, false);
 	}
 }
@@ -122,9 +205,14 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	IRBlock *b = blocks_.GetBlock(block_num);
 	b->SetInstructions(instructions);
 	b->SetOriginalSize(mipsBytes);
-	if (preload) {
-		// Hash, then only update page stats, don't link yet.
+	if (preload || g_Config.bIRBlockCache) {
 		b->UpdateHash();
+	}
+	if (g_Config.bIRBlockCache) {
+		AddToDiskCache(b);
+	}
+	if (preload) {
+		// Already hashed, only update page stats, don't link yet.
 		blocks_.FinalizeBlock(block_num, true);
 	} else {
 		// Overwrites the first instruction, and also updates stats.
@@ -135,6 +223,254 @@ bool IRJit::CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32
 	return true;
 }
 
+void IRJit::FormSuperblock(int blockNum) {
+	IRBlock *head = blocks_.GetBlock(blockNum);
+	if (!head->IsValid() || head->IsTrace())
+		return;
+
+	u32 start, size;
+	head->GetRange(start, size);
+
+	// Follow the hot exits, as long as they lead to plain blocks we haven't visited yet.
+	std::vector<u32> addresses;
+	addresses.push_back(start);
+	IRBlock *last = head;
+	while ((int)addresses.size() < IRSUPERBLOCK_MAX_BLOCKS) {
+		u32 next = last->GetHotExit(last == head ? IRSUPERBLOCK_HOT_EXIT_COUNT : IRSUPERBLOCK_FOLLOW_EXIT_COUNT);
+		if (next == 0 || (next & 3) != 0 || !Memory::IsValidAddress(next))
+			break;
+		if (std::find(addresses.begin(), addresses.end(), next) != addresses.end())
+			break;
+		u32 inst = Memory::ReadUnchecked_U32(next);
+		if (!MIPS_IS_RUNBLOCK(inst))
+			break;
+		IRBlock *nextBlock = blocks_.GetBlock(inst & MIPS_EMUHACK_VALUE_MASK);
+		if (!nextBlock || !nextBlock->IsValid() || nextBlock->IsTrace())
+			break;
+		addresses.push_back(next);
+		last = nextBlock;
+	}
+	if (addresses.size() < 2)
+		return;
+
+	std::vector<IRInst> instructions;
+	std::vector<u32> mipsBytes;
+	if (!frontend_.DoJitTrace(addresses, instructions, mipsBytes) || instructions.size() > 0xFFFF)
+		return;
+	if (frontend_.CheckRounding(start)) {
+		// Same as in Compile(), the existing blocks were built with the wrong assumptions.
+		ClearCache();
+		for (auto &it : diskCache_)
+			it.second.blocks.clear();
+		return;
+	}
+
+	int traceNum = blocks_.AllocateBlock(start);
+	if ((traceNum & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+		// Out of block numbers, the next Compile() will clear.
+		return;
+	}
+
+	// Replace the first block with the superblock.  The others stay for other paths.
+	blocks_.GetBlock(blockNum)->Destroy(blockNum);
+	IRBlock *b = blocks_.GetBlock(traceNum);
+	b->SetInstructions(instructions);
+	b->SetOriginalSize(mipsBytes[0]);
+	b->SetTraceRanges(addresses, mipsBytes);
+	blocks_.FinalizeBlock(traceNum);
+}
+
+void IRJit::PreloadModuleBlocks(u32 moduleHash, u32 textStart, u32 textEnd) {
+	if (!g_Config.bIRBlockCache)
+		return;
+
+	if (diskCachePath_.empty()) {
+		std::string discID = g_paramSFO.GetDiscID();
+		if (discID.empty())
+			return;
+		File::CreateFullPath(GetSysDirectory(DIRECTORY_APP_CACHE));
+		diskCachePath_ = GetSysDirectory(DIRECTORY_APP_CACHE) / (discID + ".irblockcache");
+		LoadDiskCache();
+	}
+
+	// Anything that was loaded in the same place before must be gone now.
+	for (auto &it : diskCache_) {
+		if (it.second.textStart <= textEnd && it.second.textEnd >= textStart)
+			it.second.active = false;
+	}
+
+	DiskCacheModule &module = diskCache_[moduleHash];
+	if (module.textStart != textStart || module.textEnd != textEnd) {
+		// Relocated differently (or new), so none of the old blocks would match.
+		module.blocks.clear();
+		module.textStart = textStart;
+		module.textEnd = textEnd;
+		diskCacheDirty_ = true;
+	}
+	module.active = true;
+
+	int count = 0;
+	for (const auto &it : module.blocks) {
+		u32 start = it.first;
+		const DiskCacheBlock &cached = it.second;
+		if (!Memory::IsValidRange(start, cached.size) || MIPS_IS_RUNBLOCK(Memory::ReadUnchecked_U32(start)))
+			continue;
+		if (blocks_.FindPreloadBlock(start) != -1 || HashOriginalCode(start, cached.size) != cached.hash)
+			continue;
+
+		int block_num = blocks_.AllocateBlock(start);
+		if ((block_num & ~MIPS_EMUHACK_VALUE_MASK) != 0) {
+			// Out of block numbers, Compile() will clear when it notices.
+			break;
+		}
+
+		// Like CompileFunction(), these don't get linked until the first time they run.
+		IRBlock *b = blocks_.GetBlock(block_num);
+		b->SetInstructions(cached.instructions);
+		b->SetOriginalSize(cached.size);
+		b->UpdateHash();
+		blocks_.FinalizeBlock(block_num, true);
+		count++;
+	}
+
+	INFO_LOG(JIT, "IRJit: Preloaded %d of %d cached blocks for module %08x", count, (int)module.blocks.size(), moduleHash);
+}
+
+void IRJit::AddToDiskCache(IRBlock *b) {
+	const IRInst *instructions = b->GetInstructions();
+	int count = b->GetNumInstructions();
+	for (int i = 0; i < count; ++i) {
+		// These are only there when debugging, don't keep them around.
+		if (instructions[i].op == IROp::Breakpoint || instructions[i].op == IROp::MemoryCheck)
+			return;
+	}
+
+	u32 start, size;
+	b->GetRange(start, size);
+	for (auto &it : diskCache_) {
+		DiskCacheModule &module = it.second;
+		if (module.active && start >= module.textStart && start + size <= module.textEnd + 4) {
+			DiskCacheBlock &cached = module.blocks[start];
+			cached.size = size;
+			cached.hash = b->GetHash();
+			cached.instructions.assign(instructions, instructions + count);
+			diskCacheDirty_ = true;
+			return;
+		}
+	}
+}
+
+void IRJit::LoadDiskCache() {
+	FILE *f = File::OpenCFile(diskCachePath_, "rb");
+	if (!f)
+		return;
+
+	IRCacheHeader header{};
+	bool success = fread(&header, sizeof(header), 1, f) == 1;
+	if (!success || header.magic != IRCACHE_HEADER_MAGIC || header.version != IRCACHE_VERSION || header.instSize != sizeof(IRInst) || header.buildHash != IRCacheBuildHash()) {
+		WARN_LOG(JIT, "IR block cache version mismatch, ignoring");
+		fclose(f);
+		return;
+	}
+	if (header.disableFlags != jo.disableFlags) {
+		// The IR depends on these, so it's not valid.
+		INFO_LOG(JIT, "IR block cache built with different jit flags, ignoring");
+		fclose(f);
+		return;
+	}
+
+	int numBlocks = 0;
+	for (u32 m = 0; success && m < header.numModules; ++m) {
+		IRCacheModuleHeader moduleHeader{};
+		success = fread(&moduleHeader, sizeof(moduleHeader), 1, f) == 1;
+		if (!success)
+			break;
+
+		DiskCacheModule &module = diskCache_[moduleHeader.moduleHash];
+		module.textStart = moduleHeader.textStart;
+		module.textEnd = moduleHeader.textEnd;
+		for (u32 i = 0; success && i < moduleHeader.numBlocks; ++i) {
+			IRCacheBlockHeader blockHeader{};
+			success = fread(&blockHeader, sizeof(blockHeader), 1, f) == 1;
+			if (!success || blockHeader.numInstructions == 0 || blockHeader.numInstructions > 0xFFFF) {
+				success = false;
+				break;
+			}
+
+			DiskCacheBlock &cached = module.blocks[blockHeader.address];
+			cached.size = blockHeader.size;
+			cached.hash = blockHeader.hash;
+			cached.instructions.resize(blockHeader.numInstructions);
+			success = fread(&cached.instructions[0], sizeof(IRInst), blockHeader.numInstructions, f) == blockHeader.numInstructions;
+			numBlocks++;
+		}
+	}
+	fclose(f);
+
+	if (!success) {
+		WARN_LOG(JIT, "IR block cache is corrupt, starting over");
+		diskCache_.clear();
+		return;
+	}
+
+	if ((header.flags & (u32)IRCacheFlags::ROUNDING) != 0) {
+		// The cached blocks expect rounding mode changes, so new ones have to match.
+		frontend_.AssumeRounding();
+	}
+	NOTICE_LOG(JIT, "IRJit: Loaded %d cached blocks for %d modules", numBlocks, (int)header.numModules);
+}
+
+void IRJit::SaveDiskCache() {
+	if (diskCachePath_.empty())
+		return;
+
+	FILE *f = File::OpenCFile(diskCachePath_, "wb");
+	if (!f)
+		return;
+
+	IRCacheHeader header{};
+	header.magic = IRCACHE_HEADER_MAGIC;
+	header.version = IRCACHE_VERSION;
+	header.instSize = sizeof(IRInst);
+	header.buildHash = IRCacheBuildHash();
+	header.disableFlags = jo.disableFlags;
+	header.flags = frontend_.UsesRounding() ? (u32)IRCacheFlags::ROUNDING : 0;
+	header.numModules = (u32)diskCache_.size();
+	bool writeFailed = fwrite(&header, sizeof(header), 1, f) != 1;
+
+	int numBlocks = 0;
+	for (const auto &it : diskCache_) {
+		const DiskCacheModule &module = it.second;
+		IRCacheModuleHeader moduleHeader{};
+		moduleHeader.moduleHash = it.first;
+		moduleHeader.textStart = module.textStart;
+		moduleHeader.textEnd = module.textEnd;
+		moduleHeader.numBlocks = (u32)module.blocks.size();
+		writeFailed = writeFailed || fwrite(&moduleHeader, sizeof(moduleHeader), 1, f) != 1;
+
+		for (const auto &blockIt : module.blocks) {
+			const DiskCacheBlock &cached = blockIt.second;
+			IRCacheBlockHeader blockHeader{};
+			blockHeader.address = blockIt.first;
+			blockHeader.size = cached.size;
+			blockHeader.hash = cached.hash;
+			blockHeader.numInstructions = (u32)cached.instructions.size();
+			writeFailed = writeFailed || fwrite(&blockHeader, sizeof(blockHeader), 1, f) != 1;
+			writeFailed = writeFailed || fwrite(&cached.instructions[0], sizeof(IRInst), cached.instructions.size(), f) != cached.instructions.size();
+			numBlocks++;
+		}
+	}
+	fclose(f);
+
+	if (writeFailed) {
+		ERROR_LOG(JIT, "Failed to write IR block cache, disk full?");
+		File::Delete(diskCachePath_);
+	} else {
+		NOTICE_LOG(JIT, "IRJit: Saved %d cached blocks for %d modules", numBlocks, (int)diskCache_.size());
+		diskCacheDirty_ = false;
+	}
+}
+
 void IRJit::CompileFunction(u32 start_address, u32 length) {
 	PROFILE_THIS_SCOPE("jitc");
 
@@ -233,9 +569,10 @@ void IRJit::RunLoopUntil(u64 globalticks) {
 					Core_ExecException(mips_->pc, startPC, ExecExceptionType::JUMP);
 					break;
 				}
+				ProfileBlockExit(data, mips_->pc);
 			} else {
 				// RestoreRoundingMode(true);
-				Compile(mips_->pc);
+				CompileAt(this, mips_->pc);
 				// ApplyRoundingMode(true);
 			}
 		}
@@ -296,12 +633,21 @@ void IRBlockCache::FinalizeBlock(int i, bool preload) {
 
 	u32 startAddr, size;
 	blocks_[i].GetRange(startAddr, size);
+	AddToPages(i, startAddr, size);
+	for (const auto &range : blocks_[i].GetTraceRanges()) {
+		AddToPages(i, range.first, range.second);
+	}
+}
 
+void IRBlockCache::AddToPages(int i, u32 startAddr, u32 size) {
 	u32 startPage = AddressToPage(startAddr);
 	u32 endPage = AddressToPage(startAddr + size);
 
 	for (u32 page = startPage; page <= endPage; ++page) {
-		byPage_[page].push_back(i);
+		std::vector<int> &blocksInPage = byPage_[page];
+		// A superblock can cover the same page more than once.
+		if (blocksInPage.empty() || blocksInPage.back() != i)
+			blocksInPage.push_back(i);
 	}
 }
 
@@ -369,11 +715,17 @@ JitBlockDebugInfo IRBlockCache::GetBlockDebugInfo(int blockNum) const {
 	ir.GetRange(start, size);
 	debugInfo.originalAddress = start;  // TODO
 
-	for (u32 addr = start; addr < start + size; addr += 4) {
-		char temp[256];
-		MIPSDisAsm(Memory::Read_Instruction(addr), addr, temp, true);
-		std::string mipsDis = temp;
-		debugInfo.origDisasm.push_back(mipsDis);
+	auto disasmRange = [&](u32 rangeStart, u32 rangeSize) {
+		for (u32 addr = rangeStart; addr < rangeStart + rangeSize; addr += 4) {
+			char temp[256];
+			MIPSDisAsm(Memory::Read_Instruction(addr), addr, temp, true);
+			std::string mipsDis = temp;
+			debugInfo.origDisasm.push_back(mipsDis);
+		}
+	};
+	disasmRange(start, size);
+	for (const auto &range : ir.GetTraceRanges()) {
+		disasmRange(range.first, range.second);
 	}
 
 	for (int i = 0; i < ir.GetNumInstructions(); i++) {
@@ -396,6 +748,8 @@ void IRBlockCache::ComputeStats(BlockCacheStats &bcStats) const {
 
 		u32 origAddr, mipsBytes;
 		b.GetRange(origAddr, mipsBytes);
+		for (const auto &range : b.GetTraceRanges())
+			mipsBytes += range.second;
 		double origSize = (double)mipsBytes;
 		double bloat = codeSize / origSize;
 		if (bloat < minBloat) {
@@ -473,17 +827,7 @@ void IRBlock::Destroy(int number) {
 
 u64 IRBlock::CalculateHash() const {
 	if (origAddr_) {
-		// This is unfortunate.  In case of emuhacks, we have to make a copy.
-		std::vector<u32> buffer;
-		buffer.resize(origSize_ / 4);
-		size_t pos = 0;
-		for (u32 off = 0; off < origSize_; off += 4) {
-			// Let's actually hash the replacement, if any.
-			MIPSOpcode instr = Memory::ReadUnchecked_Instruction(origAddr_ + off, false);
-			buffer[pos++] = instr.encoding;
-		}
-
-		return XXH3_64bits(&buffer[0], origSize_);
+		return HashOriginalCode(origAddr_, origSize_);
 	}
 
 	return 0;
@@ -492,7 +836,21 @@ u64 IRBlock::CalculateHash() const {
 bool IRBlock::OverlapsRange(u32 addr, u32 size) const {
 	addr &= 0x3FFFFFFF;
 	u32 origAddr = origAddr_ & 0x3FFFFFFF;
-	return addr + size > origAddr && addr < origAddr + origSize_;
+	if (addr + size > origAddr && addr < origAddr + origSize_)
+		return true;
+	for (const auto &range : traceRanges_) {
+		u32 rangeAddr = range.first & 0x3FFFFFFF;
+		if (addr + size > rangeAddr && addr < rangeAddr + range.second)
+			return true;
+	}
+	return false;
+}
+
+void IRBlock::SetTraceRanges(const std::vector<u32> &addresses, const std::vector<u32> &sizes) {
+	traceRanges_.clear();
+	for (size_t i = 1; i < addresses.size(); ++i) {
+		traceRanges_.push_back(std::make_pair(addresses[i], sizes[i]));
+	}
 }
 
 MIPSOpcode IRJit::GetOriginalOp(MIPSOpcode op) {
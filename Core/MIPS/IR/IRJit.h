@@ -18,10 +18,14 @@
 #pragma once
 
 #include <cstring>
+#include <map>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "Common/CommonTypes.h"
 #include "Common/CPUDetect.h"
+#include "Common/File/Path.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/IR/IRRegCache.h"
@@ -35,6 +39,14 @@
 
 namespace MIPSComp {
 
+enum {
+	// After a block exits to the same PC this many times in a row, we try to form a superblock.
+	IRSUPERBLOCK_HOT_EXIT_COUNT = 64,
+	// Later blocks in the superblock need less history to be followed.
+	IRSUPERBLOCK_FOLLOW_EXIT_COUNT = 16,
+	IRSUPERBLOCK_MAX_BLOCKS = 4,
+};
+
 // TODO : Use arena allocators. For now let's just malloc.
 class IRBlock {
 public:
@@ -47,6 +59,9 @@ class IRBlock {
 		origSize_ = b.origSize_;
 		origFirstOpcode_ = b.origFirstOpcode_;
 		hash_ = b.hash_;
+		traceRanges_ = std::move(b.traceRanges_);
+		hotExit_ = b.hotExit_;
+		hotExitCount_ = b.hotExitCount_;
 		b.instr_ = nullptr;
 	}
 
@@ -77,6 +92,7 @@ class IRBlock {
 	bool HashMatches() const {
 		return origAddr_ && hash_ == CalculateHash();
 	}
+	u64 GetHash() const { return hash_; }
 	bool OverlapsRange(u32 addr, u32 size) const;
 
 	void GetRange(u32 &start, u32 &size) const {
@@ -84,6 +100,26 @@ class IRBlock {
 		size = origSize_;
 	}
 
+	// For superblocks, the ranges of the blocks after the first, in order.
+	void SetTraceRanges(const std::vector<u32> &addresses, const std::vector<u32> &sizes);
+	const std::vector<std::pair<u32, u32>> &GetTraceRanges() const { return traceRanges_; }
+	bool IsTrace() const { return !traceRanges_.empty(); }
+
+	// Returns how many times in a row the block has now exited to exitPC.
+	int CountExit(u32 exitPC) {
+		if (exitPC == hotExit_) {
+			if (hotExitCount_ < 0xFFFF)
+				hotExitCount_++;
+		} else {
+			hotExit_ = exitPC;
+			hotExitCount_ = 1;
+		}
+		return hotExitCount_;
+	}
+	u32 GetHotExit(int minCount) const {
+		return hotExitCount_ >= minCount ? hotExit_ : 0;
+	}
+
 	void Finalize(int number);
 	void Destroy(int number);
 
@@ -96,6 +132,9 @@ class IRBlock {
 	u32 origSize_;
 	u64 hash_ = 0;
 	MIPSOpcode origFirstOpcode_ = MIPSOpcode(0x68FFFFFF);
+	std::vector<std::pair<u32, u32>> traceRanges_;
+	u32 hotExit_ = 0;
+	u16 hotExitCount_ = 0;
 };
 
 class IRBlockCache : public JitBlockCacheDebugInterface {
@@ -128,6 +167,7 @@ class IRBlockCache : public JitBlockCacheDebugInterface {
 
 private:
 	u32 AddressToPage(u32 addr) const;
+	void AddToPages(int i, u32 startAddr, u32 size);
 
 	std::vector<IRBlock> blocks_;
 	std::unordered_map<u32, std::vector<int>> byPage_;
@@ -170,16 +210,51 @@ class IRJit : public JitInterface {
 	void LinkBlock(u8 *exitPoint, const u8 *checkedEntry) override;
 	void UnlinkBlock(u8 *checkedEntry, u32 originalAddress) override;
 
-private:
+	void PreloadModuleBlocks(u32 moduleHash, u32 textStart, u32 textEnd) override;
+	void FlushDiskCache() override;
+
+protected:
 	bool CompileBlock(u32 em_address, std::vector<IRInst> &instructions, u32 &mipsBytes, bool preload);
 	bool ReplaceJalTo(u32 dest);
 
+	// Call after each block runs, so hot paths can be joined into superblocks.
+	// Looks the block up again, since it may be gone if the code it ran cleared the cache.
+	void ProfileBlockExit(int blockNum, u32 exitPC) {
+		IRBlock *block = useSuperblocks_ ? blocks_.GetBlock(blockNum) : nullptr;
+		if (block && block->CountExit(exitPC) == IRSUPERBLOCK_HOT_EXIT_COUNT)
+			FormSuperblock(blockNum);
+	}
+	void FormSuperblock(int blockNum);
+
+	// Optimized blocks kept on disk between runs (bIRBlockCache), grouped by module.
+	// They're only preloaded, so they're checked against the code hash before each is used.
+	struct DiskCacheBlock {
+		u32 size;
+		u64 hash;
+		std::vector<IRInst> instructions;
+	};
+	struct DiskCacheModule {
+		u32 textStart = 0;
+		u32 textEnd = 0;
+		// Whether it's loaded now, so new blocks in its range should be added.
+		bool active = false;
+		std::map<u32, DiskCacheBlock> blocks;
+	};
+	void LoadDiskCache();
+	void SaveDiskCache();
+	void AddToDiskCache(IRBlock *b);
+
 	JitOptions jo;
 
 	IRFrontend frontend_;
 	IRBlockCache blocks_;
 
 	MIPSState *mips_;
+	bool useSuperblocks_ = false;
+
+	std::map<u32, DiskCacheModule> diskCache_;
+	Path diskCachePath_;
+	bool diskCacheDirty_ = false;
 
 	// where to write branch-likely trampolines. not used atm
 	// u32 blTrampolines_;
@@ -0,0 +1,135 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Common/Log.h"
+#include "Common/Profiler/Profiler.h"
+#include "Core/Core.h"
+#include "Core/CoreTiming.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/MIPSTables.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+
+namespace MIPSComp {
+
+void IRNativeJit::Init(IRToNativeInterface &backend, CodeBlockCommon &code) {
+	backend_ = &backend;
+	code_ = &code;
+	backend_->GenerateFixedCode();
+}
+
+void IRNativeJit::ClearCache() {
+	IRJit::ClearCache();
+	nativeBlocks_.clear();
+	ResetCodeSpace();
+	backend_->GenerateFixedCode();
+}
+
+const u8 *IRNativeJit::GetNativeBlock(int blockNum) {
+	if (blockNum < (int)nativeBlocks_.size() && nativeBlocks_[blockNum])
+		return nativeBlocks_[blockNum];
+
+	IRBlock *block = blocks_.GetBlock(blockNum);
+	const u8 *entry = backend_->ConvertIRToNative(block->GetInstructions(), block->GetNumInstructions());
+	if (!entry)
+		return nullptr;
+	if (blockNum >= (int)nativeBlocks_.size())
+		nativeBlocks_.resize(std::max(blockNum + 1, (int)nativeBlocks_.size() * 2), nullptr);
+	nativeBlocks_[blockNum] = entry;
+	return entry;
+}
+
+void IRNativeJit::RunLoopUntil(u64 globalticks) {
+	PROFILE_THIS_SCOPE("jit");
+
+	while (true) {
+		CoreTiming::Advance();
+		if (coreState != 0) {
+			break;
+		}
+		while (mips_->downcount >= 0) {
+			u32 inst = Memory::ReadUnchecked_U32(mips_->pc);
+			u32 opcode = inst & 0xFF000000;
+			if (opcode == MIPS_EMUHACK_OPCODE) {
+				int blockNum = inst & 0xFFFFFF;
+				const u8 *entry = GetNativeBlock(blockNum);
+				if (!entry) {
+					INFO_LOG(JIT, "IRNativeJit: Out of code space, clearing the cache");
+					ClearCache();
+					// The emuhack ops are gone now, so this will recompile.
+					continue;
+				}
+				u32 startPC = mips_->pc;
+				mips_->pc = backend_->GetEnterFunc()(mips_, entry);
+				if (!Memory::IsValidAddress(mips_->pc) || (mips_->pc & 3) != 0) {
+					Core_ExecException(mips_->pc, startPC, ExecExceptionType::JUMP);
+					break;
+				}
+				ProfileBlockExit(blockNum, mips_->pc);
+			} else {
+				CompileAt(this, mips_->pc);
+			}
+		}
+	}
+}
+
+bool IRNativeJit::CodeInRange(const u8 *ptr) const {
+	return code_->IsInSpace(ptr);
+}
+
+const u8 *IRNativeJit::GetCrashHandler() const {
+	return backend_->GetCrashHandler();
+}
+
+bool IRNativeJit::DescribeCodePtr(const u8 *ptr, std::string &name) {
+	if (!code_->IsInSpace(ptr))
+		return false;
+
+	if (ptr == (const u8 *)backend_->GetEnterFunc()) {
+		name = "enterCode";
+	} else if (ptr == backend_->GetExitCode()) {
+		name = "exitCode";
+	} else if (ptr == backend_->GetCrashHandler()) {
+		name = "crashHandler";
+	} else if (ptr < backend_->GetBlocksStart()) {
+		name = "PreGenCode";
+	} else {
+		// Blocks are allocated in order, so the closest start below is the one.
+		int bestNum = -1;
+		for (int i = 0; i < (int)nativeBlocks_.size(); ++i) {
+			const u8 *start = nativeBlocks_[i];
+			if (start && start <= ptr && (bestNum == -1 || start > nativeBlocks_[bestNum]))
+				bestNum = i;
+		}
+		IRBlock *block = bestNum == -1 ? nullptr : blocks_.GetBlock(bestNum);
+		if (!block) {
+			name = "Unknown";
+			return true;
+		}
+		u32 start, size;
+		block->GetRange(start, size);
+		char temp[64];
+		snprintf(temp, sizeof(temp), "%08x_IR%d", start, bestNum);
+		name = temp;
+	}
+	return true;
+}
+
+}  // namespace MIPSComp
@@ -0,0 +1,100 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+// Shared between the backends that turn IR into native code.
+
+#include <string>
+#include <vector>
+
+#include "Common/CodeBlock.h"
+#include "Common/CommonTypes.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRJit.h"
+
+class MIPSState;
+
+namespace MIPSComp {
+
+// Generated code is entered through the enter thunk, with a pointer to the MIPSState and the block entry.
+// Blocks return the next PC, and leave the register state written back to the MIPSState.
+typedef u32 (*IRNativeEnterFunc)(MIPSState *mips, const u8 *entry);
+
+// Implemented by each backend, which only needs to know how to emit code.
+class IRToNativeInterface {
+public:
+	virtual ~IRToNativeInterface() {}
+
+	// Must be called before converting any blocks, and after each reset of the code block.
+	virtual void GenerateFixedCode() = 0;
+	// Returns the entry point of the generated code, or nullptr if out of space.
+	virtual const u8 *ConvertIRToNative(const IRInst *instructions, int count) = 0;
+
+	IRNativeEnterFunc GetEnterFunc() const { return enterCode_; }
+	const u8 *GetCrashHandler() const { return crashHandler_; }
+	const u8 *GetExitCode() const { return exitCode_; }
+	// Everything before this is fixed code, and never changes.
+	const u8 *GetBlocksStart() const { return blocksStart_; }
+
+protected:
+	// Set by GenerateFixedCode().
+	IRNativeEnterFunc enterCode_ = nullptr;
+	const u8 *exitCode_ = nullptr;
+	const u8 *crashHandler_ = nullptr;
+	const u8 *blocksStart_ = nullptr;
+};
+
+// Uses the IR frontend and passes, but runs the resulting blocks as native code from a backend.
+// Blocks are converted lazily the first time they run.
+class IRNativeJit : public IRJit {
+public:
+	IRNativeJit(MIPSState *mipsState) : IRJit(mipsState) {}
+
+	void RunLoopUntil(u64 globalticks) override;
+
+	void ClearCache() override;
+
+	bool CodeInRange(const u8 *ptr) const override;
+	bool DescribeCodePtr(const u8 *ptr, std::string &name) override;
+	const u8 *GetCrashHandler() const override;
+
+protected:
+	// Call from the backend's constructor, after allocating the code space.
+	void Init(IRToNativeInterface &backend, CodeBlockCommon &code);
+	// Throws away all generated code, including the fixed code.
+	virtual void ResetCodeSpace() = 0;
+
+private:
+	const u8 *GetNativeBlock(int blockNum);
+
+	IRToNativeInterface *backend_ = nullptr;
+	CodeBlockCommon *code_ = nullptr;
+	// Indexed by IR block number, nullptr when not yet converted.
+	std::vector<const u8 *> nativeBlocks_;
+};
+
+// Returned by IRNativeFallback when the instruction didn't exit. Never a valid PC.
+enum : u32 {
+	IRNATIVE_FALLBACK_CONTINUE = 1,
+};
+
+// Runs a single IR instruction through the interpreter, for ops without a native implementation.
+// instBits is the IRInst, packed so it can be passed in a register.
+u32 IRNativeFallback(MIPSState *mips, u64 instBits);
+
+}  // namespace MIPSComp
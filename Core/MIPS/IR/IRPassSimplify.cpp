@@ -57,6 +57,20 @@ u32 Evaluate(u32 a, IROp op) {
 	}
 }
 
+static bool EvaluateExitCondition(u32 a, u32 b, IROp op) {
+	switch (op) {
+	case IROp::ExitToConstIfEq: return a == b;
+	case IROp::ExitToConstIfNeq: return a != b;
+	case IROp::ExitToConstIfGtZ: return (s32)a > 0;
+	case IROp::ExitToConstIfGeZ: return (s32)a >= 0;
+	case IROp::ExitToConstIfLtZ: return (s32)a < 0;
+	case IROp::ExitToConstIfLeZ: return (s32)a <= 0;
+	default:
+		_assert_msg_(false, "Unable to evaluate exit condition %d", (int)op);
+		return false;
+	}
+}
+
 IROp ArithToArithConst(IROp op) {
 	switch (op) {
 	case IROp::Add: return IROp::AddConst;
@@ -731,20 +745,38 @@ bool PropagateConstants(const IRWriter &in, IRWriter &out, const IROptions &opts
 			gpr.MapDirtyIn(inst.dest, IRREG_VFPU_CTRL_BASE + inst.src1);
 			goto doDefault;
 
+		case IROp::ExitToConstIfEq:
+		case IROp::ExitToConstIfNeq:
+		case IROp::ExitToConstIfGeZ:
+		case IROp::ExitToConstIfGtZ:
+		case IROp::ExitToConstIfLeZ:
+		case IROp::ExitToConstIfLtZ:
+		{
+			bool compareZero = inst.op != IROp::ExitToConstIfEq && inst.op != IROp::ExitToConstIfNeq;
+			if (gpr.IsImm(inst.src1) && (compareZero || gpr.IsImm(inst.src2))) {
+				u32 rhs = compareZero ? 0 : gpr.GetImm(inst.src2);
+				if (EvaluateExitCondition(gpr.GetImm(inst.src1), rhs, inst.op)) {
+					gpr.FlushAll();
+					out.Write(IROp::ExitToConst, out.AddConstant(inst.constant));
+				}
+				// Otherwise it's never taken, so we can just drop it.
+				break;
+			}
+			// Side exits don't modify regs, so the immediates are still good after.
+			// This matters most for superblocks, where the next block continues after the exit.
+			gpr.WriteBackAll();
+			out.Write(inst);
+			break;
+		}
+
 		case IROp::CallReplacement:
 		case IROp::Break:
 		case IROp::Syscall:
 		case IROp::Interpret:
 		case IROp::ExitToConst:
 		case IROp::ExitToReg:
-		case IROp::ExitToConstIfEq:
-		case IROp::ExitToConstIfNeq:
 		case IROp::ExitToConstIfFpFalse:
 		case IROp::ExitToConstIfFpTrue:
-		case IROp::ExitToConstIfGeZ:
-		case IROp::ExitToConstIfGtZ:
-		case IROp::ExitToConstIfLeZ:
-		case IROp::ExitToConstIfLtZ:
 		case IROp::Breakpoint:
 		case IROp::MemoryCheck:
 		default:
@@ -7,8 +7,10 @@ void IRRegCache::Flush(int rd) {
 		return;
 	}
 	if (reg_[rd].isImm) {
-		ir_->WriteSetConstant(rd, reg_[rd].immVal);
+		if (reg_[rd].isDirty)
+			ir_->WriteSetConstant(rd, reg_[rd].immVal);
 		reg_[rd].isImm = false;
+		reg_[rd].isDirty = false;
 	}
 }
 
@@ -17,6 +19,7 @@ void IRRegCache::Discard(int rd) {
 		return;
 	}
 	reg_[rd].isImm = false;
+	reg_[rd].isDirty = false;
 }
 
 IRRegCache::IRRegCache(IRWriter *ir) : ir_(ir) {
@@ -31,6 +34,15 @@ void IRRegCache::FlushAll() {
 	}
 }
 
+void IRRegCache::WriteBackAll() {
+	for (int i = 1; i < TOTAL_MAPPABLE_MIPSREGS; i++) {
+		if (reg_[i].isImm && reg_[i].isDirty) {
+			ir_->WriteSetConstant(i, reg_[i].immVal);
+			reg_[i].isDirty = false;
+		}
+	}
+}
+
 void IRRegCache::MapIn(int rd) {
 	Flush(rd);
 }
@@ -12,6 +12,8 @@ enum {
 
 struct RegIR {
 	bool isImm;
+	// When false, the value has already been written back.
+	bool isDirty;
 	u32 immVal;
 };
 
@@ -24,6 +26,7 @@ class IRRegCache {
 
 	void SetImm(int r, u32 immVal) {
 		reg_[r].isImm = true;
+		reg_[r].isDirty = true;
 		reg_[r].immVal = immVal;
 	}
 
@@ -31,6 +34,8 @@ class IRRegCache {
 	u32 GetImm(int r) const { return reg_[r].immVal; }
 
 	void FlushAll();
+	// Writes back all immediates, but keeps them known.  Used before side exits.
+	void WriteBackAll();
 
 	void MapDirty(int rd);
 	void MapIn(int rd);
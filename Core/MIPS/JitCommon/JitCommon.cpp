@@ -27,9 +27,11 @@
 #include "Common/StringUtils.h"
 #include "Common/Serialize/Serializer.h"
 #include "Common/Serialize/SerializeFuncs.h"
+#include "Common/TimeUtil.h"
 
 #include "Core/Util/DisArm64.h"
 #include "Core/Config.h"
+#include "Core/System.h"
 
 #include "Core/MIPS/IR/IRJit.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
@@ -43,8 +45,13 @@
 #include "../ARM64/Arm64Jit.h"
 #elif PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
 #include "../x86/Jit.h"
+#if PPSSPP_ARCH(AMD64)
+#include "../x86/X64IRJit.h"
+#endif
 #elif PPSSPP_ARCH(MIPS)
 #include "../MIPS/MipsJit.h"
+#elif PPSSPP_ARCH(RISCV64)
+#include "../RiscV/RiscVJit.h"
 #else
 #include "../fake/FakeJit.h"
 #endif
@@ -52,9 +59,22 @@
 namespace MIPSComp {
 	JitInterface *jit;
 	std::recursive_mutex jitLock;
+	JitStatistics jitStats;
 
 	void JitAt() {
-		jit->Compile(currentMIPS->pc);
+		CompileAt(jit, currentMIPS->pc);
+	}
+
+	void CompileAt(JitInterface *target, u32 em_address) {
+		if (!coreCollectDebugStats) {
+			target->Compile(em_address);
+			return;
+		}
+
+		double start = time_now_d();
+		target->Compile(em_address);
+		jitStats.compileTime += time_now_d() - start;
+		jitStats.numCompiles++;
 	}
 
 	void DoDummyJitState(PointerWrap &p) {
@@ -106,11 +126,24 @@ namespace MIPSComp {
 		return new MIPSComp::Jit(mipsState);
 #elif PPSSPP_ARCH(MIPS)
 		return new MIPSComp::MipsJit(mipsState);
+#elif PPSSPP_ARCH(RISCV64)
+		return new MIPSComp::RiscVJit(mipsState);
 #else
 		return new MIPSComp::FakeJit(mipsState);
 #endif
 	}
 
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState) {
+#if PPSSPP_ARCH(AMD64)
+		return new MIPSComp::X64IRJit(mipsState);
+#elif PPSSPP_ARCH(RISCV64)
+		return new MIPSComp::RiscVJit(mipsState);
+#else
+		// No native IR backend here yet, so just interpret the IR.
+		return new MIPSComp::IRJit(mipsState);
+#endif
+	}
+
 }
 #if PPSSPP_PLATFORM(WINDOWS) && !defined(__LIBRETRO__)
 #define DISASM_ALL 1
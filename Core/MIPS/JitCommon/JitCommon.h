@@ -136,6 +136,10 @@ namespace MIPSComp {
 		virtual void RunLoopUntil(u64 globalticks) = 0;
 		virtual void Compile(u32 em_address) = 0;
 		virtual void CompileFunction(u32 start_address, u32 length) { }
+		// Called once a module's code is in place.  The hash identifies the module file.
+		virtual void PreloadModuleBlocks(u32 moduleHash, u32 textStart, u32 textEnd) { }
+		// Writes out anything kept on disk between runs, if it changed.
+		virtual void FlushDiskCache() { }
 		virtual void ClearCache() = 0;
 		virtual void UpdateFCR31() = 0;
 		virtual MIPSOpcode GetOriginalOp(MIPSOpcode op) = 0;
@@ -171,10 +175,27 @@ namespace MIPSComp {
 	// This seems to be the same for all branch types.
 	u32 ResolveNotTakenTarget(const BranchInfo &branchInfo);
 
+	struct JitStatistics {
+		void ResetFrame() {
+			compileTime = 0.0;
+			numCompiles = 0;
+		}
+
+		// Only collected with coreCollectDebugStats.  In seconds.
+		double compileTime;
+		int numCompiles;
+	};
+
 	extern JitInterface *jit;
 	extern std::recursive_mutex jitLock;
+	extern JitStatistics jitStats;
+
+	// Compiles the block at em_address, and tracks the time it took in jitStats.
+	void CompileAt(JitInterface *target, u32 em_address);
 
 	void DoDummyJitState(PointerWrap &p);
 
 	JitInterface *CreateNativeJit(MIPSState *mipsState);
+	// Runs the IR frontend and passes, then generates native code from the IR.
+	JitInterface *CreateNativeIRJit(MIPSState *mipsState);
 }
@@ -201,6 +201,8 @@ namespace MIPSComp {
 		LSU_FPU = 0x4000,
 		LSU_VFPU = 0x8000,
 
+		SUPERBLOCKS = 0x00010000,  // IR only.
+
 		SIMD = 0x00100000,
 		BLOCKLINK = 0x00200000,
 		POINTERIFY = 0x00400000,
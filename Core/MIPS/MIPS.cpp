@@ -217,6 +217,8 @@ void MIPSState::Init() {
 		MIPSComp::jit = MIPSComp::CreateNativeJit(this);
 	} else if (PSP_CoreParameter().cpuCore == CPUCore::IR_JIT) {
 		MIPSComp::jit = new MIPSComp::IRJit(this);
+	} else if (PSP_CoreParameter().cpuCore == CPUCore::JIT_IR) {
+		MIPSComp::jit = MIPSComp::CreateNativeIRJit(this);
 	} else {
 		MIPSComp::jit = nullptr;
 	}
@@ -256,6 +258,16 @@ void MIPSState::UpdateCore(CPUCore desired) {
 		newjit = new MIPSComp::IRJit(this);
 		break;
 
+	case CPUCore::JIT_IR:
+		INFO_LOG(CPU, "Switching to JIT using IR");
+		if (oldjit) {
+			std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+			MIPSComp::jit = nullptr;
+			delete oldjit;
+		}
+		newjit = MIPSComp::CreateNativeIRJit(this);
+		break;
+
 	case CPUCore::INTERPRETER:
 		INFO_LOG(CPU, "Switching to interpreter");
 		if (oldjit) {
@@ -331,6 +343,7 @@ int MIPSState::RunLoopUntil(u64 globalTicks) {
 	switch (PSP_CoreParameter().cpuCore) {
 	case CPUCore::JIT:
 	case CPUCore::IR_JIT:
+	case CPUCore::JIT_IR:
 		while (inDelaySlot) {
 			// We must get out of the delay slot before going into jit.
 			SingleStep();
@@ -911,6 +911,13 @@ namespace MIPSAnalyst {
 		}
 	}
 
+	void PreloadModuleBlocks(u32 moduleHash, u32 textStart, u32 textEnd) {
+		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+		if (MIPSComp::jit) {
+			MIPSComp::jit->PreloadModuleBlocks(moduleHash, textStart, textEnd);
+		}
+	}
+
 	void PrecompileFunctions() {
 		if (!g_Config.bPreloadFunctions) {
 			return;
@@ -112,6 +112,7 @@ namespace MIPSAnalyst
 	void ForgetFunctions(u32 startAddr, u32 endAddr);
 	void PrecompileFunctions();
 	void PrecompileFunction(u32 startAddr, u32 length);
+	void PreloadModuleBlocks(u32 moduleHash, u32 textStart, u32 textEnd);
 
 	void SetHashMapFilename(const std::string& filename = "");
 	void LoadBuiltinHashMap();
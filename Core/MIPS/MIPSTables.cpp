@@ -15,6 +15,7 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "Common/Profiler/Profiler.h"
 #include "Core/Core.h"
 #include "Core/System.h"
 #include "Core/MemMap.h"
@@ -1043,6 +1044,7 @@ static void RunUntilWithChecks(u64 globalTicks) {
 }
 
 int MIPSInterpret_RunUntil(u64 globalTicks) {
+	PROFILE_THIS_SCOPE("interp");
 	MIPSState *curMips = currentMIPS;
 	while (coreState == CORE_RUNNING) {
 		CoreTiming::Advance();
@@ -0,0 +1,1104 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include <cstddef>
+#include <cstring>
+
+#include "Common/CPUDetect.h"
+#include "Common/MemoryUtil.h"
+#include "Core/Core.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/RiscV/IRToRiscV.h"
+
+namespace MIPSComp {
+
+using namespace RiscVGen;
+
+// Converts IR blocks directly to RV64 code, one instruction at a time, with greedy register allocation.
+// Like the x64 backend, anything not handled natively is run through the IR interpreter.
+// Mapped GPRs always hold the 32-bit value sign extended to 64 bits, as the W instructions produce.
+
+static const RiscVReg MEMBASEREG = X27;
+// Points at MIPSState::r[0], so all IR regs and downcount are within a 12-bit offset.
+static const RiscVReg CTXREG = X26;
+static const RiscVReg SCRATCH1 = X5;
+static const RiscVReg SCRATCH2 = X6;
+static const RiscVReg SCRATCH3 = X7;
+static const RiscVReg FSCRATCH1 = F0;
+static const RiscVReg FSCRATCH2 = F1;
+
+// Callee saved first, so short blocks don't bother the rest.  X10/X11 are left for args and the exit PC.
+static const RiscVReg allocGPRs[] = { X8, X9, X18, X19, X20, X21, X22, X23, X24, X25, X12, X13, X14, X15, X16, X17, X28, X29, X30, X31 };
+// F0-F7 are scratch.
+static const RiscVReg allocFPRs[] = { F8, F9, F18, F19, F20, F21, F22, F23, F24, F25, F26, F27, F10, F11, F12, F13, F14, F15, F16, F17, F28, F29, F30, F31 };
+static const RiscVReg calleeSavedGPRs[] = { X1, X8, X9, X18, X19, X20, X21, X22, X23, X24, X25, X26, X27 };
+static const RiscVReg calleeSavedFPRs[] = { F8, F9, F18, F19, F20, F21, F22, F23, F24, F25, F26, F27 };
+
+static const int NUM_ALLOC_GPRS = (int)(sizeof(allocGPRs) / sizeof(allocGPRs[0]));
+static const int NUM_ALLOC_FPRS = (int)(sizeof(allocFPRs) / sizeof(allocFPRs[0]));
+static const int NUM_IR_REGS = 256;
+
+static_assert(offsetof(MIPSState, pc) == IRREG_PC * 4, "IRREG_PC must match MIPSState");
+static_assert(offsetof(MIPSState, r[0]) == 0, "CTXREG offsets assume r is first");
+static_assert(offsetof(MIPSState, downcount) < 2048, "downcount must be reachable from CTXREG");
+
+static s32 GPROffset(u8 reg) {
+	return (s32)(offsetof(MIPSState, r[0]) + reg * 4);
+}
+
+static s32 FPROffset(u8 reg) {
+	return (s32)(offsetof(MIPSState, f[0]) + reg * 4);
+}
+
+static bool FitsInImm12(s32 v) {
+	return v >= -2048 && v <= 2047;
+}
+
+static void ZeroExtend32(RiscVEmitter *emit, RiscVReg rd, RiscVReg rs) {
+	if (cpu_info.RiscV_B) {
+		emit->ZEXT_W(rd, rs);
+	} else {
+		emit->SLLI(rd, rs, 32);
+		emit->SRLI(rd, rd, 32);
+	}
+}
+
+class RiscVRegallocGPR {
+public:
+	void Start(RiscVEmitter *emit);
+
+	// Maps an IR register into a host register, loading the current value if load is set.
+	// Mapped registers are locked until Unlock(), so they can't be spilled mid-instruction.
+	RiscVReg Map(u8 r, bool load, bool dirty);
+	void Unlock();
+
+	// Writes back dirty registers, but keeps the mapping. Used on exit paths.
+	void WriteBackAll();
+	void FlushAll();
+
+private:
+	struct HostReg {
+		u8 ir;
+		bool mapped;
+		bool dirty;
+		bool locked;
+		u32 lastUse;
+	};
+
+	int AllocHost();
+	void FlushHost(int h);
+
+	RiscVEmitter *emit_ = nullptr;
+	HostReg hosts_[NUM_ALLOC_GPRS];
+	s8 irToHost_[NUM_IR_REGS];
+	u32 useCounter_ = 0;
+};
+
+void RiscVRegallocGPR::Start(RiscVEmitter *emit) {
+	emit_ = emit;
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		hosts_[i].mapped = false;
+		hosts_[i].dirty = false;
+		hosts_[i].locked = false;
+		hosts_[i].lastUse = 0;
+	}
+	memset(irToHost_, -1, sizeof(irToHost_));
+	useCounter_ = 0;
+}
+
+int RiscVRegallocGPR::AllocHost() {
+	int best = -1;
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		if (!hosts_[i].mapped)
+			return i;
+		if (hosts_[i].locked)
+			continue;
+		if (best == -1 || hosts_[i].lastUse < hosts_[best].lastUse)
+			best = i;
+	}
+	_assert_msg_(best != -1, "IRToRiscV: Ran out of GPRs");
+	FlushHost(best);
+	return best;
+}
+
+void RiscVRegallocGPR::FlushHost(int h) {
+	HostReg &host = hosts_[h];
+	if (!host.mapped)
+		return;
+	if (host.dirty)
+		emit_->SW(allocGPRs[h], CTXREG, GPROffset(host.ir));
+	irToHost_[host.ir] = -1;
+	host.mapped = false;
+	host.dirty = false;
+	host.locked = false;
+}
+
+RiscVReg RiscVRegallocGPR::Map(u8 r, bool load, bool dirty) {
+	if (r == MIPS_REG_ZERO && !dirty)
+		return R_ZERO;
+
+	int h = irToHost_[r];
+	if (h == -1) {
+		h = AllocHost();
+		hosts_[h].ir = r;
+		hosts_[h].mapped = true;
+		hosts_[h].dirty = false;
+		irToHost_[r] = h;
+		if (load)
+			emit_->LW(allocGPRs[h], CTXREG, GPROffset(r));
+	}
+	hosts_[h].lastUse = ++useCounter_;
+	hosts_[h].locked = true;
+	if (dirty)
+		hosts_[h].dirty = true;
+	return allocGPRs[h];
+}
+
+void RiscVRegallocGPR::Unlock() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i)
+		hosts_[i].locked = false;
+}
+
+void RiscVRegallocGPR::WriteBackAll() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		if (hosts_[i].mapped && hosts_[i].dirty)
+			emit_->SW(allocGPRs[i], CTXREG, GPROffset(hosts_[i].ir));
+	}
+}
+
+void RiscVRegallocGPR::FlushAll() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i)
+		FlushHost(i);
+}
+
+// There's no vector unit assumed, so vec4 ops are done per lane on singles.
+class RiscVRegallocFPR {
+public:
+	void Start(RiscVEmitter *emit);
+
+	RiscVReg Map(u8 r, bool load, bool dirty);
+	void Unlock();
+
+	void WriteBackAll();
+	void FlushAll();
+
+private:
+	struct HostReg {
+		u8 ir;
+		bool mapped;
+		bool dirty;
+		bool locked;
+		u32 lastUse;
+	};
+
+	int AllocHost();
+	void FlushHost(int h);
+
+	RiscVEmitter *emit_ = nullptr;
+	HostReg hosts_[NUM_ALLOC_FPRS];
+	s8 irToHost_[NUM_IR_REGS];
+	u32 useCounter_ = 0;
+};
+
+void RiscVRegallocFPR::Start(RiscVEmitter *emit) {
+	emit_ = emit;
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		hosts_[i].mapped = false;
+		hosts_[i].dirty = false;
+		hosts_[i].locked = false;
+		hosts_[i].lastUse = 0;
+	}
+	memset(irToHost_, -1, sizeof(irToHost_));
+	useCounter_ = 0;
+}
+
+int RiscVRegallocFPR::AllocHost() {
+	int best = -1;
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		if (!hosts_[i].mapped)
+			return i;
+		if (hosts_[i].locked)
+			continue;
+		if (best == -1 || hosts_[i].lastUse < hosts_[best].lastUse)
+			best = i;
+	}
+	_assert_msg_(best != -1, "IRToRiscV: Ran out of FPRs");
+	FlushHost(best);
+	return best;
+}
+
+void RiscVRegallocFPR::FlushHost(int h) {
+	HostReg &host = hosts_[h];
+	if (!host.mapped)
+		return;
+	if (host.dirty)
+		emit_->FSW(allocFPRs[h], CTXREG, FPROffset(host.ir));
+	irToHost_[host.ir] = -1;
+	host.mapped = false;
+	host.dirty = false;
+	host.locked = false;
+}
+
+RiscVReg RiscVRegallocFPR::Map(u8 r, bool load, bool dirty) {
+	int h = irToHost_[r];
+	if (h == -1) {
+		h = AllocHost();
+		hosts_[h].ir = r;
+		hosts_[h].mapped = true;
+		hosts_[h].dirty = false;
+		irToHost_[r] = h;
+		if (load)
+			emit_->FLW(allocFPRs[h], CTXREG, FPROffset(r));
+	}
+	hosts_[h].lastUse = ++useCounter_;
+	hosts_[h].locked = true;
+	if (dirty)
+		hosts_[h].dirty = true;
+	return allocFPRs[h];
+}
+
+void RiscVRegallocFPR::Unlock() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i)
+		hosts_[i].locked = false;
+}
+
+void RiscVRegallocFPR::WriteBackAll() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		if (hosts_[i].mapped && hosts_[i].dirty)
+			emit_->FSW(allocFPRs[i], CTXREG, FPROffset(hosts_[i].ir));
+	}
+}
+
+void RiscVRegallocFPR::FlushAll() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i)
+		FlushHost(i);
+}
+
+// Jumps anywhere, even outside JAL range.
+static void QuickJ(RiscVEmitter *emit, const u8 *dst) {
+	if (emit->JInRange(dst)) {
+		emit->J(dst);
+	} else {
+		emit->LI(SCRATCH1, (uintptr_t)dst);
+		emit->JR(SCRATCH1);
+	}
+}
+
+void IRToRiscV::GenerateFixedCode() {
+	RiscVCodeBlock *emit = code_;
+	emit->BeginWrite(GetMemoryProtectPageSize());
+	emit->AlignCodePage();
+	emit->SetAutoCompress(true);
+
+	const int gprCount = (int)(sizeof(calleeSavedGPRs) / sizeof(calleeSavedGPRs[0]));
+	const int fprCount = (int)(sizeof(calleeSavedFPRs) / sizeof(calleeSavedFPRs[0]));
+	// Keep the stack 16-byte aligned.
+	const int frameSize = ((gprCount + fprCount) * 8 + 15) & ~15;
+
+	enterCode_ = (IRNativeEnterFunc)emit->AlignCode16();
+	emit->ADDI(R_SP, R_SP, -frameSize);
+	for (int i = 0; i < gprCount; ++i)
+		emit->SD(calleeSavedGPRs[i], R_SP, i * 8);
+	for (int i = 0; i < fprCount; ++i)
+		emit->FS(64, calleeSavedFPRs[i], R_SP, (gprCount + i) * 8);
+	emit->LI(SCRATCH1, (uintptr_t)&Memory::base);
+	emit->LD(MEMBASEREG, SCRATCH1, 0);
+	emit->MV(CTXREG, X10);
+	emit->JR(X11);
+
+	// The next PC is in X10, already sign extended as the ABI wants for u32.
+	exitCode_ = emit->AlignCode16();
+	for (int i = 0; i < gprCount; ++i)
+		emit->LD(calleeSavedGPRs[i], R_SP, i * 8);
+	for (int i = 0; i < fprCount; ++i)
+		emit->FL(64, calleeSavedFPRs[i], R_SP, (gprCount + i) * 8);
+	emit->ADDI(R_SP, R_SP, frameSize);
+	emit->RET();
+
+	// Memory exceptions land here, with the stack as it was in the block.
+	crashHandler_ = emit->AlignCode16();
+	emit->LI(SCRATCH1, (uintptr_t)&coreState);
+	emit->LI(SCRATCH2, (s32)CORE_RUNTIME_ERROR);
+	emit->SW(SCRATCH2, SCRATCH1, 0);
+	emit->LI(SCRATCH2, -1);
+	emit->SW(SCRATCH2, CTXREG, (s32)offsetof(MIPSState, downcount));
+	emit->LW(X10, CTXREG, (s32)offsetof(MIPSState, pc));
+	QuickJ(emit, exitCode_);
+
+	// Let's spare the pre-generated code from unprotect-reprotect.
+	blocksStart_ = emit->AlignCodePage();
+	emit->FlushIcache();
+	emit->EndWrite();
+}
+
+// Computes the host address of PSP address addrReg + offset into SCRATCH1.
+static RiscVReg MemAddress(RiscVEmitter *emit, RiscVReg addrReg, u32 offset) {
+	RiscVReg src = addrReg;
+	if (offset != 0) {
+		if (FitsInImm12((s32)offset)) {
+			emit->ADDIW(SCRATCH1, addrReg, (s32)offset);
+		} else {
+			emit->LI(SCRATCH1, (s32)offset);
+			emit->ADDW(SCRATCH1, addrReg, SCRATCH1);
+		}
+		src = SCRATCH1;
+	}
+#ifdef MASKED_PSP_MEMORY
+	emit->LI(SCRATCH2, (s32)Memory::MEMVIEW32_MASK);
+	emit->AND(SCRATCH1, src, SCRATCH2);
+	emit->ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+#else
+	if (cpu_info.RiscV_B) {
+		emit->ADD_UW(SCRATCH1, src, MEMBASEREG);
+	} else {
+		ZeroExtend32(emit, SCRATCH1, src);
+		emit->ADD(SCRATCH1, SCRATCH1, MEMBASEREG);
+	}
+#endif
+	return SCRATCH1;
+}
+
+// This requires that the IR has been through IRPassSimplify, but not ThreeOpToTwoOp.
+const u8 *IRToRiscV::ConvertIRToNative(const IRInst *instructions, int count) {
+	RiscVCodeBlock *emit = code_;
+
+	// Generous estimate: vec4 ops, clz, and exits with many dirty regs are the largest.
+	size_t sizeEstimate = 256 + (size_t)count * 160;
+	if (emit->GetSpaceLeft() < sizeEstimate)
+		return nullptr;
+
+	emit->BeginWrite(sizeEstimate);
+	const u8 *start = emit->AlignCode16();
+
+	RiscVRegallocGPR gpr;
+	RiscVRegallocFPR fpr;
+	gpr.Start(emit);
+	fpr.Start(emit);
+
+	auto exitToConst = [&](u32 pc) {
+		gpr.WriteBackAll();
+		fpr.WriteBackAll();
+		emit->LI(X10, (s32)pc);
+		QuickJ(emit, exitCode_);
+	};
+
+	typedef void (RiscVEmitter::*RegOp)(RiscVReg rd, RiscVReg rs1, RiscVReg rs2);
+	typedef void (RiscVEmitter::*ImmOp)(RiscVReg rd, RiscVReg rs1, s32 simm12);
+	auto intOp3 = [&](const IRInst &inst, RegOp op) {
+		RiscVReg s1 = gpr.Map(inst.src1, true, false);
+		RiscVReg s2 = gpr.Map(inst.src2, true, false);
+		(emit->*op)(gpr.Map(inst.dest, false, true), s1, s2);
+	};
+	auto intOpConst = [&](const IRInst &inst, ImmOp immOp, RegOp op) {
+		RiscVReg s1 = gpr.Map(inst.src1, true, false);
+		RiscVReg d = gpr.Map(inst.dest, false, true);
+		if (FitsInImm12((s32)inst.constant)) {
+			(emit->*immOp)(d, s1, (s32)inst.constant);
+		} else {
+			emit->LI(SCRATCH1, (s32)inst.constant);
+			(emit->*op)(d, s1, SCRATCH1);
+		}
+	};
+	auto addConst = [&](const IRInst &inst, u32 constant) {
+		RiscVReg s1 = gpr.Map(inst.src1, true, false);
+		RiscVReg d = gpr.Map(inst.dest, false, true);
+		if (FitsInImm12((s32)constant)) {
+			emit->ADDIW(d, s1, (s32)constant);
+		} else {
+			emit->LI(SCRATCH1, (s32)constant);
+			emit->ADDW(d, s1, SCRATCH1);
+		}
+	};
+
+	typedef void (RiscVEmitter::*ShiftImmOp)(RiscVReg rd, RiscVReg rs1, u32 shamt);
+	auto shiftImm = [&](const IRInst &inst, ShiftImmOp op) {
+		RiscVReg s1 = gpr.Map(inst.src1, true, false);
+		RiscVReg d = gpr.Map(inst.dest, false, true);
+		// The emitter doesn't allow zero shifts.
+		if ((inst.src2 & 31) == 0)
+			emit->MV(d, s1);
+		else
+			(emit->*op)(d, s1, inst.src2 & 31);
+	};
+	// Rotates s right by the amount register, without Zbb.
+	auto rotateRight = [&](RiscVReg d, RiscVReg s, RiscVReg amount) {
+		// The W shifts only use the low 5 bits, so -amount works as 32 - amount.
+		emit->SRLW(SCRATCH1, s, amount);
+		emit->NEGW(SCRATCH2, amount);
+		emit->SLLW(SCRATCH2, s, SCRATCH2);
+		emit->OR(d, SCRATCH1, SCRATCH2);
+	};
+
+	typedef void (RiscVEmitter::*FPOp3)(int bits, RiscVReg rd, RiscVReg rs1, RiscVReg rs2, Round rm);
+	typedef void (RiscVEmitter::*FPOp2)(int bits, RiscVReg rd, RiscVReg rs);
+	auto fpuOp3 = [&](u8 dest, u8 src1, u8 src2, FPOp3 op) {
+		RiscVReg s1 = fpr.Map(src1, true, false);
+		RiscVReg s2 = fpr.Map(src2, true, false);
+		(emit->*op)(32, fpr.Map(dest, false, true), s1, s2, Round::DYNAMIC);
+	};
+	auto fpuOp2 = [&](u8 dest, u8 src1, FPOp2 op) {
+		RiscVReg s1 = fpr.Map(src1, true, false);
+		(emit->*op)(32, fpr.Map(dest, false, true), s1);
+	};
+	// Sets SCRATCH1 to 1 if either is NaN.
+	auto checkUnordered = [&](RiscVReg s1, RiscVReg s2) {
+		emit->FEQ(32, SCRATCH1, s1, s1);
+		emit->FEQ(32, SCRATCH2, s2, s2);
+		emit->AND(SCRATCH1, SCRATCH1, SCRATCH2);
+		emit->XORI(SCRATCH1, SCRATCH1, 1);
+	};
+
+	for (int i = 0; i < count; i++) {
+		const IRInst &inst = instructions[i];
+		gpr.Unlock();
+		fpr.Unlock();
+
+		switch (inst.op) {
+		case IROp::Nop:
+			break;
+
+		case IROp::SetConst:
+		{
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			emit->LI(d, (s32)inst.constant);
+			break;
+		}
+		case IROp::SetConstF:
+		{
+			RiscVReg d = fpr.Map(inst.dest, false, true);
+			if (inst.constant == 0) {
+				emit->FMV(FMv::W, FMv::X, d, R_ZERO);
+			} else {
+				emit->LI(SCRATCH1, (s32)inst.constant);
+				emit->FMV(FMv::W, FMv::X, d, SCRATCH1);
+			}
+			break;
+		}
+
+		case IROp::Mov:
+		case IROp::MtLo:
+		case IROp::MtHi:
+		case IROp::MfLo:
+		case IROp::MfHi:
+		case IROp::FpCondToReg:
+		case IROp::VfpuCtrlToReg:
+		case IROp::SetCtrlVFPUReg:
+		case IROp::SetPC:
+		{
+			// These are all just moves between IR GPRs, only the indices differ.
+			u8 src = inst.src1;
+			u8 dest = inst.dest;
+			switch (inst.op) {
+			case IROp::MtLo: dest = IRREG_LO; break;
+			case IROp::MtHi: dest = IRREG_HI; break;
+			case IROp::MfLo: src = IRREG_LO; break;
+			case IROp::MfHi: src = IRREG_HI; break;
+			case IROp::FpCondToReg: src = IRREG_FPCOND; break;
+			case IROp::VfpuCtrlToReg: src = IRREG_VFPU_CTRL_BASE + inst.src1; break;
+			case IROp::SetCtrlVFPUReg: dest = IRREG_VFPU_CTRL_BASE + inst.dest; break;
+			case IROp::SetPC: dest = IRREG_PC; break;
+			default: break;
+			}
+			if (src == dest)
+				break;
+			RiscVReg s = gpr.Map(src, true, false);
+			emit->MV(gpr.Map(dest, false, true), s);
+			break;
+		}
+
+		case IROp::SetPCConst:
+			emit->LI(gpr.Map(IRREG_PC, false, true), (s32)inst.constant);
+			break;
+		case IROp::ZeroFpCond:
+			emit->LI(gpr.Map(IRREG_FPCOND, false, true), 0);
+			break;
+		case IROp::SetCtrlVFPU:
+			emit->LI(gpr.Map(IRREG_VFPU_CTRL_BASE + inst.dest, false, true), (s32)inst.constant);
+			break;
+		case IROp::SetCtrlVFPUFReg:
+		{
+			RiscVReg s = fpr.Map(inst.src1, true, false);
+			emit->FMV(FMv::X, FMv::W, gpr.Map(IRREG_VFPU_CTRL_BASE + inst.dest, false, true), s);
+			break;
+		}
+
+		case IROp::Add: intOp3(inst, &RiscVEmitter::ADDW); break;
+		case IROp::Sub: intOp3(inst, &RiscVEmitter::SUBW); break;
+		// These keep sign extended values sign extended.
+		case IROp::And: intOp3(inst, &RiscVEmitter::AND); break;
+		case IROp::Or: intOp3(inst, &RiscVEmitter::OR); break;
+		case IROp::Xor: intOp3(inst, &RiscVEmitter::XOR); break;
+
+		case IROp::AddConst: addConst(inst, inst.constant); break;
+		case IROp::SubConst: addConst(inst, 0U - inst.constant); break;
+		case IROp::AndConst: intOpConst(inst, &RiscVEmitter::ANDI, &RiscVEmitter::AND); break;
+		case IROp::OrConst: intOpConst(inst, &RiscVEmitter::ORI, &RiscVEmitter::OR); break;
+		case IROp::XorConst: intOpConst(inst, &RiscVEmitter::XORI, &RiscVEmitter::XOR); break;
+
+		case IROp::Neg:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			emit->NEGW(gpr.Map(inst.dest, false, true), s1);
+			break;
+		}
+		case IROp::Not:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			emit->NOT(gpr.Map(inst.dest, false, true), s1);
+			break;
+		}
+		case IROp::Ext8to32:
+		case IROp::Ext16to32:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			int bits = inst.op == IROp::Ext8to32 ? 8 : 16;
+			if (cpu_info.RiscV_B && bits == 8) {
+				emit->SEXT_B(d, s1);
+			} else if (cpu_info.RiscV_B) {
+				emit->SEXT_H(d, s1);
+			} else {
+				emit->SLLI(d, s1, 64 - bits);
+				emit->SRAI(d, d, 64 - bits);
+			}
+			break;
+		}
+		case IROp::BSwap32:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			if (cpu_info.RiscV_B) {
+				emit->REV8(d, s1);
+				emit->SRAI(d, d, 32);
+			} else {
+				emit->SLLIW(SCRATCH1, s1, 24);
+				emit->SRLIW(SCRATCH2, s1, 24);
+				emit->OR(SCRATCH1, SCRATCH1, SCRATCH2);
+				emit->LI(SCRATCH3, 0xFF00);
+				emit->AND(SCRATCH2, s1, SCRATCH3);
+				emit->SLLIW(SCRATCH2, SCRATCH2, 8);
+				emit->OR(SCRATCH1, SCRATCH1, SCRATCH2);
+				emit->SRLIW(SCRATCH2, s1, 8);
+				emit->AND(SCRATCH2, SCRATCH2, SCRATCH3);
+				emit->OR(d, SCRATCH1, SCRATCH2);
+			}
+			break;
+		}
+		case IROp::BSwap16:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			emit->LI(SCRATCH3, 0x00FF00FF);
+			emit->SRLIW(SCRATCH1, s1, 8);
+			emit->AND(SCRATCH1, SCRATCH1, SCRATCH3);
+			emit->AND(SCRATCH2, s1, SCRATCH3);
+			emit->SLLIW(SCRATCH2, SCRATCH2, 8);
+			emit->OR(d, SCRATCH1, SCRATCH2);
+			break;
+		}
+		case IROp::Clz:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			if (cpu_info.RiscV_B) {
+				emit->CLZW(d, s1);
+				break;
+			}
+			// Binary search, with the value moved to the top of the register.
+			emit->SLLI(SCRATCH2, s1, 32);
+			emit->LI(SCRATCH1, 32);
+			FixupBranch zero = emit->BEQ(SCRATCH2, R_ZERO);
+			emit->LI(SCRATCH1, 0);
+			for (int shift = 16; shift >= 1; shift >>= 1) {
+				emit->SRLI(SCRATCH3, SCRATCH2, 64 - shift);
+				FixupBranch nonZero = emit->BNE(SCRATCH3, R_ZERO);
+				emit->ADDI(SCRATCH1, SCRATCH1, shift);
+				emit->SLLI(SCRATCH2, SCRATCH2, shift);
+				emit->SetJumpTarget(nonZero);
+			}
+			emit->SetJumpTarget(zero);
+			emit->MV(d, SCRATCH1);
+			break;
+		}
+
+		case IROp::ShlImm: shiftImm(inst, &RiscVEmitter::SLLIW); break;
+		case IROp::ShrImm: shiftImm(inst, &RiscVEmitter::SRLIW); break;
+		case IROp::SarImm: shiftImm(inst, &RiscVEmitter::SRAIW); break;
+		case IROp::RorImm:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			int sa = inst.src2 & 31;
+			if (sa == 0) {
+				emit->MV(d, s1);
+			} else if (cpu_info.RiscV_B) {
+				emit->RORIW(d, s1, sa);
+			} else {
+				emit->SRLIW(SCRATCH1, s1, sa);
+				emit->SLLIW(SCRATCH2, s1, 32 - sa);
+				emit->OR(d, SCRATCH1, SCRATCH2);
+			}
+			break;
+		}
+		// The W shifts only use the low 5 bits of the amount, just like MIPS.
+		case IROp::Shl: intOp3(inst, &RiscVEmitter::SLLW); break;
+		case IROp::Shr: intOp3(inst, &RiscVEmitter::SRLW); break;
+		case IROp::Sar: intOp3(inst, &RiscVEmitter::SRAW); break;
+		case IROp::Ror:
+		{
+			if (cpu_info.RiscV_B) {
+				intOp3(inst, &RiscVEmitter::RORW);
+				break;
+			}
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg s2 = gpr.Map(inst.src2, true, false);
+			rotateRight(gpr.Map(inst.dest, false, true), s1, s2);
+			break;
+		}
+
+		// Comparing sign extended values gives the same answer as comparing the 32-bit values,
+		// even unsigned, since the order is kept.
+		case IROp::Slt: intOp3(inst, &RiscVEmitter::SLT); break;
+		case IROp::SltU: intOp3(inst, &RiscVEmitter::SLTU); break;
+		case IROp::SltConst: intOpConst(inst, &RiscVEmitter::SLTI, &RiscVEmitter::SLT); break;
+		case IROp::SltUConst: intOpConst(inst, &RiscVEmitter::SLTIU, &RiscVEmitter::SLTU); break;
+
+		case IROp::MovZ:
+		case IROp::MovNZ:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg s2 = gpr.Map(inst.src2, true, false);
+			RiscVReg d = gpr.Map(inst.dest, true, true);
+			FixupBranch skip = inst.op == IROp::MovZ ? emit->BNE(s1, R_ZERO) : emit->BEQ(s1, R_ZERO);
+			emit->MV(d, s2);
+			emit->SetJumpTarget(skip);
+			break;
+		}
+		case IROp::Max:
+		case IROp::Min:
+		{
+			if (cpu_info.RiscV_B) {
+				intOp3(inst, inst.op == IROp::Max ? &RiscVEmitter::MAX : &RiscVEmitter::MIN);
+				break;
+			}
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg s2 = gpr.Map(inst.src2, true, false);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			emit->MV(SCRATCH1, s1);
+			FixupBranch keep = inst.op == IROp::Max ? emit->BGE(s1, s2) : emit->BGE(s2, s1);
+			emit->MV(SCRATCH1, s2);
+			emit->SetJumpTarget(keep);
+			emit->MV(d, SCRATCH1);
+			break;
+		}
+
+		case IROp::Mult:
+		case IROp::MultU:
+		case IROp::Madd:
+		case IROp::MaddU:
+		case IROp::Msub:
+		case IROp::MsubU:
+		{
+			bool isSigned = inst.op == IROp::Mult || inst.op == IROp::Madd || inst.op == IROp::Msub;
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg s2 = gpr.Map(inst.src2, true, false);
+			if (isSigned) {
+				// Sign extended inputs give the full 64-bit product.
+				emit->MUL(SCRATCH1, s1, s2);
+			} else {
+				ZeroExtend32(emit, SCRATCH1, s1);
+				ZeroExtend32(emit, SCRATCH2, s2);
+				emit->MUL(SCRATCH1, SCRATCH1, SCRATCH2);
+			}
+			if (inst.op != IROp::Mult && inst.op != IROp::MultU) {
+				RiscVReg lo = gpr.Map(IRREG_LO, true, false);
+				RiscVReg hi = gpr.Map(IRREG_HI, true, false);
+				emit->SLLI(SCRATCH2, hi, 32);
+				ZeroExtend32(emit, SCRATCH3, lo);
+				emit->OR(SCRATCH2, SCRATCH2, SCRATCH3);
+				if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+					emit->ADD(SCRATCH1, SCRATCH2, SCRATCH1);
+				else
+					emit->SUB(SCRATCH1, SCRATCH2, SCRATCH1);
+			}
+			emit->ADDIW(gpr.Map(IRREG_LO, false, true), SCRATCH1, 0);
+			emit->SRAI(gpr.Map(IRREG_HI, false, true), SCRATCH1, 32);
+			break;
+		}
+
+		case IROp::Load8:
+		case IROp::Load8Ext:
+		case IROp::Load16:
+		case IROp::Load16Ext:
+		case IROp::Load32:
+		{
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			RiscVReg d = gpr.Map(inst.dest, false, true);
+			switch (inst.op) {
+			case IROp::Load8: emit->LBU(d, addr, 0); break;
+			case IROp::Load8Ext: emit->LB(d, addr, 0); break;
+			case IROp::Load16: emit->LHU(d, addr, 0); break;
+			case IROp::Load16Ext: emit->LH(d, addr, 0); break;
+			default: emit->LW(d, addr, 0); break;
+			}
+			break;
+		}
+		case IROp::LoadFloat:
+		{
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			emit->FLW(fpr.Map(inst.dest, false, true), addr, 0);
+			break;
+		}
+		case IROp::LoadVec4:
+		{
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			for (int lane = 0; lane < 4; ++lane)
+				emit->FLW(fpr.Map(inst.dest + lane, false, true), addr, lane * 4);
+			break;
+		}
+		case IROp::Store8:
+		case IROp::Store16:
+		case IROp::Store32:
+		{
+			RiscVReg value = gpr.Map(inst.src3, true, false);
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			if (inst.op == IROp::Store8)
+				emit->SB(value, addr, 0);
+			else if (inst.op == IROp::Store16)
+				emit->SH(value, addr, 0);
+			else
+				emit->SW(value, addr, 0);
+			break;
+		}
+		case IROp::StoreFloat:
+		{
+			RiscVReg value = fpr.Map(inst.src3, true, false);
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			emit->FSW(value, addr, 0);
+			break;
+		}
+		case IROp::StoreVec4:
+		{
+			RiscVReg addr = MemAddress(emit, gpr.Map(inst.src1, true, false), inst.constant);
+			for (int lane = 0; lane < 4; ++lane)
+				emit->FSW(fpr.Map(inst.src3 + lane, true, false), addr, lane * 4);
+			break;
+		}
+
+		case IROp::FAdd: fpuOp3(inst.dest, inst.src1, inst.src2, &RiscVEmitter::FADD); break;
+		case IROp::FSub: fpuOp3(inst.dest, inst.src1, inst.src2, &RiscVEmitter::FSUB); break;
+		case IROp::FMul: fpuOp3(inst.dest, inst.src1, inst.src2, &RiscVEmitter::FMUL); break;
+		case IROp::FDiv: fpuOp3(inst.dest, inst.src1, inst.src2, &RiscVEmitter::FDIV); break;
+		case IROp::FMov: fpuOp2(inst.dest, inst.src1, &RiscVEmitter::FMV); break;
+		case IROp::FAbs: fpuOp2(inst.dest, inst.src1, &RiscVEmitter::FABS); break;
+		case IROp::FNeg: fpuOp2(inst.dest, inst.src1, &RiscVEmitter::FNEG); break;
+		case IROp::FSqrt:
+		{
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			emit->FSQRT(32, fpr.Map(inst.dest, false, true), s1);
+			break;
+		}
+		case IROp::FMin:
+		case IROp::FMax:
+		{
+			// FMIN/FMAX prefer the non-NaN value and order zeros, std::min/max just compare.
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			RiscVReg s2 = fpr.Map(inst.src2, true, false);
+			RiscVReg d = fpr.Map(inst.dest, false, true);
+			if (inst.op == IROp::FMin)
+				emit->FLT(32, SCRATCH1, s2, s1);
+			else
+				emit->FLT(32, SCRATCH1, s1, s2);
+			emit->FMV(32, FSCRATCH1, s1);
+			FixupBranch keep = emit->BEQ(SCRATCH1, R_ZERO);
+			emit->FMV(32, FSCRATCH1, s2);
+			emit->SetJumpTarget(keep);
+			emit->FMV(32, d, FSCRATCH1);
+			break;
+		}
+		case IROp::FRSqrt:
+		case IROp::FRecip:
+		{
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			if (inst.op == IROp::FRSqrt)
+				emit->FSQRT(32, FSCRATCH2, s1);
+			else
+				emit->FMV(32, FSCRATCH2, s1);
+			emit->LI(SCRATCH1, 1.0f);
+			emit->FMV(FMv::W, FMv::X, FSCRATCH1, SCRATCH1);
+			emit->FDIV(32, fpr.Map(inst.dest, false, true), FSCRATCH1, FSCRATCH2);
+			break;
+		}
+		case IROp::FCvtSW:
+		{
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			emit->FMV(FMv::X, FMv::W, SCRATCH1, s1);
+			emit->FCVT(FConv::S, FConv::W, fpr.Map(inst.dest, false, true), SCRATCH1);
+			break;
+		}
+		case IROp::FMovFromGPR:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			emit->FMV(FMv::W, FMv::X, fpr.Map(inst.dest, false, true), s1);
+			break;
+		}
+		case IROp::FMovToGPR:
+		{
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			emit->FMV(FMv::X, FMv::W, gpr.Map(inst.dest, false, true), s1);
+			break;
+		}
+
+		case IROp::FCmp:
+		{
+			if (inst.dest == IRFpCompareMode::False) {
+				emit->LI(gpr.Map(IRREG_FPCOND, false, true), 0);
+				break;
+			}
+			RiscVReg s1 = fpr.Map(inst.src1, true, false);
+			RiscVReg s2 = fpr.Map(inst.src2, true, false);
+			RiscVReg d = gpr.Map(IRREG_FPCOND, false, true);
+			switch (inst.dest) {
+			case IRFpCompareMode::EitherUnordered:
+				checkUnordered(s1, s2);
+				emit->MV(d, SCRATCH1);
+				break;
+			case IRFpCompareMode::EqualOrdered:
+				emit->FEQ(32, d, s1, s2);
+				break;
+			case IRFpCompareMode::EqualUnordered:
+				checkUnordered(s1, s2);
+				emit->FEQ(32, SCRATCH2, s1, s2);
+				emit->OR(d, SCRATCH1, SCRATCH2);
+				break;
+			case IRFpCompareMode::LessOrdered:
+				emit->FLT(32, d, s1, s2);
+				break;
+			case IRFpCompareMode::LessEqualOrdered:
+				emit->FLE(32, d, s1, s2);
+				break;
+			case IRFpCompareMode::LessUnordered:
+				// Not (s1 >= s2) is true for NaNs too.
+				emit->FLE(32, SCRATCH1, s2, s1);
+				emit->XORI(d, SCRATCH1, 1);
+				break;
+			case IRFpCompareMode::LessEqualUnordered:
+				emit->FLT(32, SCRATCH1, s2, s1);
+				emit->XORI(d, SCRATCH1, 1);
+				break;
+			}
+			break;
+		}
+
+		case IROp::Vec4Init:
+		{
+			static const float vec4InitValues[7][4] = {
+				{ 0.0f, 0.0f, 0.0f, 0.0f },
+				{ 1.0f, 1.0f, 1.0f, 1.0f },
+				{ -1.0f, -1.0f, -1.0f, -1.0f },
+				{ 1.0f, 0.0f, 0.0f, 0.0f },
+				{ 0.0f, 1.0f, 0.0f, 0.0f },
+				{ 0.0f, 0.0f, 1.0f, 0.0f },
+				{ 0.0f, 0.0f, 0.0f, 1.0f },
+			};
+			for (int lane = 0; lane < 4; ++lane) {
+				float value = vec4InitValues[inst.src1][lane];
+				RiscVReg d = fpr.Map(inst.dest + lane, false, true);
+				if (value == 0.0f) {
+					emit->FMV(FMv::W, FMv::X, d, R_ZERO);
+				} else {
+					emit->LI(SCRATCH1, value);
+					emit->FMV(FMv::W, FMv::X, d, SCRATCH1);
+				}
+			}
+			break;
+		}
+		case IROp::Vec4Shuffle:
+		{
+			// Go through scratch, in case the frontend ever shuffles in place.
+			for (int lane = 0; lane < 4; ++lane)
+				emit->FMV(32, (RiscVReg)(F2 + lane), fpr.Map(inst.src1 + ((inst.src2 >> (lane * 2)) & 3), true, false));
+			for (int lane = 0; lane < 4; ++lane)
+				emit->FMV(32, fpr.Map(inst.dest + lane, false, true), (RiscVReg)(F2 + lane));
+			break;
+		}
+		case IROp::Vec4Mov:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp2(inst.dest + lane, inst.src1 + lane, &RiscVEmitter::FMV);
+			break;
+		case IROp::Vec4Add:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp3(inst.dest + lane, inst.src1 + lane, inst.src2 + lane, &RiscVEmitter::FADD);
+			break;
+		case IROp::Vec4Sub:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp3(inst.dest + lane, inst.src1 + lane, inst.src2 + lane, &RiscVEmitter::FSUB);
+			break;
+		case IROp::Vec4Mul:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp3(inst.dest + lane, inst.src1 + lane, inst.src2 + lane, &RiscVEmitter::FMUL);
+			break;
+		case IROp::Vec4Div:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp3(inst.dest + lane, inst.src1 + lane, inst.src2 + lane, &RiscVEmitter::FDIV);
+			break;
+		case IROp::Vec4Neg:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp2(inst.dest + lane, inst.src1 + lane, &RiscVEmitter::FNEG);
+			break;
+		case IROp::Vec4Abs:
+			for (int lane = 0; lane < 4; ++lane)
+				fpuOp2(inst.dest + lane, inst.src1 + lane, &RiscVEmitter::FABS);
+			break;
+		case IROp::Vec4Scale:
+		{
+			// The scale may live inside the dest, so grab it first.
+			emit->FMV(32, FSCRATCH2, fpr.Map(inst.src2, true, false));
+			for (int lane = 0; lane < 4; ++lane) {
+				RiscVReg s1 = fpr.Map(inst.src1 + lane, true, false);
+				emit->FMUL(32, fpr.Map(inst.dest + lane, false, true), s1, FSCRATCH2);
+			}
+			break;
+		}
+		case IROp::Vec4Dot:
+		{
+			// Multiply and add separately, to match the interpreter's rounding.
+			for (int lane = 0; lane < 4; ++lane) {
+				RiscVReg s1 = fpr.Map(inst.src1 + lane, true, false);
+				RiscVReg s2 = fpr.Map(inst.src2 + lane, true, false);
+				if (lane == 0) {
+					emit->FMUL(32, FSCRATCH1, s1, s2);
+				} else {
+					emit->FMUL(32, FSCRATCH2, s1, s2);
+					emit->FADD(32, FSCRATCH1, FSCRATCH1, FSCRATCH2);
+				}
+			}
+			emit->FMV(32, fpr.Map(inst.dest, false, true), FSCRATCH1);
+			break;
+		}
+		case IROp::Vec4ClampToZero:
+		{
+			// Zero anything with the sign bit set, including negative zero and NaNs.
+			for (int lane = 0; lane < 4; ++lane) {
+				RiscVReg s1 = fpr.Map(inst.src1 + lane, true, false);
+				emit->FMV(FMv::X, FMv::W, SCRATCH1, s1);
+				emit->SRAI(SCRATCH2, SCRATCH1, 31);
+				emit->NOT(SCRATCH2, SCRATCH2);
+				emit->AND(SCRATCH1, SCRATCH1, SCRATCH2);
+				emit->FMV(FMv::W, FMv::X, fpr.Map(inst.dest + lane, false, true), SCRATCH1);
+			}
+			break;
+		}
+
+		case IROp::Downcount:
+		{
+			const s32 downcountOffset = (s32)offsetof(MIPSState, downcount);
+			emit->LW(SCRATCH1, CTXREG, downcountOffset);
+			if (FitsInImm12(-(s32)inst.constant)) {
+				emit->ADDIW(SCRATCH1, SCRATCH1, -(s32)inst.constant);
+			} else {
+				emit->LI(SCRATCH2, (s32)inst.constant);
+				emit->SUBW(SCRATCH1, SCRATCH1, SCRATCH2);
+			}
+			emit->SW(SCRATCH1, CTXREG, downcountOffset);
+			break;
+		}
+
+		case IROp::RestoreRoundingMode:
+		case IROp::ApplyRoundingMode:
+		case IROp::UpdateRoundingMode:
+			// Not implemented in the interpreter either.
+			break;
+
+		case IROp::ExitToConst:
+			exitToConst(inst.constant);
+			break;
+		case IROp::ExitToReg:
+		case IROp::ExitToPC:
+		{
+			RiscVReg s = gpr.Map(inst.op == IROp::ExitToPC ? IRREG_PC : inst.src1, true, false);
+			gpr.WriteBackAll();
+			fpr.WriteBackAll();
+			emit->MV(X10, s);
+			QuickJ(emit, exitCode_);
+			break;
+		}
+		case IROp::ExitToConstIfEq:
+		case IROp::ExitToConstIfNeq:
+		case IROp::ExitToConstIfGtZ:
+		case IROp::ExitToConstIfGeZ:
+		case IROp::ExitToConstIfLtZ:
+		case IROp::ExitToConstIfLeZ:
+		{
+			RiscVReg s1 = gpr.Map(inst.src1, true, false);
+			RiscVReg s2 = R_ZERO;
+			if (inst.op == IROp::ExitToConstIfEq || inst.op == IROp::ExitToConstIfNeq)
+				s2 = gpr.Map(inst.src2, true, false);
+			// Branch over the exit when the condition is false.  The mapping stays as is.
+			auto branchIfFalse = [&]() -> FixupBranch {
+				switch (inst.op) {
+				case IROp::ExitToConstIfEq: return emit->BNE(s1, s2);
+				case IROp::ExitToConstIfNeq: return emit->BEQ(s1, s2);
+				case IROp::ExitToConstIfGtZ: return emit->BGE(R_ZERO, s1);
+				case IROp::ExitToConstIfGeZ: return emit->BLT(s1, R_ZERO);
+				case IROp::ExitToConstIfLtZ: return emit->BGE(s1, R_ZERO);
+				default: return emit->BLT(R_ZERO, s1);
+				}
+			};
+			FixupBranch skip = branchIfFalse();
+			exitToConst(inst.constant);
+			emit->SetJumpTarget(skip);
+			break;
+		}
+
+		default:
+		{
+			// Everything else goes through the interpreter, with all state written back.
+			gpr.FlushAll();
+			fpr.FlushAll();
+			u64 instBits;
+			memcpy(&instBits, &inst, sizeof(instBits));
+			emit->MV(X10, CTXREG);
+			emit->LI(X11, instBits, SCRATCH2);
+			emit->LI(SCRATCH1, (uintptr_t)&IRNativeFallback);
+			emit->JALR(R_RA, SCRATCH1, 0);
+			emit->LI(SCRATCH1, (s32)IRNATIVE_FALLBACK_CONTINUE);
+			FixupBranch cont = emit->BEQ(X10, SCRATCH1);
+			QuickJ(emit, exitCode_);
+			emit->SetJumpTarget(cont);
+			break;
+		}
+		}
+	}
+
+	// Blocks always end in an exit. If we got here, the block was badly constructed.
+	gpr.FlushAll();
+	fpr.FlushAll();
+	QuickJ(emit, crashHandler_);
+
+	emit->FlushIcache();
+	emit->EndWrite();
+	return start;
+}
+
+}  // namespace
+
+#endif // PPSSPP_ARCH(RISCV64)
@@ -0,0 +1,37 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+
+namespace MIPSComp {
+
+// Targets RV64GC. Zba/Zbb are used when available.
+class IRToRiscV : public IRToNativeInterface {
+public:
+	void SetCodeBlock(RiscVGen::RiscVCodeBlock *code) { code_ = code; }
+	void GenerateFixedCode() override;
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count) override;
+
+private:
+	RiscVGen::RiscVCodeBlock *code_ = nullptr;
+};
+
+}  // namespace
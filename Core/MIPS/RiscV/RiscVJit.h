@@ -0,0 +1,45 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+#include "Core/MIPS/RiscV/IRToRiscV.h"
+
+namespace MIPSComp {
+
+// Runs IR blocks as native RISC-V code, see IRNativeJit.
+class RiscVJit : public IRNativeJit, public RiscVGen::RiscVCodeBlock {
+public:
+	RiscVJit(MIPSState *mipsState);
+
+protected:
+	void ResetCodeSpace() override {
+		ClearCodeSpace(0);
+	}
+
+private:
+	IRToRiscV backend_;
+};
+
+}  // namespace MIPSComp
+
+#endif
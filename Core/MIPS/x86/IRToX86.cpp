@@ -1,299 +1,1106 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
 #include "ppsspp_config.h"
-#if PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#if PPSSPP_ARCH(AMD64)
 
+#include <cstddef>
+#include <cstring>
+
+#include "Common/ABI.h"
+#include "Common/CPUDetect.h"
+#include "Common/MemoryUtil.h"
+#include "Core/Core.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/x86/IRToX86.h"
+#include "Core/MIPS/x86/RegCache.h"
 
 namespace MIPSComp {
 
-// Initial attempt at converting IR directly to x86.
-// This is intended to be an easy way to benefit from the IR with the current infrastructure.
-// Later tries may go across multiple blocks and a different representation.
+using namespace Gen;
+using namespace X64JitConstants;
 
-struct GPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
-};
+// Converts IR blocks directly to x64, one instruction at a time, with greedy register allocation.
+// Anything not handled natively is run through the IR interpreter, one instruction at a time,
+// after writing everything back. This keeps rarely used ops (and ones with odd edge cases) exact.
 
-struct FPRMapping {
-	Gen::OpArg dest;
-	Gen::OpArg src1;
-	Gen::OpArg src2;
-};
+// RAX, RCX, and RDX are scratch. RBX is the memory base, R14 the context pointer.
+static const X64Reg allocGPRs[] = { RSI, RDI, RBP, R8, R9, R10, R11, R12, R13, R15 };
+// XMM0 and XMM1 are scratch.
+static const X64Reg allocFPRs[] = { XMM2, XMM3, XMM4, XMM5, XMM6, XMM7, XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15 };
+
+static const int NUM_ALLOC_GPRS = (int)(sizeof(allocGPRs) / sizeof(allocGPRs[0]));
+static const int NUM_ALLOC_FPRS = (int)(sizeof(allocFPRs) / sizeof(allocFPRs[0]));
+static const int NUM_IR_REGS = 256;
 
+static_assert(offsetof(MIPSState, pc) == IRREG_PC * 4, "IRREG_PC must match MIPSState");
+
+static OpArg GPRAddr(u8 reg) {
+	return MIPSSTATE_VAR_ELEM32(r[0], reg);
+}
+
+static OpArg FPRAddr(u8 reg) {
+	return MIPSSTATE_VAR_ELEM32(f[0], reg);
+}
 
 class GreedyRegallocGPR {
 public:
-	GPRMapping Map(IRInst inst, const IRMeta &meta);
+	void Start(XEmitter *emit);
+
+	// Maps an IR register into a host register, loading the current value if load is set.
+	// Mapped registers are locked until Unlock(), so they can't be spilled mid-instruction.
+	X64Reg Map(u8 r, bool load, bool dirty);
+	void Unlock();
+
+	// Writes back dirty registers, but keeps the mapping. Used on exit paths.
+	void WriteBackAll();
+	// Writes back and forgets.
+	void Flush(u8 r);
+	void FlushAll();
 
 private:
-	
+	struct HostReg {
+		u8 ir;
+		bool mapped;
+		bool dirty;
+		bool locked;
+		u32 lastUse;
+	};
+
+	int AllocHost();
+	void FlushHost(int h);
+
+	XEmitter *emit_ = nullptr;
+	HostReg hosts_[NUM_ALLOC_GPRS];
+	s8 irToHost_[NUM_IR_REGS];
+	u32 useCounter_ = 0;
 };
 
+void GreedyRegallocGPR::Start(XEmitter *emit) {
+	emit_ = emit;
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		hosts_[i].mapped = false;
+		hosts_[i].dirty = false;
+		hosts_[i].locked = false;
+		hosts_[i].lastUse = 0;
+	}
+	memset(irToHost_, -1, sizeof(irToHost_));
+	useCounter_ = 0;
+}
 
-GPRMapping GreedyRegallocGPR::Map(IRInst inst, const IRMeta &meta) {
-	GPRMapping mapping;
-	if (meta.types[0] == 'G') {
+int GreedyRegallocGPR::AllocHost() {
+	int best = -1;
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		if (!hosts_[i].mapped)
+			return i;
+		if (hosts_[i].locked)
+			continue;
+		if (best == -1 || hosts_[i].lastUse < hosts_[best].lastUse)
+			best = i;
+	}
+	_assert_msg_(best != -1, "IRToX86: Ran out of GPRs");
+	FlushHost(best);
+	return best;
+}
 
+void GreedyRegallocGPR::FlushHost(int h) {
+	HostReg &host = hosts_[h];
+	if (!host.mapped)
+		return;
+	if (host.dirty)
+		emit_->MOV(32, GPRAddr(host.ir), R(allocGPRs[h]));
+	irToHost_[host.ir] = -1;
+	host.mapped = false;
+	host.dirty = false;
+	host.locked = false;
+}
+
+X64Reg GreedyRegallocGPR::Map(u8 r, bool load, bool dirty) {
+	int h = irToHost_[r];
+	if (h == -1) {
+		h = AllocHost();
+		hosts_[h].ir = r;
+		hosts_[h].mapped = true;
+		hosts_[h].dirty = false;
+		irToHost_[r] = h;
+		if (load)
+			emit_->MOV(32, R(allocGPRs[h]), GPRAddr(r));
 	}
-	// etc..
-	return mapping;
+	hosts_[h].lastUse = ++useCounter_;
+	hosts_[h].locked = true;
+	if (dirty)
+		hosts_[h].dirty = true;
+	return allocGPRs[h];
+}
+
+void GreedyRegallocGPR::Unlock() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i)
+		hosts_[i].locked = false;
+}
+
+void GreedyRegallocGPR::WriteBackAll() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i) {
+		if (hosts_[i].mapped && hosts_[i].dirty)
+			emit_->MOV(32, GPRAddr(hosts_[i].ir), R(allocGPRs[i]));
+	}
+}
+
+void GreedyRegallocGPR::Flush(u8 r) {
+	if (irToHost_[r] != -1)
+		FlushHost(irToHost_[r]);
+}
+
+void GreedyRegallocGPR::FlushAll() {
+	for (int i = 0; i < NUM_ALLOC_GPRS; ++i)
+		FlushHost(i);
 }
 
 // Every 4 registers can also be mapped into an SSE register.
 // When changing from single to vec4 mapping, we'll just flush, for now.
+// Single mappings only care about the lowest lane.
 class GreedyRegallocFPR {
 public:
-	FPRMapping Map(IRInst inst, const IRMeta &meta);
+	void Start(XEmitter *emit);
+
+	X64Reg MapSingle(u8 r, bool load, bool dirty);
+	// r must be a multiple of 4.
+	X64Reg MapVec4(u8 r, bool load, bool dirty);
+	void Unlock();
+
+	// Copies the value of r into the lowest lane of xmm, however it's currently mapped.
+	void LoadSingleTo(X64Reg xmm, u8 r);
+
+	void WriteBackAll();
+	void FlushAll();
+
+private:
+	struct HostReg {
+		u8 ir;
+		bool mapped;
+		bool vec4;
+		bool dirty;
+		bool locked;
+		u32 lastUse;
+	};
+
+	int AllocHost();
+	void FlushHost(int h, bool discard = false);
+
+	XEmitter *emit_ = nullptr;
+	HostReg hosts_[NUM_ALLOC_FPRS];
+	s8 irToHost_[NUM_IR_REGS];
+	u32 useCounter_ = 0;
 };
 
-FPRMapping GreedyRegallocFPR::Map(IRInst inst, const IRMeta &meta) {
-	FPRMapping mapping;
+void GreedyRegallocFPR::Start(XEmitter *emit) {
+	emit_ = emit;
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		hosts_[i].mapped = false;
+		hosts_[i].vec4 = false;
+		hosts_[i].dirty = false;
+		hosts_[i].locked = false;
+		hosts_[i].lastUse = 0;
+	}
+	memset(irToHost_, -1, sizeof(irToHost_));
+	useCounter_ = 0;
+}
+
+int GreedyRegallocFPR::AllocHost() {
+	int best = -1;
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		if (!hosts_[i].mapped)
+			return i;
+		if (hosts_[i].locked)
+			continue;
+		if (best == -1 || hosts_[i].lastUse < hosts_[best].lastUse)
+			best = i;
+	}
+	_assert_msg_(best != -1, "IRToX86: Ran out of FPRs");
+	FlushHost(best);
+	return best;
+}
+
+void GreedyRegallocFPR::FlushHost(int h, bool discard) {
+	HostReg &host = hosts_[h];
+	if (!host.mapped)
+		return;
+	if (host.dirty && !discard) {
+		if (host.vec4)
+			emit_->MOVAPS(FPRAddr(host.ir), allocFPRs[h]);
+		else
+			emit_->MOVSS(FPRAddr(host.ir), allocFPRs[h]);
+	}
+	int count = host.vec4 ? 4 : 1;
+	for (int i = 0; i < count; ++i)
+		irToHost_[host.ir + i] = -1;
+	host.mapped = false;
+	host.vec4 = false;
+	host.dirty = false;
+	host.locked = false;
+}
+
+X64Reg GreedyRegallocFPR::MapSingle(u8 r, bool load, bool dirty) {
+	int h = irToHost_[r];
+	if (h != -1 && hosts_[h].vec4) {
+		FlushHost(h);
+		h = -1;
+	}
+	if (h == -1) {
+		h = AllocHost();
+		hosts_[h].ir = r;
+		hosts_[h].mapped = true;
+		hosts_[h].vec4 = false;
+		hosts_[h].dirty = false;
+		irToHost_[r] = h;
+		if (load)
+			emit_->MOVSS(allocFPRs[h], FPRAddr(r));
+	}
+	hosts_[h].lastUse = ++useCounter_;
+	hosts_[h].locked = true;
+	if (dirty)
+		hosts_[h].dirty = true;
+	return allocFPRs[h];
+}
+
+X64Reg GreedyRegallocFPR::MapVec4(u8 r, bool load, bool dirty) {
+	_dbg_assert_((r & 3) == 0);
+	int h = irToHost_[r];
+	if (h == -1 || !hosts_[h].vec4) {
+		// Get rid of any singles, we don't need them if we're not loading.
+		for (int i = 0; i < 4; ++i) {
+			if (irToHost_[r + i] != -1)
+				FlushHost(irToHost_[r + i], !load);
+		}
+
+		h = AllocHost();
+		hosts_[h].ir = r;
+		hosts_[h].mapped = true;
+		hosts_[h].vec4 = true;
+		hosts_[h].dirty = false;
+		for (int i = 0; i < 4; ++i)
+			irToHost_[r + i] = h;
+		if (load)
+			emit_->MOVAPS(allocFPRs[h], FPRAddr(r));
+	}
+	hosts_[h].lastUse = ++useCounter_;
+	hosts_[h].locked = true;
+	if (dirty)
+		hosts_[h].dirty = true;
+	return allocFPRs[h];
+}
+
+void GreedyRegallocFPR::LoadSingleTo(X64Reg xmm, u8 r) {
+	int h = irToHost_[r];
+	if (h == -1) {
+		emit_->MOVSS(xmm, FPRAddr(r));
+	} else if (!hosts_[h].vec4) {
+		emit_->MOVAPS(xmm, R(allocFPRs[h]));
+	} else {
+		int lane = r - hosts_[h].ir;
+		emit_->MOVAPS(xmm, R(allocFPRs[h]));
+		if (lane != 0)
+			emit_->SHUFPS(xmm, R(xmm), (u8)(lane * 0x55));
+	}
+}
+
+void GreedyRegallocFPR::Unlock() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i)
+		hosts_[i].locked = false;
+}
+
+void GreedyRegallocFPR::WriteBackAll() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i) {
+		const HostReg &host = hosts_[i];
+		if (!host.mapped || !host.dirty)
+			continue;
+		if (host.vec4)
+			emit_->MOVAPS(FPRAddr(host.ir), allocFPRs[i]);
+		else
+			emit_->MOVSS(FPRAddr(host.ir), allocFPRs[i]);
+	}
+}
+
+void GreedyRegallocFPR::FlushAll() {
+	for (int i = 0; i < NUM_ALLOC_FPRS; ++i)
+		FlushHost(i);
+}
+
+void IRToX86::GenerateFixedCode() {
+	XCodeBlock *emit = code_;
+	emit->BeginWrite(GetMemoryProtectPageSize());
+	emit->AlignCodePage();
+
+	// Constants, kept close so we can use RIP addressing.
+	alignas(16) static const float vec4InitValues[7][4] = {
+		{ 0.0f, 0.0f, 0.0f, 0.0f },
+		{ 1.0f, 1.0f, 1.0f, 1.0f },
+		{ -1.0f, -1.0f, -1.0f, -1.0f },
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f },
+	};
+	alignas(16) static const u32 signBits[4] = { 0x80000000, 0x80000000, 0x80000000, 0x80000000 };
+	alignas(16) static const u32 noSignMask[4] = { 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF, 0x7FFFFFFF };
+	alignas(16) static const float one[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
 
-	return mapping;
+	auto writeConstant = [&](const void *data, size_t size) {
+		const u8 *ptr = emit->AlignCode16();
+		u8 *writable = emit->GetWritableCodePtr();
+		emit->ReserveCodeSpace((int)size);
+		memcpy(writable, data, size);
+		return ptr;
+	};
+	vec4InitValues_ = (const float *)writeConstant(vec4InitValues, sizeof(vec4InitValues));
+	signBits_ = (const u32 *)writeConstant(signBits, sizeof(signBits));
+	noSignMask_ = (const u32 *)writeConstant(noSignMask, sizeof(noSignMask));
+	one_ = (const float *)writeConstant(one, sizeof(one));
+
+	enterCode_ = (IRNativeEnterFunc)emit->AlignCode16();
+	emit->ABI_PushAllCalleeSavedRegsAndAdjustStack();
+	emit->MOV(64, R(MEMBASEREG), ImmPtr(Memory::base));
+	emit->LEA(64, CTXREG, MDisp(ABI_PARAM1, (int)offsetof(MIPSState, f[0])));
+	emit->JMPptr(R(ABI_PARAM2));
+
+	exitCode_ = emit->AlignCode16();
+	emit->ABI_PopAllCalleeSavedRegsAndAdjustStack();
+	emit->RET();
+
+	// Memory exceptions land here, with the stack as it was in the block.
+	crashHandler_ = emit->AlignCode16();
+	emit->MOV(64, R(RAX), ImmPtr((const void *)&coreState));
+	emit->MOV(32, MatR(RAX), Imm32(CORE_RUNTIME_ERROR));
+	emit->MOV(32, MIPSSTATE_VAR(downcount), Imm32(-1));
+	emit->MOV(32, R(EAX), MIPSSTATE_VAR(pc));
+	emit->JMP(exitCode_, true);
+
+	// Let's spare the pre-generated code from unprotect-reprotect.
+	blocksStart_ = emit->AlignCodePage();
+	emit->EndWrite();
 }
 
+// Computes the PSP address src1 + offset into EAX, and returns the host address operand.
+static OpArg MemAddress(XEmitter *emit, X64Reg addrReg, u32 offset) {
+	if (offset == 0) {
+#ifdef MASKED_PSP_MEMORY
+		emit->MOV(32, R(EAX), R(addrReg));
+		emit->AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+		return MComplex(MEMBASEREG, RAX, SCALE_1, 0);
+#else
+		// 32-bit ops keep the upper bits of mapped registers clear.
+		return MComplex(MEMBASEREG, addrReg, SCALE_1, 0);
+#endif
+	}
+	emit->LEA(32, EAX, MDisp(addrReg, (s32)offset));
+#ifdef MASKED_PSP_MEMORY
+	emit->AND(32, R(EAX), Imm32(Memory::MEMVIEW32_MASK));
+#endif
+	return MComplex(MEMBASEREG, RAX, SCALE_1, 0);
+}
+
+// This requires that the IR has been through IRPassSimplify, but not ThreeOpToTwoOp.
+const u8 *IRToX86::ConvertIRToNative(const IRInst *instructions, int count) {
+	XCodeBlock *emit = code_;
+
+	// Generous estimate: the largest ops are around 64 bytes.
+	size_t sizeEstimate = 128 + (size_t)count * 96;
+	if (emit->GetSpaceLeft() < sizeEstimate)
+		return nullptr;
+
+	emit->BeginWrite(sizeEstimate);
+	const u8 *start = emit->AlignCode16();
 
-// This requires that ThreeOpToTwoOp has been run as the last pass.
-void IRToX86::ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) {
-	// Set up regcaches
-	using namespace Gen;
+	GreedyRegallocGPR gpr;
+	GreedyRegallocFPR fpr;
+	gpr.Start(emit);
+	fpr.Start(emit);
 
-	GreedyRegallocGPR gprAlloc;
-	GreedyRegallocFPR fprAlloc;
+	auto writeBackAll = [&]() {
+		gpr.WriteBackAll();
+		fpr.WriteBackAll();
+	};
+	auto exitToEAX = [&]() {
+		emit->JMP(exitCode_, true);
+	};
+	auto exitToConst = [&](u32 pc) {
+		writeBackAll();
+		emit->MOV(32, R(EAX), Imm32(pc));
+		exitToEAX();
+	};
+	// Only writes back on the exit path, the mapping stays as is.
+	auto exitToConstIf = [&](CCFlags cc, u32 pc) {
+		// Flipping the low bit inverts any x86 condition.
+		FixupBranch skip = emit->J_CC((CCFlags)(cc ^ 1), true);
+		exitToConst(pc);
+		emit->SetJumpTarget(skip);
+	};
+
+	typedef void (XEmitter::*IntOp)(int bits, const OpArg &a1, const OpArg &a2);
+	auto intOp3 = [&](const IRInst &inst, IntOp op, bool symmetric) {
+		X64Reg s1 = gpr.Map(inst.src1, true, false);
+		X64Reg s2 = gpr.Map(inst.src2, true, false);
+		X64Reg d = gpr.Map(inst.dest, false, true);
+		if (d == s1) {
+			(emit->*op)(32, R(d), R(s2));
+		} else if (d == s2 && symmetric) {
+			(emit->*op)(32, R(d), R(s1));
+		} else if (d == s2) {
+			emit->MOV(32, R(EAX), R(s1));
+			(emit->*op)(32, R(EAX), R(s2));
+			emit->MOV(32, R(d), R(EAX));
+		} else {
+			emit->MOV(32, R(d), R(s1));
+			(emit->*op)(32, R(d), R(s2));
+		}
+	};
+	auto intOpConst = [&](const IRInst &inst, IntOp op) {
+		X64Reg s1 = gpr.Map(inst.src1, true, false);
+		X64Reg d = gpr.Map(inst.dest, false, true);
+		if (d != s1)
+			emit->MOV(32, R(d), R(s1));
+		(emit->*op)(32, R(d), Imm32(inst.constant));
+	};
+
+	typedef void (XEmitter::*ShiftOp)(int bits, OpArg dest, OpArg shift);
+	auto shiftImm = [&](const IRInst &inst, ShiftOp op) {
+		X64Reg s1 = gpr.Map(inst.src1, true, false);
+		X64Reg d = gpr.Map(inst.dest, false, true);
+		if (d != s1)
+			emit->MOV(32, R(d), R(s1));
+		if (inst.src2 != 0)
+			(emit->*op)(32, R(d), Imm8(inst.src2));
+	};
+	auto shiftVar = [&](const IRInst &inst, ShiftOp op) {
+		X64Reg s1 = gpr.Map(inst.src1, true, false);
+		X64Reg s2 = gpr.Map(inst.src2, true, false);
+		X64Reg d = gpr.Map(inst.dest, false, true);
+		// x86 masks the shift amount to 5 bits for 32-bit ops, just like MIPS.
+		emit->MOV(32, R(ECX), R(s2));
+		if (d != s1)
+			emit->MOV(32, R(d), R(s1));
+		(emit->*op)(32, R(d), R(CL));
+	};
+	auto compareToReg = [&](const IRInst &inst, CCFlags cc, const OpArg &rhs, X64Reg lhs) {
+		emit->CMP(32, R(lhs), rhs);
+		emit->SETcc(cc, R(EAX));
+		X64Reg d = gpr.Map(inst.dest, false, true);
+		emit->MOVZX(32, 8, d, R(EAX));
+	};
+
+	typedef void (XEmitter::*SSEOp)(X64Reg regOp, OpArg arg);
+	auto fpuOp3 = [&](const IRInst &inst, SSEOp op, bool vec4) {
+		X64Reg s1 = vec4 ? fpr.MapVec4(inst.src1, true, false) : fpr.MapSingle(inst.src1, true, false);
+		X64Reg s2 = vec4 ? fpr.MapVec4(inst.src2, true, false) : fpr.MapSingle(inst.src2, true, false);
+		X64Reg d = vec4 ? fpr.MapVec4(inst.dest, inst.dest == inst.src1 || inst.dest == inst.src2, true) : fpr.MapSingle(inst.dest, false, true);
+		if (d == s1) {
+			(emit->*op)(d, R(s2));
+		} else if (d == s2) {
+			emit->MOVAPS(XMM0, R(s1));
+			(emit->*op)(XMM0, R(s2));
+			emit->MOVAPS(d, R(XMM0));
+		} else {
+			emit->MOVAPS(d, R(s1));
+			(emit->*op)(d, R(s2));
+		}
+	};
+	auto fpuOp2 = [&](const IRInst &inst, SSEOp op, const OpArg &arg, bool vec4) {
+		X64Reg s1 = vec4 ? fpr.MapVec4(inst.src1, true, false) : fpr.MapSingle(inst.src1, true, false);
+		X64Reg d = vec4 ? fpr.MapVec4(inst.dest, inst.dest == inst.src1, true) : fpr.MapSingle(inst.dest, false, true);
+		if (d != s1)
+			emit->MOVAPS(d, R(s1));
+		(emit->*op)(d, arg);
+	};
 
-	// Loop through all the instructions, emitting code as we go.
-	// Note that we do need to implement them all - fallbacks are not permitted.
 	for (int i = 0; i < count; i++) {
-		const IRInst *inst = &instructions[i];
-		const IRMeta &meta = *GetIRMeta(inst->op);
-		GPRMapping gpr = gprAlloc.Map(*inst, meta);
-		FPRMapping fpr = fprAlloc.Map(*inst, meta);
+		const IRInst &inst = instructions[i];
+		gpr.Unlock();
+		fpr.Unlock();
 
-		bool symmetric = false;
-		switch (inst->op) {
+		switch (inst.op) {
 		case IROp::Nop:
-			_assert_(false);
 			break;
 
-			// Output-only
 		case IROp::SetConst:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
+		{
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (inst.constant == 0)
+				emit->XOR(32, R(d), R(d));
+			else
+				emit->MOV(32, R(d), Imm32(inst.constant));
 			break;
+		}
 		case IROp::SetConstF:
-			code_->MOV(32, gpr.dest, Imm32(constants[inst->src1]));
+		{
+			X64Reg d = fpr.MapSingle(inst.dest, false, true);
+			if (inst.constant == 0) {
+				emit->XORPS(d, R(d));
+			} else {
+				emit->MOV(32, R(EAX), Imm32(inst.constant));
+				emit->MOVD_xmm(d, R(EAX));
+			}
 			break;
+		}
 
-			// Add gets to be special cased because we have LEA.
-		case IROp::Add:
-			if (gpr.dest.IsSimpleReg() && gpr.src1.IsSimpleReg() && gpr.src2.IsSimpleReg()) {
-				code_->LEA(32, gpr.dest.GetSimpleReg(), MRegSum(gpr.src1.GetSimpleReg(), gpr.src2.GetSimpleReg()));
-				break;
-			}
-			// Else fall through.
-			// 3-op arithmetic that directly corresponds to x86
-			// (often 2-op in practice if src1 == dst). x86 only does 2-op though so some of these will need splitting.
-		case IROp::Sub:
-		case IROp::And:
-		case IROp::Or:
-		case IROp::Xor:
-			if (inst->src1 != inst->dest) {
-				code_->MOV(32, gpr.dest, gpr.src1);
-			}
-			// Emit directly
-			switch (inst->op) {
-			case IROp::Add: code_->ADD(32, gpr.dest, gpr.src2); break;
-			case IROp::Sub: code_->SUB(32, gpr.dest, gpr.src2); break;
-			case IROp::And: code_->AND(32, gpr.dest, gpr.src2); break;
-			case IROp::Or: code_->OR(32, gpr.dest, gpr.src2); break;
-			case IROp::Xor: code_->XOR(32, gpr.dest, gpr.src2); break;
+		case IROp::Mov:
+		case IROp::MtLo:
+		case IROp::MtHi:
+		case IROp::MfLo:
+		case IROp::MfHi:
+		case IROp::FpCondToReg:
+		case IROp::VfpuCtrlToReg:
+		case IROp::SetCtrlVFPUReg:
+		case IROp::SetPC:
+		{
+			// These are all just moves between IR GPRs, only the indices differ.
+			u8 src = inst.src1;
+			u8 dest = inst.dest;
+			switch (inst.op) {
+			case IROp::MtLo: dest = IRREG_LO; break;
+			case IROp::MtHi: dest = IRREG_HI; break;
+			case IROp::MfLo: src = IRREG_LO; break;
+			case IROp::MfHi: src = IRREG_HI; break;
+			case IROp::FpCondToReg: src = IRREG_FPCOND; break;
+			case IROp::VfpuCtrlToReg: src = IRREG_VFPU_CTRL_BASE + inst.src1; break;
+			case IROp::SetCtrlVFPUReg: dest = IRREG_VFPU_CTRL_BASE + inst.dest; break;
+			case IROp::SetPC: dest = IRREG_PC; break;
+			default: break;
 			}
+			if (src == dest)
+				break;
+			X64Reg s = gpr.Map(src, true, false);
+			X64Reg d = gpr.Map(dest, false, true);
+			emit->MOV(32, R(d), R(s));
 			break;
+		}
 
-			// Variable shifts.
-		case IROp::Shl:
-		case IROp::Shr:
-		case IROp::Sar:
-		case IROp::Ror:
+		case IROp::SetPCConst:
+			emit->MOV(32, R(gpr.Map(IRREG_PC, false, true)), Imm32(inst.constant));
+			break;
+		case IROp::ZeroFpCond:
+		{
+			X64Reg d = gpr.Map(IRREG_FPCOND, false, true);
+			emit->XOR(32, R(d), R(d));
+			break;
+		}
+		case IROp::SetCtrlVFPU:
+			emit->MOV(32, R(gpr.Map(IRREG_VFPU_CTRL_BASE + inst.dest, false, true)), Imm32(inst.constant));
+			break;
+		case IROp::SetCtrlVFPUFReg:
+		{
+			X64Reg s = fpr.MapSingle(inst.src1, true, false);
+			X64Reg d = gpr.Map(IRREG_VFPU_CTRL_BASE + inst.dest, false, true);
+			emit->MOVD_xmm(R(d), s);
+			break;
+		}
 
-		case IROp::Slt:
-		case IROp::SltU:
-		case IROp::MovZ:
-		case IROp::MovNZ:
-		case IROp::Max:
-		case IROp::Min:
+		case IROp::Add:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (d == s1)
+				emit->ADD(32, R(d), R(s2));
+			else if (d == s2)
+				emit->ADD(32, R(d), R(s1));
+			else
+				emit->LEA(32, d, MRegSum(s1, s2));
 			break;
+		}
+		case IROp::Sub: intOp3(inst, &XEmitter::SUB, false); break;
+		case IROp::And: intOp3(inst, &XEmitter::AND, true); break;
+		case IROp::Or: intOp3(inst, &XEmitter::OR, true); break;
+		case IROp::Xor: intOp3(inst, &XEmitter::XOR, true); break;
 
-			// 2-op arithmetic with constant
 		case IROp::AddConst:
-		case IROp::SubConst:
-		case IROp::AndConst:
-		case IROp::OrConst:
-		case IROp::XorConst:
-		case IROp::SltConst:
-		case IROp::SltUConst:
-
-			// 2-op arithmetic with immediate
-		case IROp::ShlImm:
-		case IROp::ShrImm:
-		case IROp::SarImm:
-		case IROp::RorImm:
-
-			// 2-op arithmetic
-		case IROp::Mov:
-			code_->MOV(32, gpr.dest, gpr.src1);
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (d == s1)
+				emit->ADD(32, R(d), Imm32(inst.constant));
+			else
+				emit->LEA(32, d, MDisp(s1, (s32)inst.constant));
 			break;
+		}
+		case IROp::SubConst: intOpConst(inst, &XEmitter::SUB); break;
+		case IROp::AndConst: intOpConst(inst, &XEmitter::AND); break;
+		case IROp::OrConst: intOpConst(inst, &XEmitter::OR); break;
+		case IROp::XorConst: intOpConst(inst, &XEmitter::XOR); break;
 
 		case IROp::Neg:
 		case IROp::Not:
+		case IROp::BSwap32:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (d != s1)
+				emit->MOV(32, R(d), R(s1));
+			if (inst.op == IROp::Neg)
+				emit->NEG(32, R(d));
+			else if (inst.op == IROp::Not)
+				emit->NOT(32, R(d));
+			else
+				emit->BSWAP(32, d);
+			break;
+		}
+		case IROp::BSwap16:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (d != s1)
+				emit->MOV(32, R(d), R(s1));
+			// Swapping all four, then the halves back, swaps within each half.
+			emit->BSWAP(32, d);
+			emit->ROR(32, R(d), Imm8(16));
+			break;
+		}
 		case IROp::Ext8to32:
 		case IROp::Ext16to32:
-		case IROp::ReverseBits:
-		case IROp::BSwap16:
-		case IROp::BSwap32:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			emit->MOVSX(32, inst.op == IROp::Ext8to32 ? 8 : 16, d, R(s1));
+			break;
+		}
 		case IROp::Clz:
-			if (inst->dest != inst->src1) {
-				code_->NEG(32, gpr.dest); break;
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			if (cpu_info.bLZCNT) {
+				emit->LZCNT(32, d, R(s1));
+			} else {
+				emit->BSR(32, EAX, R(s1));
+				FixupBranch notFound = emit->J_CC(CC_Z);
+				emit->XOR(32, R(EAX), Imm8(31));
+				FixupBranch done = emit->J();
+				emit->SetJumpTarget(notFound);
+				emit->MOV(32, R(EAX), Imm32(32));
+				emit->SetJumpTarget(done);
+				emit->MOV(32, R(d), R(EAX));
 			}
 			break;
-				// Multiplier control
-		case IROp::MtLo:
-		case IROp::MtHi:
-		case IROp::MfLo:
-		case IROp::MfHi:
+		}
+
+		case IROp::ShlImm: shiftImm(inst, &XEmitter::SHL); break;
+		case IROp::ShrImm: shiftImm(inst, &XEmitter::SHR); break;
+		case IROp::SarImm: shiftImm(inst, &XEmitter::SAR); break;
+		case IROp::RorImm: shiftImm(inst, &XEmitter::ROR); break;
+		case IROp::Shl: shiftVar(inst, &XEmitter::SHL); break;
+		case IROp::Shr: shiftVar(inst, &XEmitter::SHR); break;
+		case IROp::Sar: shiftVar(inst, &XEmitter::SAR); break;
+		case IROp::Ror: shiftVar(inst, &XEmitter::ROR); break;
+
+		case IROp::Slt:
+		case IROp::SltU:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			compareToReg(inst, inst.op == IROp::Slt ? CC_L : CC_B, R(s2), s1);
+			break;
+		}
+		case IROp::SltConst:
+		case IROp::SltUConst:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			compareToReg(inst, inst.op == IROp::SltConst ? CC_L : CC_B, Imm32(inst.constant), s1);
+			break;
+		}
+
+		case IROp::MovZ:
+		case IROp::MovNZ:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			X64Reg d = gpr.Map(inst.dest, true, true);
+			emit->TEST(32, R(s1), R(s1));
+			emit->CMOVcc(32, d, R(s2), inst.op == IROp::MovZ ? CC_Z : CC_NZ);
+			break;
+		}
+		case IROp::Max:
+		case IROp::Min:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			emit->MOV(32, R(EAX), R(s1));
+			emit->CMP(32, R(EAX), R(s2));
+			emit->CMOVcc(32, EAX, R(s2), inst.op == IROp::Max ? CC_L : CC_G);
+			emit->MOV(32, R(d), R(EAX));
+			break;
+		}
+
 		case IROp::Mult:
 		case IROp::MultU:
 		case IROp::Madd:
 		case IROp::MaddU:
 		case IROp::Msub:
 		case IROp::MsubU:
-		case IROp::Div:
-		case IROp::DivU:
+		{
+			// lo and hi are adjacent, so we treat them as one 64-bit value in memory.
+			bool isSigned = inst.op == IROp::Mult || inst.op == IROp::Madd || inst.op == IROp::Msub;
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			if (isSigned) {
+				emit->MOVSX(64, 32, RAX, R(s1));
+				emit->MOVSX(64, 32, RDX, R(s2));
+			} else {
+				emit->MOV(32, R(EAX), R(s1));
+				emit->MOV(32, R(EDX), R(s2));
+			}
+			emit->IMUL(64, RAX, R(RDX));
+			gpr.Flush(IRREG_LO);
+			gpr.Flush(IRREG_HI);
+			if (inst.op == IROp::Mult || inst.op == IROp::MultU)
+				emit->MOV(64, MIPSSTATE_VAR(lo), R(RAX));
+			else if (inst.op == IROp::Madd || inst.op == IROp::MaddU)
+				emit->ADD(64, MIPSSTATE_VAR(lo), R(RAX));
+			else
+				emit->SUB(64, MIPSSTATE_VAR(lo), R(RAX));
+			break;
+		}
 
-			// Memory access
 		case IROp::Load8:
 		case IROp::Load8Ext:
 		case IROp::Load16:
 		case IROp::Load16Ext:
 		case IROp::Load32:
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			OpArg src = MemAddress(emit, addr, inst.constant);
+			X64Reg d = gpr.Map(inst.dest, false, true);
+			switch (inst.op) {
+			case IROp::Load8: emit->MOVZX(32, 8, d, src); break;
+			case IROp::Load8Ext: emit->MOVSX(32, 8, d, src); break;
+			case IROp::Load16: emit->MOVZX(32, 16, d, src); break;
+			case IROp::Load16Ext: emit->MOVSX(32, 16, d, src); break;
+			default: emit->MOV(32, R(d), src); break;
+			}
+			break;
+		}
 		case IROp::LoadFloat:
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			OpArg src = MemAddress(emit, addr, inst.constant);
+			emit->MOVSS(fpr.MapSingle(inst.dest, false, true), src);
+			break;
+		}
+		case IROp::LoadVec4:
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			OpArg src = MemAddress(emit, addr, inst.constant);
+			emit->MOVAPS(fpr.MapVec4(inst.dest, false, true), src);
+			break;
+		}
 		case IROp::Store8:
 		case IROp::Store16:
 		case IROp::Store32:
-		case IROp::StoreFloat:
-		case IROp::LoadVec4:
-		case IROp::StoreVec4:
-
-			// Output-only SIMD functions
-		case IROp::Vec4Init:
-		case IROp::Vec4Shuffle:
-
-			// 2-op SIMD functions
-		case IROp::Vec4Mov:
-			code_->MOVAPS(fpr.dest.GetSimpleReg(), fpr.src1);
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			X64Reg value = gpr.Map(inst.src3, true, false);
+			OpArg dest = MemAddress(emit, addr, inst.constant);
+			int bits = inst.op == IROp::Store8 ? 8 : (inst.op == IROp::Store16 ? 16 : 32);
+			emit->MOV(bits, dest, R(value));
 			break;
-		case IROp::Vec4Neg:
-		case IROp::Vec4Abs:
+		}
+		case IROp::StoreFloat:
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			X64Reg value = fpr.MapSingle(inst.src3, true, false);
+			emit->MOVSS(MemAddress(emit, addr, inst.constant), value);
 			break;
-		case IROp::Vec4ClampToZero:
-			code_->PXOR(XMM0, R(XMM0));
-			code_->PMAXSW(XMM0, fpr.src1);
-			code_->MOVAPD(fpr.dest, XMM0);
+		}
+		case IROp::StoreVec4:
+		{
+			X64Reg addr = gpr.Map(inst.src1, true, false);
+			X64Reg value = fpr.MapVec4(inst.src3, true, false);
+			emit->MOVAPS(MemAddress(emit, addr, inst.constant), value);
 			break;
-		case IROp::Vec4DuplicateUpperBitsAndShift1:
-		case IROp::Vec2ClampToZero:
-
-			// 3-op SIMD functions
-		case IROp::Vec4Add:
-		case IROp::Vec4Sub:
-		case IROp::Vec4Mul:
-		case IROp::Vec4Div:
-
-		case IROp::Vec4Scale:
-		case IROp::Vec4Dot:
-
-			// Pack-unpack
-		case IROp::Vec2Unpack16To31:
-		case IROp::Vec2Unpack16To32:
-		case IROp::Vec4Unpack8To32:
-		case IROp::Vec2Pack32To16:
-		case IROp::Vec2Pack31To16:
-		case IROp::Vec4Pack32To8:
-		case IROp::Vec4Pack31To8:
-
-		case IROp::FCmpVfpuBit:
-		case IROp::FCmpVfpuAggregate:
-		case IROp::FCmovVfpuCC:
-
-			// Trancendental functions (non-simd)
-		case IROp::FSin:
-		case IROp::FCos:
-		case IROp::FRSqrt:
-		case IROp::FRecip:
-		case IROp::FAsin:
+		}
 
-			// 3-Op FP
-		case IROp::FAdd:
-		case IROp::FSub:
+		case IROp::FAdd: fpuOp3(inst, &XEmitter::ADDSS, false); break;
+		case IROp::FSub: fpuOp3(inst, &XEmitter::SUBSS, false); break;
+		case IROp::FDiv: fpuOp3(inst, &XEmitter::DIVSS, false); break;
 		case IROp::FMul:
-		case IROp::FDiv:
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			X64Reg s2 = fpr.MapSingle(inst.src2, true, false);
+			emit->MOVAPS(XMM0, R(s1));
+			emit->MULSS(XMM0, R(s2));
+			// x86 gives a negative NaN for inf * 0, but we want a positive one.
+			emit->UCOMISS(XMM0, R(XMM0));
+			FixupBranch notNaN = emit->J_CC(CC_NP);
+			emit->UCOMISS(s1, R(s2));
+			FixupBranch hadNaN = emit->J_CC(CC_P);
+			emit->MOV(32, R(EAX), Imm32(0x7fc00000));
+			emit->MOVD_xmm(XMM0, R(EAX));
+			emit->SetJumpTarget(notNaN);
+			emit->SetJumpTarget(hadNaN);
+			emit->MOVAPS(fpr.MapSingle(inst.dest, false, true), R(XMM0));
+			break;
+		}
 		case IROp::FMin:
 		case IROp::FMax:
-
-			// 2-Op FP
+		{
+			// std::min/max return the first arg when unordered, MINSS/MAXSS return the second.
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			X64Reg s2 = fpr.MapSingle(inst.src2, true, false);
+			emit->MOVAPS(XMM0, R(s2));
+			if (inst.op == IROp::FMin)
+				emit->MINSS(XMM0, R(s1));
+			else
+				emit->MAXSS(XMM0, R(s1));
+			emit->MOVAPS(fpr.MapSingle(inst.dest, false, true), R(XMM0));
+			break;
+		}
 		case IROp::FMov:
-		case IROp::FAbs:
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			X64Reg d = fpr.MapSingle(inst.dest, false, true);
+			if (d != s1)
+				emit->MOVAPS(d, R(s1));
+			break;
+		}
+		case IROp::FAbs: fpuOp2(inst, &XEmitter::ANDPS, M(noSignMask_), false); break;
+		case IROp::FNeg: fpuOp2(inst, &XEmitter::XORPS, M(signBits_), false); break;
 		case IROp::FSqrt:
-		case IROp::FNeg:
-		case IROp::FSat0_1:
-		case IROp::FSatMinus1_1:
-		case IROp::FSign:
-		case IROp::FCeil:
-		case IROp::FFloor:
-		case IROp::FCmp:
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			emit->SQRTSS(fpr.MapSingle(inst.dest, false, true), R(s1));
+			break;
+		}
+		case IROp::FRSqrt:
+		case IROp::FRecip:
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			if (inst.op == IROp::FRSqrt)
+				emit->SQRTSS(XMM1, R(s1));
+			else
+				emit->MOVAPS(XMM1, R(s1));
+			emit->MOVSS(XMM0, M(one_));
+			emit->DIVSS(XMM0, R(XMM1));
+			emit->MOVAPS(fpr.MapSingle(inst.dest, false, true), R(XMM0));
+			break;
+		}
 		case IROp::FCvtSW:
-		case IROp::FCvtWS:
-		case IROp::FRound:
-		case IROp::FTrunc:
-
-			// Cross moves
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			emit->CVTDQ2PS(fpr.MapSingle(inst.dest, false, true), R(s1));
+			break;
+		}
 		case IROp::FMovFromGPR:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			emit->MOVD_xmm(fpr.MapSingle(inst.dest, false, true), R(s1));
+			break;
+		}
 		case IROp::FMovToGPR:
-		case IROp::FpCondToReg:
-		case IROp::VfpuCtrlToReg:
+		{
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			emit->MOVD_xmm(R(gpr.Map(inst.dest, false, true)), s1);
+			break;
+		}
 
-			// VFPU flag/control
-		case IROp::SetCtrlVFPU:
-		case IROp::SetCtrlVFPUReg:
-		case IROp::SetCtrlVFPUFReg:
-		case IROp::ZeroFpCond:
+		case IROp::FCmp:
+		{
+			if (inst.dest == IRFpCompareMode::False) {
+				X64Reg d = gpr.Map(IRREG_FPCOND, false, true);
+				emit->XOR(32, R(d), R(d));
+				break;
+			}
+			X64Reg s1 = fpr.MapSingle(inst.src1, true, false);
+			X64Reg s2 = fpr.MapSingle(inst.src2, true, false);
+			switch (inst.dest) {
+			case IRFpCompareMode::EitherUnordered:
+				emit->UCOMISS(s1, R(s2));
+				emit->SETcc(CC_P, R(EAX));
+				break;
+			case IRFpCompareMode::EqualOrdered:
+				emit->UCOMISS(s1, R(s2));
+				emit->SETcc(CC_E, R(EAX));
+				emit->SETcc(CC_NP, R(ECX));
+				emit->AND(32, R(EAX), R(ECX));
+				break;
+			case IRFpCompareMode::EqualUnordered:
+				emit->UCOMISS(s1, R(s2));
+				emit->SETcc(CC_E, R(EAX));
+				break;
+			case IRFpCompareMode::LessOrdered:
+				emit->UCOMISS(s2, R(s1));
+				emit->SETcc(CC_A, R(EAX));
+				break;
+			case IRFpCompareMode::LessEqualOrdered:
+				emit->UCOMISS(s2, R(s1));
+				emit->SETcc(CC_AE, R(EAX));
+				break;
+			case IRFpCompareMode::LessUnordered:
+				emit->UCOMISS(s1, R(s2));
+				emit->SETcc(CC_B, R(EAX));
+				break;
+			case IRFpCompareMode::LessEqualUnordered:
+				emit->UCOMISS(s1, R(s2));
+				emit->SETcc(CC_BE, R(EAX));
+				break;
+			}
+			emit->MOVZX(32, 8, gpr.Map(IRREG_FPCOND, false, true), R(EAX));
+			break;
+		}
+
+		case IROp::Vec4Init:
+			emit->MOVAPS(fpr.MapVec4(inst.dest, false, true), M(vec4InitValues_ + inst.src1 * 4));
+			break;
+		case IROp::Vec4Shuffle:
+		{
+			X64Reg s1 = fpr.MapVec4(inst.src1, true, false);
+			X64Reg d = fpr.MapVec4(inst.dest, inst.dest == inst.src1, true);
+			emit->MOVAPS(XMM0, R(s1));
+			emit->SHUFPS(XMM0, R(XMM0), inst.src2);
+			emit->MOVAPS(d, R(XMM0));
+			break;
+		}
+		case IROp::Vec4Mov:
+		{
+			X64Reg s1 = fpr.MapVec4(inst.src1, true, false);
+			X64Reg d = fpr.MapVec4(inst.dest, inst.dest == inst.src1, true);
+			if (d != s1)
+				emit->MOVAPS(d, R(s1));
+			break;
+		}
+		case IROp::Vec4Add: fpuOp3(inst, &XEmitter::ADDPS, true); break;
+		case IROp::Vec4Sub: fpuOp3(inst, &XEmitter::SUBPS, true); break;
+		case IROp::Vec4Mul: fpuOp3(inst, &XEmitter::MULPS, true); break;
+		case IROp::Vec4Div: fpuOp3(inst, &XEmitter::DIVPS, true); break;
+		case IROp::Vec4Neg: fpuOp2(inst, &XEmitter::XORPS, M(signBits_), true); break;
+		case IROp::Vec4Abs: fpuOp2(inst, &XEmitter::ANDPS, M(noSignMask_), true); break;
+		case IROp::Vec4Scale:
+		{
+			// The scale may live inside a vec4, even the source one.
+			X64Reg s1 = fpr.MapVec4(inst.src1, true, false);
+			fpr.LoadSingleTo(XMM1, inst.src2);
+			emit->SHUFPS(XMM1, R(XMM1), 0);
+			X64Reg d = fpr.MapVec4(inst.dest, inst.dest == inst.src1, true);
+			if (d != s1)
+				emit->MOVAPS(d, R(s1));
+			emit->MULPS(d, R(XMM1));
+			break;
+		}
+		case IROp::Vec4Dot:
+		{
+			// Add sequentially, to match the interpreter's rounding.
+			X64Reg s1 = fpr.MapVec4(inst.src1, true, false);
+			X64Reg s2 = fpr.MapVec4(inst.src2, true, false);
+			emit->MOVAPS(XMM0, R(s1));
+			emit->MULPS(XMM0, R(s2));
+			for (int lane = 1; lane < 4; ++lane) {
+				emit->MOVAPS(XMM1, R(XMM0));
+				emit->SHUFPS(XMM1, R(XMM1), (u8)(lane * 0x55));
+				emit->ADDSS(XMM0, R(XMM1));
+			}
+			// The dest may be inside one of the sources, which can go now.
+			fpr.Unlock();
+			emit->MOVAPS(fpr.MapSingle(inst.dest, false, true), R(XMM0));
+			break;
+		}
+		case IROp::Vec4ClampToZero:
+		{
+			X64Reg s1 = fpr.MapVec4(inst.src1, true, false);
+			X64Reg d = fpr.MapVec4(inst.dest, inst.dest == inst.src1, true);
+			// Expand the sign bit, and use andnot to zero negative values.
+			emit->MOVAPS(XMM0, R(s1));
+			emit->PSRAD(XMM0, 31);
+			emit->PANDN(XMM0, R(s1));
+			emit->MOVAPS(d, R(XMM0));
+			break;
+		}
+
+		case IROp::Downcount:
+			emit->SUB(32, MIPSSTATE_VAR(downcount), Imm32(inst.constant));
+			break;
+
+		case IROp::RestoreRoundingMode:
+		case IROp::ApplyRoundingMode:
+		case IROp::UpdateRoundingMode:
+			// Not implemented in the interpreter either.
+			break;
 
-			// Block Exits
 		case IROp::ExitToConst:
+			exitToConst(inst.constant);
+			break;
 		case IROp::ExitToReg:
+		case IROp::ExitToPC:
+		{
+			X64Reg s = gpr.Map(inst.op == IROp::ExitToPC ? IRREG_PC : inst.src1, true, false);
+			writeBackAll();
+			emit->MOV(32, R(EAX), R(s));
+			exitToEAX();
+			break;
+		}
 		case IROp::ExitToConstIfEq:
 		case IROp::ExitToConstIfNeq:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			X64Reg s2 = gpr.Map(inst.src2, true, false);
+			emit->CMP(32, R(s1), R(s2));
+			exitToConstIf(inst.op == IROp::ExitToConstIfEq ? CC_E : CC_NE, inst.constant);
+			break;
+		}
 		case IROp::ExitToConstIfGtZ:
 		case IROp::ExitToConstIfGeZ:
 		case IROp::ExitToConstIfLtZ:
 		case IROp::ExitToConstIfLeZ:
-		case IROp::ExitToPC:
+		{
+			X64Reg s1 = gpr.Map(inst.src1, true, false);
+			emit->CMP(32, R(s1), Imm8(0));
+			CCFlags cc = CC_G;
+			if (inst.op == IROp::ExitToConstIfGeZ)
+				cc = CC_GE;
+			else if (inst.op == IROp::ExitToConstIfLtZ)
+				cc = CC_L;
+			else if (inst.op == IROp::ExitToConstIfLeZ)
+				cc = CC_LE;
+			exitToConstIf(cc, inst.constant);
+			break;
+		}
 
-			// Utilities
-		case IROp::Downcount:
-		case IROp::SetPC:
-		case IROp::SetPCConst:
-		case IROp::Syscall:
-		case IROp::Interpret:  // SLOW fallback. Can be made faster.
-		case IROp::CallReplacement:
-		case IROp::Break:
 		default:
+		{
+			// Everything else goes through the interpreter, with all state written back.
+			gpr.FlushAll();
+			fpr.FlushAll();
+			u64 instBits;
+			memcpy(&instBits, &inst, sizeof(instBits));
+			emit->LEA(64, ABI_PARAM1, MDisp(CTXREG, -(int)offsetof(MIPSState, f[0])));
+			emit->MOV(64, R(ABI_PARAM2), Imm64(instBits));
+			emit->ABI_CallFunction((const void *)&IRNativeFallback);
+			emit->CMP(32, R(EAX), Imm8(IRNATIVE_FALLBACK_CONTINUE));
+			emit->J_CC(CC_NE, exitCode_, true);
 			break;
-			}
+		}
 		}
 	}
 
+	// Blocks always end in an exit. If we got here, the block was badly constructed.
+	gpr.FlushAll();
+	fpr.FlushAll();
+	emit->JMP(crashHandler_, true);
+
+	emit->EndWrite();
+	return start;
+}
 
 }  // namespace
 
-#endif // PPSSPP_ARCH(X86) || PPSSPP_ARCH(AMD64)
+#endif // PPSSPP_ARCH(AMD64)
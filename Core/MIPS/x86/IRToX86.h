@@ -1,23 +1,42 @@
-#include "Core/MIPS/IR/IRInst.h"
-#include "Common/x64Emitter.h"
+// Copyright (c) 2016- PPSSPP Project.
 
-namespace MIPSComp {
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
 
-class IRToNativeInterface {
-public:
-	virtual ~IRToNativeInterface() {}
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
 
-	virtual void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) = 0;
-};
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#pragma once
+
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+#include "Common/x64Emitter.h"
+
+namespace MIPSComp {
 
 class IRToX86 : public IRToNativeInterface {
 public:
 	void SetCodeBlock(Gen::XCodeBlock *code) { code_ = code; }
-	void ConvertIRToNative(const IRInst *instructions, int count, const u32 *constants) override;
+	void GenerateFixedCode() override;
+	const u8 *ConvertIRToNative(const IRInst *instructions, int count) override;
 
 private:
-	Gen::XCodeBlock *code_;
+	Gen::XCodeBlock *code_ = nullptr;
+
+	// Constants used by the generated code, within RIP range.
+	const float *vec4InitValues_ = nullptr;
+	const u32 *signBits_ = nullptr;
+	const u32 *noSignMask_ = nullptr;
+	const float *one_ = nullptr;
 };
 
 }  // namespace
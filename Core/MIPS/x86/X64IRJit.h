@@ -0,0 +1,45 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(AMD64)
+
+#include "Common/x64Emitter.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+#include "Core/MIPS/x86/IRToX86.h"
+
+namespace MIPSComp {
+
+// Runs IR blocks as native x64 code, see IRNativeJit.
+class X64IRJit : public IRNativeJit, public Gen::XCodeBlock {
+public:
+	X64IRJit(MIPSState *mipsState);
+
+protected:
+	void ResetCodeSpace() override {
+		ClearCodeSpace(0);
+	}
+
+private:
+	IRToX86 backend_;
+};
+
+}  // namespace MIPSComp
+
+#endif
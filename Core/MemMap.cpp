@@ -22,6 +22,7 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <mutex>
 
 #include "Common/Common.h"
@@ -382,6 +383,9 @@ void DoState(PointerWrap &p) {
 	p.DoMarker("VRAM");
 	DoArray(p, m_pPhysicalScratchPad, SCRATCHPAD_SIZE);
 	p.DoMarker("ScratchPad");
+
+	if (p.mode == PointerWrap::MODE_READ)
+		MarkAllWritten();
 }
 
 void Shutdown() {
@@ -490,9 +494,62 @@ void Memset(const u32 _Address, const u8 _iValue, const u32 _iLength, const char
 			Write_U8(_iValue, (u32)(_Address + i));
 	}
 
+	MarkWritten(_Address, _iLength);
 	NotifyMemInfo(MemBlockFlags::WRITE, _Address, _iLength, tag, strlen(tag));
 }
 
+static const u32 WRITE_TRACK_PAGE_SHIFT = 12;
+// VRAM is folded over its mirrors, RAM is sized for the largest remaster.
+static std::atomic<u32> vramWriteStamps[VRAM_SIZE >> WRITE_TRACK_PAGE_SHIFT];
+static std::atomic<u32> ramWriteStamps[RAM_DOUBLE_SIZE * 2 >> WRITE_TRACK_PAGE_SHIFT];
+static std::atomic<u32> writeStamp{ 1 };
+static std::atomic<u32> allWrittenStamp{ 0 };
+
+static std::atomic<u32> *WriteStampSlot(u32 address) {
+	address &= 0x3FFFFFFF;
+	if ((address & 0x3F800000) == 0x04000000) {
+		return &vramWriteStamps[(address & (VRAM_SIZE - 1)) >> WRITE_TRACK_PAGE_SHIFT];
+	} else if (address >= 0x08000000 && address < 0x08000000 + RAM_DOUBLE_SIZE * 2) {
+		return &ramWriteStamps[(address - 0x08000000) >> WRITE_TRACK_PAGE_SHIFT];
+	}
+	return nullptr;
+}
+
+u32 NextWriteStamp() {
+	// Writes from now on get the new value, so they compare as after this stamp.
+	return writeStamp.fetch_add(1) + 1;
+}
+
+void MarkWritten(u32 address, u32 size) {
+	if (size == 0)
+		return;
+	const u32 stamp = writeStamp.load(std::memory_order_relaxed);
+	const u32 end = address + size - 1 < address ? 0xFFFFFFFF : address + size - 1;
+	for (u64 page = address >> WRITE_TRACK_PAGE_SHIFT; page <= (end >> WRITE_TRACK_PAGE_SHIFT); ++page) {
+		std::atomic<u32> *slot = WriteStampSlot((u32)page << WRITE_TRACK_PAGE_SHIFT);
+		if (slot)
+			slot->store(stamp, std::memory_order_relaxed);
+	}
+}
+
+void MarkAllWritten() {
+	allWrittenStamp = NextWriteStamp();
+}
+
+bool WrittenSince(u32 address, u32 size, u32 stamp) {
+	if ((s32)(allWrittenStamp.load(std::memory_order_relaxed) - stamp) >= 0)
+		return true;
+	const u32 end = address + (size == 0 ? 0 : size - 1);
+	if (end < address)
+		return true;
+	for (u64 page = address >> WRITE_TRACK_PAGE_SHIFT; page <= (end >> WRITE_TRACK_PAGE_SHIFT); ++page) {
+		const std::atomic<u32> *slot = WriteStampSlot((u32)page << WRITE_TRACK_PAGE_SHIFT);
+		if (!slot || (s32)(slot->load(std::memory_order_relaxed) - stamp) >= 0)
+			return true;
+	}
+	return false;
+}
+
 } // namespace
 
 void PSPPointerNotifyRW(int rw, uint32_t ptr, uint32_t bytes, const char * tag, size_t tagLen) {
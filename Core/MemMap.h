@@ -334,6 +334,16 @@ inline bool IsValidRange(const u32 address, const u32 size) {
 	return IsValidAddress(address) && ValidSize(address, size) == size;
 }
 
+// Coarse tracking of bulk writes to RAM and VRAM, per 4KB page.  Fed by Memcpy/Memset, GE
+// transfers and cache writebacks - the CPU jits store directly, so those writes aren't seen.
+// A consumer takes a stamp before reading memory, and can later ask if anything was written since.
+u32 NextWriteStamp();
+void MarkWritten(u32 address, u32 size);
+// Treats all memory as written, i.e. after loading a savestate.
+void MarkAllWritten();
+// Conservative: true for untracked addresses, or if the stamp is from before MarkAllWritten.
+bool WrittenSince(u32 address, u32 size, u32 stamp);
+
 }  // namespace Memory
 
 // Avoiding a global include for NotifyMemInfo.
@@ -35,6 +35,7 @@ inline void Memcpy(const u32 to_address, const void *from_data, const u32 len, c
 	u8 *to = GetPointerWriteRange(to_address, len);
 	if (to) {
 		memcpy(to, from_data, len);
+		MarkWritten(to_address, len);
 		if (!tag) {
 			tag = "Memcpy";
 			tagLen = sizeof("Memcpy") - 1;
@@ -67,6 +68,7 @@ inline void Memcpy(const u32 to_address, const u32 from_address, const u32 len,
 		return;
 
 	memcpy(to, from, len);
+	MarkWritten(to_address, len);
 
 	if (MemBlockInfoDetailed(len)) {
 		char tagData[128];
@@ -31,6 +31,7 @@
 #include "Common/TimeUtil.h"
 
 #include "Core/SaveState.h"
+#include "Core/SaveStateRewind.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -102,155 +103,13 @@ namespace SaveState
 		return CChunkFileReader::LoadPtr(&data[0], state, errorString);
 	}
 
-	struct StateRingbuffer
-	{
-		StateRingbuffer(int size) : first_(0), next_(0), size_(size), base_(-1)
-		{
-			states_.resize(size);
-			baseMapping_.resize(size);
-		}
-
-		CChunkFileReader::Error Save()
-		{
-			std::lock_guard<std::mutex> guard(lock_);
-
-			int n = next_++ % size_;
-			if ((next_ % size_) == first_)
-				++first_;
-
-			static std::vector<u8> buffer;
-			std::vector<u8> *compressBuffer = &buffer;
-			CChunkFileReader::Error err;
-
-			if (base_ == -1 || ++baseUsage_ > BASE_USAGE_INTERVAL)
-			{
-				base_ = (base_ + 1) % ARRAY_SIZE(bases_);
-				baseUsage_ = 0;
-				err = SaveToRam(bases_[base_]);
-				// Let's not bother savestating twice.
-				compressBuffer = &bases_[base_];
-			}
-			else
-				err = SaveToRam(buffer);
-
-			if (err == CChunkFileReader::ERROR_NONE)
-				ScheduleCompress(&states_[n], compressBuffer, &bases_[base_]);
-			else
-				states_[n].clear();
-			baseMapping_[n] = base_;
-			return err;
-		}
-
-		CChunkFileReader::Error Restore(std::string *errorString)
-		{
-			std::lock_guard<std::mutex> guard(lock_);
-
-			// No valid states left.
-			if (Empty())
-				return CChunkFileReader::ERROR_BAD_FILE;
-
-			int n = (--next_ + size_) % size_;
-			if (states_[n].empty())
-				return CChunkFileReader::ERROR_BAD_FILE;
-
-			static std::vector<u8> buffer;
-			LockedDecompress(buffer, states_[n], bases_[baseMapping_[n]]);
-			return LoadFromRam(buffer, errorString);
-		}
-
-		void ScheduleCompress(std::vector<u8> *result, const std::vector<u8> *state, const std::vector<u8> *base)
-		{
-			if (compressThread_.joinable())
-				compressThread_.join();
-			compressThread_ = std::thread([=]{
-				SetCurrentThreadName("SaveStateCompress");
-
-				// Should do no I/O, so no JNI thread context needed.
-				Compress(*result, *state, *base);
-			});
-		}
-
-		void Compress(std::vector<u8> &result, const std::vector<u8> &state, const std::vector<u8> &base)
-		{
-			std::lock_guard<std::mutex> guard(lock_);
-			// Bail if we were cleared before locking.
-			if (first_ == 0 && next_ == 0)
-				return;
-
-			result.clear();
-			for (size_t i = 0; i < state.size(); i += BLOCK_SIZE)
-			{
-				int blockSize = std::min(BLOCK_SIZE, (int)(state.size() - i));
-				if (i + blockSize > base.size() || memcmp(&state[i], &base[i], blockSize) != 0)
-				{
-					result.push_back(1);
-					result.insert(result.end(), state.begin() + i, state.begin() +i + blockSize);
-				}
-				else
-					result.push_back(0);
-			}
-		}
-
-		void LockedDecompress(std::vector<u8> &result, const std::vector<u8> &compressed, const std::vector<u8> &base)
-		{
-			result.clear();
-			result.reserve(base.size());
-			auto basePos = base.begin();
-			for (size_t i = 0; i < compressed.size(); )
-			{
-				if (compressed[i] == 0)
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(base.size() - result.size()));
-					result.insert(result.end(), basePos, basePos + blockSize);
-					basePos += blockSize;
-				}
-				else
-				{
-					++i;
-					int blockSize = std::min(BLOCK_SIZE, (int)(compressed.size() - i));
-					result.insert(result.end(), compressed.begin() + i, compressed.begin() + i + blockSize);
-					i += blockSize;
-					basePos += blockSize;
-				}
-			}
-		}
-
-		void Clear()
-		{
-			if (compressThread_.joinable())
-				compressThread_.join();
-
-			// This lock is mainly for shutdown.
-			std::lock_guard<std::mutex> guard(lock_);
-			first_ = 0;
-			next_ = 0;
-		}
-
-		bool Empty() const
-		{
-			return next_ == first_;
-		}
-
-		static const int BLOCK_SIZE;
-		// TODO: Instead, based on size of compressed state?
-		static const int BASE_USAGE_INTERVAL;
-
-		typedef std::vector<u8> StateBuffer;
-
-		int first_;
-		int next_;
-		int size_;
-
-		std::vector<StateBuffer> states_;
-		StateBuffer bases_[2];
-		std::vector<int> baseMapping_;
-		std::mutex lock_;
-		std::thread compressThread_;
-
-		int base_;
-		int baseUsage_;
-	};
+	// The rewind buffer wants exactly the state size, rather than SaveToRam's reuse.
+	static bool SaveRewindState(std::vector<u8> &data) {
+		SaveStart state;
+		size_t sz = CChunkFileReader::MeasurePtr(state);
+		data.resize(sz);
+		return CChunkFileReader::SavePtr(&data[0], state, sz) == CChunkFileReader::ERROR_NONE;
+	}
 
 	static bool needsProcess = false;
 	static bool needsRestart = false;
@@ -266,15 +125,16 @@ namespace SaveState
 	static int lastSaveDataGeneration = 0;
 	static std::string saveStateInitialGitVersion = "";
 
-	// TODO: Should this be configurable?
-	static const int REWIND_NUM_STATES = 20;
 	static const int SCREENSHOT_FAILURE_RETRIES = 15;
-	static StateRingbuffer rewindStates(REWIND_NUM_STATES);
-	// TODO: Any reason for this to be configurable?
-	const static float rewindMaxWallFrequency = 1.0f;
+	static StateRingbuffer rewindStates;
 	static double rewindLastTime = 0.0f;
-	const int StateRingbuffer::BLOCK_SIZE = 8192;
-	const int StateRingbuffer::BASE_USAGE_INTERVAL = 15;
+
+	static CChunkFileReader::Error RestoreRewindState(std::string *errorString) {
+		static std::vector<u8> buffer;
+		if (!rewindStates.Restore(buffer))
+			return CChunkFileReader::ERROR_BAD_FILE;
+		return LoadFromRam(buffer, errorString);
+	}
 
 	void SaveStart::DoState(PointerWrap &p)
 	{
@@ -752,7 +612,7 @@ namespace SaveState
 		CChunkFileReader::Error result;
 		do {
 			std::string errorString;
-			result = rewindStates.Restore(&errorString);
+			result = RestoreRewindState(&errorString);
 		} while (result == CChunkFileReader::ERROR_BROKEN_STATE);
 
 		if (result == CChunkFileReader::ERROR_NONE) {
@@ -771,15 +631,16 @@ namespace SaveState
 		if (gpuStats.numFlips % g_Config.iRewindFlipFrequency != 0)
 			return;
 
-		// For fast-forwarding, otherwise they may be useless and too close.
+		// For fast-forwarding, don't snapshot more often than we would at normal speed,
+		// otherwise they may be useless and too close, and eat up the budget.
 		double now = time_now_d();
-		float diff = now - rewindLastTime;
-		if (diff < rewindMaxWallFrequency)
+		double diff = now - rewindLastTime;
+		if (diff < g_Config.iRewindFlipFrequency * (1.0 / 60.0) * 0.5)
 			return;
 
 		rewindLastTime = now;
 		DEBUG_LOG(BOOT, "Saving rewind state");
-		rewindStates.Save();
+		rewindStates.Save(&SaveRewindState, (size_t)g_Config.iRewindBufferSizeMB * 1024 * 1024);
 	}
 
 	bool HasLoadedState() {
@@ -922,6 +783,12 @@ namespace SaveState
 				}
 				result = CChunkFileReader::Save(op.filename, title, PPSSPP_GIT_VERSION, state);
 				if (result == CChunkFileReader::ERROR_NONE) {
+					// A good moment to also keep what the jit learned, in case we don't exit cleanly.
+					{
+						std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+						if (MIPSComp::jit)
+							MIPSComp::jit->FlushDiskCache();
+					}
 					callbackMessage = slot_prefix + sc->T("Saved State");
 					callbackResult = Status::SUCCESS;
 #ifndef MOBILE_DEVICE
@@ -958,7 +825,7 @@ namespace SaveState
 
 			case SAVESTATE_REWIND:
 				INFO_LOG(SAVESTATE, "Rewinding to recent savestate snapshot");
-				result = rewindStates.Restore(&errorString);
+				result = RestoreRewindState(&errorString);
 				if (result == CChunkFileReader::ERROR_NONE) {
 					callbackMessage = sc->T("Loaded State");
 					callbackResult = Status::SUCCESS;
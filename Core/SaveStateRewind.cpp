@@ -0,0 +1,247 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <zstd.h>
+
+#include "Common/Thread/ParallelLoop.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Core/SaveStateRewind.h"
+
+namespace SaveState
+{
+	const int StateRingbuffer::PAGE_SIZE = 16384;
+	const int StateRingbuffer::COMPRESSION_LEVEL = 1;
+	const int StateRingbuffer::BASE_DIRTY_DIVISOR = 4;
+
+	bool StateRingbuffer::Save(const SaveFunc &save, size_t budget)
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		LockedFinishCompress();
+		budget_ = budget;
+
+		if (!save(staging_))
+			return false;
+		const size_t sz = staging_.size();
+
+		snapshots_.emplace_back();
+		Snapshot &snap = snapshots_.back();
+		const int numPages = (int)((sz + PAGE_SIZE - 1) / PAGE_SIZE);
+
+		// Start over from a new base if the old one has drifted too far to be useful.
+		if (!base_ || base_->size() != sz || lastDirtyPages_ * BASE_DIRTY_DIVISOR > numPages)
+		{
+			base_ = std::make_shared<StateBuffer>(std::move(staging_));
+			baseBytes_ += sz;
+			staging_ = StateBuffer();
+			lastDirtyPages_ = 0;
+			snap.base = base_;
+			snap.pageSizes.resize(numPages, 0);
+			deltaBytes_ += snap.Bytes();
+			LockedEvict(budget);
+			return true;
+		}
+
+		snap.base = base_;
+		snap.pageSizes.resize(numPages, 0);
+		if (scratch_.size() < (size_t)numPages)
+			scratch_.resize(numPages);
+
+		pending_ = ParallelRangeLoopWaitable(&g_threadManager, [this, sz](int l, int h) {
+			const StateBuffer &base = *base_;
+			for (int i = l; i < h; ++i)
+			{
+				size_t offset = (size_t)i * PAGE_SIZE;
+				size_t pageSize = std::min((size_t)PAGE_SIZE, sz - offset);
+				StateBuffer &out = scratch_[i];
+				if (memcmp(&staging_[offset], &base[offset], pageSize) == 0)
+				{
+					out.clear();
+					continue;
+				}
+
+				out.resize(ZSTD_compressBound(pageSize));
+				size_t written = ZSTD_compress(&out[0], out.size(), &staging_[offset], pageSize, COMPRESSION_LEVEL);
+				// Shouldn't happen, but if it does, store the page raw and mark it as such.
+				if (ZSTD_isError(written))
+				{
+					out.assign(staging_.begin() + offset, staging_.begin() + offset + pageSize);
+					out.push_back(0);
+				}
+				else
+				{
+					out.resize(written);
+					out.push_back(1);
+				}
+			}
+		}, 0, numPages, 8);
+
+		return true;
+	}
+
+	bool StateRingbuffer::Restore(std::vector<u8> &result)
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		LockedFinishCompress();
+
+		// No valid states left.
+		if (snapshots_.empty())
+			return false;
+
+		Snapshot snap = std::move(snapshots_.back());
+		snapshots_.pop_back();
+		deltaBytes_ -= snap.Bytes();
+
+		bool success = LockedDecompress(result, snap);
+		LockedReleaseBase(snap.base);
+		return success;
+	}
+
+	void StateRingbuffer::Clear()
+	{
+		// This lock is mainly for shutdown.
+		std::lock_guard<std::mutex> guard(lock_);
+		LockedFinishCompress();
+
+		snapshots_.clear();
+		base_.reset();
+		baseBytes_ = 0;
+		deltaBytes_ = 0;
+		lastDirtyPages_ = 0;
+		staging_ = StateBuffer();
+		scratch_.clear();
+	}
+
+	size_t StateRingbuffer::UsedBytes()
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		LockedFinishCompress();
+		return baseBytes_ + deltaBytes_;
+	}
+
+	int StateRingbuffer::Count()
+	{
+		std::lock_guard<std::mutex> guard(lock_);
+		return (int)snapshots_.size();
+	}
+
+	// Gathers the pages compressed for the newest snapshot, if any are in flight.
+	void StateRingbuffer::LockedFinishCompress()
+	{
+		if (!pending_)
+			return;
+		pending_->WaitAndRelease();
+		pending_ = nullptr;
+
+		Snapshot &snap = snapshots_.back();
+		size_t total = 0;
+		int dirty = 0;
+		for (size_t i = 0; i < snap.pageSizes.size(); ++i)
+		{
+			snap.pageSizes[i] = (u32)scratch_[i].size();
+			total += scratch_[i].size();
+			if (!scratch_[i].empty())
+				dirty++;
+		}
+
+		snap.data.resize(total);
+		size_t pos = 0;
+		for (size_t i = 0; i < snap.pageSizes.size(); ++i)
+		{
+			if (!scratch_[i].empty())
+				memcpy(&snap.data[pos], &scratch_[i][0], scratch_[i].size());
+			pos += scratch_[i].size();
+		}
+
+		lastDirtyPages_ = dirty;
+		deltaBytes_ += snap.Bytes();
+		LockedEvict(budget_);
+	}
+
+	// Drops the oldest snapshots until we're within budget, always keeping the newest.
+	void StateRingbuffer::LockedEvict(size_t budget)
+	{
+		while (snapshots_.size() > 1 && baseBytes_ + deltaBytes_ > budget)
+		{
+			Snapshot &oldest = snapshots_.front();
+			deltaBytes_ -= oldest.Bytes();
+			std::shared_ptr<StateBuffer> base = std::move(oldest.base);
+			snapshots_.pop_front();
+			LockedReleaseBase(base);
+		}
+	}
+
+	// Bases are shared by all snapshots that were diffed against them.
+	void StateRingbuffer::LockedReleaseBase(std::shared_ptr<StateBuffer> &base)
+	{
+		if (base && base.use_count() == 1)
+			baseBytes_ -= base->size();
+		base.reset();
+		if (snapshots_.empty() && base_)
+		{
+			// Nothing references the current base, so no point in keeping it around.
+			if (base_.use_count() == 1)
+				baseBytes_ -= base_->size();
+			base_.reset();
+		}
+	}
+
+	bool StateRingbuffer::LockedDecompress(std::vector<u8> &result, const Snapshot &snap)
+	{
+		const StateBuffer &base = *snap.base;
+		result.resize(base.size());
+
+		std::vector<size_t> offsets(snap.pageSizes.size());
+		size_t pos = 0;
+		for (size_t i = 0; i < snap.pageSizes.size(); ++i)
+		{
+			offsets[i] = pos;
+			pos += snap.pageSizes[i];
+		}
+
+		std::atomic<bool> failed(false);
+		ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+			for (int i = l; i < h; ++i)
+			{
+				size_t offset = (size_t)i * PAGE_SIZE;
+				size_t pageSize = std::min((size_t)PAGE_SIZE, base.size() - offset);
+				u32 compressedSize = snap.pageSizes[i];
+				if (compressedSize == 0)
+				{
+					memcpy(&result[offset], &base[offset], pageSize);
+					continue;
+				}
+
+				const u8 *src = &snap.data[offsets[i]];
+				if (src[compressedSize - 1] == 0)
+				{
+					memcpy(&result[offset], src, pageSize);
+				}
+				else
+				{
+					size_t read = ZSTD_decompress(&result[offset], pageSize, src, compressedSize - 1);
+					if (read != pageSize)
+						failed = true;
+				}
+			}
+		}, 0, (int)snap.pageSizes.size(), 8);
+
+		return !failed;
+	}
+}
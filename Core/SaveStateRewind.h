@@ -0,0 +1,95 @@
+// Copyright (c) 2012- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+
+struct WaitableCounter;
+
+namespace SaveState
+{
+	// Keeps recent states as page-granular deltas against a full "base" state.
+	// Pages that are identical to the base cost nothing, and the dirty ones are zstd compressed
+	// in parallel on the thread manager while emulation continues. The number of states kept
+	// is bounded by a memory budget rather than a fixed count, so snapshots can be taken often.
+	class StateRingbuffer
+	{
+	public:
+		// Fills in the serialized state, returning false on failure.
+		typedef std::function<bool(std::vector<u8> &state)> SaveFunc;
+
+		bool Save(const SaveFunc &save, size_t budget);
+		// Pops the newest state into result.  Returns false if there was none, or it was corrupt.
+		bool Restore(std::vector<u8> &result);
+		void Clear();
+
+		bool Empty() const
+		{
+			return snapshots_.empty();
+		}
+
+		// Bases and deltas currently kept, which is what the budget limits.
+		size_t UsedBytes();
+		int Count();
+
+	private:
+		typedef std::vector<u8> StateBuffer;
+
+		struct Snapshot
+		{
+			std::shared_ptr<StateBuffer> base;
+			// Compressed size of each page (including a trailing raw/zstd flag), 0 if same as base.
+			std::vector<u32> pageSizes;
+			StateBuffer data;
+
+			size_t Bytes() const
+			{
+				return data.size() + pageSizes.size() * sizeof(u32);
+			}
+		};
+
+		void LockedFinishCompress();
+		void LockedEvict(size_t budget);
+		void LockedReleaseBase(std::shared_ptr<StateBuffer> &base);
+		bool LockedDecompress(std::vector<u8> &result, const Snapshot &snap);
+
+		static const int PAGE_SIZE;
+		static const int COMPRESSION_LEVEL;
+		// Rebase once more than 1/BASE_DIRTY_DIVISOR of the pages differ from the base.
+		static const int BASE_DIRTY_DIVISOR;
+
+		std::deque<Snapshot> snapshots_;
+		std::shared_ptr<StateBuffer> base_;
+		StateBuffer staging_;
+		std::vector<StateBuffer> scratch_;
+		WaitableCounter *pending_ = nullptr;
+		std::mutex lock_;
+
+		size_t budget_ = 0;
+		size_t baseBytes_ = 0;
+		size_t deltaBytes_ = 0;
+		int lastDirtyPages_ = 0;
+	};
+}
@@ -35,6 +35,7 @@
 #include "Common/System/System.h"
 #include "Common/File/Path.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Thread/ThreadUtil.h"
 #include "Common/Data/Encoding/Utf8.h"
 
@@ -43,6 +44,7 @@
 #include "Common/GraphicsContext.h"
 #include "Core/MemFault.h"
 #include "Core/HDRemaster.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/MIPS.h"
 #include "Core/MIPS/MIPSAnalyst.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
@@ -60,6 +62,7 @@
 #include "Core/CoreTiming.h"
 #include "Core/CoreParameter.h"
 #include "Core/FileLoaders/RamCachingFileLoader.h"
+#include "Core/FileLoaders/ReadAheadFileLoader.h"
 #include "Core/FileSystems/MetaFileSystem.h"
 #include "Core/Loaders.h"
 #include "Core/PSPLoaders.h"
@@ -234,11 +237,17 @@ bool CPU_Init(std::string *errorString) {
 
 	Path filename = g_CoreParameter.fileToStart;
 	loadedFile = ResolveFileLoaderTarget(ConstructFileLoader(filename));
+	bool cachedInRam = false;
 #if PPSSPP_ARCH(AMD64)
 	if (g_Config.bCacheFullIsoInRam) {
 		loadedFile = new RamCachingFileLoader(loadedFile);
+		cachedInRam = true;
 	}
 #endif
+	// Remote files already read ahead in CachingFileLoader, and the RAM cache reads in the whole file anyway.
+	if (!cachedInRam && !loadedFile->IsRemote() && !loadedFile->IsDirectory()) {
+		loadedFile = new ReadAheadFileLoader(loadedFile);
+	}
 
 	IdentifiedFileType type = Identify_File(loadedFile, errorString);
 
@@ -358,6 +367,11 @@ void CPU_Shutdown() {
 		Audio_Shutdown();
 	}
 
+	{
+		std::lock_guard<std::recursive_mutex> guard(MIPSComp::jitLock);
+		if (MIPSComp::jit)
+			MIPSComp::jit->FlushDiskCache();
+	}
 	pspFileSystem.Shutdown();
 	mipsr4k.Shutdown();
 	Memory::Shutdown();
@@ -394,8 +408,11 @@ void Core_UpdateDebugStats(bool collectStats) {
 	}
 
 	if (!PSP_CoreParameter().frozen && !Core_IsStepping()) {
+		PROFILE_COUNTER("draw_calls", gpuStats.numDrawCalls);
+		PROFILE_COUNTER("verts_submitted", gpuStats.numVertsSubmitted);
 		kernelStats.ResetFrame();
 		gpuStats.ResetFrame();
+		MIPSComp::jitStats.ResetFrame();
 	}
 }
 
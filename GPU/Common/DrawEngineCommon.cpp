@@ -31,6 +31,8 @@
 
 #define QUAD_INDICES_MAX 65536
 
+#define VERTEXCACHE_DECIMATION_INTERVAL 17
+
 enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
@@ -39,6 +41,10 @@ DrawEngineCommon::DrawEngineCommon() : decoderMap_(16) {
 	decJitCache_ = new VertexDecoderJitCache();
 	transformed = (TransformedVertex *)AllocateMemoryPages(TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
 	transformedExpanded = (TransformedVertex *)AllocateMemoryPages(3 * TRANSFORMED_VERTEX_BUFFER_SIZE, MEM_PROT_READ | MEM_PROT_WRITE);
+	vertexDataCache_.SetReleaseFunc([this](CachedVertexData *data) {
+		ReleaseCachedVertexData(data);
+	});
+	decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
 }
 
 DrawEngineCommon::~DrawEngineCommon() {
@@ -183,6 +189,19 @@ void DrawEngineCommon::NotifyConfigChanged() {
 	decOptions_.applySkinInDecode = g_Config.bSoftwareSkinning;
 }
 
+void DrawEngineCommon::ClearTrackedVertexArrays() {
+	vertexDataCache_.Clear();
+}
+
+void DrawEngineCommon::DecimateTrackedVertexArrays() {
+	gpuStats.numTrackedVertexArrays = (int)vertexDataCache_.NumArrays();
+
+	if (--decimationCounter_ <= 0) {
+		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
+		vertexDataCache_.Decimate(gpuStats.numFlips);
+	}
+}
+
 u32 DrawEngineCommon::NormalizeVertices(u8 *outPtr, u8 *bufPtr, const u8 *inPtr, int lowerBound, int upperBound, u32 vertType, int *vertexSize) {
 	const u32 vertTypeID = GetVertTypeID(vertType, gstate.getUVGenMode(), decOptions_.applySkinInDecode);
 	VertexDecoder *dec = GetVertexDecoder(vertTypeID);
@@ -774,6 +793,145 @@ uint64_t DrawEngineCommon::ComputeHash() {
 	return fullhash;
 }
 
+uint64_t DrawEngineCommon::ComputeVertexArrayKey(uint64_t dataHash) {
+	// Beyond the raw data, the decoded data and indices depend on the vertex type and how each prim was drawn.
+	struct DrawCallKey {
+		u32 vertexCount;
+		u16 indexLowerBound;
+		u16 indexUpperBound;
+		s8 prim;
+		u8 indexType;
+		u8 clockwise;
+		u8 pad;
+	};
+	DrawCallKey keys[MAX_DEFERRED_DRAW_CALLS];
+	const bool cullEnabled = gstate.isCullEnabled();
+	const int cullMode = gstate.getCullMode();
+	for (int i = 0; i < numDrawCalls; i++) {
+		const DeferredDrawCall &dc = drawCalls[i];
+		DrawCallKey &key = keys[i];
+		key.vertexCount = dc.vertexCount;
+		key.indexLowerBound = dc.indexLowerBound;
+		key.indexUpperBound = dc.indexUpperBound;
+		key.prim = dc.prim;
+		key.indexType = dc.indexType;
+		key.clockwise = !cullEnabled || cullMode == dc.cullMode;
+		key.pad = 0;
+	}
+
+	return XXH3_64bits_withSeed(keys, sizeof(DrawCallKey) * numDrawCalls, dataHash ^ ((uint64_t)lastVType_ << 32));
+}
+
+CachedVertexData *DrawEngineCommon::GetCachedVertexData() {
+	// Cannot cache vertex data with morph enabled.
+	if (!g_Config.bVertexCache || (lastVType_ & GE_VTYPE_MORPHCOUNT_MASK))
+		return nullptr;
+	// Also avoid caching when software skinning.
+	if (decOptions_.applySkinInDecode && (lastVType_ & GE_VTYPE_WEIGHT_MASK))
+		return nullptr;
+
+	PROFILE_THIS_SCOPE("vcache");
+	const int frame = gpuStats.numFlips;
+	u32 id = dcid_ ^ gstate.getUVGenMode();  // This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
+	VertexArrayInfo *vai = vertexDataCache_.GetArray(id, frame);
+	VertexCacheStats &stats = vertexDataCache_.stats;
+
+	switch (vai->status) {
+	case VertexArrayInfo::VAI_NEW:
+	{
+		// Haven't seen this one before.  Not worth decoding into the cache yet, unless something else already has.
+		vai->hash = ComputeHash();
+		vai->minihash = ComputeMiniHash();
+		vai->key = ComputeVertexArrayKey(vai->hash);
+		vai->status = VertexArrayInfo::VAI_HASHING;
+		vai->drawsUntilNextFullHash = 0;
+
+		CachedVertexData *data = vertexDataCache_.Find(vai->key, frame);
+		if (data) {
+			stats.hits++;
+			stats.sharedHits++;
+			gpuStats.numCachedDrawCalls++;
+			gpuStats.numCachedVertsDrawn += data->indexCount;
+		}
+		return data;
+	}
+
+	// Hashing - still gaining confidence about the buffer.
+	// But if we get this far it's likely to be worth decoding into the cache.
+	case VertexArrayInfo::VAI_HASHING:
+	{
+		PROFILE_THIS_SCOPE("vcachehash");
+		if (vai->drawsUntilNextFullHash == 0) {
+			// Let's try to skip a full hash if mini would fail.
+			const u32 newMiniHash = ComputeMiniHash();
+			uint64_t newHash = vai->hash;
+			if (newMiniHash == vai->minihash) {
+				newHash = ComputeHash();
+			}
+			if (newMiniHash != vai->minihash || newHash != vai->hash) {
+				vertexDataCache_.MarkUnreliable(vai);
+				return nullptr;
+			}
+			if (vertexCountInDrawCalls_ > 64) {
+				// exponential backoff up to 16 draws, then every 24
+				vai->drawsUntilNextFullHash = std::min(24, vai->numFrames);
+			} else {
+				// Lower numbers seem much more likely to change.
+				vai->drawsUntilNextFullHash = 0;
+			}
+			// TODO: tweak
+			//if (vai->numFrames > 1000) {
+			//	vai->status = VertexArrayInfo::VAI_RELIABLE;
+			//}
+		} else {
+			vai->drawsUntilNextFullHash--;
+			u32 newMiniHash = ComputeMiniHash();
+			if (newMiniHash != vai->minihash) {
+				vertexDataCache_.MarkUnreliable(vai);
+				return nullptr;
+			}
+		}
+		break;
+	}
+
+	// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
+	case VertexArrayInfo::VAI_RELIABLE:
+		break;
+
+	case VertexArrayInfo::VAI_UNRELIABLE:
+	default:
+		return nullptr;
+	}
+
+	CachedVertexData *data = vertexDataCache_.Find(vai->key, frame);
+	if (data) {
+		stats.hits++;
+		gpuStats.numCachedDrawCalls++;
+		gpuStats.numCachedVertsDrawn += data->indexCount;
+		return data;
+	}
+
+	// Decode straight into the cache, the backends upload from there.
+	data = vertexDataCache_.Add(vai->key, frame);
+	const int stride = dec_->GetDecVtxFmt().stride;
+	data->verts.resize(ComputeNumVertsToDecode() * stride);
+	DecodeVerts(data->verts.data());
+	_dbg_assert_msg_(gstate_c.vertBounds.minV >= gstate_c.vertBounds.maxV, "Should not have checked UVs when caching.");
+
+	data->numDecodedVerts = decodedVerts_;
+	data->verts.resize(decodedVerts_ * stride);
+	data->inds.assign(decIndex, decIndex + indexGen.VertexCount());
+	data->indexCount = indexGen.VertexCount();
+	data->pureCount = indexGen.PureCount();
+	data->maxIndex = indexGen.MaxIndex();
+	data->prim = indexGen.Prim();
+	data->generalPrim = indexGen.GeneralPrim();
+	data->seenOnlyPurePrims = indexGen.SeenOnlyPurePrims();
+	data->vertexFullAlpha = gstate_c.vertexFullAlpha;
+	gpuStats.numUncachedVertsDrawn += data->indexCount;
+	return data;
+}
+
 // Cheap bit scrambler from https://nullprogram.com/blog/2018/07/31/
 inline uint32_t lowbias32_r(uint32_t x) {
 	x ^= x >> 16;
@@ -26,6 +26,7 @@
 #include "GPU/Common/GPUStateUtils.h"
 #include "GPU/Common/GPUDebugInterface.h"
 #include "GPU/Common/IndexGenerator.h"
+#include "GPU/Common/VertexCache.h"
 #include "GPU/Common/VertexDecoderCommon.h"
 
 class VertexDecoder;
@@ -123,9 +124,15 @@ class DrawEngineCommon {
 
 	VertexDecoder *GetVertexDecoder(u32 vtype);
 
+	void ClearTrackedVertexArrays();
+	const VertexCache &GetVertexDataCache() const {
+		return vertexDataCache_;
+	}
+
 protected:
 	virtual bool UpdateUseHWTessellation(bool enabled) { return enabled; }
-	virtual void ClearTrackedVertexArrays() {}
+	// Called when cached vertex data is forgotten, to free CachedVertexData::backendData.
+	virtual void ReleaseCachedVertexData(CachedVertexData *data) {}
 
 	int ComputeNumVertsToDecode() const;
 	void DecodeVerts(u8 *dest);
@@ -136,6 +143,12 @@ class DrawEngineCommon {
 	// Utility for vertex caching
 	u32 ComputeMiniHash();
 	uint64_t ComputeHash();
+	uint64_t ComputeVertexArrayKey(uint64_t dataHash);
+
+	// Returns decoded data for the queued draw calls if they look static, decoding into the cache
+	// if needed.  Otherwise returns nullptr, and they should be decoded as usual.
+	CachedVertexData *GetCachedVertexData();
+	void DecimateTrackedVertexArrays();
 
 	// Vertex decoding
 	void DecodeVertsStep(u8 *dest, int &i, int &decodedVerts);
@@ -215,6 +228,9 @@ class DrawEngineCommon {
 	int decodeCounter_ = 0;
 	u32 dcid_ = 0;
 
+	// Decoded vertex data of static draws, shared by the backends.
+	VertexCache vertexDataCache_;
+
 	// Vertex collector state
 	IndexGenerator indexGen;
 	int decodedVerts_ = 0;
@@ -467,6 +467,8 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			if (entry->lastFrame != gpuStats.numFlips) {
 				u32 diff = gpuStats.numFlips - entry->lastFrame;
 				entry->numFrames++;
+				// Writes we saw to the texture's pages (DMA, GE transfers, cache writebacks) always need a recheck.
+				bool written = entry->WrittenSinceHash();
 
 				if (entry->framesUntilNextFullHash < diff) {
 					// Exponential backoff up to 512 frames.  Textures are often reused.
@@ -476,9 +478,13 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 					} else {
 						entry->framesUntilNextFullHash = entry->numFrames;
 					}
-					rehash = true;
+					// Lazy caching already tolerates missed CPU writes, so trust the tracking there, up to a point.
+					bool stale = gpuStats.numFlips - entry->hashFrame >= TEXCACHE_MAX_UNTRACKED_FRAMES;
+					rehash = written || stale || !g_Config.bTextureBackoffCache;
 				} else {
 					entry->framesUntilNextFullHash -= diff;
+					if (written)
+						rehash = true;
 				}
 			}
 
@@ -496,7 +502,7 @@ TexCacheEntry *TextureCacheCommon::SetTexture() {
 			}
 		}
 
-		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < TEXCACHE_MAX_TEXELS_SCALED) {
+		if (match && (entry->status & TexCacheEntry::STATUS_TO_SCALE) && standardScaleFactor_ != 1 && texelsScaledThisFrame_ < g_Config.iTexScalingFrameBudget && scaleJobs_.CanMakeProgress(entry->CacheKey())) {
 			if ((entry->status & TexCacheEntry::STATUS_CHANGE_FREQUENT) == 0) {
 				// INFO_LOG(G3D, "Reloading texture to do the scaling we skipped..");
 				match = false;
@@ -784,6 +790,8 @@ void TextureCacheCommon::Decimate(bool forcePressure) {
 	}
 
 	DecimateVideos();
+	// Scaled textures that never got drawn again.
+	scaleJobs_.Decimate(gpuStats.numFlips, TEXTURE_KILL_AGE);
 	replacer_.Decimate(forcePressure ? ReplacerDecimateMode::FORCE_PRESSURE : ReplacerDecimateMode::NEW_FRAME);
 }
 
@@ -2015,6 +2023,8 @@ void TextureCacheCommon::ApplyTexture() {
 			// Update the hash on the texture.
 			int w = gstate.getTextureWidth(0);
 			int h = gstate.getTextureHeight(0);
+			entry->hashWriteStamp = Memory::NextWriteStamp();
+			entry->hashFrame = gpuStats.numFlips;
 			entry->fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 
 			// TODO: Here we could check the secondary cache; maybe the texture is in there?
@@ -2403,6 +2413,8 @@ void TextureCacheCommon::Clear(bool delete_them) {
 		secondCacheSizeEstimate_ = 0;
 	}
 	videos_.clear();
+	// Any still running finish on their own.
+	scaleJobs_.Clear();
 
 	if (dynamicClutFbo_) {
 		dynamicClutFbo_->Release();
@@ -2415,6 +2427,7 @@ void TextureCacheCommon::Clear(bool delete_them) {
 }
 
 void TextureCacheCommon::DeleteTexture(TexCache::iterator it) {
+	scaleJobs_.Forget(it->second->CacheKey());
 	ReleaseTexture(it->second.get(), true);
 	cacheSizeEstimate_ -= EstimateTexMemoryUsage(it->second.get());
 	cache_.erase(it);
@@ -2435,6 +2448,8 @@ bool TextureCacheCommon::CheckFullHash(TexCacheEntry *entry, bool &doDelete) {
 	u32 fullhash;
 	{
 		PROFILE_THIS_SCOPE("texhash");
+		entry->hashWriteStamp = Memory::NextWriteStamp();
+		entry->hashFrame = gpuStats.numFlips;
 		fullhash = QuickTexHash(replacer_, entry->addr, entry->bufw, w, h, GETextureFormat(entry->format), entry);
 	}
 
@@ -2710,8 +2725,10 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 		plan.scaleFactor = 1;
 	}
 
-	if (plan.scaleFactor != 1) {
-		if (texelsScaledThisFrame_ >= TEXCACHE_MAX_TEXELS_SCALED && plan.slowScaler) {
+	// The software scaler runs on threads (below), so only the GPU upscaling needs the budget here.
+	const bool asyncScale = !plan.hardwareScaling && !g_Config.bSaveNewTextures;
+	if (plan.scaleFactor != 1 && !asyncScale) {
+		if (texelsScaledThisFrame_ >= g_Config.iTexScalingFrameBudget && plan.slowScaler) {
 			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
 			plan.scaleFactor = 1;
 		} else {
@@ -2760,6 +2777,29 @@ bool TextureCacheCommon::PrepareBuildTexture(BuildTexturePlan &plan, TexCacheEnt
 		plan.replaceValid = false;
 	}
 
+	if (asyncScale && plan.scaleFactor > 1 && !plan.replaceValid) {
+		std::shared_ptr<TextureScaleJob> job;
+		if (texelsScaledThisFrame_ < g_Config.iTexScalingFrameBudget) {
+			// If the texture changed since, this drops the job and we start over.
+			job = scaleJobs_.TakeFinished(entry->CacheKey(), entry->fullhash, plan.w, plan.h, plan.scaleFactor);
+		}
+		if (job) {
+			// Scaled on a thread, we just need to upload it.
+			plan.scaled = job;
+			entry->status &= ~TexCacheEntry::STATUS_TO_SCALE;
+			entry->status |= TexCacheEntry::STATUS_IS_SCALED;
+			texelsScaledThisFrame_ += plan.w * plan.h;
+		} else {
+			if (scaleJobs_.CanStart(entry->CacheKey())) {
+				plan.asyncScaleFactor = plan.scaleFactor;
+			}
+			// Meanwhile, use the unscaled texture with all its levels.
+			entry->status |= TexCacheEntry::STATUS_TO_SCALE;
+			plan.scaleFactor = 1;
+			plan.levelsToLoad = plan.levelsToCreate;
+		}
+	}
+
 	// NOTE! Last chance to change scale factor here!
 
 	plan.saveTexture = false;
@@ -2826,7 +2866,13 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 		double replaceStart = time_now_d();
 		plan.replaced->Load(srcLevel, data, stride);
 		replacementTimeThisFrame_ += time_now_d() - replaceStart;
+	} else if (LoadScaledTextureLevel(entry, data, stride, plan, srcLevel)) {
+		// Already decoded and scaled on a thread.
 	} else {
+		if (plan.asyncScaleFactor > 1 && srcLevel == plan.baseLevelSrc) {
+			StartScaleJob(entry, plan, srcLevel, texDecFlags);
+		}
+
 		GETextureFormat tfmt = (GETextureFormat)entry.format;
 		GEPaletteFormat clutformat = gstate.getClutPaletteFormat();
 		u32 texaddr = gstate.getTextureAddress(srcLevel);
@@ -2887,6 +2933,43 @@ void TextureCacheCommon::LoadTextureLevel(TexCacheEntry &entry, uint8_t *data, i
 	}
 }
 
+void TextureCacheCommon::StartScaleJob(TexCacheEntry &entry, const BuildTexturePlan &plan, int srcLevel, TexDecodeFlags texDecFlags) {
+	std::shared_ptr<TextureScaleJob> job = std::make_shared<TextureScaleJob>();
+	job->fullhash = entry.fullhash;
+	job->w = gstate.getTextureWidth(srcLevel);
+	job->h = gstate.getTextureHeight(srcLevel);
+	job->scaleFactor = plan.asyncScaleFactor;
+	job->startFrame = gpuStats.numFlips;
+
+	// Decoding needs the current CLUT and state, so that part happens here.
+	GETextureFormat tfmt = (GETextureFormat)entry.format;
+	u32 texaddr = gstate.getTextureAddress(srcLevel);
+	int bufw = GetTextureBufw(srcLevel, texaddr, tfmt);
+	job->pixels.resize(std::max(bufw, job->w) * job->h);
+	job->alphaResult = DecodeTextureLevel((u8 *)job->pixels.data(), job->w * 4, tfmt, gstate.getClutPaletteFormat(), texaddr, srcLevel, bufw, texDecFlags | TexDecodeFlags::EXPAND32);
+
+	scaleJobs_.Start(entry.CacheKey(), job);
+}
+
+bool TextureCacheCommon::LoadScaledTextureLevel(TexCacheEntry &entry, uint8_t *data, int stride, const BuildTexturePlan &plan, int srcLevel) {
+	const TextureScaleJob *job = plan.scaled.get();
+	// If we ran out of memory, the backend might have given up on scaling.
+	if (!job || srcLevel != plan.baseLevelSrc || job->scaleFactor != plan.scaleFactor)
+		return false;
+
+	const int w = job->w * job->scaleFactor;
+	const int h = job->h * job->scaleFactor;
+	if (stride == w * 4) {
+		memcpy(data, job->pixels.data(), w * h * 4);
+	} else {
+		for (int y = 0; y < h; ++y) {
+			memcpy(data + stride * y, job->pixels.data() + w * y, w * 4);
+		}
+	}
+	entry.SetAlphaStatus(job->alphaResult, srcLevel);
+	return true;
+}
+
 CheckAlphaResult TextureCacheCommon::CheckCLUTAlpha(const uint8_t *pixelData, GEPaletteFormat clutFormat, int w) {
 	switch (clutFormat) {
 	case GE_CMODE_16BIT_ABGR4444:
@@ -44,7 +44,9 @@ enum FramebufferNotification {
 // Note: only used when hash backoff is disabled.
 #define TEXCACHE_FRAME_CHANGE_FREQUENT_REGAIN_TRUST 33
 
-#define TEXCACHE_MAX_TEXELS_SCALED (256*256)  // Per frame
+// Writes by the CPU jits aren't tracked per page, so even with lazy caching, textures nothing
+// seemed to write get a full hash again after this many frames, like the old backoff cap.
+#define TEXCACHE_MAX_UNTRACKED_FRAMES 512
 
 struct VirtualFramebuffer;
 class TextureReplacer;
@@ -175,6 +177,8 @@ struct TexCacheEntry {
 	int numInvalidated;
 	u32 framesUntilNextFullHash;
 	u32 fullhash;
+	u32 hashWriteStamp;  // Memory::NextWriteStamp() taken when fullhash was computed.
+	int hashFrame;  // gpuStats.numFlips when fullhash was computed.
 	u32 cluthash;
 	u16 maxSeenV;
 
@@ -207,6 +211,7 @@ struct TexCacheEntry {
 	bool Matches(u16 dim2, u8 format2, u8 maxLevel2) const;
 	u64 CacheKey() const;
 	static u64 CacheKey(u32 addr, u8 format, u16 dim, u32 cluthash);
+	bool WrittenSinceHash() const;
 };
 
 // Can't be unordered_map, we use lower_bound ... although for some reason that (used to?) compiles on MSVC.
@@ -289,6 +294,11 @@ struct BuildTexturePlan {
 	// TODO: Expand32 should probably also be decided in PrepareBuildTexture.
 	bool decodeToClut8;
 
+	// If > 1, the 0-mip is loaded unscaled for now and a copy gets scaled by this on a thread.
+	int asyncScaleFactor = 1;
+	// A 0-mip that finished scaling on a thread, loaded instead of decoding and scaling.
+	std::shared_ptr<TextureScaleJob> scaled;
+
 	void GetMipSize(int level, int *w, int *h) const {
 		if (replaceValid && replaced->GetSize(level, *w, *h)) {
 			return;
@@ -376,6 +386,10 @@ class TextureCacheCommon {
 	CheckAlphaResult ReadIndexedTex(u8 *out, int outPitch, int level, const u8 *texptr, int bytesPerIndex, int bufw, bool reverseColors, bool expandTo32Bit);
 	ReplacedTexture &FindReplacement(TexCacheEntry *entry, int &w, int &h, int &d);
 
+	// Software scaling runs on threads, see PrepareBuildTexture.
+	void StartScaleJob(TexCacheEntry &entry, const BuildTexturePlan &plan, int srcLevel, TexDecodeFlags texDecFlags);
+	bool LoadScaledTextureLevel(TexCacheEntry &entry, uint8_t *data, int stride, const BuildTexturePlan &plan, int srcLevel);
+
 	// Return value is mapData normally, but could be another buffer allocated with AllocateAlignedMemory.
 	void LoadTextureLevel(TexCacheEntry &entry, uint8_t *mapData, int mapRowPitch, BuildTexturePlan &plan, int srcLevel, Draw::DataFormat dstFmt, TexDecodeFlags texDecFlags);
 
@@ -426,7 +440,7 @@ class TextureCacheCommon {
 		gpuStats.numTextureDataBytesHashed += sizeInRAM;
 
 		if (Memory::IsValidAddress(addr + sizeInRAM)) {
-			return StableQuickTexHash(checkp, sizeInRAM);
+			return ParallelQuickTexHash(checkp, sizeInRAM);
 		} else {
 			return 0;
 		}
@@ -461,6 +475,9 @@ class TextureCacheCommon {
 	TexCache secondCache_;
 	u32 secondCacheSizeEstimate_ = 0;
 
+	// Scaled textures waiting to be uploaded, or still being scaled.
+	TextureScaleQueue scaleJobs_;
+
 	struct VideoInfo {
 		u32 addr;
 		u32 size;
@@ -527,3 +544,10 @@ inline u64 TexCacheEntry::CacheKey(u32 addr, u8 format, u16 dim, u32 cluthash) {
 	}
 	return cachekey;
 }
+
+inline bool TexCacheEntry::WrittenSinceHash() const {
+	// Unlike sizeInRAM, this covers the whole texture, so writes to the bottom half count too.
+	const int h = 1 << ((dim >> 8) & 0xF);
+	const u32 fullSize = (textureBitsPerPixel[format] * bufw * h) / 8;
+	return Memory::WrittenSince(addr, fullSize, hashWriteStamp);
+}
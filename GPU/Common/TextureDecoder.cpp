@@ -17,12 +17,15 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+
 #include "ext/xxhash.h"
 
 #include "Common/Common.h"
 #include "Common/Data/Convert/ColorConv.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/Thread/ParallelLoop.h"
 
 #include "GPU/GPU.h"
 #include "GPU/GPUState.h"
@@ -31,6 +34,7 @@
 #ifdef _M_SSE
 #include <emmintrin.h>
 #include <smmintrin.h>
+#include <immintrin.h>
 #endif
 
 #if PPSSPP_ARCH(ARM_NEON)
@@ -279,6 +283,32 @@ u32 StableQuickTexHash(const void *checkp, u32 size) {
 #endif
 }
 
+// Large textures are hashed in chunks on the thread manager.  The chunking only depends on the size,
+// so the result is stable, but it differs from StableQuickTexHash for these sizes.
+static const u32 PARALLEL_TEXHASH_MIN_SIZE = 256 * 1024;
+static const u32 PARALLEL_TEXHASH_MIN_CHUNK = 64 * 1024;
+static const u32 PARALLEL_TEXHASH_MAX_CHUNKS = 64;
+
+u32 ParallelQuickTexHash(const void *checkp, u32 size) {
+	if (size < PARALLEL_TEXHASH_MIN_SIZE)
+		return StableQuickTexHash(checkp, size);
+
+	// Keep chunks a multiple of 64 bytes so they all take the fast path.
+	const u32 chunkSize = std::max(PARALLEL_TEXHASH_MIN_CHUNK, ((size / PARALLEL_TEXHASH_MAX_CHUNKS) + 63) & ~63);
+	const int chunks = (int)((size + chunkSize - 1) / chunkSize);
+	u32 hashes[PARALLEL_TEXHASH_MAX_CHUNKS + 1];
+
+	const u8 *p = (const u8 *)checkp;
+	ParallelRangeLoop(&g_threadManager, [&](int l, int h) {
+		for (int i = l; i < h; ++i) {
+			const u32 offset = (u32)i * chunkSize;
+			hashes[i] = StableQuickTexHash(p + offset, std::min(chunkSize, size - offset));
+		}
+	}, 0, chunks, 1);
+
+	return (u32)XXH3_64bits(hashes, chunks * sizeof(u32));
+}
+
 void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch) {
 	// ysrcp is in 32-bits, so this is convenient.
 	const u32 pitchBy32 = pitch >> 2;
@@ -314,6 +344,34 @@ void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch) {
 			ysrcp += pitchBy32 * 8;
 		}
 	} else
+#elif PPSSPP_ARCH(ARM_NEON)
+	if (((uintptr_t)ysrcp & 0xF) == 0 && (pitch & 0xF) == 0) {
+		u32 *dest = (u32 *)texptr;
+		for (int by = 0; by < byc; by++) {
+			const u32 *xsrc = ysrcp;
+			for (int bx = 0; bx < bxc; bx++) {
+				const u32 *src = xsrc;
+				for (int n = 0; n < 2; n++) {
+					uint32x4_t temp1 = vld1q_u32(src);
+					src += pitchBy32;
+					uint32x4_t temp2 = vld1q_u32(src);
+					src += pitchBy32;
+					uint32x4_t temp3 = vld1q_u32(src);
+					src += pitchBy32;
+					uint32x4_t temp4 = vld1q_u32(src);
+					src += pitchBy32;
+
+					vst1q_u32(dest, temp1);
+					vst1q_u32(dest + 4, temp2);
+					vst1q_u32(dest + 8, temp3);
+					vst1q_u32(dest + 12, temp4);
+					dest += 16;
+				}
+				xsrc += 4;
+			}
+			ysrcp += pitchBy32 * 8;
+		}
+	} else
 #endif
 	{
 		u32 *dest = (u32 *)texptr;
@@ -416,6 +474,340 @@ void DoUnswizzleTex16(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch
 	}
 }
 
+template <typename ClutT>
+static void DeIndexTexture4SimpleGeneric(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, ClutT *alphaSum) {
+	ClutT sum = *alphaSum;
+	while (length >= 2) {
+		u8 index = *indexed++;
+		ClutT color0 = clut[index & 0xf];
+		ClutT color1 = clut[index >> 4];
+		*dest++ = color0;
+		*dest++ = color1;
+		sum &= color0 & color1;
+		length -= 2;
+	}
+	if (length) {  // Last pixel. Can really only happen in 1xY textures, but making this work generically.
+		u8 index = *indexed++;
+		ClutT color0 = clut[index & 0xf];
+		*dest = color0;
+		sum &= color0;
+	}
+	*alphaSum = sum;
+}
+
+template <typename ClutT>
+static void DeIndexTexture8SimpleGeneric(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, ClutT *alphaSum) {
+	ClutT sum = *alphaSum;
+	for (int i = 0; i < length; ++i) {
+		ClutT color = clut[*indexed++];
+		sum &= color;
+		*dest++ = color;
+	}
+	*alphaSum = sum;
+}
+
+#ifdef _M_SSE
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline u32 AndLanes32_AVX2(__m256i v) {
+	__m128i sum = _mm_and_si128(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	sum = _mm_and_si128(sum, _mm_srli_si128(sum, 8));
+	sum = _mm_and_si128(sum, _mm_srli_si128(sum, 4));
+	return (u32)_mm_cvtsi128_si32(sum);
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline __m256i SplitNibbles_AVX2(const u8 *indexed, __m256i order, __m256i *index1) {
+	// After shuffling the source with order, unpacking lays out the index of pixels 0-31 and 32-63.
+	const __m256i mask4 = _mm256_set1_epi8(0x0F);
+	__m256i src = _mm256_loadu_si256((const __m256i *)indexed);
+	src = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(src, order), _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256i lo = _mm256_and_si256(src, mask4);
+	const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(src, 4), mask4);
+	*index1 = _mm256_unpackhi_epi8(lo, hi);
+	return _mm256_unpacklo_epi8(lo, hi);
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline __m256i LookupClut4x16_AVX2(u16 *dest, __m256i index, __m256i tableLo, __m256i tableHi) {
+	const __m256i lo = _mm256_shuffle_epi8(tableLo, index);
+	const __m256i hi = _mm256_shuffle_epi8(tableHi, index);
+	const __m256i color0 = _mm256_unpacklo_epi8(lo, hi);
+	const __m256i color1 = _mm256_unpackhi_epi8(lo, hi);
+	_mm256_storeu_si256((__m256i *)dest, color0);
+	_mm256_storeu_si256((__m256i *)(dest + 16), color1);
+	return _mm256_and_si256(color0, color1);
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static int DeIndexTexture4Simple16_AVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut, u16 *alphaSum) {
+	// Split the palette into a table of low bytes and one of high bytes, copied to both lanes for pshufb.
+	const __m256i splitBytes = _mm256_setr_epi8(
+		0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+		0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+	__m256i entries = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)clut), splitBytes);
+	entries = _mm256_permute4x64_epi64(entries, _MM_SHUFFLE(3, 1, 2, 0));
+	const __m256i tableLo = _mm256_permute2x128_si256(entries, entries, 0x00);
+	const __m256i tableHi = _mm256_permute2x128_si256(entries, entries, 0x11);
+
+	// Each lane makes 8 pixels of each store, so the lanes take turns with 4 source bytes.
+	const __m256i order = _mm256_setr_epi8(
+		0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15,
+		0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15);
+
+	__m256i sum = _mm256_set1_epi8(-1);
+	const int chunks = length / 64;
+	for (int i = 0; i < chunks; ++i) {
+		__m256i index1;
+		const __m256i index0 = SplitNibbles_AVX2(indexed + i * 32, order, &index1);
+		sum = _mm256_and_si256(sum, LookupClut4x16_AVX2(dest + i * 64, index0, tableLo, tableHi));
+		sum = _mm256_and_si256(sum, LookupClut4x16_AVX2(dest + i * 64 + 32, index1, tableLo, tableHi));
+	}
+
+	const u32 sum32 = AndLanes32_AVX2(sum);
+	*alphaSum &= (u16)(sum32 & (sum32 >> 16));
+	return chunks * 64;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static inline __m256i LookupClut4x32_AVX2(u32 *dest, __m256i index, const __m256i table[4]) {
+	const __m256i b0 = _mm256_shuffle_epi8(table[0], index);
+	const __m256i b1 = _mm256_shuffle_epi8(table[1], index);
+	const __m256i b2 = _mm256_shuffle_epi8(table[2], index);
+	const __m256i b3 = _mm256_shuffle_epi8(table[3], index);
+	const __m256i lo01 = _mm256_unpacklo_epi8(b0, b1);
+	const __m256i hi01 = _mm256_unpackhi_epi8(b0, b1);
+	const __m256i lo23 = _mm256_unpacklo_epi8(b2, b3);
+	const __m256i hi23 = _mm256_unpackhi_epi8(b2, b3);
+	const __m256i color0 = _mm256_unpacklo_epi16(lo01, lo23);
+	const __m256i color1 = _mm256_unpackhi_epi16(lo01, lo23);
+	const __m256i color2 = _mm256_unpacklo_epi16(hi01, hi23);
+	const __m256i color3 = _mm256_unpackhi_epi16(hi01, hi23);
+	_mm256_storeu_si256((__m256i *)dest, color0);
+	_mm256_storeu_si256((__m256i *)(dest + 8), color1);
+	_mm256_storeu_si256((__m256i *)(dest + 16), color2);
+	_mm256_storeu_si256((__m256i *)(dest + 24), color3);
+	return _mm256_and_si256(_mm256_and_si256(color0, color1), _mm256_and_si256(color2, color3));
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static int DeIndexTexture4Simple32_AVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *alphaSum) {
+	// Split the palette into four tables, one per byte, copied to both lanes for pshufb.
+	const __m256i splitBytes = _mm256_setr_epi8(
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15,
+		0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15);
+	const __m256i splitLanes = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	__m256i entries0 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)clut), splitBytes);
+	__m256i entries1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(clut + 8)), splitBytes);
+	entries0 = _mm256_permutevar8x32_epi32(entries0, splitLanes);
+	entries1 = _mm256_permutevar8x32_epi32(entries1, splitLanes);
+	const __m256i tables02 = _mm256_unpacklo_epi64(entries0, entries1);
+	const __m256i tables13 = _mm256_unpackhi_epi64(entries0, entries1);
+	const __m256i table[4] = {
+		_mm256_permute2x128_si256(tables02, tables02, 0x00),
+		_mm256_permute2x128_si256(tables13, tables13, 0x00),
+		_mm256_permute2x128_si256(tables02, tables02, 0x11),
+		_mm256_permute2x128_si256(tables13, tables13, 0x11),
+	};
+
+	// Each lane makes 4 pixels of each store, so the lanes take turns with 2 source bytes.
+	const __m256i order = _mm256_setr_epi8(
+		0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+		0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+
+	__m256i sum = _mm256_set1_epi8(-1);
+	const int chunks = length / 64;
+	for (int i = 0; i < chunks; ++i) {
+		__m256i index1;
+		const __m256i index0 = SplitNibbles_AVX2(indexed + i * 32, order, &index1);
+		sum = _mm256_and_si256(sum, LookupClut4x32_AVX2(dest + i * 64, index0, table));
+		sum = _mm256_and_si256(sum, LookupClut4x32_AVX2(dest + i * 64 + 32, index1, table));
+	}
+
+	*alphaSum &= AndLanes32_AVX2(sum);
+	return chunks * 64;
+}
+
+// Note: this reads 2 bytes past the color at the highest index used.
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static int DeIndexTexture8Simple16_AVX2(u16 *dest, const u8 *indexed, int length, const u16 *clut, u16 *alphaSum) {
+	const __m256i mask16 = _mm256_set1_epi32(0x0000FFFF);
+	__m256i sum = _mm256_set1_epi8(-1);
+	const int chunks = length / 16;
+	for (int i = 0; i < chunks; ++i) {
+		const __m256i index0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i * 16)));
+		const __m256i index1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i * 16 + 8)));
+		const __m256i color0 = _mm256_and_si256(_mm256_i32gather_epi32((const int *)clut, index0, 2), mask16);
+		const __m256i color1 = _mm256_and_si256(_mm256_i32gather_epi32((const int *)clut, index1, 2), mask16);
+		const __m256i colors = _mm256_permute4x64_epi64(_mm256_packus_epi32(color0, color1), _MM_SHUFFLE(3, 1, 2, 0));
+		_mm256_storeu_si256((__m256i *)(dest + i * 16), colors);
+		sum = _mm256_and_si256(sum, colors);
+	}
+
+	const u32 sum32 = AndLanes32_AVX2(sum);
+	*alphaSum &= (u16)(sum32 & (sum32 >> 16));
+	return chunks * 16;
+}
+
+#if defined(__GNUC__) || defined(__clang__) || defined(__INTEL_COMPILER)
+[[gnu::target("avx2")]]
+#endif
+static int DeIndexTexture8Simple32_AVX2(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *alphaSum) {
+	__m256i sum = _mm256_set1_epi8(-1);
+	const int chunks = length / 16;
+	for (int i = 0; i < chunks; ++i) {
+		const __m256i index0 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i * 16)));
+		const __m256i index1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(indexed + i * 16 + 8)));
+		const __m256i color0 = _mm256_i32gather_epi32((const int *)clut, index0, 4);
+		const __m256i color1 = _mm256_i32gather_epi32((const int *)clut, index1, 4);
+		_mm256_storeu_si256((__m256i *)(dest + i * 16), color0);
+		_mm256_storeu_si256((__m256i *)(dest + i * 16 + 8), color1);
+		sum = _mm256_and_si256(sum, _mm256_and_si256(color0, color1));
+	}
+
+	*alphaSum &= AndLanes32_AVX2(sum);
+	return chunks * 16;
+}
+
+#elif PPSSPP_ARCH(ARM_NEON)
+
+static inline uint8x16_t LookupTable16_NEON(uint8x16_t table, uint8x16_t index) {
+#if PPSSPP_ARCH(ARM64)
+	return vqtbl1q_u8(table, index);
+#else
+	uint8x8x2_t table2;
+	table2.val[0] = vget_low_u8(table);
+	table2.val[1] = vget_high_u8(table);
+	return vcombine_u8(vtbl2_u8(table2, vget_low_u8(index)), vtbl2_u8(table2, vget_high_u8(index)));
+#endif
+}
+
+static inline u8 AndLanes8_NEON(uint8x16_t v) {
+	const uint64x2_t v64 = vreinterpretq_u64_u8(v);
+	u64 sum = vgetq_lane_u64(v64, 0) & vgetq_lane_u64(v64, 1);
+	sum &= sum >> 32;
+	sum &= sum >> 16;
+	sum &= sum >> 8;
+	return (u8)sum;
+}
+
+static int DeIndexTexture4Simple16_NEON(u16 *dest, const u8 *indexed, int length, const u16 *clut, u16 *alphaSum) {
+	// Deinterleaving gives us a table of low bytes and one of high bytes.
+	const uint8x16x2_t table = vld2q_u8((const u8 *)clut);
+	const uint8x16_t mask4 = vdupq_n_u8(0x0F);
+
+	uint8x16_t sumLo = vdupq_n_u8(0xFF);
+	uint8x16_t sumHi = vdupq_n_u8(0xFF);
+	const int chunks = length / 32;
+	for (int i = 0; i < chunks; ++i) {
+		const uint8x16_t src = vld1q_u8(indexed + i * 16);
+		const uint8x16x2_t index = vzipq_u8(vandq_u8(src, mask4), vshrq_n_u8(src, 4));
+		for (int j = 0; j < 2; ++j) {
+			uint8x16x2_t color;
+			color.val[0] = LookupTable16_NEON(table.val[0], index.val[j]);
+			color.val[1] = LookupTable16_NEON(table.val[1], index.val[j]);
+			vst2q_u8((u8 *)(dest + i * 32 + j * 16), color);
+			sumLo = vandq_u8(sumLo, color.val[0]);
+			sumHi = vandq_u8(sumHi, color.val[1]);
+		}
+	}
+
+	*alphaSum &= (u16)(AndLanes8_NEON(sumLo) | (AndLanes8_NEON(sumHi) << 8));
+	return chunks * 32;
+}
+
+static int DeIndexTexture4Simple32_NEON(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *alphaSum) {
+	// Deinterleaving gives us a table for each byte of the colors.
+	const uint8x16x4_t table = vld4q_u8((const u8 *)clut);
+	const uint8x16_t mask4 = vdupq_n_u8(0x0F);
+
+	uint8x16_t sum[4];
+	for (int k = 0; k < 4; ++k)
+		sum[k] = vdupq_n_u8(0xFF);
+	const int chunks = length / 32;
+	for (int i = 0; i < chunks; ++i) {
+		const uint8x16_t src = vld1q_u8(indexed + i * 16);
+		const uint8x16x2_t index = vzipq_u8(vandq_u8(src, mask4), vshrq_n_u8(src, 4));
+		for (int j = 0; j < 2; ++j) {
+			uint8x16x4_t color;
+			for (int k = 0; k < 4; ++k) {
+				color.val[k] = LookupTable16_NEON(table.val[k], index.val[j]);
+				sum[k] = vandq_u8(sum[k], color.val[k]);
+			}
+			vst4q_u8((u8 *)(dest + i * 32 + j * 16), color);
+		}
+	}
+
+	u32 sum32 = 0;
+	for (int k = 0; k < 4; ++k)
+		sum32 |= AndLanes8_NEON(sum[k]) << (k * 8);
+	*alphaSum &= sum32;
+	return chunks * 32;
+}
+
+#endif
+
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	u16 alphaSum = 0xFFFF;
+	int done = 0;
+#ifdef _M_SSE
+	if (cpu_info.bAVX2)
+		done = DeIndexTexture4Simple16_AVX2(dest, indexed, length, clut, &alphaSum);
+#elif PPSSPP_ARCH(ARM_NEON)
+	done = DeIndexTexture4Simple16_NEON(dest, indexed, length, clut, &alphaSum);
+#endif
+	DeIndexTexture4SimpleGeneric(dest + done, indexed + done / 2, length - done, clut, &alphaSum);
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	u32 alphaSum = 0xFFFFFFFF;
+	int done = 0;
+#ifdef _M_SSE
+	if (cpu_info.bAVX2)
+		done = DeIndexTexture4Simple32_AVX2(dest, indexed, length, clut, &alphaSum);
+#elif PPSSPP_ARCH(ARM_NEON)
+	done = DeIndexTexture4Simple32_NEON(dest, indexed, length, clut, &alphaSum);
+#endif
+	DeIndexTexture4SimpleGeneric(dest + done, indexed + done / 2, length - done, clut, &alphaSum);
+	*outAlphaSum &= alphaSum;
+}
+
+void DeIndexTexture8Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum) {
+	u16 alphaSum = 0xFFFF;
+	int done = 0;
+#ifdef _M_SSE
+	if (cpu_info.bAVX2)
+		done = DeIndexTexture8Simple16_AVX2(dest, indexed, length, clut, &alphaSum);
+#endif
+	DeIndexTexture8SimpleGeneric(dest + done, indexed + done, length - done, clut, &alphaSum);
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+void DeIndexTexture8Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum) {
+	u32 alphaSum = 0xFFFFFFFF;
+	int done = 0;
+#ifdef _M_SSE
+	if (cpu_info.bAVX2)
+		done = DeIndexTexture8Simple32_AVX2(dest, indexed, length, clut, &alphaSum);
+#endif
+	DeIndexTexture8SimpleGeneric(dest + done, indexed + done, length - done, clut, &alphaSum);
+	*outAlphaSum &= alphaSum;
+}
+
 // S3TC / DXT Decoder
 class DXTDecoder {
 public:
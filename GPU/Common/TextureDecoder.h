@@ -37,6 +37,8 @@ void DoSwizzleTex16(const u32 *ysrcp, u8 *texptr, int bxc, int byc, u32 pitch);
 void DoUnswizzleTex16(const u8 *texptr, u32 *ydestp, int bxc, int byc, u32 pitch);
 
 u32 StableQuickTexHash(const void *checkp, u32 size);
+// Splits large sizes across threads, so the result differs from StableQuickTexHash for those.
+u32 ParallelQuickTexHash(const void *checkp, u32 size);
 
 // outMask is an in/out parameter.
 void CopyAndSumMask16(u16 *dst, const u16 *src, int width, u32 *outMask);
@@ -118,6 +120,14 @@ inline CheckAlphaResult CheckAlpha32Rect(const u32 *pixelData, int stride, int w
 	return AlphaSumIsFull(alphaSum, fullAlphaMask) ? CHECKALPHA_FULL : CHECKALPHA_ANY;
 }
 
+// CLUT lookups without any offset, mask, or shift (see GPUgstate::isClutIndexSimple), using SIMD where available.
+// outAlphaSum is an in/out parameter.  DeIndexTexture8Simple with a 16-bit CLUT may read 2 bytes past the
+// highest color used.
+void DeIndexTexture4Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+void DeIndexTexture4Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+void DeIndexTexture8Simple(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+void DeIndexTexture8Simple(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
 template <typename IndexT, typename ClutT>
 inline void DeIndexTexture(/*WRITEONLY*/ ClutT *dest, const IndexT *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
 	// Usually, there is no special offset, mask, or shift.
@@ -127,11 +137,8 @@ inline void DeIndexTexture(/*WRITEONLY*/ ClutT *dest, const IndexT *indexed, int
 
 	if (nakedIndex) {
 		if (sizeof(IndexT) == 1) {
-			for (int i = 0; i < length; ++i) {
-				ClutT color = clut[*indexed++];
-				alphaSum &= color;
-				*dest++ = color;
-			}
+			DeIndexTexture8Simple(dest, (const u8 *)indexed, length, clut, outAlphaSum);
+			return;
 		} else {
 			for (int i = 0; i < length; ++i) {
 				ClutT color = clut[(*indexed++) & 0xFF];
@@ -163,21 +170,8 @@ inline void DeIndexTexture4(/*WRITEONLY*/ ClutT *dest, const u8 *indexed, int le
 
 	ClutT alphaSum = (ClutT)(-1);
 	if (nakedIndex) {
-		while (length >= 2) {
-			u8 index = *indexed++;
-			ClutT color0 = clut[index & 0xf];
-			ClutT color1 = clut[index >> 4];
-			*dest++ = color0;
-			*dest++ = color1;
-			alphaSum &= color0 & color1;
-			length -= 2;
-		}
-		if (length) {  // Last pixel. Can really only happen in 1xY textures, but making this work generically.
-			u8 index = *indexed++;
-			ClutT color0 = clut[index & 0xf];
-			*dest = color0;
-			alphaSum &= color0;
-		}
+		DeIndexTexture4Simple(dest, indexed, length, clut, outAlphaSum);
+		return;
 	} else {
 		while (length >= 2) {
 			u8 index = *indexed++;
@@ -588,7 +588,7 @@ void dbgPGM(int w, int h, u32* pixels, const char* prefix = "dbg") { // 1 compon
 
 /////////////////////////////////////// Texture Scaler
 
-TextureScalerCommon::TextureScalerCommon() {
+TextureScalerCommon::TextureScalerCommon(bool parallel) : parallel_(parallel) {
 	// initBicubicWeights() used to be here.
 }
 
@@ -627,6 +627,32 @@ void TextureScalerCommon::ScaleAlways(u32 *out, u32 *src, int &width, int &heigh
 	}
 }
 
+void TextureScalerCommon::PlanScaleAlways(std::vector<ScalePass> &passes, u32 *out, u32 *src, int width, int height, int factor) {
+	if (IsEmptyOrFlat(src, width * height)) {
+		const u32 pixel = *src;
+		const int outWidth = width * factor;
+		passes.push_back({ [=](int l, int h) {
+			std::fill(out + l * outWidth, out + h * outWidth, pixel);
+		}, 0, height * factor });
+		return;
+	}
+
+	// Later passes resize the buffers earlier ones point into.  They only ever grow, so grow them up front.
+	if (g_Config.bTexDeposterize) {
+		bufDeposter.resize(width * height);
+		bufTmp3.resize(width * height);
+	}
+	if (g_Config.iTexScalingType == HYBRID || g_Config.iTexScalingType == HYBRID_BICUBIC) {
+		bufTmp1.resize(width * height * factor);
+		bufTmp2.resize(width * height * factor * factor);
+		bufTmp3.resize(width * height * factor * factor);
+	}
+
+	planPasses_ = &passes;
+	ScaleInto(out, src, width, height, factor);
+	planPasses_ = nullptr;
+}
+
 bool TextureScalerCommon::ScaleInto(u32 *outputBuf, u32 *src, int &width, int &height, int factor) {
 #ifdef SCALING_MEASURE_TIME
 	double t_start = time_now_d();
@@ -694,24 +720,34 @@ bool TextureScalerCommon::Scale(u32* &data, int &width, int &height, int factor)
 
 const int MIN_LINES_PER_THREAD = 4;
 
+void TextureScalerCommon::RangeLoop(const std::function<void(int, int)> &loop, int lower, int upper) {
+	if (planPasses_) {
+		planPasses_->push_back({ loop, lower, upper });
+	} else if (parallel_) {
+		ParallelRangeLoop(&g_threadManager, loop, lower, upper, MIN_LINES_PER_THREAD);
+	} else {
+		loop(lower, upper);
+	}
+}
+
 void TextureScalerCommon::ScaleXBRZ(int factor, u32* source, u32* dest, int width, int height) {
 	xbrz::ScalerCfg cfg;
-	ParallelRangeLoop(&g_threadManager, std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&xbrz::scale, factor, source, dest, width, height, xbrz::ColorFormat::ARGB, cfg, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleBilinear(int factor, u32* source, u32* dest, int width, int height) {
 	bufTmp1.resize(width * height * factor);
 	u32 *tmpBuf = bufTmp1.data();
-	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearH, factor, source, tmpBuf, width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager, std::bind(&bilinearV, factor, tmpBuf, dest, width, 0, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&bilinearH, factor, source, tmpBuf, width, std::placeholders::_1, std::placeholders::_2), 0, height);
+	RangeLoop(std::bind(&bilinearV, factor, tmpBuf, dest, width, 0, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleBicubicBSpline(int factor, u32* source, u32* dest, int width, int height) {
-	ParallelRangeLoop(&g_threadManager,std::bind(&scaleBicubicBSpline, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&scaleBicubicBSpline, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleBicubicMitchell(int factor, u32* source, u32* dest, int width, int height) {
-	ParallelRangeLoop(&g_threadManager,std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&scaleBicubicMitchell, factor, source, dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 }
 
 void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int width, int height, bool bicubic) {
@@ -728,8 +764,8 @@ void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int wi
 	bufTmp2.resize(width*height*factor*factor);
 	bufTmp3.resize(width*height*factor*factor);
 
-	ParallelRangeLoop(&g_threadManager,std::bind(&generateDistanceMask, source, bufTmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&convolve3x3, bufTmp1.data(), bufTmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&generateDistanceMask, source, bufTmp1.data(), width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
+	RangeLoop(std::bind(&convolve3x3, bufTmp1.data(), bufTmp2.data(), KERNEL_SPLAT, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
 	ScaleBilinear(factor, bufTmp2.data(), bufTmp3.data(), width, height);
 	// mask C is now in bufTmp3
 
@@ -742,13 +778,160 @@ void TextureScalerCommon::ScaleHybrid(int factor, u32* source, u32* dest, int wi
 
 	// Now we can mix it all together
 	// The factor 8192 was found through practical testing on a variety of textures
-	ParallelRangeLoop(&g_threadManager,std::bind(&mix, dest, bufTmp2.data(), bufTmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&mix, dest, bufTmp2.data(), bufTmp3.data(), 8192, width*factor, std::placeholders::_1, std::placeholders::_2), 0, height*factor);
 }
 
 void TextureScalerCommon::DePosterize(u32* source, u32* dest, int width, int height) {
 	bufTmp3.resize(width*height);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, source, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeH, dest, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
-	ParallelRangeLoop(&g_threadManager,std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height, MIN_LINES_PER_THREAD);
+	RangeLoop(std::bind(&deposterizeH, source, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height);
+	RangeLoop(std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
+	RangeLoop(std::bind(&deposterizeH, dest, bufTmp3.data(), width, std::placeholders::_1, std::placeholders::_2), 0, height);
+	RangeLoop(std::bind(&deposterizeV, bufTmp3.data(), dest, width, height, std::placeholders::_1, std::placeholders::_2), 0, height);
+}
+
+// About this many output pixels per piece of a scale.
+static const int SCALE_PIECE_PIXELS = 16384;
+
+// One texture being scaled a piece at a time.  Only one piece of it is queued or running at once.
+struct TextureScaleRun {
+	std::shared_ptr<TextureScaleJob> job;
+	TextureScalerCommon scaler{ false };
+	std::vector<TextureScalerCommon::ScalePass> passes;
+	std::vector<u32> scaled;
+	size_t pass = 0;
+	int line = 0;
+};
+
+static std::atomic<int> nextScaleThread;
+
+// Runs a few lines of a scale, then queues the next piece.  A whole texture would hold up a worker for a long
+// time, and with it anything pinned to that worker, like parallel loops for SAS or the software renderer.
+class TextureScaleTask : public Task {
+public:
+	TextureScaleTask(std::shared_ptr<TextureScaleRun> run) : run_(run) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	// Only at teardown, which drops the rest of the job.
+	bool Cancellable() override {
+		return true;
+	}
+
+	void Run() override;
+
+	static void Enqueue(std::shared_ptr<TextureScaleRun> run) {
+		// The shared queue is always checked first, so pieces there would make pinned work wait for every job
+		// to finish.  At the end of a worker's own queue, they only wait for what was already queued.
+		const int numThreads = std::max(1, g_threadManager.GetNumLooperThreads());
+		g_threadManager.EnqueueTaskOnThread(nextScaleThread++ % numThreads, new TextureScaleTask(run));
+	}
+
+private:
+	std::shared_ptr<TextureScaleRun> run_;
+};
+
+void TextureScaleTask::Run() {
+	TextureScaleRun &run = *run_;
+	TextureScaleJob &job = *run.job;
+	const int outPixels = job.w * job.h * job.scaleFactor * job.scaleFactor;
+
+	if (run.scaled.empty()) {
+		// The first piece just plans it, which checks for flat textures.
+		run.scaled.resize(outPixels);
+		run.scaler.PlanScaleAlways(run.passes, run.scaled.data(), job.pixels.data(), job.w, job.h, job.scaleFactor);
+		run.line = run.passes.empty() ? 0 : run.passes[0].lower;
+	} else {
+		const TextureScalerCommon::ScalePass &pass = run.passes[run.pass];
+		const int lines = std::max(MIN_LINES_PER_THREAD, (int)((s64)(pass.upper - pass.lower) * SCALE_PIECE_PIXELS / outPixels));
+		const int end = std::min(pass.upper, run.line + lines);
+		pass.loop(run.line, end);
+		run.line = end;
+	}
+
+	while (run.pass < run.passes.size() && run.line >= run.passes[run.pass].upper) {
+		run.pass++;
+		if (run.pass < run.passes.size())
+			run.line = run.passes[run.pass].lower;
+	}
+
+	if (run.pass < run.passes.size()) {
+		Enqueue(run_);
+	} else {
+		job.pixels = std::move(run.scaled);
+		job.done = true;
+	}
+}
+
+void TextureScaleQueue::Start(u64 key, std::shared_ptr<TextureScaleJob> job) {
+	job->done = false;
+	jobs_[key] = job;
+	std::shared_ptr<TextureScaleRun> run = std::make_shared<TextureScaleRun>();
+	run->job = job;
+	TextureScaleTask::Enqueue(run);
+}
+
+std::shared_ptr<TextureScaleJob> TextureScaleQueue::TakeFinished(u64 key, u32 fullhash, int w, int h, int scaleFactor) {
+	auto it = jobs_.find(key);
+	if (it == jobs_.end() || !it->second->done)
+		return nullptr;
+
+	std::shared_ptr<TextureScaleJob> job = it->second;
+	jobs_.erase(it);
+	// If the texture changed since, this is of no use.  The caller can start over.
+	if (job->fullhash != fullhash || job->w != w || job->h != h || job->scaleFactor != scaleFactor)
+		return nullptr;
+	return job;
+}
+
+size_t TextureScaleQueue::NumJobs() const {
+	size_t count = jobs_.size();
+	for (const auto &job : forgotten_) {
+		if (!job->done)
+			count++;
+	}
+	return count;
+}
+
+bool TextureScaleQueue::CanMakeProgress(u64 key) const {
+	auto it = jobs_.find(key);
+	if (it != jobs_.end()) {
+		return it->second->done;
+	}
+	return NumJobs() < MAX_JOBS;
+}
+
+bool TextureScaleQueue::CanStart(u64 key) const {
+	return jobs_.find(key) == jobs_.end() && NumJobs() < MAX_JOBS;
+}
+
+void TextureScaleQueue::Decimate(int frame, int killAge) {
+	for (auto iter = jobs_.begin(); iter != jobs_.end(); ) {
+		if (iter->second->done && iter->second->startFrame + killAge < frame) {
+			iter = jobs_.erase(iter);
+		} else {
+			++iter;
+		}
+	}
+	forgotten_.erase(std::remove_if(forgotten_.begin(), forgotten_.end(), [](const std::shared_ptr<TextureScaleJob> &job) {
+		return job->done.load();
+	}), forgotten_.end());
+}
+
+void TextureScaleQueue::Forget(u64 key) {
+	auto it = jobs_.find(key);
+	if (it == jobs_.end())
+		return;
+	if (!it->second->done)
+		forgotten_.push_back(it->second);
+	jobs_.erase(it);
+}
+
+void TextureScaleQueue::Clear() {
+	for (auto &it : jobs_) {
+		if (!it.second->done)
+			forgotten_.push_back(it.second);
+	}
+	jobs_.clear();
 }
@@ -17,8 +17,15 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
 #include "Common/CommonTypes.h"
 #include "Common/MemoryUtil.h"
+#include "GPU/Common/TextureDecoder.h"
 
 static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 
@@ -27,13 +34,24 @@ static const int MIN_TEXSCALE_LINES_PER_THREAD = 4;
 // They will of course not unflip during the operation so be aware of that).
 class TextureScalerCommon {
 public:
-	TextureScalerCommon();
+	// Scalers used from a worker thread must not be parallel, the loops would wait on more tasks.
+	explicit TextureScalerCommon(bool parallel = true);
 	~TextureScalerCommon();
 
 	void ScaleAlways(u32 *out, u32 *src, int &width, int &height, int factor);
 	bool Scale(u32 *&data, int &width, int &height, int factor);
 	bool ScaleInto(u32 *out, u32 *src, int &width, int &height, int factor);
 
+	// One step of a scale, over a range of lines.  Each step has to be done before the next one starts.
+	struct ScalePass {
+		std::function<void(int, int)> loop;
+		int lower;
+		int upper;
+	};
+	// Like ScaleAlways, but lists the passes instead of running them, so they can be run a few lines at a time.
+	// They point into this scaler's buffers, so it has to outlive them.
+	void PlanScaleAlways(std::vector<ScalePass> &passes, u32 *out, u32 *src, int width, int height, int factor);
+
 	enum { XBRZ = 0, HYBRID = 1, BICUBIC = 2, HYBRID_BICUBIC = 3 };
 
 protected:
@@ -46,9 +64,58 @@ class TextureScalerCommon {
 	void DePosterize(u32* source, u32* dest, int width, int height);
 
 	bool IsEmptyOrFlat(const u32 *data, int pixels) const;
+	void RangeLoop(const std::function<void(int, int)> &loop, int lower, int upper);
+
+	bool parallel_;
+	// While planning, RangeLoop adds the loops here rather than running them.
+	std::vector<ScalePass> *planPasses_ = nullptr;
 
 	// depending on the factor and texture sizes, these can get pretty large 
 	// maximum is (100 MB total for a 512 by 512 texture with scaling factor 5 and hybrid scaling)
 	// of course, scaling factor 5 is totally silly anyway
 	SimpleBuf<u32> bufDeposter, bufOutput, bufTmp1, bufTmp2, bufTmp3;
 };
+
+struct TextureScaleJob {
+	// What was decoded, so we can tell if the texture changed meanwhile.
+	u32 fullhash = 0;
+	int w = 0;
+	int h = 0;
+	int scaleFactor = 1;
+	int startFrame = 0;
+	CheckAlphaResult alphaResult = CHECKALPHA_ANY;
+	// The decoded 0-mip (8888), replaced by the scaled one once done.
+	std::vector<u32> pixels;
+	std::atomic<bool> done{};
+};
+
+// Textures being scaled on the thread manager, by texture cache key.  Finished ones wait to be uploaded.
+// Only used from the GPU thread, the tasks only touch their own job.
+class TextureScaleQueue {
+public:
+	// Scales job->pixels on a thread.
+	void Start(u64 key, std::shared_ptr<TextureScaleJob> job);
+	// Returns the finished job if it still matches the texture.  If it doesn't, it's dropped.
+	std::shared_ptr<TextureScaleJob> TakeFinished(u64 key, u32 fullhash, int w, int h, int scaleFactor);
+
+	// Whether rebuilding a texture waiting to be scaled gets it any closer.
+	bool CanMakeProgress(u64 key) const;
+	bool CanStart(u64 key) const;
+
+	// Drops finished jobs that never got picked up, and forgotten ones that are done running.
+	void Decimate(int frame, int killAge);
+	// For textures that are going away.  Jobs still running keep counting toward MAX_JOBS until they're done.
+	void Forget(u64 key);
+	void Clear();
+	size_t Size() const {
+		return jobs_.size() + forgotten_.size();
+	}
+
+	enum { MAX_JOBS = 16 };
+
+private:
+	size_t NumJobs() const;
+
+	std::unordered_map<u64, std::shared_ptr<TextureScaleJob>> jobs_;
+	std::vector<std::shared_ptr<TextureScaleJob>> forgotten_;
+};
@@ -0,0 +1,159 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+
+#include "GPU/Common/VertexCache.h"
+
+VertexCache::VertexCache() : arrays_(1024), data_(256) {
+}
+
+VertexCache::~VertexCache() {
+	// The backend should have cleared already, if it had anything to release.
+	release_ = nullptr;
+	Clear();
+}
+
+VertexArrayInfo *VertexCache::GetArray(u32 id, int frame) {
+	VertexArrayInfo *vai = arrays_.Get(id);
+	if (!vai) {
+		vai = new VertexArrayInfo();
+		vai->lastFrame = frame;
+		arrays_.Insert(id, vai);
+	}
+
+	vai->numDraws++;
+	if (vai->lastFrame != frame) {
+		vai->numFrames++;
+		vai->lastFrame = frame;
+	}
+	return vai;
+}
+
+void VertexCache::MarkUnreliable(VertexArrayInfo *vai) {
+	vai->status = VertexArrayInfo::VAI_UNRELIABLE;
+	stats.unreliable++;
+	// The decoded data stays, another array might still use it.
+}
+
+CachedVertexData *VertexCache::Find(uint64_t key, int frame) {
+	CachedVertexData *data = data_.Get(key);
+	if (data) {
+		data->lastFrame = frame;
+		data->numDraws++;
+	}
+	return data;
+}
+
+CachedVertexData *VertexCache::Add(uint64_t key, int frame) {
+	CachedVertexData *data = data_.Get(key);
+	if (data) {
+		Release(data);
+		data_.Remove(key);
+		delete data;
+	}
+
+	data = new CachedVertexData();
+	data->key = key;
+	data->lastFrame = frame;
+	data_.Insert(key, data);
+	stats.decodes++;
+	return data;
+}
+
+void VertexCache::Decimate(int frame) {
+	const int threshold = frame - KILL_AGE;
+	const int unreliableThreshold = frame - UNRELIABLE_KILL_AGE;
+	int unreliableLeft = UNRELIABLE_KILL_MAX;
+	arrays_.Iterate([&](uint32_t hash, VertexArrayInfo *vai) {
+		bool kill;
+		if (vai->status == VertexArrayInfo::VAI_UNRELIABLE) {
+			// We limit killing unreliable so we don't rehash too often.
+			kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
+		} else {
+			kill = vai->lastFrame < threshold;
+		}
+		if (kill) {
+			// This is actually quite safe.
+			arrays_.Remove(hash);
+			delete vai;
+		}
+	});
+	arrays_.Maintain();
+
+	struct Candidate {
+		int lastFrame;
+		uint64_t key;
+		size_t size;
+	};
+	std::vector<Candidate> candidates;
+	candidates.reserve(data_.size());
+	dataBytes_ = 0;
+	data_.Iterate([&](uint64_t key, CachedVertexData *data) {
+		if (data->lastFrame < threshold) {
+			Release(data);
+			data_.Remove(key);
+			delete data;
+		} else {
+			candidates.push_back(Candidate{ data->lastFrame, key, SizeOf(data) });
+			dataBytes_ += candidates.back().size;
+		}
+	});
+
+	if (dataBytes_ > MAX_DATA_BYTES) {
+		// Drop the least recently used until we're back within budget.
+		std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+			return a.lastFrame < b.lastFrame;
+		});
+		for (const Candidate &c : candidates) {
+			if (dataBytes_ <= MAX_DATA_BYTES)
+				break;
+			CachedVertexData *data = data_.Get(c.key);
+			Release(data);
+			data_.Remove(c.key);
+			delete data;
+			dataBytes_ -= c.size;
+		}
+	}
+	data_.Maintain();
+}
+
+void VertexCache::Clear() {
+	arrays_.Iterate([&](uint32_t hash, VertexArrayInfo *vai) {
+		delete vai;
+	});
+	arrays_.Clear();
+
+	data_.Iterate([&](uint64_t key, CachedVertexData *data) {
+		Release(data);
+		delete data;
+	});
+	data_.Clear();
+	dataBytes_ = 0;
+}
+
+void VertexCache::ReleaseBackendData() {
+	data_.Iterate([&](uint64_t key, CachedVertexData *data) {
+		Release(data);
+	});
+}
+
+void VertexCache::Release(CachedVertexData *data) {
+	if (data->backendData && release_)
+		release_(data);
+	data->backendData = nullptr;
+}
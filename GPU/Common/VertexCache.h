@@ -0,0 +1,152 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Common/CommonTypes.h"
+#include "Common/Data/Collections/Hashmaps.h"
+
+// Backend-agnostic cache of decoded vertex data, so static geometry only goes through
+// the VertexDecoder once, whatever the backend.
+//
+// There are two levels.  A VertexArrayInfo tracks a sequence of draw calls (by the
+// addresses and counts, see DrawEngineCommon::dcid_) and whether its data seems to
+// change.  Once it seems stable, it points to a CachedVertexData by content: a hash
+// of the raw vertex and index data, the vertex type, and how the prims were drawn.
+// That way, identical data drawn from different places or after a different flush
+// still only gets decoded once.
+//
+// State transitions of a VertexArrayInfo:
+// NEW -> HASHING (once drawn)
+// HASHING -> UNRELIABLE (data changed)
+// HASHING -> RELIABLE (not currently used)
+// UNRELIABLE -> death
+// HASHING/RELIABLE -> death (not drawn for a while)
+
+struct CachedVertexData {
+	uint64_t key = 0;
+
+	// Decoded vertices and the generated (u16) indices.
+	std::vector<u8> verts;
+	std::vector<u16> inds;
+	int numDecodedVerts = 0;
+
+	// IndexGenerator results, enough to draw with or without the indices.
+	u16 indexCount = 0;
+	u16 pureCount = 0;
+	u16 maxIndex = 0;
+	s8 prim = -1;
+	s8 generalPrim = -1;
+	bool seenOnlyPurePrims = false;
+	bool vertexFullAlpha = false;
+
+	int lastFrame = 0;
+	int numDraws = 0;
+
+	// Owned by the backend, for example GPU buffers with a copy of the data.
+	// Released through the callback passed to VertexCache.
+	void *backendData = nullptr;
+};
+
+struct VertexArrayInfo {
+	enum Status : uint8_t {
+		VAI_NEW,
+		VAI_HASHING,
+		VAI_RELIABLE,  // cache, don't hash
+		VAI_UNRELIABLE,  // never cache
+	};
+
+	uint64_t hash = 0;
+	uint64_t key = 0;
+	u32 minihash = 0;
+	Status status = VAI_NEW;
+
+	int numDraws = 0;
+	int numFrames = 0;
+	int lastFrame = 0;  // So that we can forget.
+	u16 drawsUntilNextFullHash = 0;
+};
+
+struct VertexCacheStats {
+	// Draws served from decoded data, and how many of those found it by content from another array.
+	int hits = 0;
+	int sharedHits = 0;
+	// Decoded data added to the cache.
+	int decodes = 0;
+	// Arrays that changed after being cached, and are now decoded every time.
+	int unreliable = 0;
+};
+
+class VertexCache {
+public:
+	typedef std::function<void(CachedVertexData *)> ReleaseFunc;
+
+	VertexCache();
+	~VertexCache();
+
+	// Called whenever data is removed, with backendData still set.
+	void SetReleaseFunc(ReleaseFunc release) {
+		release_ = release;
+	}
+
+	VertexArrayInfo *GetArray(u32 id, int frame);
+	void MarkUnreliable(VertexArrayInfo *vai);
+
+	CachedVertexData *Find(uint64_t key, int frame);
+	// Replaces any existing data for this key.
+	CachedVertexData *Add(uint64_t key, int frame);
+
+	// Forgets anything not used in a while, and keeps the decoded data within budget.
+	void Decimate(int frame);
+	void Clear();
+	// Drops the backend copies, but keeps the decoded data.
+	void ReleaseBackendData();
+
+	size_t NumArrays() const {
+		return arrays_.size();
+	}
+	size_t NumData() const {
+		return data_.size();
+	}
+	size_t DataBytes() const {
+		return dataBytes_;
+	}
+
+	VertexCacheStats stats;
+
+	enum {
+		KILL_AGE = 120,
+		UNRELIABLE_KILL_AGE = 240,
+		UNRELIABLE_KILL_MAX = 4,
+		MAX_DATA_BYTES = 32 * 1024 * 1024,
+	};
+
+private:
+	void Release(CachedVertexData *data);
+	static size_t SizeOf(const CachedVertexData *data) {
+		return data->verts.size() + data->inds.size() * sizeof(u16);
+	}
+
+	PrehashMap<VertexArrayInfo *, nullptr> arrays_;
+	DenseHashMap<uint64_t, CachedVertexData *, nullptr> data_;
+	size_t dataBytes_ = 0;
+	ReleaseFunc release_;
+};
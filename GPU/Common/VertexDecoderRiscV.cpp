@@ -0,0 +1,579 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+#if PPSSPP_ARCH(RISCV64)
+
+#include "Common/CPUDetect.h"
+#include "Common/Log.h"
+#include "Core/Config.h"
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "GPU/GPUState.h"
+#include "GPU/Common/VertexDecoderCommon.h"
+
+static const float by128 = 1.0f / 128.0f;
+static const float by32768 = 1.0f / 32768.0f;
+static const float const65535 = 65535.0f;
+
+using namespace RiscVGen;
+
+// Only caller saved registers are used, so there's nothing to push.
+static const RiscVReg srcReg = X10;
+static const RiscVReg dstReg = X11;
+static const RiscVReg counterReg = X12;
+
+static const RiscVReg tempReg1 = X13;
+static const RiscVReg tempReg2 = X14;
+static const RiscVReg tempReg3 = X15;
+static const RiscVReg scratchReg = X16;
+
+static const RiscVReg fullAlphaReg = X17;
+static const RiscVReg boundsMinUReg = X28;
+static const RiscVReg boundsMinVReg = X29;
+static const RiscVReg boundsMaxUReg = X30;
+static const RiscVReg boundsMaxVReg = X31;
+
+static const RiscVReg fpScratchReg1 = F0;
+static const RiscVReg fpSrc[3] = { F3, F4, F5 };
+
+static const RiscVReg fpByReg = F10;
+static const RiscVReg fpUScaleReg = F11;
+static const RiscVReg fpVScaleReg = F12;
+static const RiscVReg fpUOffsetReg = F13;
+static const RiscVReg fpVOffsetReg = F14;
+
+// There's no vector unit assumed, so everything is done a component at a time.
+// Skinning and morphing are left to the C++ decoder for now.
+static const JitLookup jitLookup[] = {
+	{&VertexDecoder::Step_WeightsU8, &VertexDecoderJitCache::Jit_WeightsU8},
+	{&VertexDecoder::Step_WeightsU16, &VertexDecoderJitCache::Jit_WeightsU16},
+	{&VertexDecoder::Step_WeightsFloat, &VertexDecoderJitCache::Jit_WeightsFloat},
+
+	{&VertexDecoder::Step_TcFloat, &VertexDecoderJitCache::Jit_TcFloat},
+	{&VertexDecoder::Step_TcU8ToFloat, &VertexDecoderJitCache::Jit_TcU8ToFloat},
+	{&VertexDecoder::Step_TcU16ToFloat, &VertexDecoderJitCache::Jit_TcU16ToFloat},
+
+	{&VertexDecoder::Step_TcU8Prescale, &VertexDecoderJitCache::Jit_TcU8Prescale},
+	{&VertexDecoder::Step_TcU16Prescale, &VertexDecoderJitCache::Jit_TcU16Prescale},
+	{&VertexDecoder::Step_TcFloatPrescale, &VertexDecoderJitCache::Jit_TcFloatPrescale},
+
+	{&VertexDecoder::Step_TcFloatThrough, &VertexDecoderJitCache::Jit_TcFloatThrough},
+	{&VertexDecoder::Step_TcU16ThroughToFloat, &VertexDecoderJitCache::Jit_TcU16ThroughToFloat},
+
+	{&VertexDecoder::Step_NormalS8, &VertexDecoderJitCache::Jit_NormalS8},
+	{&VertexDecoder::Step_NormalS8ToFloat, &VertexDecoderJitCache::Jit_NormalS8ToFloat},
+	{&VertexDecoder::Step_NormalS16, &VertexDecoderJitCache::Jit_NormalS16},
+	{&VertexDecoder::Step_NormalFloat, &VertexDecoderJitCache::Jit_NormalFloat},
+
+	{&VertexDecoder::Step_Color8888, &VertexDecoderJitCache::Jit_Color8888},
+	{&VertexDecoder::Step_Color4444, &VertexDecoderJitCache::Jit_Color4444},
+	{&VertexDecoder::Step_Color565, &VertexDecoderJitCache::Jit_Color565},
+	{&VertexDecoder::Step_Color5551, &VertexDecoderJitCache::Jit_Color5551},
+
+	{&VertexDecoder::Step_PosS8Through, &VertexDecoderJitCache::Jit_PosS8Through},
+	{&VertexDecoder::Step_PosS16Through, &VertexDecoderJitCache::Jit_PosS16Through},
+	{&VertexDecoder::Step_PosFloatThrough, &VertexDecoderJitCache::Jit_PosFloatThrough},
+
+	{&VertexDecoder::Step_PosS8, &VertexDecoderJitCache::Jit_PosS8},
+	{&VertexDecoder::Step_PosS16, &VertexDecoderJitCache::Jit_PosS16},
+	{&VertexDecoder::Step_PosFloat, &VertexDecoderJitCache::Jit_PosFloat},
+};
+
+JittedVertexDecoder VertexDecoderJitCache::Compile(const VertexDecoder &dec, int32_t *jittedSize) {
+	dec_ = &dec;
+
+	BeginWrite(4096);
+	const u8 *start = AlignCode16();
+	SetAutoCompress(true);
+
+	bool prescaleStep = false;
+	bool log = false;
+
+	// Look for prescaled texcoord steps
+	for (int i = 0; i < dec.numSteps_; i++) {
+		if (dec.steps_[i] == &VertexDecoder::Step_TcU8Prescale ||
+			dec.steps_[i] == &VertexDecoder::Step_TcU16Prescale ||
+			dec.steps_[i] == &VertexDecoder::Step_TcFloatPrescale) {
+			prescaleStep = true;
+		}
+	}
+
+	// Keep the scale/offset in a few fp registers if we need it.
+	if (prescaleStep) {
+		LI(tempReg1, &gstate_c.uv);
+		FL(32, fpUScaleReg, tempReg1, offsetof(UVScale, uScale));
+		FL(32, fpVScaleReg, tempReg1, offsetof(UVScale, vScale));
+		FL(32, fpUOffsetReg, tempReg1, offsetof(UVScale, uOff));
+		FL(32, fpVOffsetReg, tempReg1, offsetof(UVScale, vOff));
+		// Fold the fixed point scale in, it's a power of two so the result is the same.
+		if ((dec.VertexType() & GE_VTYPE_TC_MASK) == GE_VTYPE_TC_8BIT) {
+			LI(scratchReg, by128);
+			FMV(FMv::W, FMv::X, fpScratchReg1, scratchReg);
+			FMUL(32, fpUScaleReg, fpUScaleReg, fpScratchReg1);
+			FMUL(32, fpVScaleReg, fpVScaleReg, fpScratchReg1);
+		} else if ((dec.VertexType() & GE_VTYPE_TC_MASK) == GE_VTYPE_TC_16BIT) {
+			LI(scratchReg, by32768);
+			FMV(FMv::W, FMv::X, fpScratchReg1, scratchReg);
+			FMUL(32, fpUScaleReg, fpUScaleReg, fpScratchReg1);
+			FMUL(32, fpVScaleReg, fpVScaleReg, fpScratchReg1);
+		}
+	}
+
+	if (dec.col) {
+		// Cleared when any vertex has alpha != 0xFF.
+		LI(fullAlphaReg, 1);
+	}
+
+	if (dec.tc && dec.throughmode) {
+		// TODO: Smarter, only when doing bounds.
+		LI(scratchReg, &gstate_c.vertBounds);
+		LHU(boundsMinUReg, scratchReg, offsetof(KnownVertexBounds, minU));
+		LHU(boundsMaxUReg, scratchReg, offsetof(KnownVertexBounds, maxU));
+		LHU(boundsMinVReg, scratchReg, offsetof(KnownVertexBounds, minV));
+		LHU(boundsMaxVReg, scratchReg, offsetof(KnownVertexBounds, maxV));
+	}
+
+	const u8 *loopStart = GetCodePtr();
+	for (int i = 0; i < dec.numSteps_; i++) {
+		if (!CompileStep(dec, i)) {
+			EndWrite();
+			// Reset the code ptr (effectively undoing what we generated) and return zero to indicate that we failed.
+			ResetCodePtr(GetOffset(start));
+			char temp[1024] = {0};
+			dec.ToString(temp);
+			ERROR_LOG(G3D, "Could not compile vertex decoder, failed at step %d: %s", i, temp);
+			return nullptr;
+		}
+	}
+
+	ADDI(srcReg, srcReg, dec.VertexSize());
+	ADDI(dstReg, dstReg, dec.decFmt.stride);
+	ADDIW(counterReg, counterReg, -1);
+	BNE(counterReg, R_ZERO, loopStart);
+
+	if (dec.col) {
+		LI(tempReg1, &gstate_c.vertexFullAlpha);
+		FixupBranch skip = BNE(fullAlphaReg, R_ZERO);
+		SB(fullAlphaReg, tempReg1, 0);
+		SetJumpTarget(skip);
+	}
+
+	if (dec.tc && dec.throughmode) {
+		// TODO: Smarter, only when doing bounds.
+		LI(scratchReg, &gstate_c.vertBounds);
+		SH(boundsMinUReg, scratchReg, offsetof(KnownVertexBounds, minU));
+		SH(boundsMaxUReg, scratchReg, offsetof(KnownVertexBounds, maxU));
+		SH(boundsMinVReg, scratchReg, offsetof(KnownVertexBounds, minV));
+		SH(boundsMaxVReg, scratchReg, offsetof(KnownVertexBounds, maxV));
+	}
+
+	RET();
+
+	FlushIcache();
+
+	if (log) {
+		char temp[1024] = { 0 };
+		dec.ToString(temp);
+		INFO_LOG(JIT, "=== %s (%d bytes) ===", temp, (int)(GetCodePtr() - start));
+		std::vector<std::string> lines = DisassembleRV64(start, (int)(GetCodePtr() - start));
+		for (auto line : lines) {
+			INFO_LOG(JIT, "%s", line.c_str());
+		}
+		INFO_LOG(JIT, "==========");
+	}
+
+	*jittedSize = (int)(GetCodePtr() - start);
+	EndWrite();
+	return (JittedVertexDecoder)start;
+}
+
+bool VertexDecoderJitCache::CompileStep(const VertexDecoder &dec, int step) {
+	// See if we find a matching JIT function
+	for (size_t i = 0; i < ARRAY_SIZE(jitLookup); i++) {
+		if (dec.steps_[step] == jitLookup[i].func) {
+			((*this).*jitLookup[i].jitFunc)();
+			return true;
+		}
+	}
+	return false;
+}
+
+// Puts a float constant in fpByReg, to multiply by.
+static void LoadFloatConst(RiscVEmitter *emit, float value) {
+	emit->LI(scratchReg, value);
+	emit->FMV(FMv::W, FMv::X, fpByReg, scratchReg);
+}
+
+static void UpdateFullAlpha(RiscVEmitter *emit, RiscVReg alpha) {
+	// fullAlphaReg &= alpha == 0xFF.
+	emit->XORI(tempReg3, alpha, 0xFF);
+	emit->SLTIU(tempReg3, tempReg3, 1);
+	emit->AND(fullAlphaReg, fullAlphaReg, tempReg3);
+}
+
+// Expands the 5 bits at shift in src to 8 bits, and places them at dstShift in dst.
+static void Expand5To8(RiscVEmitter *emit, RiscVReg dst, RiscVReg src, int shift, int dstShift) {
+	if (shift != 0)
+		emit->SRLIW(tempReg3, src, shift);
+	emit->ANDI(tempReg3, shift != 0 ? tempReg3 : src, 0x1F);
+	emit->SLLIW(scratchReg, tempReg3, 3);
+	emit->SRLIW(tempReg3, tempReg3, 2);
+	emit->OR(tempReg3, tempReg3, scratchReg);
+	if (dstShift != 0)
+		emit->SLLIW(tempReg3, tempReg3, dstShift);
+	emit->OR(dst, dst, tempReg3);
+}
+
+void VertexDecoderJitCache::Jit_WeightsU8() {
+	// Basic implementation - a byte at a time. TODO: Optimize
+	int j;
+	for (j = 0; j < dec_->nweights; j++) {
+		LBU(tempReg1, srcReg, dec_->weightoff + j);
+		SB(tempReg1, dstReg, dec_->decFmt.w0off + j);
+	}
+	while (j & 3) {
+		SB(R_ZERO, dstReg, dec_->decFmt.w0off + j);
+		j++;
+	}
+}
+
+void VertexDecoderJitCache::Jit_WeightsU16() {
+	// Basic implementation - a short at a time. TODO: Optimize
+	int j;
+	for (j = 0; j < dec_->nweights; j++) {
+		LHU(tempReg1, srcReg, dec_->weightoff + j * 2);
+		SH(tempReg1, dstReg, dec_->decFmt.w0off + j * 2);
+	}
+	while (j & 3) {
+		SH(R_ZERO, dstReg, dec_->decFmt.w0off + j * 2);
+		j++;
+	}
+}
+
+void VertexDecoderJitCache::Jit_WeightsFloat() {
+	int j;
+	for (j = 0; j < dec_->nweights; j++) {
+		LW(tempReg1, srcReg, dec_->weightoff + j * 4);
+		SW(tempReg1, dstReg, dec_->decFmt.w0off + j * 4);
+	}
+	while (j & 3) {  // Zero additional weights rounding up to 4.
+		SW(R_ZERO, dstReg, dec_->decFmt.w0off + j * 4);
+		j++;
+	}
+}
+
+void VertexDecoderJitCache::Jit_Color8888() {
+	LW(tempReg1, srcReg, dec_->coloff);
+	SW(tempReg1, dstReg, dec_->decFmt.c0off);
+
+	SRLIW(tempReg2, tempReg1, 24);
+	UpdateFullAlpha(this, tempReg2);
+}
+
+void VertexDecoderJitCache::Jit_Color4444() {
+	LHU(tempReg1, srcReg, dec_->coloff);
+
+	// Spread out the components.
+	ANDI(tempReg2, tempReg1, 0x000F);
+	for (int i = 1; i < 4; ++i) {
+		SRLIW(tempReg3, tempReg1, i * 4);
+		ANDI(tempReg3, tempReg3, 0x000F);
+		SLLIW(tempReg3, tempReg3, i * 8);
+		OR(tempReg2, tempReg2, tempReg3);
+	}
+
+	// And expand to 8 bits.
+	SLLIW(tempReg3, tempReg2, 4);
+	OR(tempReg2, tempReg2, tempReg3);
+	SW(tempReg2, dstReg, dec_->decFmt.c0off);
+
+	SRLIW(tempReg2, tempReg1, 12);
+	ORI(tempReg2, tempReg2, 0xF0);
+	UpdateFullAlpha(this, tempReg2);
+}
+
+void VertexDecoderJitCache::Jit_Color565() {
+	LHU(tempReg1, srcReg, dec_->coloff);
+
+	// Start with full alpha.  No need to update fullAlphaReg.
+	LI(tempReg2, (s32)0xFF000000);
+	Expand5To8(this, tempReg2, tempReg1, 0, 0);
+	Expand5To8(this, tempReg2, tempReg1, 11, 16);
+
+	// Now G, which has 6 bits.
+	SRLIW(tempReg3, tempReg1, 5);
+	ANDI(tempReg3, tempReg3, 0x3F);
+	SLLIW(scratchReg, tempReg3, 2);
+	SRLIW(tempReg3, tempReg3, 4);
+	OR(tempReg3, tempReg3, scratchReg);
+	SLLIW(tempReg3, tempReg3, 8);
+	OR(tempReg2, tempReg2, tempReg3);
+
+	SW(tempReg2, dstReg, dec_->decFmt.c0off);
+}
+
+void VertexDecoderJitCache::Jit_Color5551() {
+	LHU(tempReg1, srcReg, dec_->coloff);
+
+	LI(tempReg2, 0);
+	Expand5To8(this, tempReg2, tempReg1, 0, 0);
+	Expand5To8(this, tempReg2, tempReg1, 5, 8);
+	Expand5To8(this, tempReg2, tempReg1, 10, 16);
+
+	// Alpha is either 0 or 0xFF, the top bit decides.
+	SRLIW(tempReg3, tempReg1, 15);
+	AND(fullAlphaReg, fullAlphaReg, tempReg3);
+	NEG(tempReg3, tempReg3);
+	SLLIW(tempReg3, tempReg3, 24);
+	OR(tempReg2, tempReg2, tempReg3);
+
+	SW(tempReg2, dstReg, dec_->decFmt.c0off);
+}
+
+void VertexDecoderJitCache::Jit_TcU16ThroughToFloat() {
+	LHU(tempReg1, srcReg, dec_->tcoff);
+	LHU(tempReg2, srcReg, dec_->tcoff + 2);
+
+	auto updateSide = [&](RiscVReg src, bool greater, RiscVReg dst) {
+		if (cpu_info.RiscV_B) {
+			if (greater)
+				MAXU(dst, dst, src);
+			else
+				MINU(dst, dst, src);
+			return;
+		}
+		FixupBranch skip = greater ? BGEU(dst, src) : BGEU(src, dst);
+		MV(dst, src);
+		SetJumpTarget(skip);
+	};
+
+	updateSide(tempReg1, false, boundsMinUReg);
+	updateSide(tempReg1, true, boundsMaxUReg);
+	updateSide(tempReg2, false, boundsMinVReg);
+	updateSide(tempReg2, true, boundsMaxVReg);
+
+	FCVT(FConv::S, FConv::WU, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::WU, fpSrc[1], tempReg2);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcFloatThrough() {
+	LW(tempReg1, srcReg, dec_->tcoff);
+	LW(tempReg2, srcReg, dec_->tcoff + 4);
+	SW(tempReg1, dstReg, dec_->decFmt.uvoff);
+	SW(tempReg2, dstReg, dec_->decFmt.uvoff + 4);
+
+	// The bounds are tracked as u16, truncated.
+	FL(32, fpSrc[0], srcReg, dec_->tcoff);
+	FL(32, fpSrc[1], srcReg, dec_->tcoff + 4);
+	FCVT(FConv::W, FConv::S, tempReg1, fpSrc[0], Round::TOZERO);
+	FCVT(FConv::W, FConv::S, tempReg2, fpSrc[1], Round::TOZERO);
+	SLLI(tempReg1, tempReg1, 48);
+	SRLI(tempReg1, tempReg1, 48);
+	SLLI(tempReg2, tempReg2, 48);
+	SRLI(tempReg2, tempReg2, 48);
+
+	auto updateSide = [&](RiscVReg src, bool greater, RiscVReg dst) {
+		FixupBranch skip = greater ? BGEU(dst, src) : BGEU(src, dst);
+		MV(dst, src);
+		SetJumpTarget(skip);
+	};
+
+	updateSide(tempReg1, false, boundsMinUReg);
+	updateSide(tempReg1, true, boundsMaxUReg);
+	updateSide(tempReg2, false, boundsMinVReg);
+	updateSide(tempReg2, true, boundsMaxVReg);
+}
+
+void VertexDecoderJitCache::Jit_TcFloat() {
+	LW(tempReg1, srcReg, dec_->tcoff);
+	LW(tempReg2, srcReg, dec_->tcoff + 4);
+	SW(tempReg1, dstReg, dec_->decFmt.uvoff);
+	SW(tempReg2, dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcU8Prescale() {
+	LBU(tempReg1, srcReg, dec_->tcoff);
+	LBU(tempReg2, srcReg, dec_->tcoff + 1);
+	FCVT(FConv::S, FConv::WU, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::WU, fpSrc[1], tempReg2);
+	FMUL(32, fpSrc[0], fpSrc[0], fpUScaleReg);
+	FMUL(32, fpSrc[1], fpSrc[1], fpVScaleReg);
+	FADD(32, fpSrc[0], fpSrc[0], fpUOffsetReg);
+	FADD(32, fpSrc[1], fpSrc[1], fpVOffsetReg);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcU8ToFloat() {
+	LBU(tempReg1, srcReg, dec_->tcoff);
+	LBU(tempReg2, srcReg, dec_->tcoff + 1);
+	LoadFloatConst(this, by128);
+	FCVT(FConv::S, FConv::WU, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::WU, fpSrc[1], tempReg2);
+	FMUL(32, fpSrc[0], fpSrc[0], fpByReg);
+	FMUL(32, fpSrc[1], fpSrc[1], fpByReg);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcU16Prescale() {
+	LHU(tempReg1, srcReg, dec_->tcoff);
+	LHU(tempReg2, srcReg, dec_->tcoff + 2);
+	FCVT(FConv::S, FConv::WU, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::WU, fpSrc[1], tempReg2);
+	FMUL(32, fpSrc[0], fpSrc[0], fpUScaleReg);
+	FMUL(32, fpSrc[1], fpSrc[1], fpVScaleReg);
+	FADD(32, fpSrc[0], fpSrc[0], fpUOffsetReg);
+	FADD(32, fpSrc[1], fpSrc[1], fpVOffsetReg);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcU16ToFloat() {
+	LHU(tempReg1, srcReg, dec_->tcoff);
+	LHU(tempReg2, srcReg, dec_->tcoff + 2);
+	LoadFloatConst(this, by32768);
+	FCVT(FConv::S, FConv::WU, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::WU, fpSrc[1], tempReg2);
+	FMUL(32, fpSrc[0], fpSrc[0], fpByReg);
+	FMUL(32, fpSrc[1], fpSrc[1], fpByReg);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_TcFloatPrescale() {
+	FL(32, fpSrc[0], srcReg, dec_->tcoff);
+	FL(32, fpSrc[1], srcReg, dec_->tcoff + 4);
+	FMUL(32, fpSrc[0], fpSrc[0], fpUScaleReg);
+	FMUL(32, fpSrc[1], fpSrc[1], fpVScaleReg);
+	FADD(32, fpSrc[0], fpSrc[0], fpUOffsetReg);
+	FADD(32, fpSrc[1], fpSrc[1], fpVOffsetReg);
+	FS(32, fpSrc[0], dstReg, dec_->decFmt.uvoff);
+	FS(32, fpSrc[1], dstReg, dec_->decFmt.uvoff + 4);
+}
+
+void VertexDecoderJitCache::Jit_PosS8() {
+	Jit_AnyS8ToFloat(dec_->posoff);
+	for (int i = 0; i < 3; ++i)
+		FS(32, fpSrc[i], dstReg, dec_->decFmt.posoff + i * 4);
+}
+
+void VertexDecoderJitCache::Jit_PosS16() {
+	Jit_AnyS16ToFloat(dec_->posoff);
+	for (int i = 0; i < 3; ++i)
+		FS(32, fpSrc[i], dstReg, dec_->decFmt.posoff + i * 4);
+}
+
+void VertexDecoderJitCache::Jit_PosFloat() {
+	for (int i = 0; i < 3; ++i) {
+		LW(tempReg1, srcReg, dec_->posoff + i * 4);
+		SW(tempReg1, dstReg, dec_->decFmt.posoff + i * 4);
+	}
+}
+
+void VertexDecoderJitCache::Jit_PosS8Through() {
+	// 8-bit positions in throughmode always decode to 0, depth included.
+	for (int i = 0; i < 3; ++i)
+		SW(R_ZERO, dstReg, dec_->decFmt.posoff + i * 4);
+}
+
+void VertexDecoderJitCache::Jit_PosS16Through() {
+	// X and Y are signed, Z is unsigned.
+	LH(tempReg1, srcReg, dec_->posoff);
+	LH(tempReg2, srcReg, dec_->posoff + 2);
+	LHU(tempReg3, srcReg, dec_->posoff + 4);
+	FCVT(FConv::S, FConv::W, fpSrc[0], tempReg1);
+	FCVT(FConv::S, FConv::W, fpSrc[1], tempReg2);
+	FCVT(FConv::S, FConv::W, fpSrc[2], tempReg3);
+	for (int i = 0; i < 3; ++i)
+		FS(32, fpSrc[i], dstReg, dec_->decFmt.posoff + i * 4);
+}
+
+void VertexDecoderJitCache::Jit_PosFloatThrough() {
+	// Instead of just copying 12 bytes, we copy 8 and clamp Z.
+	LW(tempReg1, srcReg, dec_->posoff);
+	LW(tempReg2, srcReg, dec_->posoff + 4);
+	SW(tempReg1, dstReg, dec_->decFmt.posoff);
+	SW(tempReg2, dstReg, dec_->decFmt.posoff + 4);
+
+	// Compare and branch, so NaNs go through unchanged like in the C++ decoder.
+	FL(32, fpSrc[2], srcReg, dec_->posoff + 8);
+	LoadFloatConst(this, const65535);
+	FLT(32, tempReg1, fpByReg, fpSrc[2]);
+	FixupBranch skipMax = BEQ(tempReg1, R_ZERO);
+	FMV(32, fpSrc[2], fpByReg);
+	SetJumpTarget(skipMax);
+	FMV(FMv::W, FMv::X, fpScratchReg1, R_ZERO);
+	FLT(32, tempReg1, fpSrc[2], fpScratchReg1);
+	FixupBranch skipMin = BEQ(tempReg1, R_ZERO);
+	FMV(32, fpSrc[2], fpScratchReg1);
+	SetJumpTarget(skipMin);
+	FS(32, fpSrc[2], dstReg, dec_->decFmt.posoff + 8);
+}
+
+void VertexDecoderJitCache::Jit_NormalS8() {
+	for (int i = 0; i < 3; ++i) {
+		LB(tempReg1, srcReg, dec_->nrmoff + i);
+		SB(tempReg1, dstReg, dec_->decFmt.nrmoff + i);
+	}
+	SB(R_ZERO, dstReg, dec_->decFmt.nrmoff + 3);
+}
+
+void VertexDecoderJitCache::Jit_NormalS8ToFloat() {
+	Jit_AnyS8ToFloat(dec_->nrmoff);
+	for (int i = 0; i < 3; ++i)
+		FS(32, fpSrc[i], dstReg, dec_->decFmt.nrmoff + i * 4);
+}
+
+// Copy 6 bytes and then 2 zeroes.
+void VertexDecoderJitCache::Jit_NormalS16() {
+	for (int i = 0; i < 3; ++i) {
+		LH(tempReg1, srcReg, dec_->nrmoff + i * 2);
+		SH(tempReg1, dstReg, dec_->decFmt.nrmoff + i * 2);
+	}
+	SH(R_ZERO, dstReg, dec_->decFmt.nrmoff + 6);
+}
+
+void VertexDecoderJitCache::Jit_NormalFloat() {
+	for (int i = 0; i < 3; ++i) {
+		LW(tempReg1, srcReg, dec_->nrmoff + i * 4);
+		SW(tempReg1, dstReg, dec_->decFmt.nrmoff + i * 4);
+	}
+}
+
+void VertexDecoderJitCache::Jit_AnyS8ToFloat(int srcoff) {
+	LoadFloatConst(this, by128);
+	for (int i = 0; i < 3; ++i) {
+		LB(tempReg1, srcReg, srcoff + i);
+		FCVT(FConv::S, FConv::W, fpSrc[i], tempReg1);
+		FMUL(32, fpSrc[i], fpSrc[i], fpByReg);
+	}
+}
+
+void VertexDecoderJitCache::Jit_AnyS16ToFloat(int srcoff) {
+	LoadFloatConst(this, by32768);
+	for (int i = 0; i < 3; ++i) {
+		LH(tempReg1, srcReg, srcoff + i * 2);
+		FCVT(FConv::S, FConv::W, fpSrc[i], tempReg1);
+		FMUL(32, fpSrc[i], fpSrc[i], fpByReg);
+	}
+}
+
+#endif // PPSSPP_ARCH(RISCV64)
@@ -16,6 +16,7 @@
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
 #include <algorithm>
+#include <cstddef>
 #include <cstring>
 #include <functional>
 #include <mutex>
@@ -24,7 +25,10 @@
 #include <zstd.h>
 #include "Common/Profiler/Profiler.h"
 #include "Common/CommonTypes.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/MappedFile.h"
 #include "Common/Log.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/Core.h"
 #include "Core/CoreTiming.h"
@@ -45,11 +49,23 @@
 
 namespace GPURecord {
 
+// Points either into the vectors below, or for uncompressed dumps, directly into the mapped file.
+struct DumpData {
+	const Command *commands = nullptr;
+	u32 numCommands = 0;
+	const u8 *pushbuf = nullptr;
+	u32 pushbufSize = 0;
+};
+
 static std::string lastExecFilename;
 static uint32_t lastExecVersion;
+static DumpData lastExecData;
 static std::vector<Command> lastExecCommands;
 static std::vector<u8> lastExecPushbuf;
+static MappedFile lastExecMapping;
 static std::mutex executeLock;
+static std::function<bool(double)> replayCallback;
+static bool replayAgain = false;
 
 // This class maps pushbuffer (dump data) sections to PSP memory.
 // Dumps can be larger than available PSP memory, because they include generated data too.
@@ -59,7 +75,7 @@ static std::mutex executeLock;
 // Slabs are managed with LRU, extra buffers are round-robin.
 class BufMapping {
 public:
-	BufMapping(const std::vector<u8> &pushbuf) : pushbuf_(pushbuf) {
+	BufMapping(const u8 *pushbuf, u32 pushbufSize) : pushbuf_(pushbuf), pushbufSize_(pushbufSize) {
 	}
 
 	// Returns a pointer to contiguous memory for this access, or else 0 (failure).
@@ -120,7 +136,7 @@ class BufMapping {
 
 		bool Alloc();
 		void Free();
-		bool Setup(u32 bufpos, const std::vector<u8> &pushbuf_);
+		bool Setup(u32 bufpos, const u8 *pushbuf, u32 pushbufSize);
 	};
 
 	// An adhoc mapping of the pushbuffer (either larger than a slab or straddling slabs.)
@@ -139,7 +155,7 @@ class BufMapping {
 			return psp_pointer_;
 		}
 
-		bool Alloc(u32 bufpos, u32 sz, const std::vector<u8> &pushbuf_);
+		bool Alloc(u32 bufpos, u32 sz, const u8 *pushbuf);
 		void Free();
 	};
 
@@ -148,7 +164,8 @@ class BufMapping {
 	u32 extraOffset_ = 0;
 	ExtraInfo extra_[EXTRA_COUNT]{};
 
-	const std::vector<u8> &pushbuf_;
+	const u8 *pushbuf_;
+	u32 pushbufSize_;
 };
 
 u32 BufMapping::Map(u32 bufpos, u32 sz, const std::function<void()> &flush) {
@@ -185,7 +202,7 @@ u32 BufMapping::MapSlab(u32 bufpos, const std::function<void()> &flush) {
 	flush();
 
 	// Okay, we need to allocate.
-	if (!slabs_[best].Setup(slab_pos, pushbuf_)) {
+	if (!slabs_[best].Setup(slab_pos, pushbuf_, pushbufSize_)) {
 		return 0;
 	}
 	lastSlab_ = best;
@@ -236,7 +253,7 @@ void BufMapping::SlabInfo::Free() {
 	}
 }
 
-bool BufMapping::ExtraInfo::Alloc(u32 bufpos, u32 sz, const std::vector<u8> &pushbuf_) {
+bool BufMapping::ExtraInfo::Alloc(u32 bufpos, u32 sz, const u8 *pushbuf) {
 	// Make sure we've freed any previous allocation first.
 	Free();
 
@@ -251,7 +268,7 @@ bool BufMapping::ExtraInfo::Alloc(u32 bufpos, u32 sz, const std::vector<u8> &pus
 
 	buf_pointer_ = bufpos;
 	size_ = sz;
-	Memory::MemcpyUnchecked(psp_pointer_, pushbuf_.data() + bufpos, sz);
+	Memory::MemcpyUnchecked(psp_pointer_, pushbuf + bufpos, sz);
 	return true;
 }
 
@@ -263,7 +280,7 @@ void BufMapping::ExtraInfo::Free() {
 	}
 }
 
-bool BufMapping::SlabInfo::Setup(u32 bufpos, const std::vector<u8> &pushbuf_) {
+bool BufMapping::SlabInfo::Setup(u32 bufpos, const u8 *pushbuf, u32 pushbufSize) {
 	// If it already has RAM, we're simply taking it over.  Slabs come only in one size.
 	if (psp_pointer_ == 0) {
 		if (!Alloc()) {
@@ -272,8 +289,8 @@ bool BufMapping::SlabInfo::Setup(u32 bufpos, const std::vector<u8> &pushbuf_) {
 	}
 
 	buf_pointer_ = bufpos;
-	u32 sz = std::min((u32)SLAB_SIZE, (u32)pushbuf_.size() - bufpos);
-	Memory::MemcpyUnchecked(psp_pointer_, pushbuf_.data() + bufpos, sz);
+	u32 sz = std::min((u32)SLAB_SIZE, pushbufSize - bufpos);
+	Memory::MemcpyUnchecked(psp_pointer_, pushbuf + bufpos, sz);
 
 	slabGeneration_++;
 	last_used_ = slabGeneration_;
@@ -284,8 +301,8 @@ int BufMapping::slabGeneration_ = 0;
 
 class DumpExecute {
 public:
-	DumpExecute(const std::vector<u8> &pushbuf, const std::vector<Command> &commands, uint32_t version)
-		: pushbuf_(pushbuf), commands_(commands), mapping_(pushbuf), version_(version) {
+	DumpExecute(const DumpData &data, uint32_t version)
+		: pushbuf_(data.pushbuf), commands_(data.commands), numCommands_(data.numCommands), mapping_(data.pushbuf, data.pushbufSize), version_(version) {
 	}
 	~DumpExecute();
 
@@ -323,8 +340,9 @@ class DumpExecute {
 	u32 lastTex_[8]{};
 	u32 lastBase_ = 0;
 
-	const std::vector<u8> &pushbuf_;
-	const std::vector<Command> &commands_;
+	const u8 *pushbuf_;
+	const Command *commands_;
+	u32 numCommands_;
 	BufMapping mapping_;
 	uint32_t version_ = 0;
 };
@@ -445,7 +463,7 @@ void DumpExecute::SubmitListEnd() {
 }
 
 void DumpExecute::Init(u32 ptr, u32 sz) {
-	gstate.Restore((u32_le *)(pushbuf_.data() + ptr));
+	gstate.Restore((const u32_le *)(pushbuf_ + ptr));
 	gpu->ReapplyGfxState();
 
 	for (int i = 0; i < 8; ++i) {
@@ -456,7 +474,7 @@ void DumpExecute::Init(u32 ptr, u32 sz) {
 }
 
 void DumpExecute::Registers(u32 ptr, u32 sz) {
-	SubmitCmds(pushbuf_.data() + ptr, sz);
+	SubmitCmds(pushbuf_ + ptr, sz);
 }
 
 void DumpExecute::Vertices(u32 ptr, u32 sz) {
@@ -492,7 +510,7 @@ void DumpExecute::ClutAddr(u32 ptr, u32 sz) {
 		u32 addr;
 		u32 flags;
 	};
-	const ClutAddrData *data = (const ClutAddrData *)(pushbuf_.data() + ptr);
+	const ClutAddrData *data = (const ClutAddrData *)(pushbuf_ + ptr);
 	execClutAddr = data->addr;
 	execClutFlags = data->flags;
 }
@@ -505,7 +523,7 @@ void DumpExecute::Clut(u32 ptr, u32 sz) {
 		// Could potentially always skip if !isTarget, but playing it safe for offset texture behavior.
 		if (Memory::IsValidRange(execClutAddr, sz) && (!isTarget || !g_Config.bSoftwareRendering)) {
 			// Intentionally don't trigger an upload here.
-			Memory::MemcpyUnchecked(execClutAddr, pushbuf_.data() + ptr, sz);
+			Memory::MemcpyUnchecked(execClutAddr, pushbuf_ + ptr, sz);
 			NotifyMemInfo(MemBlockFlags::WRITE, execClutAddr, sz, "ReplayClut");
 		}
 
@@ -544,7 +562,7 @@ void DumpExecute::Memset(u32 ptr, u32 sz) {
 		u32 sz;
 	};
 
-	const MemsetCommand *data = (const MemsetCommand *)(pushbuf_.data() + ptr);
+	const MemsetCommand *data = (const MemsetCommand *)(pushbuf_ + ptr);
 
 	if (Memory::IsVRAMAddress(data->dest)) {
 		SyncStall();
@@ -553,14 +571,14 @@ void DumpExecute::Memset(u32 ptr, u32 sz) {
 }
 
 void DumpExecute::MemcpyDest(u32 ptr, u32 sz) {
-	execMemcpyDest = *(const u32 *)(pushbuf_.data() + ptr);
+	execMemcpyDest = *(const u32 *)(pushbuf_ + ptr);
 }
 
 void DumpExecute::Memcpy(u32 ptr, u32 sz) {
 	PROFILE_THIS_SCOPE("ReplayMemcpy");
 	if (Memory::IsVRAMAddress(execMemcpyDest)) {
 		SyncStall();
-		Memory::MemcpyUnchecked(execMemcpyDest, pushbuf_.data() + ptr, sz);
+		Memory::MemcpyUnchecked(execMemcpyDest, pushbuf_ + ptr, sz);
 		NotifyMemInfo(MemBlockFlags::WRITE, execMemcpyDest, sz, "ReplayMemcpy");
 		gpu->PerformWriteColorFromMemory(execMemcpyDest, sz);
 	}
@@ -591,7 +609,7 @@ void DumpExecute::Framebuf(int level, u32 ptr, u32 sz) {
 		u32 pad;
 	};
 
-	FramebufData *framebuf = (FramebufData *)(pushbuf_.data() + ptr);
+	const FramebufData *framebuf = (const FramebufData *)(pushbuf_ + ptr);
 
 	if (lastTex_[level] != framebuf->addr || lastBufw_[level] != framebuf->bufw) {
 		u32 bufwCmd = GE_CMD_TEXBUFWIDTH0 + level;
@@ -611,7 +629,7 @@ void DumpExecute::Framebuf(int level, u32 ptr, u32 sz) {
 	// Could potentially always skip if !isTarget, but playing it safe for offset texture behavior.
 	if (Memory::IsValidRange(framebuf->addr, pspSize) && !unchangedVRAM && (!isTarget || !g_Config.bSoftwareRendering)) {
 		// Intentionally don't trigger an upload here.
-		Memory::MemcpyUnchecked(framebuf->addr, pushbuf_.data() + ptr + headerSize, pspSize);
+		Memory::MemcpyUnchecked(framebuf->addr, pushbuf_ + ptr + headerSize, pspSize);
 		NotifyMemInfo(MemBlockFlags::WRITE, framebuf->addr, pspSize, "ReplayTex");
 	}
 }
@@ -622,7 +640,7 @@ void DumpExecute::Display(u32 ptr, u32 sz) {
 		int linesize, pixelFormat;
 	};
 
-	DisplayBufData *disp = (DisplayBufData *)(pushbuf_.data() + ptr);
+	const DisplayBufData *disp = (const DisplayBufData *)(pushbuf_ + ptr);
 
 	// Sync up drawing.
 	SyncStall();
@@ -633,7 +651,7 @@ void DumpExecute::Display(u32 ptr, u32 sz) {
 
 void DumpExecute::EdramTrans(u32 ptr, u32 sz) {
 	uint32_t value;
-	memcpy(&value, pushbuf_.data() + ptr, 4);
+	memcpy(&value, pushbuf_ + ptr, 4);
 
 	// Sync up drawing.
 	SyncStall();
@@ -657,7 +675,8 @@ bool DumpExecute::Run() {
 	if (gpu)
 		gpu->SetAddrTranslation(0x400);
 
-	for (const Command &cmd : commands_) {
+	for (u32 i = 0; i < numCommands_; ++i) {
+		const Command &cmd = commands_[i];
 		switch (cmd.type) {
 		case CommandType::INIT:
 			Init(cmd.ptr, cmd.sz);
@@ -739,14 +758,17 @@ bool DumpExecute::Run() {
 	return true;
 }
 
-static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
+// Reads the next sz bytes of the dump, and returns how many bytes were read.
+typedef std::function<size_t(void *dest, size_t sz)> DumpReader;
+
+static bool ReadCompressed(const DumpReader &read, void *dest, size_t sz, uint32_t version) {
 	u32 compressed_size = 0;
-	if (pspFileSystem.ReadFile(fp, (u8 *)&compressed_size, sizeof(compressed_size)) != sizeof(compressed_size)) {
+	if (read(&compressed_size, sizeof(compressed_size)) != sizeof(compressed_size)) {
 		return false;
 	}
 
 	u8 *compressed = new u8[compressed_size];
-	if (pspFileSystem.ReadFile(fp, compressed, compressed_size) != compressed_size) {
+	if (read(compressed, compressed_size) != compressed_size) {
 		delete[] compressed;
 		return false;
 	}
@@ -761,12 +783,94 @@ static bool ReadCompressed(u32 fp, void *dest, size_t sz, uint32_t version) {
 	return real_size == sz;
 }
 
+static bool ReadHeader(const DumpReader &read, Header &header) {
+	// Before version 4, the header stopped before the game ID.
+	const size_t shortHeaderSize = offsetof(Header, gameID);
+	memset(&header, 0, sizeof(header));
+	if (read(&header, shortHeaderSize) != shortHeaderSize)
+		return false;
+	if (memcmp(header.magic, HEADER_MAGIC, sizeof(header.magic)) != 0 || header.version > VERSION || header.version < MIN_VERSION)
+		return false;
+	if (header.version <= 3)
+		return true;
+	return read((u8 *)&header + shortHeaderSize, sizeof(header) - shortHeaderSize) == sizeof(header) - shortHeaderSize;
+}
+
+// Reads everything after the header.
+static bool ReadDumpData(const DumpReader &read, uint32_t version, std::vector<Command> &commands, std::vector<u8> &pushbuf) {
+	u32 sz = 0;
+	u32 bufsz = 0;
+	if (read(&sz, sizeof(sz)) != sizeof(sz) || read(&bufsz, sizeof(bufsz)) != sizeof(bufsz))
+		return false;
+
+	commands.resize(sz);
+	pushbuf.resize(bufsz);
+
+	if (version != UNCOMPRESSED_VERSION) {
+		if (!ReadCompressed(read, commands.data(), sizeof(Command) * sz, version))
+			return false;
+		return ReadCompressed(read, pushbuf.data(), bufsz, version);
+	}
+
+	if (read(commands.data(), sizeof(Command) * sz) != sizeof(Command) * sz)
+		return false;
+	u8 padding[16];
+	size_t paddingSize = UncompressedPushbufOffset(sz) - (sizeof(Header) + 8 + sizeof(Command) * sz);
+	if (read(padding, paddingSize) != paddingSize)
+		return false;
+	return read(pushbuf.data(), bufsz) == bufsz;
+}
+
+// Points dumpData at the commands and pushbuf inside a whole uncompressed dump, without copying.
+static bool ParseUncompressedDump(const u8 *data, u64 size, Header &header, DumpData &dumpData) {
+	// The offsets are all u32, so keep well within that.
+	if (size < sizeof(Header) + 8 || size > 0x7FFFFFFF)
+		return false;
+
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, HEADER_MAGIC, sizeof(header.magic)) != 0 || header.version != UNCOMPRESSED_VERSION)
+		return false;
+
+	u32 sz;
+	u32 bufsz;
+	memcpy(&sz, data + sizeof(Header), sizeof(sz));
+	memcpy(&bufsz, data + sizeof(Header) + 4, sizeof(bufsz));
+	if (sizeof(Header) + 8 + (u64)sz * sizeof(Command) > size || UncompressedPushbufOffset(sz) + (u64)bufsz > size) {
+		ERROR_LOG(SYSTEM, "Truncated GE dump");
+		return false;
+	}
+
+	dumpData.commands = (const Command *)(data + sizeof(Header) + 8);
+	dumpData.numCommands = sz;
+	dumpData.pushbuf = data + UncompressedPushbufOffset(sz);
+	dumpData.pushbufSize = bufsz;
+	return true;
+}
+
+// Uncompressed dumps are used right from the file, without reading them into memory first.
+// Only the pushbuf data each command actually uses gets copied into PSP memory.
+static bool MapDump(const std::string &filename, Header &header) {
+	Path path;
+	if (!pspFileSystem.GetHostPath(filename, path) || !lastExecMapping.Open(path))
+		return false;
+
+	// Make sure this really is the file that's mounted.
+	const u64 size = lastExecMapping.Size();
+	if (size != (u64)pspFileSystem.GetFileInfo(filename).size || !ParseUncompressedDump(lastExecMapping.Data(), size, header, lastExecData)) {
+		lastExecMapping.Close();
+		return false;
+	}
+	return true;
+}
+
 static void ReplayStop() {
 	// This can happen from a separate thread.
 	std::lock_guard<std::mutex> guard(executeLock);
 	lastExecFilename.clear();
+	lastExecData = DumpData();
 	lastExecCommands.clear();
 	lastExecPushbuf.clear();
+	lastExecMapping.Close();
 	lastExecVersion = 0;
 }
 
@@ -779,51 +883,136 @@ bool RunMountedReplay(const std::string &filename) {
 	uint32_t version = lastExecVersion;
 	if (lastExecFilename != filename) {
 		PROFILE_THIS_SCOPE("ReplayLoad");
-		u32 fp = pspFileSystem.OpenFile(filename, FILEACCESS_READ);
-		Header header;
-		pspFileSystem.ReadFile(fp, (u8 *)&header, sizeof(header));
-		version = header.version;
+		lastExecData = DumpData();
+		lastExecCommands.clear();
+		lastExecPushbuf.clear();
+		lastExecMapping.Close();
 
-		if (memcmp(header.magic, HEADER_MAGIC, sizeof(header.magic)) != 0 || header.version > VERSION || header.version < MIN_VERSION) {
-			ERROR_LOG(SYSTEM, "Invalid GE dump or unsupported version");
+		Header header;
+		if (!MapDump(filename, header)) {
+			u32 fp = pspFileSystem.OpenFile(filename, FILEACCESS_READ);
+			DumpReader read = [fp](void *dest, size_t sz) {
+				return pspFileSystem.ReadFile(fp, (u8 *)dest, sz);
+			};
+
+			if (!ReadHeader(read, header)) {
+				ERROR_LOG(SYSTEM, "Invalid GE dump or unsupported version");
+				pspFileSystem.CloseFile(fp);
+				return false;
+			}
+
+			bool truncated = !ReadDumpData(read, header.version, lastExecCommands, lastExecPushbuf);
 			pspFileSystem.CloseFile(fp);
-			return false;
-		}
-		if (header.version <= 3) {
-			pspFileSystem.SeekFile(fp, 12, FILEMOVE_BEGIN);
-			memset(header.gameID, 0, sizeof(header.gameID));
+
+			if (truncated) {
+				ERROR_LOG(SYSTEM, "Truncated GE dump");
+				return false;
+			}
+
+			lastExecData.commands = lastExecCommands.data();
+			lastExecData.numCommands = (u32)lastExecCommands.size();
+			lastExecData.pushbuf = lastExecPushbuf.data();
+			lastExecData.pushbufSize = (u32)lastExecPushbuf.size();
 		}
+		version = header.version;
 
 		size_t gameIDLength = strnlen(header.gameID, sizeof(header.gameID));
 		if (gameIDLength != 0) {
 			g_paramSFO.SetValue("DISC_ID", std::string(header.gameID, gameIDLength), (int)sizeof(header.gameID));
 		}
 
-		u32 sz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&sz, sizeof(sz));
-		u32 bufsz = 0;
-		pspFileSystem.ReadFile(fp, (u8 *)&bufsz, sizeof(bufsz));
+		lastExecFilename = filename;
+		lastExecVersion = version;
+	}
 
-		lastExecCommands.resize(sz);
-		lastExecPushbuf.resize(bufsz);
+	DumpExecute executor(lastExecData, version);
+	// Only time the replay itself, not loading the dump.
+	double start = time_now_d();
+	bool success = executor.Run();
+	replayAgain = success && replayCallback && replayCallback(time_now_d() - start);
+	return success;
+}
 
-		bool truncated = false;
-		truncated = truncated || !ReadCompressed(fp, lastExecCommands.data(), sizeof(Command) * sz, header.version);
-		truncated = truncated || !ReadCompressed(fp, lastExecPushbuf.data(), bufsz, header.version);
+void SetReplayCallback(const std::function<bool(double seconds)> callback) {
+	std::lock_guard<std::mutex> guard(executeLock);
+	replayCallback = callback;
+	replayAgain = false;
+}
 
-		pspFileSystem.CloseFile(fp);
+bool ShouldReplayAgain() {
+	return replayAgain;
+}
 
-		if (truncated) {
-			ERROR_LOG(SYSTEM, "Truncated GE dump");
+bool ReadDumpFile(const Path &filename, bool mapped, Header &header, std::vector<Command> &commands, std::vector<u8> &pushbuf) {
+	if (mapped) {
+		MappedFile mapping;
+		DumpData data;
+		if (!mapping.Open(filename) || !ParseUncompressedDump(mapping.Data(), mapping.Size(), header, data))
 			return false;
-		}
+		commands.assign(data.commands, data.commands + data.numCommands);
+		pushbuf.assign(data.pushbuf, data.pushbuf + data.pushbufSize);
+		return true;
+	}
 
-		lastExecFilename = filename;
-		lastExecVersion = version;
+	FILE *in = File::OpenCFile(filename, "rb");
+	if (!in) {
+		ERROR_LOG(SYSTEM, "Unable to open GE dump %s", filename.c_str());
+		return false;
+	}
+	DumpReader read = [in](void *buf, size_t sz) {
+		return fread(buf, 1, sz, in);
+	};
+
+	if (!ReadHeader(read, header)) {
+		ERROR_LOG(SYSTEM, "Invalid GE dump or unsupported version");
+		fclose(in);
+		return false;
+	}
+	bool truncated = !ReadDumpData(read, header.version, commands, pushbuf);
+	fclose(in);
+	if (truncated) {
+		ERROR_LOG(SYSTEM, "Truncated GE dump");
+		return false;
+	}
+	return true;
+}
+
+bool ConvertToUncompressed(const Path &src, const Path &dest) {
+	Header header;
+	std::vector<Command> commands;
+	std::vector<u8> pushbuf;
+	if (!ReadDumpFile(src, false, header, commands, pushbuf))
+		return false;
+	// Older dumps need to keep their version, because of the incorrect dirty VRAM flag.
+	if (header.version < COMPRESSED_VERSION) {
+		ERROR_LOG(SYSTEM, "GE dump version %d is too old to convert", header.version);
+		return false;
+	}
+
+	FILE *out = File::OpenCFile(dest, "wb");
+	if (!out) {
+		ERROR_LOG(SYSTEM, "Unable to create %s", dest.c_str());
+		return false;
 	}
 
-	DumpExecute executor(lastExecPushbuf, lastExecCommands, version);
-	return executor.Run();
+	header.version = UNCOMPRESSED_VERSION;
+	u32 sz = (u32)commands.size();
+	u32 bufsz = (u32)pushbuf.size();
+	const u8 padding[16]{};
+	size_t paddingSize = UncompressedPushbufOffset(sz) - (sizeof(Header) + 8 + sizeof(Command) * sz);
+
+	bool success = fwrite(&header, sizeof(header), 1, out) == 1;
+	success = success && fwrite(&sz, sizeof(sz), 1, out) == 1;
+	success = success && fwrite(&bufsz, sizeof(bufsz), 1, out) == 1;
+	success = success && fwrite(commands.data(), sizeof(Command), sz, out) == sz;
+	success = success && fwrite(padding, 1, paddingSize, out) == paddingSize;
+	success = success && fwrite(pushbuf.data(), 1, bufsz, out) == bufsz;
+	success = fclose(out) == 0 && success;
+	if (!success) {
+		ERROR_LOG(SYSTEM, "Failed to write %s", dest.c_str());
+		File::Delete(dest);
+	}
+	return success;
 }
 
 };
@@ -17,10 +17,28 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
+#include <vector>
+
+#include "Common/File/Path.h"
+#include "GPU/Debugger/RecordFormat.h"
 
 namespace GPURecord {
 
 bool RunMountedReplay(const std::string &filename);
 
+// Headless normally stops after the first replay.  If set, this is called after each replay
+// with the time it took, and the dump is replayed again at the next vblank while it returns true.
+void SetReplayCallback(const std::function<bool(double seconds)> callback);
+bool ShouldReplayAgain();
+
+// Reads a whole dump file, for tools and tests.  If mapped, the file must be uncompressed,
+// and is read through a memory mapping the same way playback does.
+bool ReadDumpFile(const Path &filename, bool mapped, Header &header, std::vector<Command> &commands, std::vector<u8> &pushbuf);
+
+// Rewrites a compressed dump as an uncompressed one, which can be played back straight from
+// a memory mapping of the file instead of being decompressed first.  Only for version 6 dumps.
+bool ConvertToUncompressed(const Path &src, const Path &dest);
+
 };
@@ -35,8 +35,12 @@ static const char *HEADER_MAGIC = "PPSSPPGE";
 // Version 4: Expanded header with game ID
 // Version 5: Uses zstd
 // Version 6: Corrects dirty VRAM flag
-static const int VERSION = 6;
+// Version 7: Same as 6 but uncompressed, with the pushbuf aligned, so it can be memory mapped
+static const int VERSION = 7;
 static const int MIN_VERSION = 2;
+// Recordings are still compressed, since they're often shared.
+static const int COMPRESSED_VERSION = 6;
+static const int UNCOMPRESSED_VERSION = 7;
 
 enum class CommandType : u8 {
 	INIT = 0,
@@ -81,4 +85,11 @@ struct Command {
 
 #pragma pack(pop)
 
+// Uncompressed dumps are the header, command count and pushbuf size (u32 each), the commands,
+// and then the pushbuf at this offset.
+inline u32 UncompressedPushbufOffset(u32 numCommands) {
+	u32 commandsEnd = (u32)sizeof(Header) + 8 + numCommands * (u32)sizeof(Command);
+	return (commandsEnd + 15) & ~15;
+}
+
 };
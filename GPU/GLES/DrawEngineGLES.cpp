@@ -157,7 +157,7 @@ void DrawEngineGLES::ClearInputLayoutMap() {
 }
 
 void DrawEngineGLES::BeginFrame() {
-	gpuStats.numTrackedVertexArrays = 0;
+	DecimateTrackedVertexArrays();
 
 	FrameData &frameData = frameData_[render_->GetCurFrame()];
 	render_->BeginPushBuffer(frameData.pushIndex);
@@ -282,27 +282,42 @@ void DrawEngineGLES::DoFlush() {
 		int vertexCount = 0;
 		bool useElements = true;
 
-		if (decOptions_.applySkinInDecode && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
-			// If software skinning, we've already predecoded into "decoded". So push that content.
-			size_t size = decodedVerts_ * dec_->GetDecVtxFmt().stride;
-			u8 *dest = (u8 *)frameData.pushVertex->Push(size, &vertexBufferOffset, &vertexBuffer);
-			memcpy(dest, decoded, size);
+		CachedVertexData *cached = GetCachedVertexData();
+		if (cached) {
+			// No persistent buffers here, but a copy still beats decoding again.
+			vertexBufferOffset = (uint32_t)frameData.pushVertex->Push(cached->verts.data(), cached->verts.size(), &vertexBuffer);
+			useElements = !cached->seenOnlyPurePrims;
+			vertexCount = cached->indexCount;
+			if (useElements) {
+				indexBufferOffset = (uint32_t)frameData.pushIndex->Push(cached->inds.data(), sizeof(uint16_t) * cached->indexCount, &indexBuffer);
+			} else if (cached->pureCount) {
+				vertexCount = cached->pureCount;
+			}
+			prim = (GEPrimitiveType)cached->prim;
+			gstate_c.vertexFullAlpha = cached->vertexFullAlpha;
 		} else {
-			// Decode directly into the pushbuffer
-			u8 *dest = (u8 *)DecodeVertsToPushBuffer(frameData.pushVertex, &vertexBufferOffset, &vertexBuffer);
-		}
+			if (decOptions_.applySkinInDecode && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
+				// If software skinning, we've already predecoded into "decoded". So push that content.
+				size_t size = decodedVerts_ * dec_->GetDecVtxFmt().stride;
+				u8 *dest = (u8 *)frameData.pushVertex->Push(size, &vertexBufferOffset, &vertexBuffer);
+				memcpy(dest, decoded, size);
+			} else {
+				// Decode directly into the pushbuffer
+				u8 *dest = (u8 *)DecodeVertsToPushBuffer(frameData.pushVertex, &vertexBufferOffset, &vertexBuffer);
+			}
 
-		gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
+			gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
 
-		// If there's only been one primitive type, and it's either TRIANGLES, LINES or POINTS,
-		// there is no need for the index buffer we built. We can then use glDrawArrays instead
-		// for a very minor speed boost.
-		useElements = !indexGen.SeenOnlyPurePrims();
-		vertexCount = indexGen.VertexCount();
-		if (!useElements && indexGen.PureCount()) {
-			vertexCount = indexGen.PureCount();
+			// If there's only been one primitive type, and it's either TRIANGLES, LINES or POINTS,
+			// there is no need for the index buffer we built. We can then use glDrawArrays instead
+			// for a very minor speed boost.
+			useElements = !indexGen.SeenOnlyPurePrims();
+			vertexCount = indexGen.VertexCount();
+			if (!useElements && indexGen.PureCount()) {
+				vertexCount = indexGen.PureCount();
+			}
+			prim = indexGen.Prim();
 		}
-		prim = indexGen.Prim();
 
 		bool hasColor = (lastVType_ & GE_VTYPE_COL_MASK) != GE_VTYPE_COL_NONE;
 		if (gstate.isModeThrough()) {
@@ -79,8 +79,6 @@ class DrawEngineGLES : public DrawEngineCommon {
 	void DeviceLost();
 	void DeviceRestore(Draw::DrawContext *draw);
 
-	void ClearTrackedVertexArrays() override {}
-
 	void BeginFrame();
 	void EndFrame();
 
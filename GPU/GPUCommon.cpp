@@ -3259,6 +3259,7 @@ void GPUCommon::DoBlockTransfer(u32 skipDrawReason) {
 			ERROR_LOG_REPORT_ONCE(invalidtransfer, G3D, "Block transfer invalid: %08x/%x -> %08x/%x, %ix%ix%i (%i,%i)->(%i,%i)", srcBasePtr, srcStride, dstBasePtr, dstStride, width, height, bpp, srcX, srcY, dstX, dstY);
 		}
 
+		Memory::MarkWritten(dstBasePtr + (dstY * dstStride + dstX) * bpp, height * dstStride * bpp);
 		if (framebufferManager_) {
 			// Fixes Gran Turismo's funky text issue, since it overwrites the current texture.
 			textureCache_->Invalidate(dstBasePtr + (dstY * dstStride + dstX) * bpp, height * dstStride * bpp, GPU_INVALIDATE_HINT);
@@ -3335,6 +3336,10 @@ bool GPUCommon::PerformWriteColorFromMemory(u32 dest, int size) {
 }
 
 void GPUCommon::InvalidateCache(u32 addr, int size, GPUInvalidationType type) {
+	// These are all either writes we saw (DMA, memcpy) or the game telling us it wrote (cache writeback.)
+	if (size > 0 && type != GPU_INVALIDATE_ALL)
+		Memory::MarkWritten(addr, size);
+
 	if (size > 0)
 		textureCache_->Invalidate(addr, size, type);
 	else
@@ -3460,10 +3465,12 @@ void GPUCommon::UpdateUVScaleOffset() {
 
 size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 	float vertexAverageCycles = gpuStats.numVertsSubmitted > 0 ? (float)gpuStats.vertexGPUCycles / (float)gpuStats.numVertsSubmitted : 0.0f;
+	const VertexCache &vertexCache = drawEngineCommon_->GetVertexDataCache();
 	return snprintf(buffer, size,
 		"DL processing time: %0.2f ms\n"
 		"Draw calls: %d, flushes %d, clears %d (cached: %d)\n"
 		"Num Tracked Vertex Arrays: %d\n"
+		"Vertex cache: %d decoded (%d kB), hits %d (shared %d), unreliable %d\n"
 		"Vertices: %d cached: %d uncached: %d\n"
 		"FBOs active: %d (evaluations: %d)\n"
 		"Textures: %d, dec: %d, invalidated: %d, hashed: %d kB\n"
@@ -3476,6 +3483,11 @@ size_t GPUCommon::FormatGPUStatsCommon(char *buffer, size_t size) {
 		gpuStats.numClears,
 		gpuStats.numCachedDrawCalls,
 		gpuStats.numTrackedVertexArrays,
+		(int)vertexCache.NumData(),
+		(int)(vertexCache.DataBytes() / 1024),
+		vertexCache.stats.hits,
+		vertexCache.stats.sharedHits,
+		vertexCache.stats.unreliable,
 		gpuStats.numVertsSubmitted,
 		gpuStats.numCachedVertsDrawn,
 		gpuStats.numUncachedVertsDrawn,
@@ -62,7 +62,25 @@ struct BinWaitable : public Waitable {
 		}
 	}
 
+	// Called by tasks as they consume items, in case the binner is waiting on a full tile queue.
+	void NotifySpace() {
+		// Both seq_cst, so either the waiter sees the space, or we see the waiter.
+		if (spaceWaiters_ != 0) {
+			std::unique_lock<std::mutex> lock(mutex_);
+			cond_.notify_all();
+		}
+	}
+
+	template <typename F>
+	void WaitForSpace(F hasSpace) {
+		spaceWaiters_++;
+		std::unique_lock<std::mutex> lock(mutex_);
+		cond_.wait(lock, hasSpace);
+		spaceWaiters_--;
+	}
+
 	std::atomic<int> count_;
+	std::atomic<int> spaceWaiters_{ 0 };
 	std::mutex mutex_;
 	std::condition_variable cond_;
 };
@@ -97,8 +115,8 @@ static inline void DrawBinItem(const BinItem &item, const RasterizerState &state
 
 class DrawBinItemsTask : public Task {
 public:
-	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, const BinManager::BinStateQueue &states)
-		: notify_(notify), items_(items), status_(status), states_(states) {
+	DrawBinItemsTask(BinWaitable *notify, BinManager::BinItemQueue &items, std::atomic<bool> &status, double &cost, const BinManager::BinStateQueue &states)
+		: notify_(notify), items_(items), status_(status), cost_(cost), states_(states) {
 	}
 
 	TaskType Type() const override {
@@ -106,10 +124,14 @@ class DrawBinItemsTask : public Task {
 	}
 
 	void Run() override {
-		ProcessItems();
-		status_ = false;
-		// In case of any atomic issues, do another pass.
-		ProcessItems();
+		// Any thread may pick this up, so status_ marks ownership of the tile's queue.
+		// We give it up when empty, but take it back if more arrived and no one else claimed it.
+		do {
+			double st = time_now_d();
+			ProcessItems();
+			cost_ += time_now_d() - st;
+			status_ = false;
+		} while (!items_.Empty() && !status_.exchange(true));
 		notify_->Drain();
 	}
 
@@ -123,12 +145,14 @@ class DrawBinItemsTask : public Task {
 			const BinItem &item = items_.PeekNext();
 			DrawBinItem(item, states_[item.stateIndex]);
 			items_.SkipNext();
+			notify_->NotifySpace();
 		}
 	}
 
 	BinWaitable *notify_;
 	BinManager::BinItemQueue &items_;
 	std::atomic<bool> &status_;
+	double &cost_;
 	const BinManager::BinStateQueue &states_;
 };
 
@@ -144,11 +168,11 @@ BinManager::BinManager() {
 	for (auto &s : taskStatus_)
 		s = false;
 
-	int maxInitTasks = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
-	for (int i = 0; i < maxInitTasks; ++i) {
+	numTaskQueues_ = std::min(g_threadManager.GetNumLooperThreads() * TILES_PER_THREAD, MAX_POSSIBLE_TASKS);
+	for (int i = 0; i < numTaskQueues_; ++i) {
 		taskQueues_[i].Setup();
 		for (DrawBinItemsTask *&task : taskLists_[i].tasks)
-			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], states_);
+			task = new DrawBinItemsTask(waitable_, taskQueues_[i], taskStatus_[i], taskCosts_[i], states_);
 	}
 	states_.Setup();
 	cluts_.Setup();
@@ -460,10 +484,6 @@ void BinManager::Drain(bool flushing) {
 		int w2 = (queueRange_.x2 - queueRange_.x1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 		int h2 = (queueRange_.y2 - queueRange_.y1 + (SCREEN_SCALE_FACTOR * 2 - 1)) / (SCREEN_SCALE_FACTOR * 2);
 
-		// Always bin the entire possible range, but focus on the drawn area.
-		ScreenCoords tl(0, 0, 0);
-		ScreenCoords br(1024 * SCREEN_SCALE_FACTOR, 1024 * SCREEN_SCALE_FACTOR, 0);
-
 		if (pendingOverlap_ && maxTasks_ == 1 && flushing && queue_.Size() == 1 && !FORCE_SINGLE_THREAD) {
 			// If the drawing is 1:1, we can potentially use threads.  It's worth checking.
 			const auto &item = queue_.PeekNext();
@@ -472,21 +492,20 @@ void BinManager::Drain(bool flushing) {
 				maxTasks_ = std::min(g_threadManager.GetNumLooperThreads(), MAX_POSSIBLE_TASKS);
 		}
 
+		// Remember how long each tile took, so the next split can balance the work.
+		for (size_t i = 0; i < lastTileCosts_.size(); ++i) {
+			lastTileCosts_[i].cost += taskCosts_[i];
+			taskCosts_[i] = 0.0;
+		}
+
+		int tiles = maxTasks_ == 1 ? 1 : std::min(maxTasks_ * TILES_PER_THREAD, numTaskQueues_);
 		taskRanges_.clear();
-		if (h2 >= 18 && w2 >= h2 * 4) {
-			int bin_w = std::max(4, (w2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, queueRange_.x1 + bin_w - 1, br.y - 1 });
-			for (int x = queueRange_.x1 + bin_w; x <= queueRange_.x2; x += bin_w) {
-				int x2 = x + bin_w > queueRange_.x2 ? br.x : x + bin_w;
-				taskRanges_.push_back(BinCoords{ x, tl.y, x2 - 1, br.y - 1 });
-			}
+		if (tiles <= 1) {
+			// Nothing to split.
+		} else if (h2 >= 18 && w2 >= h2 * 4) {
+			SplitTaskRanges(true, tiles, queueRange_.x1, queueRange_.x2);
 		} else if (h2 >= 18 && w2 >= 18) {
-			int bin_h = std::max(4, (h2 + maxTasks_ - 1) / maxTasks_) * SCREEN_SCALE_FACTOR * 2;
-			taskRanges_.push_back(BinCoords{ tl.x, tl.y, br.x - 1, queueRange_.y1 + bin_h - 1 });
-			for (int y = queueRange_.y1 + bin_h; y <= queueRange_.y2; y += bin_h) {
-				int y2 = y + bin_h > queueRange_.y2 ? br.y : y + bin_h;
-				taskRanges_.push_back(BinCoords{ tl.x, y, br.x - 1, y2 - 1 });
-			}
+			SplitTaskRanges(false, tiles, queueRange_.y1, queueRange_.y2);
 		}
 
 		tasksSplit_ = true;
@@ -513,9 +532,13 @@ void BinManager::Drain(bool flushing) {
 					continue;
 
 				if (taskQueues_[i].NearFull()) {
-					// This shouldn't often happen, but if it does, wait for space.
-					if (taskQueues_[i].Full())
-						waitable_->Wait();
+					// This shouldn't often happen, but if it does, wait for space in just this tile.
+					// The other tiles keep drawing meanwhile.
+					if (taskQueues_[i].Full()) {
+						EnqueueTask(i);
+						BinItemQueue &tileQueue = taskQueues_[i];
+						waitable_->WaitForSpace([&] { return !tileQueue.Full(); });
+					}
 					// If we're not flushing and not near full, let's just continue later.
 					// Near full means we'd drain on next prim, so better to finish it now.
 					else if (!flushing && !queue_.NearFull())
@@ -537,19 +560,89 @@ void BinManager::Drain(bool flushing) {
 			if (taskQueues_[i].Empty())
 				continue;
 			threads++;
-			if (taskStatus_[i])
-				continue;
-
-			waitable_->Fill();
-			taskStatus_[i] = true;
-			g_threadManager.EnqueueTaskOnThread(i, taskLists_[i].Next());
-			enqueues_++;
+			EnqueueTask(i);
 		}
 
 		mostThreads_ = std::max(mostThreads_, threads);
 	}
 }
 
+void BinManager::EnqueueTask(int i) {
+	// If a task already owns this tile, it'll pick up the new items.
+	if (taskStatus_[i].exchange(true))
+		return;
+
+	waitable_->Fill();
+	// Not tied to a thread, so whichever thread is idle first takes the tile.
+	g_threadManager.EnqueueTask(taskLists_[i].Next());
+	enqueues_++;
+}
+
+void BinManager::SplitTaskRanges(bool columns, int tiles, int lo, int hi) {
+	// Work in cells of two pixels, the same granularity bins have always used.
+	constexpr int CELL_SIZE = SCREEN_SCALE_FACTOR * 2;
+	constexpr int MIN_TILE_CELLS = 4;
+	const int firstCell = lo / CELL_SIZE;
+	const int cells = hi / CELL_SIZE - firstCell + 1;
+	tiles = std::max(1, std::min(tiles, cells / MIN_TILE_CELLS));
+
+	// Spread the cost measured for the previous tiles over the cells they covered.
+	std::vector<double> weights(cells, 0.0);
+	double measured = 0.0;
+	if (lastTilesColumns_ == columns) {
+		for (const BinTileCost &tile : lastTileCosts_) {
+			int c1 = std::max(tile.lo / CELL_SIZE - firstCell, 0);
+			int c2 = std::min(tile.hi / CELL_SIZE - firstCell, cells - 1);
+			if (c2 < c1 || tile.cost <= 0.0)
+				continue;
+			double perCell = tile.cost / (tile.hi / CELL_SIZE - tile.lo / CELL_SIZE + 1);
+			for (int c = c1; c <= c2; ++c)
+				weights[c] += perCell;
+			measured += perCell * (c2 - c1 + 1);
+		}
+	}
+	// Always blend in some uniform cost, so stale measurements or empty areas don't produce huge tiles.
+	const double uniform = measured > 0.0 ? measured * 0.1 / cells : 1.0;
+	double total = 0.0;
+	for (double &w : weights) {
+		w += uniform;
+		total += w;
+	}
+
+	// Always bin the entire possible range, but focus on the drawn area.
+	const int fullEnd = 1024 * SCREEN_SCALE_FACTOR;
+	lastTileCosts_.clear();
+	lastTilesColumns_ = columns;
+
+	int start = 0;
+	int startCell = 0;
+	double sum = 0.0;
+	double tileMeasured = 0.0;
+	for (int c = 0; c < cells; ++c) {
+		sum += weights[c];
+		tileMeasured += weights[c] - uniform;
+		int done = (int)lastTileCosts_.size();
+		bool last = c == cells - 1;
+		bool roomForRest = cells - (c + 1) >= (tiles - done - 1) * MIN_TILE_CELLS;
+		if (!last && (c + 1 - startCell < MIN_TILE_CELLS || sum < total * (done + 1) / tiles) && roomForRest)
+			continue;
+		if (!last && done == tiles - 1)
+			continue;
+
+		int end = last ? fullEnd : (firstCell + c + 1) * CELL_SIZE;
+		if (columns)
+			taskRanges_.push_back(BinCoords{ start, 0, end - 1, fullEnd - 1 });
+		else
+			taskRanges_.push_back(BinCoords{ 0, start, fullEnd - 1, end - 1 });
+		// Carry over a decayed estimate, so a few cheap draws don't throw away the history.
+		lastTileCosts_.push_back(BinTileCost{ (firstCell + startCell) * CELL_SIZE, (firstCell + c + 1) * CELL_SIZE - 1, tileMeasured * 0.5 });
+
+		start = end;
+		startCell = c + 1;
+		tileMeasured = 0.0;
+	}
+}
+
 void BinManager::Flush(const char *reason) {
 	if (queueRange_.x1 == 0x7FFFFFFF)
 		return;
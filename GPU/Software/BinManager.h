@@ -171,6 +171,13 @@ struct BinTaskList {
 	}
 };
 
+// Measured drawing time for a tile, along the axis it was split on.
+struct BinTileCost {
+	int lo;
+	int hi;
+	double cost;
+};
+
 struct BinDirtyRange {
 	uint32_t base;
 	uint32_t strideBytes;
@@ -232,8 +239,10 @@ class BinManager {
 	static constexpr int QUEUED_STATES = 4096;
 	// These are 1KB each, so half an MB.
 	static constexpr int QUEUED_CLUTS = 512;
-	// About 360 KB, but we have usually 16 or less of them, so 5 MB - 22 MB.
+	// About 360 KB, but we have usually 32 or less of them, so 10 MB - 44 MB.
 	static constexpr int QUEUED_PRIMS = 2048;
+	// Split into more tiles than threads, so idle threads can pick up the slack.
+	static constexpr int TILES_PER_THREAD = 2;
 
 	typedef BinQueue<Rasterizer::RasterizerState, QUEUED_STATES> BinStateQueue;
 	typedef BinQueue<BinClut, QUEUED_CLUTS> BinClutQueue;
@@ -250,11 +259,16 @@ class BinManager {
 	SoftDirty dirty_ = SoftDirty::NONE;
 
 	int maxTasks_ = 1;
+	int numTaskQueues_ = 0;
 	bool tasksSplit_ = false;
 	std::vector<BinCoords> taskRanges_;
 	BinItemQueue taskQueues_[MAX_POSSIBLE_TASKS];
 	BinTaskList taskLists_[MAX_POSSIBLE_TASKS];
 	std::atomic<bool> taskStatus_[MAX_POSSIBLE_TASKS];
+	// Only written by the task currently owning the tile, read once all tasks are idle.
+	double taskCosts_[MAX_POSSIBLE_TASKS]{};
+	std::vector<BinTileCost> lastTileCosts_;
+	bool lastTilesColumns_ = false;
 	BinWaitable *waitable_ = nullptr;
 
 	BinDirtyRange pendingWrites_[2]{};
@@ -277,6 +291,8 @@ class BinManager {
 	bool HasTextureWrite(const Rasterizer::RasterizerState &state);
 	bool IsExactSelfRender(const Rasterizer::RasterizerState &state, const BinItem &item);
 	void OptimizePendingStates(uint16_t first, uint16_t last);
+	void SplitTaskRanges(bool columns, int tiles, int lo, int hi);
+	void EnqueueTask(int i);
 	BinCoords Scissor(BinCoords range);
 	BinCoords Range(const VertexData &v0, const VertexData &v1, const VertexData &v2);
 	BinCoords Range(const VertexData &v0, const VertexData &v1);
@@ -774,6 +774,10 @@ SingleFunc GetSingleFunc(const PixelFuncID &id, BinManager *binner) {
 	return jitCache->GenericSingle(id);
 }
 
+QuadFunc GetQuadFunc(const PixelFuncID &id) {
+	return jitCache->GetQuad(id);
+}
+
 SingleFunc PixelJitCache::GenericSingle(const PixelFuncID &id) {
 	if (id.clearMode) {
 		switch (id.fbFormat) {
@@ -804,7 +808,7 @@ SingleFunc PixelJitCache::GenericSingle(const PixelFuncID &id) {
 thread_local PixelJitCache::LastCache PixelJitCache::lastSingle_;
 
 // 256k should be plenty of space for plenty of variations.
-PixelJitCache::PixelJitCache() : CodeBlock(1024 * 64 * 4), cache_(64) {
+PixelJitCache::PixelJitCache() : CodeBlock(1024 * 64 * 4), cache_(64), quadCache_(64) {
 	lastSingle_.gen = -1;
 }
 
@@ -812,6 +816,7 @@ void PixelJitCache::Clear() {
 	clearGen_++;
 	CodeBlock::Clear();
 	cache_.Clear();
+	quadCache_.Clear();
 	addresses_.clear();
 
 	constBlendHalf_11_4s_ = nullptr;
@@ -890,6 +895,15 @@ SingleFunc PixelJitCache::GetSingle(const PixelFuncID &id, BinManager *binner) {
 	return it;
 }
 
+QuadFunc PixelJitCache::GetQuad(const PixelFuncID &id) {
+	if (!g_Config.bSoftwareRenderingJit)
+		return nullptr;
+
+	// Compiled alongside the single func, so never compiles here.
+	std::lock_guard<std::mutex> guard(jitCacheLock);
+	return quadCache_.Get(std::hash<PixelFuncID>()(id));
+}
+
 void PixelJitCache::Compile(const PixelFuncID &id) {
 	// x64 is typically 200-500 bytes, but let's be safe.
 	if (GetSpaceLeft() < 65536) {
@@ -900,6 +914,9 @@ void PixelJitCache::Compile(const PixelFuncID &id) {
 	addresses_[id] = GetCodePointer();
 	SingleFunc func = CompileSingle(id);
 	cache_.Insert(std::hash<PixelFuncID>()(id), func);
+	QuadFunc quad = CompileQuad(id);
+	if (quad)
+		quadCache_.Insert(std::hash<PixelFuncID>()(id), quad);
 #endif
 }
 
@@ -42,6 +42,19 @@ namespace Rasterizer {
 typedef void (SOFTRAST_CALL *SingleFunc)(int x, int y, int z, int fog, Vec4IntArg color_in, const PixelFuncID &pixelID);
 SingleFunc GetSingleFunc(const PixelFuncID &id, BinManager *binner);
 
+// Four pixels at once, in the order (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1).
+struct PixelQuadArgs {
+	Math3D::Vec4<int> color[4];
+	Math3D::Vec4<int> z;
+	Math3D::Vec4<int> fog;
+	// Lanes with a negative mask are skipped.
+	Math3D::Vec4<int> mask;
+};
+
+typedef void (SOFTRAST_CALL *QuadFunc)(int x, int y, const PixelQuadArgs &args, const PixelFuncID &pixelID);
+// Only available once the single func is compiled, and only for some states.  Returns nullptr otherwise.
+QuadFunc GetQuadFunc(const PixelFuncID &id);
+
 void Init();
 void FlushJit();
 void Shutdown();
@@ -67,6 +80,7 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	// Returns a pointer to the code to run.
 	SingleFunc GetSingle(const PixelFuncID &id, BinManager *binner);
 	SingleFunc GenericSingle(const PixelFuncID &id);
+	QuadFunc GetQuad(const PixelFuncID &id);
 	void Clear() override;
 	void Flush();
 
@@ -75,6 +89,7 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 private:
 	void Compile(const PixelFuncID &id);
 	SingleFunc CompileSingle(const PixelFuncID &id);
+	QuadFunc CompileQuad(const PixelFuncID &id);
 
 	RegCache::Reg GetPixelID();
 	void UnlockPixelID(RegCache::Reg &r);
@@ -109,6 +124,19 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	bool Jit_ConvertFrom5551(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha);
 	bool Jit_ConvertFrom4444(const PixelFuncID &id, RegCache::Reg colorReg, RegCache::Reg temp1Reg, RegCache::Reg temp2Reg, bool keepAlpha);
 
+	bool Jit_QuadPrepare(const PixelFuncID &id);
+	bool Jit_QuadDepthRange(const PixelFuncID &id);
+	bool Jit_QuadAlphaTest(const PixelFuncID &id);
+	bool Jit_QuadApplyFog(const PixelFuncID &id);
+	bool Jit_QuadDepthTest(const PixelFuncID &id);
+	bool Jit_QuadWriteDepth(const PixelFuncID &id);
+	bool Jit_QuadBlendAndDither(const PixelFuncID &id);
+	bool Jit_QuadWriteColor(const PixelFuncID &id);
+	void Jit_QuadCompare(GEComparison func, RegCache::Reg liveReg, RegCache::Reg lhsReg, RegCache::Reg rhsReg, RegCache::Reg tempReg);
+	void Jit_QuadDiscardDead(RegCache::Reg liveReg);
+	void Jit_QuadDecodeDst(const PixelFuncID &id, RegCache::Reg resultReg, RegCache::Reg dstReg, int channel, RegCache::Reg tempReg);
+	void Jit_QuadBlendFactor(const PixelFuncID &id, RegCache::Reg factorReg, PixelBlendFactor factor, bool srcSide, int channel, RegCache::Reg dstReg, RegCache::Reg tempReg);
+
 	struct LastCache {
 		size_t key;
 		SingleFunc func;
@@ -126,6 +154,7 @@ class PixelJitCache : public Rasterizer::CodeBlock {
 	};
 
 	DenseHashMap<size_t, SingleFunc, nullptr> cache_;
+	DenseHashMap<size_t, QuadFunc, nullptr> quadCache_;
 	std::unordered_map<PixelFuncID, const u8 *> addresses_;
 	std::unordered_set<PixelFuncID> compileQueue_;
 	int clearGen_ = 0;
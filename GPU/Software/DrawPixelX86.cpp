@@ -2315,6 +2315,780 @@ bool PixelJitCache::Jit_ConvertFrom4444(const PixelFuncID &id, RegCache::Reg col
 	return true;
 }
 
+// The quad func keeps each channel of four pixels in its own vector, one pixel per lane.
+// Lanes are ordered (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1), matching PixelQuadArgs.
+QuadFunc PixelJitCache::CompileQuad(const PixelFuncID &id) {
+	// Uses AVX2 throughout.  States that don't fit fall back to the single func per pixel.
+	if (!cpu_info.bAVX2 || id.clearMode || id.stencilTest || id.colorTest || id.applyLogicOp)
+		return nullptr;
+	if (id.applyColorWriteMask || id.hasAlphaTestMask)
+		return nullptr;
+
+	regCache_.SetupABI({
+		RegCache::GEN_ARG_X,
+		RegCache::GEN_ARG_Y,
+		RegCache::GEN_ARG_QUAD,
+		RegCache::GEN_ARG_ID,
+	});
+
+	BeginWrite(64);
+	Describe("InitQuad");
+	const u8 *resetPos = AlignCode16();
+	EndWrite();
+	bool success = true;
+
+	// All args are in regs on both ABIs, but we want plenty of regs for the offsets.
+#if PPSSPP_PLATFORM(WINDOWS)
+	WriteProlog(0, { XMM6, XMM7, XMM8, XMM9, XMM10, XMM11, XMM12, XMM13, XMM14, XMM15 }, { R12, R13, R14, R15 });
+#else
+	WriteProlog(0, {}, { R12, R13, R14, R15 });
+#endif
+	stackIDOffset_ = -1;
+
+	success = success && Jit_QuadPrepare(id);
+	success = success && Jit_QuadDepthRange(id);
+	success = success && Jit_QuadAlphaTest(id);
+	success = success && Jit_QuadApplyFog(id);
+	success = success && Jit_QuadDepthTest(id);
+	success = success && Jit_QuadWriteDepth(id);
+	success = success && Jit_QuadBlendAndDither(id);
+	success = success && Jit_QuadWriteColor(id);
+
+	for (auto &fixup : discards_) {
+		SetJumpTarget(fixup);
+	}
+	discards_.clear();
+
+	static const RegCache::Purpose retained[] = {
+		RegCache::GEN_ARG_QUAD,
+		RegCache::GEN_ARG_ID,
+		RegCache::GEN_COLOR_OFF,
+		RegCache::GEN_QUAD_COLOR_OFF1,
+		RegCache::VEC_QUAD_R,
+		RegCache::VEC_QUAD_G,
+		RegCache::VEC_QUAD_B,
+		RegCache::VEC_QUAD_A,
+		RegCache::VEC_QUAD_LIVE,
+		RegCache::VEC_QUAD_DITHER,
+	};
+	for (RegCache::Purpose p : retained) {
+		if (regCache_.Has(p))
+			regCache_.ForceRelease(p);
+	}
+
+	if (!success) {
+		ERROR_LOG_REPORT(G3D, "Could not compile pixel quad func: %s", DescribePixelFuncID(id).c_str());
+
+		regCache_.Reset(false);
+		EndWrite();
+		ResetCodePtr(GetOffset(resetPos));
+		return nullptr;
+	}
+
+	const u8 *start = WriteFinalizedEpilog();
+	regCache_.Reset(true);
+	return (QuadFunc)start;
+}
+
+bool PixelJitCache::Jit_QuadPrepare(const PixelFuncID &id) {
+	Describe("QuadLive");
+	X64Reg quadReg = regCache_.Find(RegCache::GEN_ARG_QUAD);
+
+	// We track live lanes (all ones) rather than the mask, a negative mask is dead.
+	X64Reg liveReg = regCache_.Alloc(RegCache::VEC_QUAD_LIVE);
+	X64Reg temp1Reg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	VPCMPEQD(128, temp1Reg, temp1Reg, R(temp1Reg));
+	VMOVDQU(128, liveReg, MDisp(quadReg, offsetof(PixelQuadArgs, mask)));
+	VPCMPGTD(128, liveReg, liveReg, R(temp1Reg));
+	Jit_QuadDiscardDead(liveReg);
+	regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+	regCache_.ForceRetain(RegCache::VEC_QUAD_LIVE);
+
+	// Transpose the colors so each vector holds one channel.
+	Describe("QuadColor");
+	auto colorArg = [&](int i) {
+		return MDisp(quadReg, (int)(offsetof(PixelQuadArgs, color) + i * sizeof(Math3D::Vec4<int>)));
+	};
+	X64Reg temp2Reg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	X64Reg temp3Reg = regCache_.Alloc(RegCache::VEC_TEMP2);
+	X64Reg temp4Reg = regCache_.Alloc(RegCache::VEC_TEMP3);
+	VMOVDQU(128, temp3Reg, colorArg(0));
+	VPUNPCKLDQ(128, temp1Reg, temp3Reg, colorArg(1));
+	VPUNPCKHDQ(128, temp3Reg, temp3Reg, colorArg(1));
+	VMOVDQU(128, temp4Reg, colorArg(2));
+	VPUNPCKLDQ(128, temp2Reg, temp4Reg, colorArg(3));
+	VPUNPCKHDQ(128, temp4Reg, temp4Reg, colorArg(3));
+
+	X64Reg colorRegs[4];
+	static const RegCache::Purpose colorPurposes[] = { RegCache::VEC_QUAD_R, RegCache::VEC_QUAD_G, RegCache::VEC_QUAD_B, RegCache::VEC_QUAD_A };
+	for (int i = 0; i < 4; ++i)
+		colorRegs[i] = regCache_.Alloc(colorPurposes[i]);
+	VPUNPCKLQDQ(128, colorRegs[0], temp1Reg, R(temp2Reg));
+	VPUNPCKHQDQ(128, colorRegs[1], temp1Reg, R(temp2Reg));
+	VPUNPCKLQDQ(128, colorRegs[2], temp3Reg, R(temp4Reg));
+	VPUNPCKHQDQ(128, colorRegs[3], temp3Reg, R(temp4Reg));
+
+	// Now clamp each to 0-255, everything after expects it.
+	VPXOR(128, temp1Reg, temp1Reg, R(temp1Reg));
+	VPCMPEQD(128, temp2Reg, temp2Reg, R(temp2Reg));
+	VPSRLD(128, temp2Reg, temp2Reg, 24);
+	for (int i = 0; i < 4; ++i) {
+		VPMAXSD(128, colorRegs[i], colorRegs[i], R(temp1Reg));
+		VPMINSD(128, colorRegs[i], colorRegs[i], R(temp2Reg));
+		regCache_.Unlock(colorRegs[i], colorPurposes[i]);
+		regCache_.ForceRetain(colorPurposes[i]);
+	}
+	regCache_.Release(temp1Reg, RegCache::VEC_TEMP0);
+	regCache_.Release(temp2Reg, RegCache::VEC_TEMP1);
+	regCache_.Release(temp3Reg, RegCache::VEC_TEMP2);
+	regCache_.Release(temp4Reg, RegCache::VEC_TEMP3);
+
+	bool needsDepth = id.depthWrite || (id.DepthTestFunc() != GE_COMP_ALWAYS && !id.earlyZChecks) || (id.applyDepthRange && !id.earlyZChecks);
+	if (needsDepth) {
+		X64Reg zReg = regCache_.Alloc(RegCache::VEC_QUAD_Z);
+		VMOVDQU(128, zReg, MDisp(quadReg, offsetof(PixelQuadArgs, z)));
+		regCache_.Unlock(zReg, RegCache::VEC_QUAD_Z);
+		regCache_.ForceRetain(RegCache::VEC_QUAD_Z);
+	}
+	regCache_.Unlock(quadReg, RegCache::GEN_ARG_QUAD);
+
+	X64Reg argXReg = regCache_.Find(RegCache::GEN_ARG_X);
+	X64Reg argYReg = regCache_.Find(RegCache::GEN_ARG_Y);
+	X64Reg idReg = regCache_.Find(RegCache::GEN_ARG_ID);
+
+	// Each lane may use a different dither value, so gather them while we still have x and y.
+	if (id.dithering) {
+		Describe("QuadDither");
+		X64Reg rowReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		X64Reg indexReg = regCache_.Alloc(RegCache::GEN_TEMP1);
+		X64Reg valueReg = regCache_.Alloc(RegCache::GEN_TEMP2);
+		X64Reg ditherReg = regCache_.Alloc(RegCache::VEC_QUAD_DITHER);
+		for (int i = 0; i < 4; ++i) {
+			if ((i & 1) == 0) {
+				LEA(32, rowReg, MDisp(argYReg, i / 2));
+				AND(32, R(rowReg), Imm8(3));
+			}
+			LEA(32, indexReg, MDisp(argXReg, i & 1));
+			AND(32, R(indexReg), Imm8(3));
+			LEA(32, indexReg, MComplex(indexReg, rowReg, 4, 0));
+			MOVSX(32, 8, valueReg, MComplex(idReg, indexReg, 1, offsetof(PixelFuncID, cached.ditherMatrix)));
+			if (i == 0)
+				VMOVD(ditherReg, R(valueReg));
+			else
+				VPINSRD(ditherReg, ditherReg, R(valueReg), i);
+		}
+		regCache_.Release(rowReg, RegCache::GEN_TEMP0);
+		regCache_.Release(indexReg, RegCache::GEN_TEMP1);
+		regCache_.Release(valueReg, RegCache::GEN_TEMP2);
+		regCache_.Unlock(ditherReg, RegCache::VEC_QUAD_DITHER);
+		regCache_.ForceRetain(RegCache::VEC_QUAD_DITHER);
+	}
+
+	// Now calculate a pointer for each row of color, and depth if used.
+	Describe("QuadOffsets");
+	auto calcRowOffsets = [&](const void *bufDataPtr, size_t strideOffset, int bpp, RegCache::Purpose row0, RegCache::Purpose row1) {
+		X64Reg row0Reg = regCache_.Alloc(row0);
+		X64Reg row1Reg = regCache_.Alloc(row1);
+		if (id.useStandardStride) {
+			MOV(32, R(row0Reg), R(argYReg));
+			SHL(32, R(row0Reg), Imm8(9));
+		} else {
+			MOVZX(32, 16, row1Reg, MDisp(idReg, (int)strideOffset));
+			MOV(32, R(row0Reg), R(argYReg));
+			IMUL(32, row0Reg, R(row1Reg));
+		}
+		ADD(32, R(row0Reg), R(argXReg));
+
+		X64Reg ptrReg = regCache_.Alloc(RegCache::GEN_TEMP_HELPER);
+		if (RipAccessible(bufDataPtr)) {
+			MOV(PTRBITS, R(ptrReg), M(bufDataPtr));
+		} else {
+			MOV(PTRBITS, R(ptrReg), ImmPtr(bufDataPtr));
+			MOV(PTRBITS, R(ptrReg), MatR(ptrReg));
+		}
+		LEA(PTRBITS, row0Reg, MComplex(ptrReg, row0Reg, bpp, 0));
+		regCache_.Release(ptrReg, RegCache::GEN_TEMP_HELPER);
+
+		if (id.useStandardStride)
+			LEA(PTRBITS, row1Reg, MDisp(row0Reg, 512 * bpp));
+		else
+			LEA(PTRBITS, row1Reg, MComplex(row0Reg, row1Reg, bpp, 0));
+
+		regCache_.Unlock(row0Reg, row0);
+		regCache_.ForceRetain(row0);
+		regCache_.Unlock(row1Reg, row1);
+		regCache_.ForceRetain(row1);
+	};
+
+	calcRowOffsets(&fb.data, offsetof(PixelFuncID, cached.framebufStride), id.FBFormat() == GE_FORMAT_8888 ? 4 : 2, RegCache::GEN_COLOR_OFF, RegCache::GEN_QUAD_COLOR_OFF1);
+	if (id.depthWrite || (id.DepthTestFunc() != GE_COMP_ALWAYS && !id.earlyZChecks))
+		calcRowOffsets(&depthbuf.data, offsetof(PixelFuncID, cached.depthbufStride), 2, RegCache::GEN_DEPTH_OFF, RegCache::GEN_QUAD_DEPTH_OFF1);
+
+	regCache_.Unlock(argXReg, RegCache::GEN_ARG_X);
+	regCache_.ForceRelease(RegCache::GEN_ARG_X);
+	regCache_.Unlock(argYReg, RegCache::GEN_ARG_Y);
+	regCache_.ForceRelease(RegCache::GEN_ARG_Y);
+	regCache_.Unlock(idReg, RegCache::GEN_ARG_ID);
+	return true;
+}
+
+void PixelJitCache::Jit_QuadCompare(GEComparison func, RegCache::Reg liveReg, RegCache::Reg lhsReg, RegCache::Reg rhsReg, RegCache::Reg tempReg) {
+	// Lanes that fail lhs <func> rhs are cleared from liveReg.
+	switch (func) {
+	case GE_COMP_NEVER:
+		VPXOR(128, liveReg, liveReg, R(liveReg));
+		break;
+
+	case GE_COMP_ALWAYS:
+		break;
+
+	case GE_COMP_EQUAL:
+		VPCMPEQD(128, tempReg, lhsReg, R(rhsReg));
+		VPAND(128, liveReg, liveReg, R(tempReg));
+		break;
+
+	case GE_COMP_NOTEQUAL:
+		VPCMPEQD(128, tempReg, lhsReg, R(rhsReg));
+		VPANDN(128, liveReg, tempReg, R(liveReg));
+		break;
+
+	case GE_COMP_LESS:
+		VPCMPGTD(128, tempReg, rhsReg, R(lhsReg));
+		VPAND(128, liveReg, liveReg, R(tempReg));
+		break;
+
+	case GE_COMP_LEQUAL:
+		VPCMPGTD(128, tempReg, lhsReg, R(rhsReg));
+		VPANDN(128, liveReg, tempReg, R(liveReg));
+		break;
+
+	case GE_COMP_GREATER:
+		VPCMPGTD(128, tempReg, lhsReg, R(rhsReg));
+		VPAND(128, liveReg, liveReg, R(tempReg));
+		break;
+
+	case GE_COMP_GEQUAL:
+		VPCMPGTD(128, tempReg, rhsReg, R(lhsReg));
+		VPANDN(128, liveReg, tempReg, R(liveReg));
+		break;
+	}
+}
+
+void PixelJitCache::Jit_QuadDiscardDead(RegCache::Reg liveReg) {
+	// If no lanes are left, we're done.
+	VPTEST(128, liveReg, R(liveReg));
+	Discard(CC_Z);
+}
+
+bool PixelJitCache::Jit_QuadDepthRange(const PixelFuncID &id) {
+	if (!id.applyDepthRange || id.earlyZChecks)
+		return true;
+
+	Describe("QuadDepthRange");
+	X64Reg idReg = regCache_.Find(RegCache::GEN_ARG_ID);
+	X64Reg liveReg = regCache_.Find(RegCache::VEC_QUAD_LIVE);
+	X64Reg zReg = regCache_.Find(RegCache::VEC_QUAD_Z);
+	X64Reg tempReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+
+	// Clear any lanes where minz > z or z > maxz.
+	VPBROADCASTD(128, tempReg, MDisp(idReg, offsetof(PixelFuncID, cached.minz)));
+	VPCMPGTD(128, tempReg, tempReg, R(zReg));
+	VPANDN(128, liveReg, tempReg, R(liveReg));
+	VPBROADCASTD(128, tempReg, MDisp(idReg, offsetof(PixelFuncID, cached.maxz)));
+	VPCMPGTD(128, tempReg, zReg, R(tempReg));
+	VPANDN(128, liveReg, tempReg, R(liveReg));
+	Jit_QuadDiscardDead(liveReg);
+
+	regCache_.Release(tempReg, RegCache::VEC_TEMP0);
+	regCache_.Unlock(zReg, RegCache::VEC_QUAD_Z);
+	regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+	regCache_.Unlock(idReg, RegCache::GEN_ARG_ID);
+	return true;
+}
+
+bool PixelJitCache::Jit_QuadAlphaTest(const PixelFuncID &id) {
+	if (id.AlphaTestFunc() == GE_COMP_ALWAYS)
+		return true;
+
+	Describe("QuadAlphaTest");
+	X64Reg liveReg = regCache_.Find(RegCache::VEC_QUAD_LIVE);
+	if (id.AlphaTestFunc() == GE_COMP_NEVER) {
+		// Unlikely, but possible: nothing passes.
+		Discard();
+		regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+		return true;
+	}
+
+	X64Reg refReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	X64Reg tempReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	X64Reg genTempReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+	MOV(32, R(genTempReg), Imm32(id.alphaTestRef));
+	VMOVD(refReg, R(genTempReg));
+	VPBROADCASTD(128, refReg, R(refReg));
+	regCache_.Release(genTempReg, RegCache::GEN_TEMP0);
+
+	X64Reg alphaReg = regCache_.Find(RegCache::VEC_QUAD_A);
+	Jit_QuadCompare(id.AlphaTestFunc(), liveReg, alphaReg, refReg, tempReg);
+	regCache_.Unlock(alphaReg, RegCache::VEC_QUAD_A);
+	Jit_QuadDiscardDead(liveReg);
+
+	regCache_.Release(refReg, RegCache::VEC_TEMP0);
+	regCache_.Release(tempReg, RegCache::VEC_TEMP1);
+	regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+	return true;
+}
+
+bool PixelJitCache::Jit_QuadApplyFog(const PixelFuncID &id) {
+	if (!id.applyFog)
+		return true;
+
+	Describe("QuadApplyFog");
+	X64Reg quadReg = regCache_.Find(RegCache::GEN_ARG_QUAD);
+	X64Reg idReg = regCache_.Find(RegCache::GEN_ARG_ID);
+	X64Reg fogReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	X64Reg invFogReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	X64Reg roundReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+	X64Reg fogColorReg = regCache_.Alloc(RegCache::VEC_TEMP3);
+
+	// Same as the single func: (color * fog + fogColor * (255 - fog) + 255) / 256.
+	VMOVDQU(128, fogReg, MDisp(quadReg, offsetof(PixelQuadArgs, fog)));
+	VPCMPEQD(128, roundReg, roundReg, R(roundReg));
+	VPSRLD(128, roundReg, roundReg, 24);
+	VPSUBD(128, invFogReg, roundReg, R(fogReg));
+
+	static const RegCache::Purpose colorPurposes[] = { RegCache::VEC_QUAD_R, RegCache::VEC_QUAD_G, RegCache::VEC_QUAD_B };
+	for (int i = 0; i < 3; ++i) {
+		// Broadcast the byte, then shift to leave just one copy per lane.
+		VPBROADCASTB(128, fogColorReg, MDisp(idReg, (int)offsetof(PixelFuncID, cached.fogColor) + i));
+		VPSRLD(128, fogColorReg, fogColorReg, 24);
+		VPMULLD(128, fogColorReg, fogColorReg, R(invFogReg));
+
+		X64Reg colorReg = regCache_.Find(colorPurposes[i]);
+		VPMULLD(128, colorReg, colorReg, R(fogReg));
+		VPADDD(128, colorReg, colorReg, R(fogColorReg));
+		VPADDD(128, colorReg, colorReg, R(roundReg));
+		VPSRLD(128, colorReg, colorReg, 8);
+		regCache_.Unlock(colorReg, colorPurposes[i]);
+	}
+
+	regCache_.Release(fogReg, RegCache::VEC_TEMP0);
+	regCache_.Release(invFogReg, RegCache::VEC_TEMP1);
+	regCache_.Release(roundReg, RegCache::VEC_TEMP2);
+	regCache_.Release(fogColorReg, RegCache::VEC_TEMP3);
+	regCache_.Unlock(idReg, RegCache::GEN_ARG_ID);
+	regCache_.Unlock(quadReg, RegCache::GEN_ARG_QUAD);
+	return true;
+}
+
+bool PixelJitCache::Jit_QuadDepthTest(const PixelFuncID &id) {
+	if (id.DepthTestFunc() == GE_COMP_ALWAYS || id.earlyZChecks)
+		return true;
+
+	Describe("QuadDepthTest");
+	X64Reg depthOff0Reg = regCache_.Find(RegCache::GEN_DEPTH_OFF);
+	X64Reg depthOff1Reg = regCache_.Find(RegCache::GEN_QUAD_DEPTH_OFF1);
+	X64Reg refReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	X64Reg srcZReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	X64Reg tempReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+
+	// Reads both pixels of each row, even if one is dead.  They're only written if live.
+	VMOVD(refReg, MatR(depthOff0Reg));
+	VPINSRD(refReg, refReg, MatR(depthOff1Reg), 1);
+	VPMOVZXWD(128, refReg, R(refReg));
+	regCache_.Unlock(depthOff0Reg, RegCache::GEN_DEPTH_OFF);
+	regCache_.Unlock(depthOff1Reg, RegCache::GEN_QUAD_DEPTH_OFF1);
+
+	// Like the single func, the comparison is done on the u16 value.
+	X64Reg zReg = regCache_.Find(RegCache::VEC_QUAD_Z);
+	VPSLLD(128, srcZReg, zReg, 16);
+	VPSRLD(128, srcZReg, srcZReg, 16);
+	regCache_.Unlock(zReg, RegCache::VEC_QUAD_Z);
+
+	X64Reg liveReg = regCache_.Find(RegCache::VEC_QUAD_LIVE);
+	Jit_QuadCompare(id.DepthTestFunc(), liveReg, srcZReg, refReg, tempReg);
+	Jit_QuadDiscardDead(liveReg);
+	regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+
+	regCache_.Release(refReg, RegCache::VEC_TEMP0);
+	regCache_.Release(srcZReg, RegCache::VEC_TEMP1);
+	regCache_.Release(tempReg, RegCache::VEC_TEMP2);
+	return true;
+}
+
+bool PixelJitCache::Jit_QuadWriteDepth(const PixelFuncID &id) {
+	if (id.depthWrite) {
+		Describe("QuadWriteDepth");
+		X64Reg depthOff0Reg = regCache_.Find(RegCache::GEN_DEPTH_OFF);
+		X64Reg depthOff1Reg = regCache_.Find(RegCache::GEN_QUAD_DEPTH_OFF1);
+		X64Reg liveReg = regCache_.Find(RegCache::VEC_QUAD_LIVE);
+		X64Reg zReg = regCache_.Find(RegCache::VEC_QUAD_Z);
+		X64Reg maskReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+
+		// Write each live lane individually, other lanes may belong to another thread.
+		VMOVMSKPS(128, maskReg, liveReg);
+		for (int i = 0; i < 4; ++i) {
+			TEST(8, R(maskReg), Imm8(1 << i));
+			FixupBranch skip = J_CC(CC_Z);
+			VPEXTRW(MDisp(i < 2 ? depthOff0Reg : depthOff1Reg, (i & 1) * 2), zReg, i * 2);
+			SetJumpTarget(skip);
+		}
+
+		regCache_.Release(maskReg, RegCache::GEN_TEMP0);
+		regCache_.Unlock(zReg, RegCache::VEC_QUAD_Z);
+		regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+		regCache_.Unlock(depthOff0Reg, RegCache::GEN_DEPTH_OFF);
+		regCache_.Unlock(depthOff1Reg, RegCache::GEN_QUAD_DEPTH_OFF1);
+	}
+
+	// We're done with depth now, free up those regs.
+	if (regCache_.Has(RegCache::GEN_DEPTH_OFF)) {
+		regCache_.ForceRelease(RegCache::GEN_DEPTH_OFF);
+		regCache_.ForceRelease(RegCache::GEN_QUAD_DEPTH_OFF1);
+	}
+	if (regCache_.Has(RegCache::VEC_QUAD_Z))
+		regCache_.ForceRelease(RegCache::VEC_QUAD_Z);
+	return true;
+}
+
+// Bit position and size of each channel (RGBA) in the framebuffer format.
+static const int (*QuadChannelBits(GEBufferFormat fmt))[2] {
+	static const int bits8888[4][2] = { { 0, 8 }, { 8, 8 }, { 16, 8 }, { 24, 8 } };
+	static const int bits565[4][2] = { { 0, 5 }, { 5, 6 }, { 11, 5 }, { 0, 0 } };
+	static const int bits5551[4][2] = { { 0, 5 }, { 5, 5 }, { 10, 5 }, { 15, 1 } };
+	static const int bits4444[4][2] = { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 12, 4 } };
+
+	switch (fmt) {
+	case GE_FORMAT_565: return bits565;
+	case GE_FORMAT_5551: return bits5551;
+	case GE_FORMAT_4444: return bits4444;
+	default: return bits8888;
+	}
+}
+
+void PixelJitCache::Jit_QuadDecodeDst(const PixelFuncID &id, RegCache::Reg resultReg, RegCache::Reg dstReg, int channel, RegCache::Reg tempReg) {
+	const int *bits = QuadChannelBits(id.FBFormat())[channel];
+
+	if (bits[1] == 0) {
+		// Alpha is zero for the purposes of blending in 565.
+		VPXOR(128, resultReg, resultReg, R(resultReg));
+		return;
+	}
+
+	// Shift the channel to the top, then down to the bottom.
+	VPSLLD(128, resultReg, dstReg, 32 - bits[0] - bits[1]);
+	if (bits[1] == 1) {
+		// Spread the single bit to 0 or 255.
+		VPSRAD(128, resultReg, resultReg, 31);
+		VPSRLD(128, resultReg, resultReg, 24);
+		return;
+	}
+	VPSRLD(128, resultReg, resultReg, 32 - bits[1]);
+
+	// Now expand the same way the single func does, repeating the top bits.
+	if (bits[1] < 8) {
+		VPSLLD(128, tempReg, resultReg, 8 - bits[1]);
+		VPSRLD(128, resultReg, resultReg, 2 * bits[1] - 8);
+		VPOR(128, resultReg, resultReg, R(tempReg));
+	}
+}
+
+void PixelJitCache::Jit_QuadBlendFactor(const PixelFuncID &id, RegCache::Reg factorReg, PixelBlendFactor factor, bool srcSide, int channel, RegCache::Reg dstReg, RegCache::Reg tempReg) {
+	static const RegCache::Purpose colorPurposes[] = { RegCache::VEC_QUAD_R, RegCache::VEC_QUAD_G, RegCache::VEC_QUAD_B, RegCache::VEC_QUAD_A };
+
+	// Puts the source or dest channel in resultReg.
+	auto loadChannel = [&](RegCache::Reg resultReg, bool fromSrc, int c) {
+		if (fromSrc) {
+			X64Reg colorReg = regCache_.Find(colorPurposes[c]);
+			VMOVDQA(128, resultReg, R(colorReg));
+			regCache_.Unlock(colorReg, colorPurposes[c]);
+		} else {
+			Jit_QuadDecodeDst(id, resultReg, dstReg, c, resultReg == factorReg ? tempReg : factorReg);
+		}
+	};
+	auto invert = [&](RegCache::Reg valueReg) {
+		VPCMPEQD(128, factorReg, factorReg, R(factorReg));
+		VPSRLD(128, factorReg, factorReg, 24);
+		VPSUBD(128, factorReg, factorReg, R(valueReg));
+	};
+	auto invertDouble = [&](RegCache::Reg valueReg) {
+		VPADDD(128, valueReg, valueReg, R(valueReg));
+		VPCMPEQD(128, factorReg, factorReg, R(factorReg));
+		VPSRLD(128, factorReg, factorReg, 24);
+		VPMINSD(128, valueReg, valueReg, R(factorReg));
+		VPSUBD(128, factorReg, factorReg, R(valueReg));
+	};
+
+	switch (factor) {
+	case PixelBlendFactor::OTHERCOLOR:
+		loadChannel(factorReg, !srcSide, channel);
+		break;
+
+	case PixelBlendFactor::INVOTHERCOLOR:
+		loadChannel(tempReg, !srcSide, channel);
+		invert(tempReg);
+		break;
+
+	case PixelBlendFactor::SRCALPHA:
+		loadChannel(factorReg, true, 3);
+		break;
+
+	case PixelBlendFactor::INVSRCALPHA:
+		loadChannel(tempReg, true, 3);
+		invert(tempReg);
+		break;
+
+	case PixelBlendFactor::DSTALPHA:
+		Jit_QuadDecodeDst(id, factorReg, dstReg, 3, tempReg);
+		break;
+
+	case PixelBlendFactor::INVDSTALPHA:
+		loadChannel(tempReg, false, 3);
+		invert(tempReg);
+		break;
+
+	case PixelBlendFactor::DOUBLESRCALPHA:
+		loadChannel(factorReg, true, 3);
+		VPADDD(128, factorReg, factorReg, R(factorReg));
+		break;
+
+	case PixelBlendFactor::DOUBLEINVSRCALPHA:
+		loadChannel(tempReg, true, 3);
+		invertDouble(tempReg);
+		break;
+
+	case PixelBlendFactor::DOUBLEDSTALPHA:
+		Jit_QuadDecodeDst(id, factorReg, dstReg, 3, tempReg);
+		VPADDD(128, factorReg, factorReg, R(factorReg));
+		break;
+
+	case PixelBlendFactor::DOUBLEINVDSTALPHA:
+		loadChannel(tempReg, false, 3);
+		invertDouble(tempReg);
+		break;
+
+	case PixelBlendFactor::ZERO:
+		VPXOR(128, factorReg, factorReg, R(factorReg));
+		break;
+
+	case PixelBlendFactor::ONE:
+		VPCMPEQD(128, factorReg, factorReg, R(factorReg));
+		VPSRLD(128, factorReg, factorReg, 24);
+		break;
+
+	case PixelBlendFactor::FIX:
+	default:
+	{
+		// The fixed color isn't part of the id key, so read it at runtime.
+		X64Reg idReg = regCache_.Find(RegCache::GEN_ARG_ID);
+		int fixOffset = srcSide ? offsetof(PixelFuncID, cached.alphaBlendSrc) : offsetof(PixelFuncID, cached.alphaBlendDst);
+		VPBROADCASTB(128, factorReg, MDisp(idReg, fixOffset + channel));
+		VPSRLD(128, factorReg, factorReg, 24);
+		regCache_.Unlock(idReg, RegCache::GEN_ARG_ID);
+		break;
+	}
+	}
+}
+
+bool PixelJitCache::Jit_QuadBlendAndDither(const PixelFuncID &id) {
+	PixelBlendState blendState;
+	ComputePixelBlendState(blendState, id);
+
+	// We keep the dest bits around also to preserve alpha/stencil, which 565 doesn't have.
+	bool readsDst = id.alphaBlend && blendState.readsDstPixel;
+	if (readsDst || id.FBFormat() != GE_FORMAT_565) {
+		Describe("QuadReadDst");
+		X64Reg colorOff0Reg = regCache_.Find(RegCache::GEN_COLOR_OFF);
+		X64Reg colorOff1Reg = regCache_.Find(RegCache::GEN_QUAD_COLOR_OFF1);
+		X64Reg dstReg = regCache_.Alloc(RegCache::VEC_QUAD_DST);
+		if (id.FBFormat() == GE_FORMAT_8888) {
+			VMOVQ(dstReg, MatR(colorOff0Reg));
+			VPINSRQ(dstReg, dstReg, MatR(colorOff1Reg), 1);
+		} else {
+			VMOVD(dstReg, MatR(colorOff0Reg));
+			VPINSRD(dstReg, dstReg, MatR(colorOff1Reg), 1);
+			VPMOVZXWD(128, dstReg, R(dstReg));
+		}
+		regCache_.Unlock(dstReg, RegCache::VEC_QUAD_DST);
+		regCache_.ForceRetain(RegCache::VEC_QUAD_DST);
+		regCache_.Unlock(colorOff0Reg, RegCache::GEN_COLOR_OFF);
+		regCache_.Unlock(colorOff1Reg, RegCache::GEN_QUAD_COLOR_OFF1);
+	}
+
+	bool clampNeeded = id.alphaBlend || id.dithering;
+	if (!clampNeeded)
+		return true;
+
+	Describe(id.alphaBlend ? "QuadAlphaBlend" : "QuadDither");
+	X64Reg dstReg = regCache_.Has(RegCache::VEC_QUAD_DST) ? regCache_.Find(RegCache::VEC_QUAD_DST) : INVALID_REG;
+	X64Reg dstColorReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	X64Reg srcFactorReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	X64Reg dstFactorReg = regCache_.Alloc(RegCache::VEC_TEMP2);
+	X64Reg tempReg = regCache_.Alloc(RegCache::VEC_TEMP3);
+
+	static const RegCache::Purpose colorPurposes[] = { RegCache::VEC_QUAD_R, RegCache::VEC_QUAD_G, RegCache::VEC_QUAD_B };
+	for (int i = 0; i < 3; ++i) {
+		if (id.alphaBlend) {
+			bool usesFactors = blendState.usesFactors;
+			if (usesFactors) {
+				// Grab the factors first, since they may use this channel of the source color.
+				Jit_QuadBlendFactor(id, srcFactorReg, id.AlphaBlendSrc(), true, i, dstReg, tempReg);
+				if (blendState.readsDstPixel)
+					Jit_QuadBlendFactor(id, dstFactorReg, id.AlphaBlendDst(), false, i, dstReg, tempReg);
+			}
+			if (blendState.readsDstPixel)
+				Jit_QuadDecodeDst(id, dstColorReg, dstReg, i, tempReg);
+
+			X64Reg colorReg = regCache_.Find(colorPurposes[i]);
+			if (usesFactors) {
+				// Each side is ((2 * color + 1) * (2 * factor + 1)) >> 10, matching the single func.
+				VPCMPEQD(128, tempReg, tempReg, R(tempReg));
+				VPADDD(128, colorReg, colorReg, R(colorReg));
+				VPSUBD(128, colorReg, colorReg, R(tempReg));
+				VPADDD(128, srcFactorReg, srcFactorReg, R(srcFactorReg));
+				VPSUBD(128, srcFactorReg, srcFactorReg, R(tempReg));
+				VPMULLD(128, colorReg, colorReg, R(srcFactorReg));
+				VPSRLD(128, colorReg, colorReg, 10);
+
+				if (blendState.readsDstPixel) {
+					VPADDD(128, dstColorReg, dstColorReg, R(dstColorReg));
+					VPSUBD(128, dstColorReg, dstColorReg, R(tempReg));
+					VPADDD(128, dstFactorReg, dstFactorReg, R(dstFactorReg));
+					VPSUBD(128, dstFactorReg, dstFactorReg, R(tempReg));
+					VPMULLD(128, dstColorReg, dstColorReg, R(dstFactorReg));
+					VPSRLD(128, dstColorReg, dstColorReg, 10);
+				} else {
+					// A zero factor always results in zero.
+					VPXOR(128, dstColorReg, dstColorReg, R(dstColorReg));
+				}
+			}
+
+			switch (id.AlphaBlendEq()) {
+			case GE_BLENDMODE_MUL_AND_ADD:
+				VPADDD(128, colorReg, colorReg, R(dstColorReg));
+				break;
+
+			case GE_BLENDMODE_MUL_AND_SUBTRACT:
+				VPSUBD(128, colorReg, colorReg, R(dstColorReg));
+				VPXOR(128, tempReg, tempReg, R(tempReg));
+				VPMAXSD(128, colorReg, colorReg, R(tempReg));
+				break;
+
+			case GE_BLENDMODE_MUL_AND_SUBTRACT_REVERSE:
+				VPSUBD(128, colorReg, dstColorReg, R(colorReg));
+				VPXOR(128, tempReg, tempReg, R(tempReg));
+				VPMAXSD(128, colorReg, colorReg, R(tempReg));
+				break;
+
+			case GE_BLENDMODE_MIN:
+				VPMINSD(128, colorReg, colorReg, R(dstColorReg));
+				break;
+
+			case GE_BLENDMODE_MAX:
+				VPMAXSD(128, colorReg, colorReg, R(dstColorReg));
+				break;
+
+			case GE_BLENDMODE_ABSDIFF:
+				VPSUBD(128, colorReg, colorReg, R(dstColorReg));
+				VPABSD(128, colorReg, R(colorReg));
+				break;
+
+			default:
+				// Other modes just keep the source color.
+				break;
+			}
+			regCache_.Unlock(colorReg, colorPurposes[i]);
+		}
+
+		X64Reg colorReg = regCache_.Find(colorPurposes[i]);
+		if (id.dithering) {
+			X64Reg ditherReg = regCache_.Find(RegCache::VEC_QUAD_DITHER);
+			VPADDD(128, colorReg, colorReg, R(ditherReg));
+			regCache_.Unlock(ditherReg, RegCache::VEC_QUAD_DITHER);
+		}
+
+		// Blending and dithering can both take us out of range, so clamp.
+		VPXOR(128, tempReg, tempReg, R(tempReg));
+		VPMAXSD(128, colorReg, colorReg, R(tempReg));
+		VPCMPEQD(128, tempReg, tempReg, R(tempReg));
+		VPSRLD(128, tempReg, tempReg, 24);
+		VPMINSD(128, colorReg, colorReg, R(tempReg));
+		regCache_.Unlock(colorReg, colorPurposes[i]);
+	}
+
+	regCache_.Release(dstColorReg, RegCache::VEC_TEMP0);
+	regCache_.Release(srcFactorReg, RegCache::VEC_TEMP1);
+	regCache_.Release(dstFactorReg, RegCache::VEC_TEMP2);
+	regCache_.Release(tempReg, RegCache::VEC_TEMP3);
+	if (dstReg != INVALID_REG)
+		regCache_.Unlock(dstReg, RegCache::VEC_QUAD_DST);
+	return true;
+}
+
+bool PixelJitCache::Jit_QuadWriteColor(const PixelFuncID &id) {
+	Describe("QuadWriteColor");
+	const int (*bits)[2] = QuadChannelBits(id.FBFormat());
+
+	X64Reg resultReg = regCache_.Alloc(RegCache::VEC_TEMP0);
+	X64Reg tempReg = regCache_.Alloc(RegCache::VEC_TEMP1);
+	static const RegCache::Purpose colorPurposes[] = { RegCache::VEC_QUAD_R, RegCache::VEC_QUAD_G, RegCache::VEC_QUAD_B };
+	for (int i = 0; i < 3; ++i) {
+		X64Reg colorReg = regCache_.Find(colorPurposes[i]);
+		X64Reg targetReg = i == 0 ? resultReg : tempReg;
+		if (bits[i][1] != 8) {
+			VPSRLD(128, targetReg, colorReg, 8 - bits[i][1]);
+			if (bits[i][0] != 0)
+				VPSLLD(128, targetReg, targetReg, bits[i][0]);
+		} else if (bits[i][0] != 0) {
+			VPSLLD(128, targetReg, colorReg, bits[i][0]);
+		} else {
+			VMOVDQA(128, targetReg, R(colorReg));
+		}
+		if (i != 0)
+			VPOR(128, resultReg, resultReg, R(tempReg));
+		regCache_.Unlock(colorReg, colorPurposes[i]);
+	}
+
+	// Alpha/stencil is untouched without a stencil test, so copy the dest bits over.
+	if (bits[3][1] != 0) {
+		X64Reg dstReg = regCache_.Find(RegCache::VEC_QUAD_DST);
+		VPSRLD(128, tempReg, dstReg, bits[3][0]);
+		VPSLLD(128, tempReg, tempReg, bits[3][0]);
+		VPOR(128, resultReg, resultReg, R(tempReg));
+		regCache_.Unlock(dstReg, RegCache::VEC_QUAD_DST);
+	}
+	if (regCache_.Has(RegCache::VEC_QUAD_DST))
+		regCache_.ForceRelease(RegCache::VEC_QUAD_DST);
+
+	X64Reg colorOff0Reg = regCache_.Find(RegCache::GEN_COLOR_OFF);
+	X64Reg colorOff1Reg = regCache_.Find(RegCache::GEN_QUAD_COLOR_OFF1);
+	X64Reg liveReg = regCache_.Find(RegCache::VEC_QUAD_LIVE);
+	if (id.FBFormat() == GE_FORMAT_8888) {
+		// The masked store only touches live lanes, and each row is two lanes.
+		VMOVQ(tempReg, liveReg);
+		VPMASKMOVD(128, MatR(colorOff0Reg), resultReg, tempReg);
+		VPSRLDQ(128, tempReg, liveReg, 8);
+		VPSRLDQ(128, resultReg, resultReg, 8);
+		VPMASKMOVD(128, MatR(colorOff1Reg), resultReg, tempReg);
+	} else {
+		X64Reg maskReg = regCache_.Alloc(RegCache::GEN_TEMP0);
+		VMOVMSKPS(128, maskReg, liveReg);
+		for (int i = 0; i < 4; ++i) {
+			TEST(8, R(maskReg), Imm8(1 << i));
+			FixupBranch skip = J_CC(CC_Z);
+			VPEXTRW(MDisp(i < 2 ? colorOff0Reg : colorOff1Reg, (i & 1) * 2), resultReg, i * 2);
+			SetJumpTarget(skip);
+		}
+		regCache_.Release(maskReg, RegCache::GEN_TEMP0);
+	}
+
+	regCache_.Unlock(liveReg, RegCache::VEC_QUAD_LIVE);
+	regCache_.Unlock(colorOff0Reg, RegCache::GEN_COLOR_OFF);
+	regCache_.Unlock(colorOff1Reg, RegCache::GEN_QUAD_COLOR_OFF1);
+	regCache_.Release(resultReg, RegCache::VEC_TEMP0);
+	regCache_.Release(tempReg, RegCache::VEC_TEMP1);
+	return true;
+}
+
 };
 
 #endif
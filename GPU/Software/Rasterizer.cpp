@@ -111,6 +111,7 @@ static inline Vec4<float> Interpolate(const float &c0, const float &c1, const fl
 void ComputeRasterizerState(RasterizerState *state, BinManager *binner) {
 	ComputePixelFuncID(&state->pixelID);
 	state->drawPixel = Rasterizer::GetSingleFunc(state->pixelID, binner);
+	state->drawQuad = Rasterizer::GetQuadFunc(state->pixelID);
 
 	state->enableTextures = gstate.isTextureMapEnabled() && !state->pixelID.clearMode;
 	if (state->enableTextures) {
@@ -434,6 +435,7 @@ static bool ApplyStateOptimizations(RasterizerState *state, const RasterizerStat
 		// Can't compile during runtime.  This failing is a bit of a problem when undoing...
 		if (drawPixel) {
 			state->drawPixel = drawPixel;
+			state->drawQuad = Rasterizer::GetQuadFunc(pixelID);
 			memcpy(&state->pixelID, &pixelID, sizeof(PixelFuncID));
 			state->flags = ReplacePixelIDFlags(state->flags, optimize) | RasterizerStateFlags::OPTIMIZED;
 			changed = true;
@@ -680,7 +682,7 @@ static inline void ApplyTexturing(const RasterizerState &state, Vec4<int> *prim_
 	bool bilinear;
 	CalculateSamplingParams(ds, dt, w, state, level, levelFrac, bilinear);
 
-	PROFILE_THIS_SCOPE("sampler");
+	PROFILE_THIS_SCOPE_UNTRACED("sampler");
 	for (int i = 0; i < 4; ++i) {
 		if (mask[i] >= 0)
 			prim_color[i] = ApplyTexturing(s[i], t[i], ToVec4IntArg(prim_color[i]), level, levelFrac, bilinear, state);
@@ -1065,7 +1067,20 @@ void DrawTriangleSlice(
 					}
 				}
 
-				PROFILE_THIS_SCOPE("draw_tri_px");
+				PROFILE_THIS_SCOPE_UNTRACED("draw_tri_px");
+#if !defined(SOFTGPU_MEMORY_TAGGING_DETAILED)
+				if (!clearMode && state.drawQuad) {
+					PixelQuadArgs quad;
+					for (int i = 0; i < 4; ++i)
+						quad.color[i] = prim_color[i];
+					quad.z = z;
+					quad.fog = fog;
+					quad.mask = mask;
+					state.drawQuad(p.x, p.y, quad, pixelID);
+					continue;
+				}
+#endif
+
 				DrawingCoords subp = p;
 				for (int i = 0; i < 4; ++i) {
 					if (mask[i] < 0) {
@@ -1265,7 +1280,20 @@ void DrawRectangle(const VertexData &v0, const VertexData &v1, const BinCoords &
 				}
 			}
 
-			PROFILE_THIS_SCOPE("draw_rect_px");
+			PROFILE_THIS_SCOPE_UNTRACED("draw_rect_px");
+#if !defined(SOFTGPU_MEMORY_TAGGING_DETAILED)
+			if (state.drawQuad) {
+				PixelQuadArgs quad;
+				for (int i = 0; i < 4; ++i)
+					quad.color[i] = prim_color[i];
+				quad.z = z;
+				quad.fog = fog;
+				quad.mask = mask;
+				state.drawQuad(p.x, p.y, quad, state.pixelID);
+				continue;
+			}
+#endif
+
 			DrawingCoords subp = p;
 			for (int i = 0; i < 4; ++i) {
 				if (mask[i] < 0) {
@@ -1342,7 +1370,7 @@ void DrawPoint(const VertexData &v0, const BinCoords &range, const RasterizerSta
 		int texLevelFrac;
 		bool bilinear;
 		CalculateSamplingParams(0.0f, 0.0f, v0.clipw, state, texLevel, texLevelFrac, bilinear);
-		PROFILE_THIS_SCOPE("sampler");
+		PROFILE_THIS_SCOPE_UNTRACED("sampler");
 		prim_color = ApplyTexturingSingle(s, t, ToVec4IntArg(prim_color), texLevel, texLevelFrac, bilinear, state);
 	}
 
@@ -1354,7 +1382,7 @@ void DrawPoint(const VertexData &v0, const BinCoords &range, const RasterizerSta
 		fog = ClampFogDepth(v0.fogdepth);
 	}
 
-	PROFILE_THIS_SCOPE("draw_px");
+	PROFILE_THIS_SCOPE_UNTRACED("draw_px");
 	state.drawPixel(p.x, p.y, z, fog, ToVec4IntArg(prim_color), pixelID);
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
@@ -1686,14 +1714,14 @@ void DrawLine(const VertexData &v0, const VertexData &v1, const BinCoords &range
 					texBilinear = true;
 				}
 
-				PROFILE_THIS_SCOPE("sampler");
+				PROFILE_THIS_SCOPE_UNTRACED("sampler");
 				prim_color = ApplyTexturingSingle(s, t, ToVec4IntArg(prim_color), texLevel, texLevelFrac, texBilinear, state);
 			}
 
 			if (!pixelID.clearMode)
 				prim_color += Vec4<int>(sec_color, 0);
 
-			PROFILE_THIS_SCOPE("draw_px");
+			PROFILE_THIS_SCOPE_UNTRACED("draw_px");
 			state.drawPixel(p.x, p.y, z, fog, ToVec4IntArg(prim_color), pixelID);
 
 #if defined(SOFTGPU_MEMORY_TAGGING_DETAILED) || defined(SOFTGPU_MEMORY_TAGGING_BASIC)
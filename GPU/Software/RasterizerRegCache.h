@@ -108,6 +108,14 @@ struct RegCache {
 		VEC_V1 = 0x0004,
 		VEC_INDEX = 0x0005,
 		VEC_INDEX1 = 0x0006,
+		VEC_QUAD_R = 0x0010,
+		VEC_QUAD_G = 0x0011,
+		VEC_QUAD_B = 0x0012,
+		VEC_QUAD_A = 0x0013,
+		VEC_QUAD_LIVE = 0x0014,
+		VEC_QUAD_Z = 0x0015,
+		VEC_QUAD_DITHER = 0x0016,
+		VEC_QUAD_DST = 0x0017,
 
 		GEN_SRC_ALPHA = 0x0100,
 		GEN_ID = 0x0101,
@@ -116,6 +124,8 @@ struct RegCache {
 		GEN_DEPTH_OFF = 0x0105,
 		GEN_RESULT = 0x0106,
 		GEN_SHIFTVAL = 0x0107,
+		GEN_QUAD_COLOR_OFF1 = 0x0108,
+		GEN_QUAD_DEPTH_OFF1 = 0x0109,
 
 		GEN_ARG_X = 0x0180,
 		GEN_ARG_Y = 0x0181,
@@ -130,6 +140,7 @@ struct RegCache {
 		GEN_ARG_TEXPTR_PTR = 0x018A,
 		GEN_ARG_BUFW_PTR = 0x018B,
 		GEN_ARG_LEVELFRAC = 0x018C,
+		GEN_ARG_QUAD = 0x018D,
 		VEC_ARG_COLOR = 0x0080,
 		VEC_ARG_MASK = 0x0081,
 		VEC_ARG_U = 0x0082,
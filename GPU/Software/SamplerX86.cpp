@@ -1325,6 +1325,8 @@ bool SamplerJitCache::Jit_ReadClutQuad(const SamplerID &id, bool level1) {
 	return true;
 }
 
+// The four texels of a bilinear sample fit in one xmm, so this stays 128-bit even with AVX2.
+// The AVX2 wins for linear filtering are in the gathers in Jit_GetDataQuad / Jit_ReadClutQuad.
 bool SamplerJitCache::Jit_BlendQuad(const SamplerID &id, bool level1) {
 	Describe(level1 ? "BlendQuadMips" : "BlendQuad");
 
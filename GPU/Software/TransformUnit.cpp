@@ -342,7 +342,7 @@ void ComputeTransformState(TransformState *state, const VertexReader &vreader) {
 }
 
 ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const TransformState &state) {
-	PROFILE_THIS_SCOPE("read_vert");
+	PROFILE_THIS_SCOPE_UNTRACED("read_vert");
 	// If we ever thread this, we'll have to change this.
 	ClipVertexData vertex;
 
@@ -446,7 +446,7 @@ ClipVertexData TransformUnit::ReadVertex(const VertexReader &vreader, const Tran
 			Lighting::GenerateLightST(vertex.v, worldnormal);
 		}
 
-		PROFILE_THIS_SCOPE("light");
+		PROFILE_THIS_SCOPE_UNTRACED("light");
 		if (state.enableLighting)
 			Lighting::Process(vertex.v, worldpos, worldnormal, state.lightingState);
 	} else {
@@ -58,17 +58,14 @@ enum {
 	VERTEX_CACHE_SIZE = 8192 * 1024
 };
 
-#define VERTEXCACHE_DECIMATION_INTERVAL 17
 #define DESCRIPTORSET_DECIMATION_INTERVAL 1  // Temporarily cut to 1. Handle reuse breaks this when textures get deleted.
 
-enum { VAI_KILL_AGE = 120, VAI_UNRELIABLE_KILL_AGE = 240, VAI_UNRELIABLE_KILL_MAX = 4 };
-
 enum {
 	TRANSFORMED_VERTEX_BUFFER_SIZE = VERTEX_BUFFER_MAX * sizeof(TransformedVertex)
 };
 
 DrawEngineVulkan::DrawEngineVulkan(Draw::DrawContext *draw)
-	: draw_(draw), vai_(1024) {
+	: draw_(draw) {
 	decOptions_.expandAllWeightsToFloat = false;
 	decOptions_.expand8BitNormalsToFloat = false;
 #if PPSSPP_PLATFORM(MAC) || PPSSPP_PLATFORM(IOS)
@@ -273,10 +270,7 @@ void DrawEngineVulkan::DestroyDeviceObjects() {
 	}
 
 	// Need to clear this to get rid of all remaining references to the dead buffers.
-	vai_.Iterate([](uint32_t hash, VertexArrayInfoVulkan *vai) {
-		delete vai;
-	});
-	vai_.Clear();
+	ClearTrackedVertexArrays();
 }
 
 void DrawEngineVulkan::DeviceLost() {
@@ -292,8 +286,6 @@ void DrawEngineVulkan::DeviceRestore(Draw::DrawContext *draw) {
 }
 
 void DrawEngineVulkan::BeginFrame() {
-	gpuStats.numTrackedVertexArrays = (int)vai_.size();
-
 	lastPipeline_ = nullptr;
 
 	FrameData *frame = &GetCurFrame();
@@ -321,10 +313,8 @@ void DrawEngineVulkan::BeginFrame() {
 		vertexCache_->Destroy(vulkan);
 		delete vertexCache_;  // orphans the buffers, they'll get deleted once no longer used by an in-flight frame.
 		vertexCache_ = new VulkanPushBuffer(vulkan, "vertexCacheR", VERTEX_CACHE_SIZE, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, PushBufferType::CPU_TO_GPU);
-		vai_.Iterate([&](uint32_t hash, VertexArrayInfoVulkan *vai) {
-			delete vai;
-		});
-		vai_.Clear();
+		// The decoded data is still good, it'll just get uploaded again.
+		vertexDataCache_.ReleaseBackendData();
 	}
 
 	vertexCache_->BeginNoReset();
@@ -334,28 +324,7 @@ void DrawEngineVulkan::BeginFrame() {
 		descDecimationCounter_ = DESCRIPTORSET_DECIMATION_INTERVAL;
 	}
 
-	if (--decimationCounter_ <= 0) {
-		decimationCounter_ = VERTEXCACHE_DECIMATION_INTERVAL;
-
-		const int threshold = gpuStats.numFlips - VAI_KILL_AGE;
-		const int unreliableThreshold = gpuStats.numFlips - VAI_UNRELIABLE_KILL_AGE;
-		int unreliableLeft = VAI_UNRELIABLE_KILL_MAX;
-		vai_.Iterate([&](uint32_t hash, VertexArrayInfoVulkan *vai) {
-			bool kill;
-			if (vai->status == VertexArrayInfoVulkan::VAI_UNRELIABLE) {
-				// We limit killing unreliable so we don't rehash too often.
-				kill = vai->lastFrame < unreliableThreshold && --unreliableLeft >= 0;
-			} else {
-				kill = vai->lastFrame < threshold;
-			}
-			if (kill) {
-				// This is actually quite safe.
-				vai_.Remove(hash);
-				delete vai;
-			}
-		});
-	}
-	vai_.Maintain();
+	DecimateTrackedVertexArrays();
 }
 
 void DrawEngineVulkan::EndFrame() {
@@ -539,10 +508,10 @@ void DrawEngineVulkan::DirtyAllUBOs() {
 	gstate_c.Dirty(DIRTY_TEXTURE_IMAGE);
 }
 
-void MarkUnreliable(VertexArrayInfoVulkan *vai) {
-	vai->status = VertexArrayInfoVulkan::VAI_UNRELIABLE;
+void DrawEngineVulkan::ReleaseCachedVertexData(CachedVertexData *data) {
 	// TODO: If we change to a real allocator, free the data here.
 	// For now we just leave it in the pushbuffer.
+	delete (CachedVertexBuffersVulkan *)data->backendData;
 }
 
 void DrawEngineVulkan::Invalidate(InvalidationCallbackFlags flags) {
@@ -594,156 +563,41 @@ void DrawEngineVulkan::DoFlush() {
 		int vertexCount = 0;
 		bool useElements = true;
 
-		// Cannot cache vertex data with morph enabled.
-		bool useCache = g_Config.bVertexCache && !(lastVType_ & GE_VTYPE_MORPHCOUNT_MASK);
-		// Also avoid caching when software skinning.
 		VkBuffer vbuf = VK_NULL_HANDLE;
 		VkBuffer ibuf = VK_NULL_HANDLE;
-		if (decOptions_.applySkinInDecode && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
-			useCache = false;
-		}
-
-		if (useCache) {
-			PROFILE_THIS_SCOPE("vcache");
-			u32 id = dcid_ ^ gstate.getUVGenMode();  // This can have an effect on which UV decoder we need to use! And hence what the decoded data will look like. See #9263
-			VertexArrayInfoVulkan *vai = vai_.Get(id);
-			if (!vai) {
-				vai = new VertexArrayInfoVulkan();
-				vai_.Insert(id, vai);
-			}
-
-			switch (vai->status) {
-			case VertexArrayInfoVulkan::VAI_NEW:
-			{
-				// Haven't seen this one before. We don't actually upload the vertex data yet.
-				uint64_t dataHash = ComputeHash();
-				vai->hash = dataHash;
-				vai->minihash = ComputeMiniHash();
-				vai->status = VertexArrayInfoVulkan::VAI_HASHING;
-				vai->drawsUntilNextFullHash = 0;
-				DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);  // writes to indexGen
-				vai->numVerts = indexGen.VertexCount();
-				vai->prim = indexGen.Prim();
-				vai->maxIndex = indexGen.MaxIndex();
-				vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
-				goto rotateVBO;
-			}
-
-			// Hashing - still gaining confidence about the buffer.
-			// But if we get this far it's likely to be worth uploading the data.
-			case VertexArrayInfoVulkan::VAI_HASHING:
-			{
-				PROFILE_THIS_SCOPE("vcachehash");
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
-				}
-				if (vai->drawsUntilNextFullHash == 0) {
-					// Let's try to skip a full hash if mini would fail.
-					const u32 newMiniHash = ComputeMiniHash();
-					uint64_t newHash = vai->hash;
-					if (newMiniHash == vai->minihash) {
-						newHash = ComputeHash();
-					}
-					if (newMiniHash != vai->minihash || newHash != vai->hash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
-					if (vai->numVerts > 64) {
-						// exponential backoff up to 16 draws, then every 24
-						vai->drawsUntilNextFullHash = std::min(24, vai->numFrames);
-					} else {
-						// Lower numbers seem much more likely to change.
-						vai->drawsUntilNextFullHash = 0;
-					}
-					// TODO: tweak
-					//if (vai->numFrames > 1000) {
-					//	vai->status = VertexArrayInfo::VAI_RELIABLE;
-					//}
-				} else {
-					vai->drawsUntilNextFullHash--;
-					u32 newMiniHash = ComputeMiniHash();
-					if (newMiniHash != vai->minihash) {
-						MarkUnreliable(vai);
-						DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
-						goto rotateVBO;
-					}
-				}
-
-				if (!vai->vb) {
-					// Directly push to the vertex cache.
-					DecodeVertsToPushBuffer(vertexCache_, &vai->vbOffset, &vai->vb);
-					_dbg_assert_msg_(gstate_c.vertBounds.minV >= gstate_c.vertBounds.maxV, "Should not have checked UVs when caching.");
-					vai->numVerts = indexGen.VertexCount();
-					vai->maxIndex = indexGen.MaxIndex();
-					vai->flags = gstate_c.vertexFullAlpha ? VAIVULKAN_FLAG_VERTEXFULLALPHA : 0;
-					if (forceIndexed) {
-						vai->prim = indexGen.GeneralPrim();
-						useElements = true;
-					} else {
-						vai->prim = indexGen.Prim();
-						useElements = !indexGen.SeenOnlyPurePrims();
-						if (!useElements && indexGen.PureCount()) {
-							vai->numVerts = indexGen.PureCount();
-						}
-					}
-
-					if (useElements) {
-						u32 size = sizeof(uint16_t) * indexGen.VertexCount();
-						void *dest = vertexCache_->Push(size, &vai->ibOffset, &vai->ib);
-						memcpy(dest, decIndex, size);
-					} else {
-						vai->ib = VK_NULL_HANDLE;
-						vai->ibOffset = 0;
-					}
-				} else {
-					gpuStats.numCachedDrawCalls++;
-					useElements = vai->ib ? true : false;
-					gpuStats.numCachedVertsDrawn += vai->numVerts;
-					gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
-				}
-				vbuf = vai->vb;
-				ibuf = vai->ib;
-				vbOffset = vai->vbOffset;
-				ibOffset = vai->ibOffset;
-				vertexCount = vai->numVerts;
-				prim = static_cast<GEPrimitiveType>(vai->prim);
-				break;
-			}
 
-			// Reliable - we don't even bother hashing anymore. Right now we don't go here until after a very long time.
-			case VertexArrayInfoVulkan::VAI_RELIABLE:
-			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
+		CachedVertexData *cached = GetCachedVertexData();
+		if (cached) {
+			CachedVertexBuffersVulkan *buffers = (CachedVertexBuffersVulkan *)cached->backendData;
+			if (!buffers) {
+				// Directly push to the vertex cache, it stays there until the cache is wiped.
+				buffers = new CachedVertexBuffersVulkan();
+				size_t size = cached->verts.size();
+				void *dest = vertexCache_->Push(size, &buffers->vbOffset, &buffers->vb);
+				memcpy(dest, cached->verts.data(), size);
+				if (forceIndexed || !cached->seenOnlyPurePrims) {
+					size = sizeof(uint16_t) * cached->indexCount;
+					dest = vertexCache_->Push(size, &buffers->ibOffset, &buffers->ib);
+					memcpy(dest, cached->inds.data(), size);
 				}
-				gpuStats.numCachedDrawCalls++;
-				gpuStats.numCachedVertsDrawn += vai->numVerts;
-				vbuf = vai->vb;
-				ibuf = vai->ib;
-				vbOffset = vai->vbOffset;
-				ibOffset = vai->ibOffset;
-				vertexCount = vai->numVerts;
-				prim = static_cast<GEPrimitiveType>(vai->prim);
-
-				gstate_c.vertexFullAlpha = vai->flags & VAIVULKAN_FLAG_VERTEXFULLALPHA;
-				break;
+				cached->backendData = buffers;
 			}
 
-			case VertexArrayInfoVulkan::VAI_UNRELIABLE:
-			{
-				vai->numDraws++;
-				if (vai->lastFrame != gpuStats.numFlips) {
-					vai->numFrames++;
+			vertexCount = cached->indexCount;
+			if (forceIndexed) {
+				prim = (GEPrimitiveType)cached->generalPrim;
+			} else {
+				useElements = !cached->seenOnlyPurePrims;
+				if (!useElements && cached->pureCount) {
+					vertexCount = cached->pureCount;
 				}
-				DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
-				goto rotateVBO;
-			}
-			default:
-				break;
+				prim = (GEPrimitiveType)cached->prim;
 			}
+			vbuf = buffers->vb;
+			ibuf = buffers->ib;
+			vbOffset = buffers->vbOffset;
+			ibOffset = buffers->ibOffset;
+			gstate_c.vertexFullAlpha = cached->vertexFullAlpha;
 		} else {
 			if (decOptions_.applySkinInDecode && (lastVType_ & GE_VTYPE_WEIGHT_MASK)) {
 				// If software skinning, we've already predecoded into "decoded". So push that content.
@@ -755,7 +609,6 @@ void DrawEngineVulkan::DoFlush() {
 				DecodeVertsToPushBuffer(frameData.pushVertex, &vbOffset, &vbuf);
 			}
 
-	rotateVBO:
 			gpuStats.numUncachedVertsDrawn += indexGen.VertexCount();
 
 			vertexCount = indexGen.VertexCount();
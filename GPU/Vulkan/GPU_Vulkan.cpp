@@ -463,6 +463,7 @@ void GPU_Vulkan::InitDeviceObjects() {
 	if (hacks) {
 		rm->GetQueueRunner()->EnableHacks(hacks);
 	}
+	rm->GetQueueRunner()->SetSkipDrawsWhileCompiling(g_Config.bSkipDrawsWhileCompiling);
 }
 
 void GPU_Vulkan::DestroyDeviceObjects() {
@@ -479,8 +480,10 @@ void GPU_Vulkan::DestroyDeviceObjects() {
 	// Need to turn off hacks when shutting down the GPU. Don't want them running in the menu.
 	if (draw_) {
 		VulkanRenderManager *rm = (VulkanRenderManager *)draw_->GetNativeObject(Draw::NativeObject::RENDER_MANAGER);
-		if (rm)
+		if (rm) {
 			rm->GetQueueRunner()->EnableHacks(0);
+			rm->GetQueueRunner()->SetSkipDrawsWhileCompiling(false);
+		}
 	}
 }
 
@@ -588,7 +588,11 @@ void TextureCacheVulkan::BuildTexture(TexCacheEntry *const entry) {
 			} else {
 				data = drawEngine_->GetPushBufferForTextureData()->PushAligned(sz, &bufferOffset, &texBuf, pushAlignment);
 			}
-			LoadVulkanTextureLevel(*entry, (uint8_t *)data, lstride, srcLevel, lfactor, actualFmt);
+			if (!LoadScaledTextureLevel(*entry, (uint8_t *)data, lstride, plan, srcLevel)) {
+				if (plan.asyncScaleFactor > 1 && srcLevel == plan.baseLevelSrc)
+					StartScaleJob(*entry, plan, srcLevel, TexDecodeFlags{});
+				LoadVulkanTextureLevel(*entry, (uint8_t *)data, lstride, srcLevel, lfactor, actualFmt);
+			}
 			if (plan.saveTexture)
 				bufferOffset = drawEngine_->GetPushBufferForTextureData()->PushAligned(&saveData[0], sz, pushAlignment, &texBuf);
 		};
@@ -388,6 +388,7 @@ static const JitDisableFlag jitDisableFlags[] = {
 	{ MIPSComp::JitDisable::CACHE_POINTERS, "Cached pointers" },
 	{ MIPSComp::JitDisable::REGALLOC_GPR, "GPR Regalloc across instructions" },
 	{ MIPSComp::JitDisable::REGALLOC_FPR, "FPR Regalloc across instructions" },
+	{ MIPSComp::JitDisable::SUPERBLOCKS, "IR superblocks" },
 };
 
 void JitDebugScreen::CreateViews() {
@@ -409,7 +409,7 @@ void GameSettingsScreen::CreateViews() {
 		return UI::EVENT_CONTINUE;
 	});
 	vtxCache->SetEnabledFunc([] {
-		return !g_Config.bSoftwareRendering && g_Config.bHardwareTransform && g_Config.iGPUBackend != (int)GPUBackend::OPENGL;
+		return !g_Config.bSoftwareRendering && g_Config.bHardwareTransform;
 	});
 
 	CheckBox *texBackoff = graphicsSettings->Add(new CheckBox(&g_Config.bTextureBackoffCache, gr->T("Lazy texture caching", "Lazy texture caching (speedup)")));
@@ -586,6 +586,10 @@ void GameSettingsScreen::CreateViews() {
 	reverbVolume->SetEnabledPtr(&g_Config.bEnableSound);
 	reverbVolume->SetZeroLabel(a->T("Disabled"));
 
+	static const char *resamplers[] = { "Linear (fast)", "Sinc (better quality)" };
+	PopupMultiChoice *resampler = audioSettings->Add(new PopupMultiChoice(&g_Config.iAudioResampler, a->T("Audio resampler"), resamplers, 0, ARRAY_SIZE(resamplers), a->GetName(), screenManager()));
+	resampler->SetEnabledPtr(&g_Config.bEnableSound);
+
 	// Hide the backend selector in UWP builds (we only support XAudio2 there).
 #if PPSSPP_PLATFORM(WINDOWS) && !PPSSPP_PLATFORM(UWP)
 	if (IsVistaOrHigher()) {
@@ -986,6 +990,8 @@ void GameSettingsScreen::CreateViews() {
 	lockedMhz->SetZeroLabel(sy->T("Auto"));
 	PopupSliderChoice *rewindFreq = systemSettings->Add(new PopupSliderChoice(&g_Config.iRewindFlipFrequency, 0, 1800, sy->T("Rewind Snapshot Frequency", "Rewind Snapshot Frequency (mem hog)"), screenManager(), sy->T("frames, 0:off")));
 	rewindFreq->SetZeroLabel(sy->T("Off"));
+	PopupSliderChoice *rewindBuffer = systemSettings->Add(new PopupSliderChoice(&g_Config.iRewindBufferSizeMB, 32, 2048, sy->T("Rewind Memory Budget"), 32, screenManager(), sy->T("MB")));
+	rewindBuffer->SetEnabledFunc([] { return g_Config.iRewindFlipFrequency != 0; });
 
 	systemSettings->Add(new ItemHeader(sy->T("General")));
 
@@ -1715,11 +1721,12 @@ void DeveloperToolsScreen::CreateViews() {
 	// iOS can now use JIT on all modes, apparently.
 	// The bool may come in handy for future non-jit platforms though (UWP XB1?)
 
-	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter"};
+	static const char *cpuCores[] = {"Interpreter", "Dynarec (JIT)", "IR Interpreter", "JIT using IR"};
 	PopupMultiChoice *core = list->Add(new PopupMultiChoice(&g_Config.iCpuCore, gr->T("CPU Core"), cpuCores, 0, ARRAY_SIZE(cpuCores), sy->GetName(), screenManager()));
 	core->OnChoice.Handle(this, &DeveloperToolsScreen::OnJitAffectingSetting);
 	if (!canUseJit) {
 		core->HideChoice(1);
+		core->HideChoice(3);
 	}
 
 	list->Add(new Choice(dev->T("JIT debug tools")))->OnClick.Handle(this, &DeveloperToolsScreen::OnJitDebugTools);
@@ -756,11 +756,12 @@ void NativeInit(int argc, const char *argv[], const char *savegame_dir, const ch
 		}
 	}
 
-	if (System_GetPropertyBool(SYSPROP_CAN_JIT) == false && g_Config.iCpuCore == (int)CPUCore::JIT) {
+	if (System_GetPropertyBool(SYSPROP_CAN_JIT) == false && CpuCoreUsesNativeJit((CPUCore)g_Config.iCpuCore)) {
 		// Just gonna force it to the IR interpreter on startup.
 		// We don't hide the option, but we make sure it's off on bootup. In case someone wants
 		// to experiment in future iOS versions or something...
 		jitForcedOff = true;
+		jitForcedOffCore = g_Config.iCpuCore;
 	}
 
 	auto des = GetI18NCategory("DesktopUI");
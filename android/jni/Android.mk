@@ -158,6 +158,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Common/File/VFS/VFS.cpp \
   $(SRC)/Common/File/VFS/AssetReader.cpp \
   $(SRC)/Common/File/DiskFree.cpp \
+  $(SRC)/Common/File/MappedFile.cpp \
   $(SRC)/Common/File/Path.cpp \
   $(SRC)/Common/File/PathBrowser.cpp \
   $(SRC)/Common/File/FileUtil.cpp \
@@ -241,7 +242,9 @@ ARCH_FILES := \
   $(SRC)/Core/MIPS/x86/CompVFPU.cpp \
   $(SRC)/Core/MIPS/x86/CompReplace.cpp \
   $(SRC)/Core/MIPS/x86/Asm.cpp \
+  $(SRC)/Core/MIPS/x86/IRToX86.cpp \
   $(SRC)/Core/MIPS/x86/Jit.cpp \
+  $(SRC)/Core/MIPS/x86/X64IRJit.cpp \
   $(SRC)/Core/MIPS/x86/JitSafeMem.cpp \
   $(SRC)/Core/MIPS/x86/RegCache.cpp \
   $(SRC)/Core/MIPS/x86/RegCacheFPU.cpp \
@@ -257,7 +260,9 @@ ARCH_FILES := \
   $(SRC)/Core/MIPS/x86/CompVFPU.cpp \
   $(SRC)/Core/MIPS/x86/CompReplace.cpp \
   $(SRC)/Core/MIPS/x86/Asm.cpp \
+  $(SRC)/Core/MIPS/x86/IRToX86.cpp \
   $(SRC)/Core/MIPS/x86/Jit.cpp \
+  $(SRC)/Core/MIPS/x86/X64IRJit.cpp \
   $(SRC)/Core/MIPS/x86/JitSafeMem.cpp \
   $(SRC)/Core/MIPS/x86/RegCache.cpp \
   $(SRC)/Core/MIPS/x86/RegCacheFPU.cpp \
@@ -327,6 +332,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/MIPS/MIPSDebugInterface.cpp \
   $(SRC)/Core/MIPS/IR/IRFrontend.cpp \
   $(SRC)/Core/MIPS/IR/IRJit.cpp \
+  $(SRC)/Core/MIPS/IR/IRNativeCommon.cpp \
   $(SRC)/Core/MIPS/IR/IRCompALU.cpp \
   $(SRC)/Core/MIPS/IR/IRCompBranch.cpp \
   $(SRC)/Core/MIPS/IR/IRCompFPU.cpp \
@@ -354,6 +360,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/GPU/Common/GPUStateUtils.cpp.arm \
   $(SRC)/GPU/Common/SoftwareTransformCommon.cpp.arm \
   $(SRC)/GPU/Common/ReinterpretFramebuffer.cpp \
+  $(SRC)/GPU/Common/VertexCache.cpp \
   $(SRC)/GPU/Common/VertexDecoderCommon.cpp.arm \
   $(SRC)/GPU/Common/TextureCacheCommon.cpp.arm \
   $(SRC)/GPU/Common/TextureScalerCommon.cpp.arm \
@@ -425,6 +432,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/FileLoaders/HTTPFileLoader.cpp \
   $(SRC)/Core/FileLoaders/LocalFileLoader.cpp \
   $(SRC)/Core/FileLoaders/RamCachingFileLoader.cpp \
+  $(SRC)/Core/FileLoaders/ReadAheadFileLoader.cpp \
   $(SRC)/Core/FileLoaders/RetryingFileLoader.cpp \
   $(SRC)/Core/MemFault.cpp \
   $(SRC)/Core/MemMap.cpp \
@@ -432,6 +440,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/Reporting.cpp \
   $(SRC)/Core/Replay.cpp \
   $(SRC)/Core/SaveState.cpp \
+  $(SRC)/Core/SaveStateRewind.cpp \
   $(SRC)/Core/Screenshot.cpp \
   $(SRC)/Core/System.cpp \
   $(SRC)/Core/TextureReplacer.cpp \
@@ -456,6 +465,7 @@ EXEC_AND_LIB_FILES := \
   $(SRC)/Core/Debugger/WebSocket/LogBroadcaster.cpp \
   $(SRC)/Core/Debugger/WebSocket/MemorySubscriber.cpp \
   $(SRC)/Core/Debugger/WebSocket/MemoryInfoSubscriber.cpp \
+  $(SRC)/Core/Debugger/WebSocket/ProfilerSubscriber.cpp \
   $(SRC)/Core/Debugger/WebSocket/ReplaySubscriber.cpp \
   $(SRC)/Core/Debugger/WebSocket/SteppingBroadcaster.cpp \
   $(SRC)/Core/Debugger/WebSocket/SteppingSubscriber.cpp \
@@ -736,7 +746,9 @@ ifeq ($(HEADLESS),1)
   LOCAL_SRC_FILES := \
     $(SRC)/headless/Headless.cpp \
     $(SRC)/headless/StubHost.cpp \
-    $(SRC)/headless/Compare.cpp
+    $(SRC)/headless/Benchmark.cpp \
+    $(SRC)/headless/Compare.cpp \
+    $(SRC)/headless/TestQueue.cpp
 
   include $(BUILD_EXECUTABLE)
 endif
@@ -786,8 +798,16 @@ ifeq ($(UNITTEST),1)
     $(SRC)/unittest/JitHarness.cpp \
     $(SRC)/unittest/TestIRPassSimplify.cpp \
     $(SRC)/unittest/TestShaderGenerators.cpp \
+    $(SRC)/unittest/TestBinManager.cpp \
     $(SRC)/unittest/TestSoftwareGPUJit.cpp \
     $(SRC)/unittest/TestThreadManager.cpp \
+    $(SRC)/unittest/TestIRToNative.cpp \
+    $(SRC)/unittest/TestCoreTiming.cpp \
+    $(SRC)/unittest/TestBlockDevices.cpp \
+    $(SRC)/unittest/TestStereoResampler.cpp \
+    $(SRC)/unittest/TestTextureDecoder.cpp \
+    $(SRC)/unittest/TestSaveStateRewind.cpp \
+    $(SRC)/unittest/TestReadAheadFileLoader.cpp \
     $(SRC)/unittest/TestVertexJit.cpp \
     $(TESTARMEMITTER_FILE) \
     $(SRC)/unittest/UnitTest.cpp
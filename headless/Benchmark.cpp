@@ -0,0 +1,182 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
+#include "Core/HLE/HLE.h"
+#include "Core/HLE/sceKernel.h"
+#include "Core/MIPS/JitCommon/JitCommon.h"
+#include "GPU/GPU.h"
+#include "headless/Benchmark.h"
+
+void BenchmarkResults::BeginTest(const std::string &name) {
+	tests_.push_back(Test{ name });
+}
+
+void BenchmarkResults::BeginRun() {
+	if (tests_.empty())
+		BeginTest("");
+	tests_.back().runs++;
+}
+
+void BenchmarkResults::Add(const std::string &metric, double value) {
+	if (tests_.empty())
+		BeginTest("");
+
+	std::vector<Metric> &metrics = tests_.back().metrics;
+	auto it = std::find_if(metrics.begin(), metrics.end(), [&](const Metric &m) {
+		return m.name == metric;
+	});
+	if (it == metrics.end()) {
+		metrics.push_back(Metric{ metric });
+		it = metrics.end() - 1;
+	}
+	it->samples.push_back(value);
+}
+
+int BenchmarkResults::NumRuns() const {
+	return tests_.empty() ? 0 : tests_.back().runs;
+}
+
+const BenchmarkResults::Metric *BenchmarkResults::FindMetric(const std::string &metric) const {
+	if (tests_.empty())
+		return nullptr;
+	for (const Metric &m : tests_.back().metrics) {
+		if (m.name == metric)
+			return &m;
+	}
+	return nullptr;
+}
+
+bool BenchmarkResults::HasMetric(const std::string &metric) const {
+	return FindMetric(metric) != nullptr;
+}
+
+BenchmarkResults::Summary BenchmarkResults::Summarize(const std::string &metric) const {
+	const Metric *m = FindMetric(metric);
+	return m ? SummarizeSamples(m->samples) : Summary();
+}
+
+BenchmarkResults::Summary BenchmarkResults::SummarizeSamples(std::vector<double> samples) {
+	Summary summary;
+	if (samples.empty())
+		return summary;
+
+	std::sort(samples.begin(), samples.end());
+	const size_t n = samples.size();
+	summary.min = samples[0];
+	summary.median = (n & 1) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) * 0.5;
+	// Nearest rank, so with few runs this is just the slowest.
+	size_t rank = (size_t)ceil(n * 0.95);
+	summary.p95 = samples[std::max(rank, (size_t)1) - 1];
+	return summary;
+}
+
+void BenchmarkResults::PrintTest() const {
+	if (NumRuns() == 0)
+		return;
+
+	Summary wall = Summarize("wall_ms");
+	printf("    %d runs, median %0.2f ms (min %0.2f, p95 %0.2f): ", NumRuns(), wall.median, wall.min, wall.p95);
+	// GE dump replays don't run the CPU at all.
+	if (HasMetric("cpu_ms"))
+		printf("cpu %0.2f, jit %0.2f, hle %0.2f, ", Summarize("cpu_ms").median, Summarize("jit_compile_ms").median, Summarize("hle_ms").median);
+	printf("gpu %0.2f ms, %d draws\n", Summarize("gpu_ms").median, (int)Summarize("draw_calls").median);
+}
+
+bool BenchmarkResults::WriteJSON(const Path &filename) const {
+	// Full precision just makes these harder to read.
+	auto writeValue = [](json::JsonWriter &writer, const char *name, double value) {
+		writer.writeRaw(name, StringFromFormat("%.4f", value));
+	};
+
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.pushArray("tests");
+	for (const Test &test : tests_) {
+		writer.pushDict();
+		writer.writeString("name", test.name);
+		writer.writeInt("runs", test.runs);
+		writer.pushDict("metrics");
+		for (const Metric &metric : test.metrics) {
+			Summary summary = SummarizeSamples(metric.samples);
+			writer.pushDict(metric.name);
+			writeValue(writer, "min", summary.min);
+			writeValue(writer, "median", summary.median);
+			writeValue(writer, "p95", summary.p95);
+			writer.pop();
+		}
+		writer.pop();
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+
+	return File::WriteStringToFile(true, writer.str(), filename);
+}
+
+void AddEmulatorStats(BenchmarkResults &results, double runSeconds) {
+	// These are all in seconds, despite some of the names.
+	const double jitSeconds = MIPSComp::jitStats.compileTime;
+	const double hleSeconds = kernelStats.msInSyscalls;
+
+	results.BeginRun();
+	results.Add("wall_ms", runSeconds * 1000.0);
+	// Most GE work happens inside syscalls like sceGeListUpdateStallAddr, so hle_ms includes
+	// a lot of gpu_ms.  What's left is mostly the emulated CPU and CoreTiming events.
+	results.Add("cpu_ms", std::max(0.0, runSeconds - jitSeconds - hleSeconds) * 1000.0);
+	results.Add("jit_compile_ms", jitSeconds * 1000.0);
+	results.Add("jit_blocks_compiled", MIPSComp::jitStats.numCompiles);
+	results.Add("hle_ms", hleSeconds * 1000.0);
+	AddGPUStats(results);
+
+	for (const auto &syscall : kernelStats.summedMsInSyscalls) {
+		const char *name = GetFuncName(syscall.first.first, syscall.first.second);
+		results.Add(std::string("hle_ms.") + name, syscall.second * 1000.0);
+	}
+}
+
+void AddGPUStats(BenchmarkResults &results) {
+	results.Add("gpu_ms", gpuStats.msProcessingDisplayLists * 1000.0);
+	results.Add("draw_calls", gpuStats.numDrawCalls);
+	results.Add("cached_draw_calls", gpuStats.numCachedDrawCalls);
+	results.Add("flushes", gpuStats.numFlushes);
+	results.Add("verts_submitted", gpuStats.numVertsSubmitted);
+	results.Add("textures_decoded", gpuStats.numTexturesDecoded);
+	results.Add("textures_hashed", gpuStats.numTexturesHashed);
+	results.Add("texture_bytes_hashed", gpuStats.numTextureDataBytesHashed);
+	results.Add("texture_invalidations", gpuStats.numTextureInvalidations);
+	results.Add("texture_invalidations_by_framebuffer", gpuStats.numTextureInvalidationsByFramebuffer);
+	results.Add("texture_switches", gpuStats.numTextureSwitches);
+	results.Add("shader_switches", gpuStats.numShaderSwitches);
+	results.Add("framebuffer_evaluations", gpuStats.numFramebufferEvaluations);
+	results.Add("readbacks", gpuStats.numReadbacks);
+	results.Add("uploads", gpuStats.numUploads);
+	results.Add("depal", gpuStats.numDepal);
+	results.Add("color_copies", gpuStats.numColorCopies);
+	results.Add("depth_copies", gpuStats.numDepthCopies);
+	results.Add("reinterpret_copies", gpuStats.numReinterpretCopies);
+	results.Add("copies_for_shader_blend", gpuStats.numCopiesForShaderBlend);
+	results.Add("copies_for_self_tex", gpuStats.numCopiesForSelfTex);
+	results.Add("clears", gpuStats.numClears);
+	results.Add("flips", gpuStats.numFlips);
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Common/File/Path.h"
+
+// Collects samples of named metrics over repeated runs of each test, and summarizes
+// them as min/median/p95, so that runs can be compared across commits.
+class BenchmarkResults {
+public:
+	struct Summary {
+		double min = 0.0;
+		double median = 0.0;
+		double p95 = 0.0;
+	};
+
+	// Following runs and samples are for this test.
+	void BeginTest(const std::string &name);
+	void BeginRun();
+	void Add(const std::string &metric, double value);
+
+	// Of the current test.
+	int NumRuns() const;
+	bool HasMetric(const std::string &metric) const;
+	Summary Summarize(const std::string &metric) const;
+	void PrintTest() const;
+
+	bool WriteJSON(const Path &filename) const;
+
+	static Summary SummarizeSamples(std::vector<double> samples);
+
+private:
+	struct Metric {
+		std::string name;
+		std::vector<double> samples;
+	};
+	struct Test {
+		std::string name;
+		int runs = 0;
+		std::vector<Metric> metrics;
+	};
+
+	const Metric *FindMetric(const std::string &metric) const;
+
+	std::vector<Test> tests_;
+};
+
+// Adds what the emulator measured during the last run, which needs coreCollectDebugStats.
+// The stats are reset in Core_UpdateDebugStats().
+void AddEmulatorStats(BenchmarkResults &results, double runSeconds);
+// Only the GPU part of that, for when the CPU isn't running.
+void AddGPUStats(BenchmarkResults &results);
@@ -5,6 +5,7 @@
 // > --root pspautotests/tests/../ --compare --timeout=5 --graphics=software pspautotests/tests/cpu/cpu_alu/cpu_alu.prx
 
 #include "ppsspp_config.h"
+#include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <limits>
@@ -37,13 +38,21 @@
 #include "Core/WebServer.h"
 #include "Core/HLE/sceUtility.h"
 #include "Core/Host.h"
+#include "Core/Loaders.h"
+#include "Core/MemMap.h"
 #include "Core/SaveState.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/HW/SasAudio.h"
+#include "GPU/GPU.h"
 #include "GPU/Common/FramebufferManagerCommon.h"
+#include "GPU/Debugger/Playback.h"
 #include "Log.h"
 #include "LogManager.h"
 
+#include "Benchmark.h"
 #include "Compare.h"
 #include "StubHost.h"
+#include "TestQueue.h"
 #if defined(_WIN32)
 #include "WindowsHeadlessHost.h"
 #elif defined(SDL)
@@ -139,14 +148,136 @@ int printUsage(const char *progname, const char *reason)
 	fprintf(stderr, "  -v, --verbose         show the full passed/failed result\n");
 	fprintf(stderr, "  -i                    use the interpreter\n");
 	fprintf(stderr, "  --ir                  use ir interpreter\n");
+	fprintf(stderr, "  --irjit               use jit using ir\n");
 	fprintf(stderr, "  -j                    use jit (default)\n");
 	fprintf(stderr, "  -c, --compare         compare with output in file.expected\n");
 	fprintf(stderr, "  --bench               run multiple times and output speed\n");
+	fprintf(stderr, "  --bench-json=FILE     like --bench, and write min/median/p95 of each stat as JSON\n");
+	fprintf(stderr, "  --gedump-bench=N      replay each .ppdmp N times in one run and time each replay\n");
+	fprintf(stderr, "  --jobs=N              run tests in N worker processes\n");
+	fprintf(stderr, "  --results-json=FILE   write the test results as JSON\n");
+	fprintf(stderr, "  --results-junit=FILE  write the test results as JUnit XML\n");
+	fprintf(stderr, "  --trace=FILE          write a Chrome trace (chrome://tracing, ui.perfetto.dev) of the tests\n");
+	fprintf(stderr, "  --compress-zstd=FILE  write the disc image as a seekable zstd image and exit\n");
+	fprintf(stderr, "  --zstd-level=NUMBER   compression level for --compress-zstd (default 19)\n");
+	fprintf(stderr, "  --gedump-uncompress=FILE  write the GE dump uncompressed, so it can be memory mapped, and exit\n");
+	fprintf(stderr, "  --bench-sas           time SAS mixing with 8, 16, and 32 voices and exit\n");
 	fprintf(stderr, "\nSee headless.txt for details.\n");
 
 	return 1;
 }
 
+static bool CompressDiscImage(const Path &filename, const Path &outputFilename, int level) {
+	FileLoader *fileLoader = ConstructFileLoader(filename);
+	BlockDevice *blockDevice = constructBlockDevice(fileLoader);
+	if (!blockDevice) {
+		fprintf(stderr, "Unable to open disc image %s\n", filename.c_str());
+		delete fileLoader;
+		return false;
+	}
+
+	std::string errorString;
+	double startTime = time_now_d();
+	bool success = WriteZstdDiscImage(blockDevice, outputFilename, level, &errorString);
+	if (success) {
+		printf("Compressed %s to %s in %0.2f seconds\n", filename.c_str(), outputFilename.c_str(), time_now_d() - startTime);
+	} else {
+		fprintf(stderr, "Compressing %s failed: %s\n", filename.c_str(), errorString.c_str());
+	}
+
+	delete blockDevice;
+	delete fileLoader;
+	return success;
+}
+
+static bool UncompressGEDump(const Path &filename, const Path &outputFilename) {
+	double startTime = time_now_d();
+	bool success = GPURecord::ConvertToUncompressed(filename, outputFilename);
+	if (success) {
+		printf("Uncompressed %s to %s in %0.2f seconds\n", filename.c_str(), outputFilename.c_str(), time_now_d() - startTime);
+	} else {
+		fprintf(stderr, "Uncompressing %s failed, only valid version 6 GE dumps can be converted\n", filename.c_str());
+	}
+	return success;
+}
+
+static void BenchSasVoices(SasInstance *sas, u32 vagAddr, u32 vagSize, u32 outAddr, int numVoices, bool parallel) {
+	const int GRAINS = 2000;
+
+	sas->allowParallelMix = parallel;
+	for (int v = 0; v < PSP_SAS_VOICES_MAX; v++) {
+		SasVoice &voice = sas->voices[v];
+		voice.playing = false;
+		if (v >= numVoices)
+			continue;
+
+		voice.type = VOICETYPE_VAG;
+		voice.vagAddr = vagAddr;
+		voice.vagSize = vagSize;
+		voice.loop = true;
+		// A spread of pitches, most of which need interpolation.
+		voice.pitch = 0x0800 + v * 0x0100;
+		voice.volumeLeft = 0x0800 + v * 0x40;
+		voice.volumeRight = 0x1000 - v * 0x40;
+		voice.effectLeft = 0x0400;
+		voice.effectRight = 0x0400;
+		voice.envelope.SetEnvelope(PSP_SAS_ADSR_ATTACK | PSP_SAS_ADSR_DECAY | PSP_SAS_ADSR_SUSTAIN | PSP_SAS_ADSR_RELEASE, PSP_SAS_ADSR_CURVE_MODE_LINEAR_INCREASE, PSP_SAS_ADSR_CURVE_MODE_EXPONENT_DECREASE, PSP_SAS_ADSR_CURVE_MODE_LINEAR_DECREASE, PSP_SAS_ADSR_CURVE_MODE_EXPONENT_DECREASE);
+		voice.envelope.SetRate(PSP_SAS_ADSR_ATTACK | PSP_SAS_ADSR_DECAY | PSP_SAS_ADSR_SUSTAIN | PSP_SAS_ADSR_RELEASE, 0x40000000, 0x100, 0, 0x100);
+		voice.envelope.SetSustainLevel(PSP_SAS_ENVELOPE_HEIGHT_MAX / 2);
+		voice.KeyOn();
+	}
+
+	double total = 0.0;
+	double worst = 0.0;
+	for (int i = 0; i < GRAINS; i++) {
+		double start = time_now_d();
+		sas->Mix(outAddr);
+		double elapsed = time_now_d() - start;
+		total += elapsed;
+		worst = std::max(worst, elapsed);
+	}
+
+	printf("SAS %2d voices, %s: %7.1f us/grain avg, %7.1f us max\n", numVoices, parallel ? "parallel" : "serial  ", total * 1000000.0 / GRAINS, worst * 1000000.0);
+}
+
+static bool BenchSasMix() {
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	if (!Memory::Init()) {
+		fprintf(stderr, "Unable to initialize memory\n");
+		return false;
+	}
+
+	// A looping VAG of noise, which all the voices play.
+	const u32 vagAddr = PSP_GetUserMemoryBase();
+	const u32 vagSize = 0x10000;
+	const u32 outAddr = vagAddr + vagSize;
+	u8 *vag = Memory::GetPointerWriteUnchecked(vagAddr);
+	u32 seed = 0x1234;
+	for (u32 offset = 0; offset < vagSize; offset += 16) {
+		for (int i = 0; i < 16; i++) {
+			seed = seed * 1664525 + 1013904223;
+			vag[offset + i] = (u8)(seed >> 16);
+		}
+		// Predictor 0 - 4, shift 0 - 11.
+		vag[offset] = (u8)((((vag[offset] >> 4) % 5) << 4) | ((vag[offset] & 0xF) % 12));
+		// Loop start and end flags.
+		vag[offset + 1] = offset == 0 ? 6 : (offset + 16 == vagSize ? 3 : 0);
+	}
+
+	SasInstance *sas = new SasInstance();
+	// 256 samples is a common grain size.
+	sas->SetGrainSize(256);
+	printf("Mixing %d samples per grain, %d threads\n", sas->GetGrainSize(), g_threadManager.GetNumLooperThreads());
+	for (int numVoices : { 8, 16, 32 }) {
+		BenchSasVoices(sas, vagAddr, vagSize, outAddr, numVoices, false);
+		BenchSasVoices(sas, vagAddr, vagSize, outAddr, numVoices, true);
+	}
+
+	delete sas;
+	Memory::Shutdown();
+	return true;
+}
+
 static HeadlessHost *getHost(GPUCore gpuCore) {
 	switch (gpuCore) {
 	case GPUCORE_SOFTWARE:
@@ -169,7 +300,7 @@ struct AutoTestOptions {
 	bool bench : 1;
 };
 
-bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt) {
+bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt, BenchmarkResults *benchResults = nullptr) {
 	// Kinda ugly, trying to guesstimate the test name from filename...
 	currentTestName = GetTestName(coreParameter.fileToStart);
 
@@ -210,7 +341,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 		draw->BeginFrame();
 
 	bool passed = true;
-	double deadline = time_now_d() + opt.timeout;
+	double runStart = time_now_d();
+	double deadline = runStart + opt.timeout;
 	coreState = coreParameter.startBreak ? CORE_STEPPING : CORE_RUNNING;
 	while (coreState == CORE_RUNNING || coreState == CORE_STEPPING)
 	{
@@ -239,6 +371,8 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 			Core_Stop();
 		}
 	}
+	if (benchResults)
+		AddEmulatorStats(*benchResults, time_now_d() - runStart);
 	PSP_EndHostFrame();
 
 	if (draw) {
@@ -263,6 +397,56 @@ bool RunAutoTest(HeadlessHost *headlessHost, CoreParameter &coreParameter, const
 	return passed;
 }
 
+// Replays a GE dump several times in a row without the CPU running in between, so each
+// replay only measures GPU emulation.  The first replay includes compiling shaders and such.
+// Screenshot comparison happens only after the last replay.
+static bool RunGEDumpBench(HeadlessHost *headlessHost, CoreParameter &coreParameter, const AutoTestOptions &opt, int replays, BenchmarkResults &benchResults) {
+	if (coreParameter.fileToStart.GetFileExtension() != ".ppdmp") {
+		fprintf(stderr, "%s is not a GE dump, skipping\n", coreParameter.fileToStart.c_str());
+		return false;
+	}
+
+	int remaining = replays;
+	GPURecord::SetReplayCallback([&](double seconds) {
+		benchResults.BeginRun();
+		benchResults.Add("wall_ms", seconds * 1000.0);
+		AddGPUStats(benchResults);
+		// Nothing else resets these between replays.
+		gpuStats.ResetFrame();
+		return --remaining > 0;
+	});
+	bool passed = RunAutoTest(headlessHost, coreParameter, opt);
+	GPURecord::SetReplayCallback(nullptr);
+
+	if (remaining > 0) {
+		fprintf(stderr, "Only %d of %d replays finished\n", replays - remaining, replays);
+		passed = false;
+	}
+	return passed;
+}
+
+// Returns false if any tests failed, or the results couldn't be written.
+static bool WriteTestResults(const TestQueue &tests, const char *jsonFilename, const char *junitFilename, bool compare) {
+	bool success = true;
+	if (jsonFilename && !tests.WriteJSON(Path(std::string(jsonFilename)))) {
+		fprintf(stderr, "Unable to write results to %s\n", jsonFilename);
+		success = false;
+	}
+	if (junitFilename && !tests.WriteJUnit(Path(std::string(junitFilename)))) {
+		fprintf(stderr, "Unable to write results to %s\n", junitFilename);
+		success = false;
+	}
+
+	// Without --compare, only a crash really counts as a failure.
+	int failed = tests.CountResults(TestResult::CRASHED) + tests.CountResults(TestResult::HUNG);
+	failed += tests.CountResults(TestResult::PENDING) + tests.CountResults(TestResult::RUNNING);
+	if (compare)
+		failed += tests.CountResults(TestResult::FAILED);
+	if (failed != 0 && !teamCityMode)
+		success = false;
+	return success;
+}
+
 int main(int argc, const char* argv[])
 {
 	PROFILE_INIT();
@@ -291,6 +475,16 @@ int main(int argc, const char* argv[])
 	const char *mountIso = nullptr;
 	const char *mountRoot = nullptr;
 	const char *screenshotFilename = nullptr;
+	const char *compressFilename = nullptr;
+	int compressLevel = 19;
+	const char *uncompressGEDumpFilename = nullptr;
+	bool benchSas = false;
+	int numJobs = 1;
+	const char *resultsJSONFilename = nullptr;
+	const char *resultsJUnitFilename = nullptr;
+	const char *benchJSONFilename = nullptr;
+	const char *traceFilename = nullptr;
+	int gedumpReplays = 0;
 
 	for (int i = 1; i < argc; i++)
 	{
@@ -314,10 +508,16 @@ int main(int argc, const char* argv[])
 			cpuCore = CPUCore::JIT;
 		else if (!strcmp(argv[i], "--ir"))
 			cpuCore = CPUCore::IR_JIT;
+		else if (!strcmp(argv[i], "--irjit"))
+			cpuCore = CPUCore::JIT_IR;
 		else if (!strcmp(argv[i], "-c") || !strcmp(argv[i], "--compare"))
 			testOptions.compare = true;
 		else if (!strcmp(argv[i], "--bench"))
 			testOptions.bench = true;
+		else if (!strncmp(argv[i], "--bench-json=", strlen("--bench-json=")) && strlen(argv[i]) > strlen("--bench-json="))
+			benchJSONFilename = argv[i] + strlen("--bench-json=");
+		else if (!strncmp(argv[i], "--gedump-bench=", strlen("--gedump-bench=")) && strlen(argv[i]) > strlen("--gedump-bench="))
+			gedumpReplays = (int)strtol(argv[i] + strlen("--gedump-bench="), NULL, 10);
 		else if (!strcmp(argv[i], "-v") || !strcmp(argv[i], "--verbose"))
 			testOptions.verbose = true;
 		else if (!strncmp(argv[i], "--graphics=", strlen("--graphics=")) && strlen(argv[i]) > strlen("--graphics="))
@@ -352,6 +552,22 @@ int main(int argc, const char* argv[])
 			testOptions.maxScreenshotError = strtod(argv[i] + strlen("--max-mse="), nullptr);
 		else if (!strncmp(argv[i], "--debugger=", strlen("--debugger=")) && strlen(argv[i]) > strlen("--debugger="))
 			debuggerPort = (int)strtoul(argv[i] + strlen("--debugger="), NULL, 10);
+		else if (!strncmp(argv[i], "--compress-zstd=", strlen("--compress-zstd=")) && strlen(argv[i]) > strlen("--compress-zstd="))
+			compressFilename = argv[i] + strlen("--compress-zstd=");
+		else if (!strncmp(argv[i], "--zstd-level=", strlen("--zstd-level=")) && strlen(argv[i]) > strlen("--zstd-level="))
+			compressLevel = (int)strtol(argv[i] + strlen("--zstd-level="), NULL, 10);
+		else if (!strncmp(argv[i], "--gedump-uncompress=", strlen("--gedump-uncompress=")) && strlen(argv[i]) > strlen("--gedump-uncompress="))
+			uncompressGEDumpFilename = argv[i] + strlen("--gedump-uncompress=");
+		else if (!strcmp(argv[i], "--bench-sas"))
+			benchSas = true;
+		else if (!strncmp(argv[i], "--jobs=", strlen("--jobs=")) && strlen(argv[i]) > strlen("--jobs="))
+			numJobs = (int)strtol(argv[i] + strlen("--jobs="), NULL, 10);
+		else if (!strncmp(argv[i], "--results-json=", strlen("--results-json=")) && strlen(argv[i]) > strlen("--results-json="))
+			resultsJSONFilename = argv[i] + strlen("--results-json=");
+		else if (!strncmp(argv[i], "--results-junit=", strlen("--results-junit=")) && strlen(argv[i]) > strlen("--results-junit="))
+			resultsJUnitFilename = argv[i] + strlen("--results-junit=");
+		else if (!strncmp(argv[i], "--trace=", strlen("--trace=")) && strlen(argv[i]) > strlen("--trace="))
+			traceFilename = argv[i] + strlen("--trace=");
 		else if (!strcmp(argv[i], "--teamcity"))
 			teamCityMode = true;
 		else if (!strncmp(argv[i], "--state=", strlen("--state=")) && strlen(argv[i]) > strlen("--state="))
@@ -373,8 +589,36 @@ int main(int argc, const char* argv[])
 			testFilenames.push_back(temp);
 	}
 
-	if (testFilenames.empty())
+	if (testFilenames.empty() && !benchSas)
 		return printUsage(argv[0], argc <= 1 ? NULL : "No executables specified");
+	if (compressFilename && testFilenames.size() != 1)
+		return printUsage(argv[0], "Specify exactly one disc image to compress");
+	if (uncompressGEDumpFilename && testFilenames.size() != 1)
+		return printUsage(argv[0], "Specify exactly one GE dump to uncompress");
+	if (numJobs > 1 && debuggerPort > 0)
+		return printUsage(argv[0], "The debugger can't be used with --jobs");
+	if (testOptions.bench && gedumpReplays > 0)
+		return printUsage(argv[0], "Use either --bench or --gedump-bench, not both");
+	if (gedumpReplays < 0)
+		return printUsage(argv[0], "Invalid number of replays for --gedump-bench");
+	// The JSON goes with either kind of benchmark.
+	if (benchJSONFilename && gedumpReplays == 0)
+		testOptions.bench = true;
+	if (numJobs > 1 && (testOptions.bench || gedumpReplays > 0))
+		return printUsage(argv[0], "Benchmarks would only disturb each other with --jobs");
+	if (numJobs > 1 && traceFilename)
+		return printUsage(argv[0], "Tracing isn't supported with --jobs");
+
+	TestQueue tests(testFilenames);
+	// This has to happen before any threads start, the workers continue from here.
+	if (numJobs > 1 && testFilenames.size() > 1 && !compressFilename && !uncompressGEDumpFilename && !benchSas) {
+		// Give tests a chance to time out on their own first.
+		double hangTimeout = std::isfinite(testOptions.timeout) ? testOptions.timeout + 30.0 : 0.0;
+		if (!tests.RunWorkers(numJobs, hangTimeout)) {
+			tests.PrintSummary();
+			return WriteTestResults(tests, resultsJSONFilename, resultsJUnitFilename, testOptions.compare) ? 0 : 1;
+		}
+	}
 
 	LogManager::Init(&g_Config.bEnableLogging);
 	LogManager *logman = LogManager::GetInstance();
@@ -395,6 +639,26 @@ int main(int argc, const char* argv[])
 	headlessHost->SetGraphicsCore(gpuCore);
 	host = headlessHost;
 
+	if (compressFilename || uncompressGEDumpFilename || benchSas) {
+		bool success;
+		if (benchSas)
+			success = BenchSasMix();
+		else if (uncompressGEDumpFilename)
+			success = UncompressGEDump(Path(testFilenames[0]), Path(std::string(uncompressGEDumpFilename)));
+		else
+			success = CompressDiscImage(Path(testFilenames[0]), Path(std::string(compressFilename)), compressLevel);
+
+		host = nullptr;
+		delete headlessHost;
+		LogManager::Shutdown();
+		delete printfLogger;
+#if PPSSPP_PLATFORM(WINDOWS)
+		timeEndPeriod(1);
+#endif
+		g_threadManager.Teardown();
+		return success ? 0 : 1;
+	}
+
 	std::string error_string;
 	GraphicsContext *graphicsContext = nullptr;
 	bool glWorking = host->InitGraphics(&error_string, &graphicsContext);
@@ -502,20 +766,39 @@ int main(int argc, const char* argv[])
 	if (stateToLoad != NULL)
 		SaveState::Load(Path(stateToLoad), -1);
 
-	std::vector<std::string> failedTests;
-	std::vector<std::string> passedTests;
-	for (size_t i = 0; i < testFilenames.size(); ++i)
+	// Timing the JIT, HLE, and GPU has some overhead, so only when benchmarking.
+	BenchmarkResults benchResults;
+	const bool benchmarking = testOptions.bench || gedumpReplays > 0;
+	if (benchmarking)
+		Core_ForceDebugStats(true);
+	if (traceFilename)
+		Tracer_Start();
+
+	int index;
+	while ((index = tests.Next()) >= 0)
 	{
-		coreParameter.fileToStart = Path(testFilenames[i]);
+		coreParameter.fileToStart = Path(testFilenames[index]);
 		if (testOptions.compare)
 			printf("%s:\n", coreParameter.fileToStart.c_str());
-		bool passed = RunAutoTest(headlessHost, coreParameter, testOptions);
+		bool passed;
+		if (gedumpReplays > 0) {
+			std::string testName = GetTestName(coreParameter.fileToStart);
+			benchResults.BeginTest(testName);
+			passed = RunGEDumpBench(headlessHost, coreParameter, testOptions, gedumpReplays, benchResults);
+			printf("  %s - replayed %d times\n", testName.c_str(), benchResults.NumRuns());
+			benchResults.PrintTest();
+		} else {
+			passed = RunAutoTest(headlessHost, coreParameter, testOptions);
+		}
 		if (testOptions.bench) {
+			std::string testName = GetTestName(coreParameter.fileToStart);
+			benchResults.BeginTest(testName);
+
 			double st = time_now_d();
 			double deadline = st + testOptions.timeout;
 			double runs = 0.0;
 			for (int i = 0; i < 100; ++i) {
-				RunAutoTest(headlessHost, coreParameter, testOptions);
+				RunAutoTest(headlessHost, coreParameter, testOptions, &benchResults);
 				runs++;
 
 				if (time_now_d() > deadline)
@@ -523,30 +806,36 @@ int main(int argc, const char* argv[])
 			}
 			double et = time_now_d();
 
-			std::string testName = GetTestName(coreParameter.fileToStart);
 			printf("  %s - %f seconds average\n", testName.c_str(), (et - st) / runs);
+			benchResults.PrintTest();
 		}
-		if (testOptions.compare) {
+		if (testOptions.compare && passed) {
 			std::string testName = GetTestName(coreParameter.fileToStart);
-			if (passed) {
-				passedTests.push_back(testName);
-				printf("  %s - passed!\n", testName.c_str());
-			}
-			else
-				failedTests.push_back(testName);
+			printf("  %s - passed!\n", testName.c_str());
 		}
+		tests.Finish(index, passed);
 	}
 
-	if (testOptions.compare) {
-		printf("%d tests passed, %d tests failed.\n", (int)passedTests.size(), (int)failedTests.size());
-		if (!failedTests.empty())
-		{
-			printf("Failed tests:\n");
-			for (size_t i = 0; i < failedTests.size(); ++i) {
-				printf("  %s\n", failedTests[i].c_str());
-			}
+	// Workers leave the summary to the parent.
+	bool success = true;
+	if (!tests.IsWorker()) {
+		if (testOptions.compare)
+			tests.PrintSummary();
+		success = WriteTestResults(tests, resultsJSONFilename, resultsJUnitFilename, testOptions.compare);
+	}
+	if (benchmarking)
+		Core_ForceDebugStats(false);
+	if (traceFilename) {
+		Tracer_Stop();
+		if (!File::WriteStringToFile(true, Tracer_GetChromeJSON(), Path(std::string(traceFilename)))) {
+			fprintf(stderr, "Unable to write trace to %s\n", traceFilename);
+			success = false;
 		}
 	}
+	if (benchJSONFilename && !benchResults.WriteJSON(Path(std::string(benchJSONFilename)))) {
+		fprintf(stderr, "Unable to write benchmark results to %s\n", benchJSONFilename);
+		success = false;
+	}
 
 	if (debuggerPort > 0) {
 		ShutdownWebServer();
@@ -567,7 +856,5 @@ int main(int argc, const char* argv[])
 
 	g_threadManager.Teardown();
 
-	if (!failedTests.empty() && !teamCityMode)
-		return 1;
-	return 0;
+	return success ? 0 : 1;
 }
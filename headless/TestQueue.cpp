@@ -0,0 +1,440 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <new>
+
+#if !PPSSPP_PLATFORM(WINDOWS)
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "Common/Data/Format/JSONWriter.h"
+#include "Common/File/FileUtil.h"
+#include "Common/StringUtils.h"
+#include "Common/TimeUtil.h"
+#include "headless/Compare.h"
+#include "headless/TestQueue.h"
+
+// Everything in here is shared with the workers, so only lock-free atomics.
+struct alignas(8) TestQueue::Shared {
+	std::atomic<int> next{ 0 };
+	// Held while copying a test's output to stdout.
+	std::atomic<int> outputLock{ 0 };
+	// The test each worker is running, or -1.
+	std::atomic<int> workerTest[MAX_JOBS];
+};
+
+struct TestQueue::Entry {
+	std::atomic<int> result{ (int)TestResult::PENDING };
+	std::atomic<double> startTime{ 0.0 };
+	std::atomic<double> seconds{ 0.0 };
+};
+
+static const char *ResultName(TestResult result) {
+	switch (result) {
+	case TestResult::PENDING: return "pending";
+	case TestResult::RUNNING: return "running";
+	case TestResult::PASSED: return "passed";
+	case TestResult::FAILED: return "failed";
+	case TestResult::CRASHED: return "crashed";
+	case TestResult::HUNG: return "hung";
+	}
+	return "unknown";
+}
+
+static std::string EscapeXML(const std::string &str) {
+	std::string escaped;
+	escaped.reserve(str.size());
+	for (char c : str) {
+		switch (c) {
+		case '&': escaped += "&amp;"; break;
+		case '<': escaped += "&lt;"; break;
+		case '>': escaped += "&gt;"; break;
+		case '"': escaped += "&quot;"; break;
+		case '\'': escaped += "&apos;"; break;
+		default: escaped += c; break;
+		}
+	}
+	return escaped;
+}
+
+TestQueue::TestQueue(const std::vector<std::string> &filenames) : filenames_(filenames) {
+	names_.reserve(filenames_.size());
+	for (const std::string &filename : filenames_)
+		names_.push_back(GetTestName(Path(filename)));
+
+	// This also sets the time base for time_now_d(), which the workers need to share.
+	startTime_ = time_now_d();
+	Allocate(false);
+}
+
+TestQueue::~TestQueue() {
+	for (FILE *capture : captures_) {
+		if (capture)
+			fclose(capture);
+	}
+	Free();
+}
+
+void TestQueue::Allocate(bool shared) {
+	sharedSize_ = sizeof(Shared) + filenames_.size() * sizeof(Entry);
+	void *mem = nullptr;
+#if !PPSSPP_PLATFORM(WINDOWS)
+	if (shared) {
+		mem = mmap(nullptr, sharedSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (mem == MAP_FAILED)
+			mem = nullptr;
+	}
+#endif
+	sharedMapped_ = mem != nullptr;
+	if (!mem)
+		mem = new char[sharedSize_];
+
+	shared_ = new (mem) Shared();
+	for (int i = 0; i < MAX_JOBS; ++i)
+		shared_->workerTest[i] = -1;
+	entries_ = (Entry *)(shared_ + 1);
+	for (size_t i = 0; i < filenames_.size(); ++i)
+		new (&entries_[i]) Entry();
+}
+
+void TestQueue::Free() {
+	// The atomics have trivial destructors, nothing else to do.
+#if !PPSSPP_PLATFORM(WINDOWS)
+	if (sharedMapped_)
+		munmap(shared_, sharedSize_);
+	else
+#endif
+		delete[] (char *)shared_;
+	shared_ = nullptr;
+	entries_ = nullptr;
+}
+
+bool TestQueue::RunWorkers(int numJobs, double hangTimeout) {
+#if PPSSPP_PLATFORM(WINDOWS)
+	fprintf(stderr, "Parallel jobs are not supported on this platform, running tests one at a time.\n");
+	return true;
+#else
+	numJobs_ = std::min(std::min(numJobs, (int)MAX_JOBS), (int)filenames_.size());
+	if (numJobs_ <= 1)
+		return true;
+
+	Free();
+	Allocate(true);
+	if (!sharedMapped_) {
+		perror("Unable to map memory for test workers");
+		return true;
+	}
+
+	// Each worker slot gets a file to buffer output in.  We keep them here too, to show the
+	// output of a test that crashed.
+	pids_.assign(numJobs_, 0);
+	killed_.assign(numJobs_, false);
+	captures_.assign(numJobs_, nullptr);
+	for (int slot = 0; slot < numJobs_; ++slot) {
+		captures_[slot] = tmpfile();
+		if (!captures_[slot]) {
+			perror("Unable to create output file for test workers");
+			return true;
+		}
+	}
+
+	int running = 0;
+	for (int slot = 0; slot < numJobs_; ++slot) {
+		if (StartWorker(slot))
+			return true;
+		if (pids_[slot] != 0)
+			running++;
+	}
+	// Couldn't fork at all?  Then we'll just have to run them ourselves.
+	if (running == 0)
+		return true;
+
+	while (running > 0) {
+		int status = 0;
+		pid_t pid = waitpid(-1, &status, WNOHANG);
+		if (pid < 0 && errno != EINTR) {
+			perror("Waiting for test workers failed");
+			break;
+		}
+		if (pid <= 0) {
+			if (hangTimeout > 0.0)
+				KillHungWorkers(hangTimeout);
+			sleep_ms(10);
+			continue;
+		}
+
+		auto it = std::find(pids_.begin(), pids_.end(), (int)pid);
+		if (it == pids_.end())
+			continue;
+		int slot = (int)(it - pids_.begin());
+		running--;
+
+		bool diedDuringTest = shared_->workerTest[slot] >= 0;
+		WorkerExited(slot, killed_[slot]);
+		// Workers only exit on their own once the queue is empty.  If one died, replace it.
+		if (diedDuringTest && shared_->next < (int)filenames_.size()) {
+			if (StartWorker(slot))
+				return true;
+			if (pids_[slot] != 0)
+				running++;
+		}
+	}
+
+	return false;
+#endif
+}
+
+bool TestQueue::StartWorker(int slot) {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	// Otherwise, anything still buffered would be printed again by the worker.
+	fflush(stdout);
+	fflush(stderr);
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		perror("Unable to start test worker");
+		return false;
+	}
+	if (pid == 0) {
+		slot_ = slot;
+		// Keeps printfs in order with the log, which goes to stderr.
+		setvbuf(stdout, nullptr, _IOLBF, BUFSIZ);
+		savedStdout_ = dup(STDOUT_FILENO);
+		savedStderr_ = dup(STDERR_FILENO);
+		return true;
+	}
+
+	pids_[slot] = (int)pid;
+	killed_[slot] = false;
+#endif
+	return false;
+}
+
+void TestQueue::WorkerExited(int slot, bool killed) {
+	int index = shared_->workerTest[slot];
+	if (index >= 0 && entries_[index].result == (int)TestResult::RUNNING) {
+		Entry &entry = entries_[index];
+		entry.seconds = time_now_d() - entry.startTime;
+		entry.result = (int)(killed ? TestResult::HUNG : TestResult::CRASHED);
+
+		// Whatever it printed before dying is probably the best clue.
+		while (shared_->outputLock.exchange(1) != 0)
+			sleep_ms(1);
+		fflush(stdout);
+		CopyOutput(captures_[slot], fileno(stdout));
+		printf("\n%s: %s\n", names_[index].c_str(), killed ? "TIMEOUT (worker killed)" : "CRASHED");
+		fflush(stdout);
+		shared_->outputLock = 0;
+	}
+
+	shared_->workerTest[slot] = -1;
+	pids_[slot] = 0;
+}
+
+void TestQueue::KillHungWorkers(double hangTimeout) {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	double now = time_now_d();
+	for (int slot = 0; slot < numJobs_; ++slot) {
+		int index = shared_->workerTest[slot];
+		if (pids_[slot] == 0 || killed_[slot] || index < 0)
+			continue;
+		if (now - entries_[index].startTime > hangTimeout) {
+			kill((pid_t)pids_[slot], SIGKILL);
+			killed_[slot] = true;
+		}
+	}
+#endif
+}
+
+int TestQueue::Next() {
+	int index = shared_->next++;
+	if (index >= (int)filenames_.size())
+		return -1;
+
+	Entry &entry = entries_[index];
+	entry.startTime = time_now_d();
+	entry.result = (int)TestResult::RUNNING;
+	if (IsWorker()) {
+		shared_->workerTest[slot_] = index;
+		BeginCapture();
+	}
+	return index;
+}
+
+void TestQueue::Finish(int index, bool passed) {
+	Entry &entry = entries_[index];
+	entry.seconds = time_now_d() - entry.startTime;
+	if (IsWorker())
+		EndCapture();
+	entry.result = (int)(passed ? TestResult::PASSED : TestResult::FAILED);
+	if (IsWorker())
+		shared_->workerTest[slot_] = -1;
+}
+
+void TestQueue::BeginCapture() {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	fflush(stdout);
+	fflush(stderr);
+
+	// Both go to the same file, so they stay in order.
+	int fd = fileno(captures_[slot_]);
+	if (ftruncate(fd, 0) != 0 || lseek(fd, 0, SEEK_SET) != 0)
+		return;
+	dup2(fd, STDOUT_FILENO);
+	dup2(fd, STDERR_FILENO);
+#endif
+}
+
+void TestQueue::EndCapture() {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	fflush(stdout);
+	fflush(stderr);
+	dup2(savedStdout_, STDOUT_FILENO);
+	dup2(savedStderr_, STDERR_FILENO);
+
+	while (shared_->outputLock.exchange(1) != 0)
+		sleep_ms(1);
+	CopyOutput(captures_[slot_], STDOUT_FILENO);
+	shared_->outputLock = 0;
+#endif
+}
+
+void TestQueue::CopyOutput(FILE *capture, int fd) {
+#if !PPSSPP_PLATFORM(WINDOWS)
+	int captureFd = fileno(capture);
+	if (lseek(captureFd, 0, SEEK_SET) != 0)
+		return;
+
+	char buf[16384];
+	ssize_t len;
+	while ((len = read(captureFd, buf, sizeof(buf))) > 0) {
+		const char *p = buf;
+		while (len > 0) {
+			ssize_t written = write(fd, p, len);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return;
+			p += written;
+			len -= written;
+		}
+	}
+#endif
+}
+
+int TestQueue::CountResults(TestResult result) const {
+	int count = 0;
+	for (size_t i = 0; i < filenames_.size(); ++i) {
+		if (entries_[i].result == (int)result)
+			count++;
+	}
+	return count;
+}
+
+void TestQueue::PrintSummary() const {
+	const int passed = CountResults(TestResult::PASSED);
+	const int failed = CountResults(TestResult::FAILED) + CountResults(TestResult::CRASHED) + CountResults(TestResult::HUNG);
+	printf("%d tests passed, %d tests failed.\n", passed, failed);
+	if (failed != 0) {
+		printf("Failed tests:\n");
+		for (size_t i = 0; i < filenames_.size(); ++i) {
+			TestResult result = (TestResult)entries_[i].result.load();
+			if (result == TestResult::FAILED)
+				printf("  %s\n", names_[i].c_str());
+			else if (result == TestResult::CRASHED || result == TestResult::HUNG)
+				printf("  %s (%s)\n", names_[i].c_str(), ResultName(result));
+		}
+	}
+
+	const int notRun = CountResults(TestResult::PENDING) + CountResults(TestResult::RUNNING);
+	if (notRun != 0)
+		printf("%d tests did not run.\n", notRun);
+	if (numJobs_ > 1)
+		printf("Ran %d tests on %d workers in %0.2f seconds.\n", passed + failed, numJobs_, time_now_d() - startTime_);
+}
+
+bool TestQueue::WriteJSON(const Path &filename) const {
+	json::JsonWriter writer(json::JsonWriter::PRETTY);
+	writer.begin();
+	writer.writeInt("jobs", std::max(numJobs_, 1));
+	writer.writeFloat("seconds", time_now_d() - startTime_);
+	writer.writeInt("passed", CountResults(TestResult::PASSED));
+	writer.writeInt("failed", CountResults(TestResult::FAILED));
+	writer.writeInt("crashed", CountResults(TestResult::CRASHED));
+	writer.writeInt("hung", CountResults(TestResult::HUNG));
+	writer.pushArray("tests");
+	for (size_t i = 0; i < filenames_.size(); ++i) {
+		writer.pushDict();
+		writer.writeString("name", names_[i]);
+		writer.writeString("file", filenames_[i]);
+		writer.writeString("result", ResultName((TestResult)entries_[i].result.load()));
+		writer.writeFloat("seconds", entries_[i].seconds);
+		writer.pop();
+	}
+	writer.pop();
+	writer.end();
+
+	return File::WriteStringToFile(true, writer.str(), filename);
+}
+
+bool TestQueue::WriteJUnit(const Path &filename) const {
+	const int failures = CountResults(TestResult::FAILED);
+	const int errors = CountResults(TestResult::CRASHED) + CountResults(TestResult::HUNG);
+	const int skipped = CountResults(TestResult::PENDING) + CountResults(TestResult::RUNNING);
+
+	std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+	xml += StringFromFormat("<testsuites tests=\"%d\" failures=\"%d\" errors=\"%d\" skipped=\"%d\" time=\"%0.3f\">\n", (int)filenames_.size(), failures, errors, skipped, time_now_d() - startTime_);
+	xml += StringFromFormat("  <testsuite name=\"PPSSPPHeadless\" tests=\"%d\" failures=\"%d\" errors=\"%d\" skipped=\"%d\">\n", (int)filenames_.size(), failures, errors, skipped);
+	for (size_t i = 0; i < filenames_.size(); ++i) {
+		const std::string name = EscapeXML(names_[i]);
+		// Group by directory, like cpu/vfpu.
+		size_t slash = name.find_last_of('/');
+		const std::string classname = slash == name.npos ? "tests" : name.substr(0, slash);
+		xml += StringFromFormat("    <testcase classname=\"%s\" name=\"%s\" file=\"%s\" time=\"%0.3f\"", classname.c_str(), name.c_str(), EscapeXML(filenames_[i]).c_str(), entries_[i].seconds.load());
+
+		switch ((TestResult)entries_[i].result.load()) {
+		case TestResult::PASSED:
+			xml += "/>\n";
+			break;
+		case TestResult::FAILED:
+			xml += ">\n      <failure message=\"Test failed\"/>\n    </testcase>\n";
+			break;
+		case TestResult::CRASHED:
+			xml += ">\n      <error message=\"Worker crashed\"/>\n    </testcase>\n";
+			break;
+		case TestResult::HUNG:
+			xml += ">\n      <error message=\"Worker stopped responding\"/>\n    </testcase>\n";
+			break;
+		default:
+			xml += ">\n      <skipped/>\n    </testcase>\n";
+			break;
+		}
+	}
+	xml += "  </testsuite>\n";
+	xml += "</testsuites>\n";
+
+	return File::WriteStringToFile(true, xml, filename);
+}
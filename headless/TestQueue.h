@@ -0,0 +1,103 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Common/File/Path.h"
+
+enum class TestResult {
+	PENDING,
+	RUNNING,
+	PASSED,
+	FAILED,
+	// The worker running the test died.
+	CRASHED,
+	// The worker running the test stopped responding and was killed.
+	HUNG,
+};
+
+// Hands out the tests to run and collects their results.
+//
+// The emulator is full of global state, so tests can only run in parallel in separate
+// processes.  With RunWorkers(), the process forks workers that share the queue and the
+// results through shared memory, and the parent only waits and reports.  Otherwise, the
+// tests just run one after another in this process.
+class TestQueue {
+public:
+	TestQueue(const std::vector<std::string> &filenames);
+	~TestQueue();
+
+	// Must be called before any threads are started.  Returns true in a worker, or if
+	// workers couldn't be started at all, in which case the caller should run the tests.
+	// Returns false in the parent, once all tests have finished.
+	// If hangTimeout is positive, workers that spend longer than that on one test are killed.
+	bool RunWorkers(int numJobs, double hangTimeout);
+	bool IsWorker() const {
+		return slot_ >= 0;
+	}
+
+	// Returns the index of the next test to run, or -1 when there are none left.
+	// In a worker, all output is buffered until Finish(), so each test's output stays together.
+	int Next();
+	void Finish(int index, bool passed);
+
+	void PrintSummary() const;
+	bool WriteJSON(const Path &filename) const;
+	bool WriteJUnit(const Path &filename) const;
+	int CountResults(TestResult result) const;
+
+	enum {
+		MAX_JOBS = 256,
+	};
+
+private:
+	struct Shared;
+	struct Entry;
+
+	void Allocate(bool shared);
+	void Free();
+	bool StartWorker(int slot);
+	void WorkerExited(int slot, bool killed);
+	void KillHungWorkers(double hangTimeout);
+	void BeginCapture();
+	void EndCapture();
+	void CopyOutput(FILE *capture, int fd);
+
+	std::vector<std::string> filenames_;
+	std::vector<std::string> names_;
+
+	Shared *shared_ = nullptr;
+	Entry *entries_ = nullptr;
+	size_t sharedSize_ = 0;
+	bool sharedMapped_ = false;
+
+	// Per worker slot, only the parent tracks the pids.
+	std::vector<int> pids_;
+	std::vector<bool> killed_;
+	std::vector<FILE *> captures_;
+	int numJobs_ = 0;
+	double startTime_ = 0.0;
+
+	// In a worker.
+	int slot_ = -1;
+	int savedStdout_ = -1;
+	int savedStderr_ = -1;
+};
@@ -640,6 +640,8 @@ static void check_variables(CoreParameter &coreParam)
          g_Config.iCpuCore = (int)CPUCore::JIT;
       else if (!strcmp(var.value, "IR JIT"))
          g_Config.iCpuCore = (int)CPUCore::IR_JIT;
+      else if (!strcmp(var.value, "JIT IR"))
+         g_Config.iCpuCore = (int)CPUCore::JIT_IR;
       else if (!strcmp(var.value, "Interpreter"))
          g_Config.iCpuCore = (int)CPUCore::INTERPRETER;
    }
@@ -147,6 +147,7 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       {
          { "JIT",         "Dynarec (JIT)" },
          { "IR JIT",      "IR Interpreter" },
+         { "JIT IR",      "JIT using IR" },
          { "Interpreter", NULL },
          { NULL, NULL },
       },
@@ -22,10 +22,12 @@
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
 #include "Common/TimeUtil.h"
+#include "Core/Config.h"
 #include "Core/ConfigValues.h"
 #include "Core/Debugger/SymbolMap.h"
 #include "Core/MIPS/JitCommon/JitCommon.h"
 #include "Core/MIPS/JitCommon/JitBlockCache.h"
+#include "Core/MIPS/IR/IRJit.h"
 #include "Core/MIPS/MIPSCodeUtils.h"
 #include "Core/MIPS/MIPSDebugInterface.h"
 #include "Core/MIPS/MIPSAsm.h"
@@ -207,3 +209,107 @@ bool TestJit() {
 
 	return jit_speed >= interp_speed;
 }
+
+struct SuperblockRun {
+	u32 r[32];
+	u32 pc;
+	bool formedTrace;
+};
+
+static bool RunSuperblockLoop(CPUCore core, u32 disableFlags, SuperblockRun &result) {
+	// Block A always branches to B, and B loops back to A, so A's exit gets hot.
+	static const char *lines[] = {
+		"addiu a0, a0, 3",
+		"addu a1, a1, a0",
+		"bne a0, zero, 0x08804018",
+		"xor v0, a1, a0",
+		// Not taken, only here so A has a second exit.
+		"nop",
+		"nop",
+		"sll a2, a1, 3",
+		"subu a3, a2, a0",
+		"slt v1, a3, a1",
+		"addiu t0, t0, -1",
+		"bne t0, zero, 0x08804000",
+		"addu s0, s0, a3",
+	};
+
+	// Drop the old jit first, so its emuhack ops aren't left in the code.
+	mipsr4k.UpdateCore(CPUCore::INTERPRETER);
+
+	u32 addr = PSP_GetUserMemoryBase();
+	_assert_(addr == 0x08804000);
+	for (size_t i = 0; i < ARRAY_SIZE(lines); ++i) {
+		if (!MIPSAsm::MipsAssembleOpcode(lines[i], currentDebugMIPS, addr)) {
+			printf("ERROR: %s\n", MIPSAsm::GetAssembleError().c_str());
+			return false;
+		}
+		addr += 4;
+	}
+	Memory::Write_U32(MIPS_MAKE_SYSCALL("UnitTestFakeSyscalls", "UnitTestTerminator"), addr);
+	Memory::Write_U32(MIPS_MAKE_BREAK(1), addr + 4);
+
+	memset(currentMIPS->r, 0, sizeof(currentMIPS->r));
+	currentMIPS->r[MIPS_REG_A0] = 1;
+	currentMIPS->r[MIPS_REG_A1] = 0x1234;
+	// Enough trips around the loop to run the joined block for a while after it forms.
+	currentMIPS->r[MIPS_REG_T0] = MIPSComp::IRSUPERBLOCK_HOT_EXIT_COUNT * 3;
+	currentMIPS->pc = PSP_GetUserMemoryBase();
+
+	u32 oldFlags = g_Config.uJitDisableFlags;
+	g_Config.uJitDisableFlags = disableFlags;
+	mipsr4k.UpdateCore(core);
+	g_Config.uJitDisableFlags = oldFlags;
+
+	coreState = CORE_RUNNING;
+	while (coreState == CORE_RUNNING) {
+		mipsr4k.RunLoopUntil(1000000);
+	}
+
+	memcpy(result.r, currentMIPS->r, sizeof(result.r));
+	result.pc = currentMIPS->pc;
+	result.formedTrace = false;
+	MIPSComp::IRBlockCache *blocks = static_cast<MIPSComp::IRBlockCache *>(MIPSComp::jit->GetBlockCacheDebugInterface());
+	for (int i = 0; i < blocks->GetNumBlocks(); ++i) {
+		if (blocks->GetBlock(i)->IsValid() && blocks->GetBlock(i)->IsTrace())
+			result.formedTrace = true;
+	}
+	return true;
+}
+
+bool TestIRSuperblocks() {
+	SetupJitHarness();
+
+	bool success = true;
+	for (CPUCore core : { CPUCore::IR_JIT, CPUCore::JIT_IR }) {
+		SuperblockRun separate, joined;
+		if (!RunSuperblockLoop(core, (u32)MIPSComp::JitDisable::SUPERBLOCKS, separate) || !RunSuperblockLoop(core, 0, joined)) {
+			success = false;
+			break;
+		}
+
+		const char *name = core == CPUCore::IR_JIT ? "IR_JIT" : "JIT_IR";
+		if (separate.formedTrace) {
+			printf("%s: superblock formed even though disabled\n", name);
+			success = false;
+		}
+		if (!joined.formedTrace) {
+			printf("%s: no superblock formed after %d exits\n", name, (int)MIPSComp::IRSUPERBLOCK_HOT_EXIT_COUNT * 3);
+			success = false;
+		}
+		for (int i = 0; i < 32; ++i) {
+			if (separate.r[i] != joined.r[i]) {
+				printf("%s: r%d is %08x with superblocks, %08x without\n", name, i, joined.r[i], separate.r[i]);
+				success = false;
+			}
+		}
+		if (separate.pc != joined.pc) {
+			printf("%s: pc is %08x with superblocks, %08x without\n", name, joined.pc, separate.pc);
+			success = false;
+		}
+	}
+
+	mipsr4k.UpdateCore(CPUCore::INTERPRETER);
+	DestroyJitHarness();
+	return success;
+}
@@ -0,0 +1,138 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/CPUDetect.h"
+#include "Common/Data/Random/Rng.h"
+#include "Common/Thread/ThreadManager.h"
+#include "GPU/GPUState.h"
+#include "GPU/ge_constants.h"
+#include "GPU/Software/BinManager.h"
+#include "GPU/Software/SoftGpu.h"
+#include "GPU/Software/TransformUnit.h"
+
+#include "UnitTest.h"
+
+// Tiles are drawn by whichever thread is free, so this checks the split doesn't change the result.
+// Alpha blending makes every pixel depend on the order of the prims covering it.
+
+static const int FB_WIDTH = 480;
+static const int FB_HEIGHT = 272;
+static const int FB_STRIDE = 512;
+// More than fit in the queue at once, so it drains partway through and tile queues can fill up.
+static const int NUM_PRIMS = 6000;
+
+static void SetCmd(GECommand cmd, u32 data) {
+	gstate.cmdmem[cmd] = (cmd << 24) | (data & 0x00FFFFFF);
+}
+
+static void SetupState() {
+	memset(gstate.cmdmem, 0, sizeof(gstate.cmdmem));
+	SetCmd(GE_CMD_VERTEXTYPE, GE_VTYPE_THROUGH);
+	SetCmd(GE_CMD_FRAMEBUFWIDTH, FB_STRIDE);
+	SetCmd(GE_CMD_FRAMEBUFPIXFORMAT, GE_FORMAT_8888);
+	SetCmd(GE_CMD_REGION2, ((FB_HEIGHT - 1) << 10) | (FB_WIDTH - 1));
+	SetCmd(GE_CMD_SCISSOR2, ((FB_HEIGHT - 1) << 10) | (FB_WIDTH - 1));
+	SetCmd(GE_CMD_SHADEMODE, GE_SHADE_GOURAUD);
+	SetCmd(GE_CMD_ALPHABLENDENABLE, 1);
+	SetCmd(GE_CMD_BLENDMODE, GE_SRCBLEND_SRCALPHA | (GE_DSTBLEND_INVSRCALPHA << 4) | (GE_BLENDMODE_MUL_AND_ADD << 8));
+	SetCmd(GE_CMD_ZWRITEDISABLE, 1);
+}
+
+static VertexData RandomVertex(GMRng &rng) {
+	VertexData v{};
+	// Some a bit off screen, to get clipped by the scissor.
+	int x = (int)(rng.R32() % (FB_WIDTH + 64)) - 32;
+	int y = (int)(rng.R32() % (FB_HEIGHT + 64)) - 32;
+	v.screenpos = ScreenCoords(x * SCREEN_SCALE_FACTOR, y * SCREEN_SCALE_FACTOR, 0);
+	v.color0 = rng.R32();
+	v.fogdepth = 1.0f;
+	v.clipw = 1.0f;
+	return v;
+}
+
+static std::vector<u32> DrawPrims(int numThreads) {
+	g_threadManager.Init(numThreads, 1);
+
+	std::vector<u32> color(FB_STRIDE * FB_HEIGHT, 0);
+	std::vector<u16> depth(FB_STRIDE * FB_HEIGHT, 0);
+	fb.data = (u8 *)color.data();
+	depthbuf.data = (u8 *)depth.data();
+
+	// The binner picks its number of tiles based on the threads available.
+	BinManager *binner = new BinManager();
+	SetupState();
+	binner->SetDirty(SoftDirty::PIXEL_ALL | SoftDirty::SAMPLER_ALL | SoftDirty::RAST_ALL | SoftDirty::BINNER_RANGE | SoftDirty::BINNER_OVERLAP);
+	binner->UpdateState();
+
+	GMRng rng;
+	rng.Init(1234);
+	for (int i = 0; i < NUM_PRIMS; ++i) {
+		VertexData v0 = RandomVertex(rng);
+		VertexData v1 = RandomVertex(rng);
+		VertexData v2 = RandomVertex(rng);
+		switch (i % 3) {
+		case 0:
+			// Either winding, the binner drops the back facing ones itself.
+			binner->AddTriangle(v0, v1, v2);
+			binner->AddTriangle(v0, v2, v1);
+			break;
+		case 1:
+			binner->AddRect(v0, v1);
+			break;
+		default:
+			binner->AddSprite(v0, v1);
+			break;
+		}
+	}
+	binner->Flush("test");
+	delete binner;
+
+	fb.data = nullptr;
+	depthbuf.data = nullptr;
+	g_threadManager.Teardown();
+	return color;
+}
+
+bool TestBinManager() {
+	// Each draw starts and stops its own threads, this puts back whatever was running before.
+	ScopedTestThreads threads;
+
+	std::vector<u32> single = DrawPrims(1);
+	// Even on a machine with fewer cores, split into several tiles.
+	int numThreads = std::max(cpu_info.num_cores * cpu_info.logical_cpu_count, 4);
+	bool success = true;
+	for (int pass = 0; pass < 3 && success; ++pass) {
+		std::vector<u32> threaded = DrawPrims(numThreads);
+		for (int y = 0; y < FB_HEIGHT && success; ++y) {
+			for (int x = 0; x < FB_WIDTH; ++x) {
+				u32 expected = single[y * FB_STRIDE + x];
+				u32 actual = threaded[y * FB_STRIDE + x];
+				if (expected != actual) {
+					printf("BinManager: pixel %d,%d with %d threads is %08x, single thread %08x\n", x, y, numThreads, actual, expected);
+					success = false;
+					break;
+				}
+			}
+		}
+	}
+	return success;
+}
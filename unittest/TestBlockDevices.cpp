@@ -0,0 +1,326 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Common/File/FileUtil.h"
+#include "Common/File/Path.h"
+#include "Common/Swap.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/FileLoaders/LocalFileLoader.h"
+#include "Core/FileSystems/BlockDevices.h"
+#include "Core/Loaders.h"
+
+#include "UnitTest.h"
+
+extern "C" {
+#include "zlib.h"
+}
+
+static const u32 TEST_BLOCKS = 4096;  // 8 MB
+
+class MemoryFileLoader : public FileLoader {
+public:
+	MemoryFileLoader(const std::vector<u8> &data) : data_(data) {}
+
+	bool Exists() override { return true; }
+	bool IsDirectory() override { return false; }
+	s64 FileSize() override { return (s64)data_.size(); }
+	Path GetPath() const override { return Path("memory.cso"); }
+
+	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override {
+		return ReadAt(absolutePos, bytes * count, data, flags) / bytes;
+	}
+	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override {
+		reads++;
+		if (absolutePos >= (s64)data_.size())
+			return 0;
+		bytes = std::min(bytes, (size_t)(data_.size() - absolutePos));
+		memcpy(data, &data_[absolutePos], bytes);
+		return bytes;
+	}
+
+	std::atomic<int> reads{};
+
+private:
+	const std::vector<u8> &data_;
+};
+
+// Simple deterministic generator, we want the same image every run.
+static std::vector<u8> GenerateDiscData() {
+	// Runs of repeated bytes with some noise, so it compresses roughly like game data.
+	std::vector<u8> data((size_t)TEST_BLOCKS * 2048);
+	GMRng rng;
+	rng.Init(1234);
+	u8 value = 0;
+	for (size_t i = 0; i < data.size(); ++i) {
+		u32 r = rng.R32();
+		if ((r & 0x3F) == 0)
+			value = (u8)(r >> 8);
+		data[i] = (r & 0x700) == 0 ? (u8)(r >> 16) : value;
+	}
+	// Some incompressible frames too, to cover the plain path.
+	for (size_t i = 64 * 2048; i < 80 * 2048; ++i)
+		data[i] = (u8)rng.R32();
+	return data;
+}
+
+static std::vector<u8> BuildCSO(const std::vector<u8> &data, u32 frameSize) {
+	const u32 numFrames = (u32)((data.size() + frameSize - 1) / frameSize);
+	const u32 headerSize = 0x18;
+	std::vector<u32_le> index(numFrames + 1);
+	std::vector<u8> out(headerSize + index.size() * sizeof(u32_le));
+
+	memcpy(&out[0], "CISO", 4);
+	u32_le headerSizeLE = headerSize;
+	u64_le totalBytes = (u64)data.size();
+	u32_le frameSizeLE = frameSize;
+	memcpy(&out[4], &headerSizeLE, 4);
+	memcpy(&out[8], &totalBytes, 8);
+	memcpy(&out[0x10], &frameSizeLE, 4);
+	out[0x14] = 1;
+	out[0x15] = 0;
+
+	std::vector<u8> compressed(compressBound(frameSize) + 64);
+	for (u32 frame = 0; frame < numFrames; ++frame) {
+		const u8 *src = &data[(size_t)frame * frameSize];
+		const u32 srcSize = std::min(frameSize, (u32)(data.size() - (size_t)frame * frameSize));
+
+		z_stream z{};
+		deflateInit2(&z, 6, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+		z.next_in = (Bytef *)src;
+		z.avail_in = srcSize;
+		z.next_out = &compressed[0];
+		z.avail_out = (uInt)compressed.size();
+		int status = deflate(&z, Z_FINISH);
+		const u32 compressedSize = (u32)z.total_out;
+		deflateEnd(&z);
+
+		index[frame] = (u32)out.size();
+		if (status != Z_STREAM_END || compressedSize >= srcSize) {
+			index[frame] = index[frame] | 0x80000000;
+			out.insert(out.end(), src, src + srcSize);
+		} else {
+			out.insert(out.end(), compressed.begin(), compressed.begin() + compressedSize);
+		}
+	}
+	index[numFrames] = (u32)out.size();
+	memcpy(&out[headerSize], &index[0], index.size() * sizeof(u32_le));
+	return out;
+}
+
+static bool CheckBlocks(const std::vector<u8> &data, const u8 *buf, u32 minBlock, u32 count) {
+	return memcmp(buf, &data[(size_t)minBlock * 2048], (size_t)count * 2048) == 0;
+}
+
+static bool TestCSOReads(const std::vector<u8> &data, u32 frameSize) {
+	std::vector<u8> cso = BuildCSO(data, frameSize);
+	MemoryFileLoader loader(cso);
+	CISOFileBlockDevice device(&loader);
+	EXPECT_EQ_INT(device.GetNumBlocks(), TEST_BLOCKS);
+
+	std::vector<u8> buf(1024 * 2048);
+	GMRng rng;
+	rng.Init(5678);
+	for (int i = 0; i < 200; ++i) {
+		// Mix single blocks, short reads, and reads large enough to go parallel.
+		u32 count = 1 + rng.R32() % (i & 1 ? 1024 : 16);
+		u32 minBlock = rng.R32() % (TEST_BLOCKS - count);
+		if (count == 1) {
+			EXPECT_TRUE(device.ReadBlock(minBlock, &buf[0]));
+		} else {
+			EXPECT_TRUE(device.ReadBlocks(minBlock, count, &buf[0]));
+		}
+		if (!CheckBlocks(data, &buf[0], minBlock, count)) {
+			printf("CSO frame size %d: mismatch reading %d blocks at %d\n", frameSize, count, minBlock);
+			return false;
+		}
+	}
+
+	// Right up to the end of the disc.
+	EXPECT_TRUE(device.ReadBlocks(TEST_BLOCKS - 300, 300, &buf[0]));
+	EXPECT_TRUE(CheckBlocks(data, &buf[0], TEST_BLOCKS - 300, 300));
+	return true;
+}
+
+static bool CheckZeroed(const u8 *buf, u32 count) {
+	for (size_t i = 0; i < (size_t)count * 2048; ++i) {
+		if (buf[i] != 0)
+			return false;
+	}
+	return true;
+}
+
+static bool TestZstdRoundTrip(const std::vector<u8> &allData, u32 numBlocks) {
+	// Frames are 64 blocks, and written in batches of 64 frames.  Odd counts leave a partial last frame.
+	const u32 blocksPerFrame = 64;
+	std::vector<u8> data(allData.begin(), allData.begin() + (size_t)numBlocks * 2048);
+	const Path filename("BlockDevicesTest.zso");
+
+	{
+		MemoryFileLoader isoLoader(data);
+		FileBlockDevice iso(&isoLoader);
+		std::string errorString;
+		if (!WriteZstdDiscImage(&iso, filename, 3, &errorString)) {
+			printf("Zstd %d blocks: write failed: %s\n", numBlocks, errorString.c_str());
+			return false;
+		}
+	}
+
+	bool success = [&] {
+		LocalFileLoader loader(filename);
+		ZstdFileBlockDevice device(&loader);
+		EXPECT_EQ_INT(device.GetNumBlocks(), numBlocks);
+
+		std::vector<u8> buf((size_t)(numBlocks + 16) * 2048);
+		EXPECT_TRUE(device.ReadBlocks(0, numBlocks, &buf[0]));
+		EXPECT_TRUE(CheckBlocks(data, &buf[0], 0, numBlocks));
+
+		GMRng rng;
+		rng.Init(numBlocks);
+		for (int i = 0; i < 100; ++i) {
+			u32 count = 1 + rng.R32() % std::min(numBlocks, i & 1 ? 200U : 3U);
+			u32 minBlock = rng.R32() % (numBlocks - count + 1);
+			if (count == 1) {
+				EXPECT_TRUE(device.ReadBlock(minBlock, &buf[0]));
+			} else {
+				EXPECT_TRUE(device.ReadBlocks(minBlock, count, &buf[0]));
+			}
+			if (!CheckBlocks(data, &buf[0], minBlock, count)) {
+				printf("Zstd %d blocks: mismatch reading %d blocks at %d\n", numBlocks, count, minBlock);
+				return false;
+			}
+		}
+
+		// Just the last frame, which may be short.
+		const u32 lastFrameStart = ((numBlocks - 1) / blocksPerFrame) * blocksPerFrame;
+		EXPECT_TRUE(device.ReadBlocks(lastFrameStart, numBlocks - lastFrameStart, &buf[0]));
+		EXPECT_TRUE(CheckBlocks(data, &buf[0], lastFrameStart, numBlocks - lastFrameStart));
+		EXPECT_TRUE(device.ReadBlock(numBlocks - 1, &buf[0]));
+		EXPECT_TRUE(CheckBlocks(data, &buf[0], numBlocks - 1, 1));
+
+		// Past the end reads zeros and fails.  Straddling the end reads what's there, then zeros.
+		memset(&buf[0], 0xCC, buf.size());
+		EXPECT_FALSE(device.ReadBlock(numBlocks, &buf[0]));
+		EXPECT_TRUE(CheckZeroed(&buf[0], 1));
+		memset(&buf[0], 0xCC, buf.size());
+		EXPECT_FALSE(device.ReadBlocks(numBlocks + 5, 4, &buf[0]));
+		EXPECT_TRUE(CheckZeroed(&buf[0], 4));
+		memset(&buf[0], 0xCC, buf.size());
+		const u32 straddle = std::min(numBlocks, 3U);
+		EXPECT_TRUE(device.ReadBlocks(numBlocks - straddle, straddle + 8, &buf[0]));
+		EXPECT_TRUE(CheckBlocks(data, &buf[0], numBlocks - straddle, straddle));
+		EXPECT_TRUE(CheckZeroed(&buf[(size_t)straddle * 2048], 8));
+		return true;
+	}();
+
+	// Uncached reads of part of a frame shouldn't keep it, or push out frames we're using.
+	if (success && numBlocks > blocksPerFrame * 2) {
+		success = [&] {
+			std::string zso;
+			EXPECT_TRUE(File::ReadFileToString(false, filename, zso));
+			std::vector<u8> zsoData(zso.begin(), zso.end());
+			MemoryFileLoader loader(zsoData);
+			ZstdFileBlockDevice device(&loader);
+
+			std::vector<u8> buf(2048);
+			EXPECT_TRUE(device.ReadBlock(1, &buf[0]));
+			EXPECT_TRUE(CheckBlocks(data, &buf[0], 1, 1));
+			const int reads = loader.reads;
+
+			EXPECT_TRUE(device.ReadBlock(blocksPerFrame + 1, &buf[0], true));
+			EXPECT_TRUE(CheckBlocks(data, &buf[0], blocksPerFrame + 1, 1));
+			EXPECT_EQ_INT(loader.reads, reads + 1);
+
+			// The first frame is still cached, the uncached one has to be read again.
+			EXPECT_TRUE(device.ReadBlock(2, &buf[0]));
+			EXPECT_TRUE(CheckBlocks(data, &buf[0], 2, 1));
+			EXPECT_EQ_INT(loader.reads, reads + 1);
+			EXPECT_TRUE(device.ReadBlock(blocksPerFrame + 2, &buf[0]));
+			EXPECT_TRUE(CheckBlocks(data, &buf[0], blocksPerFrame + 2, 1));
+			EXPECT_EQ_INT(loader.reads, reads + 2);
+			return true;
+		}();
+	}
+
+	File::Delete(filename);
+	return success;
+}
+
+static double BenchCSOReadBlocks(const std::vector<u8> &data, const std::vector<u8> &cso) {
+	MemoryFileLoader loader(cso);
+	CISOFileBlockDevice device(&loader);
+
+	// Like a video or level load streaming through the disc.
+	const u32 readBlocks = 256;
+	std::vector<u8> buf(readBlocks * 2048);
+	Instant start = Instant::Now();
+	for (u32 block = 0; block < TEST_BLOCKS; block += readBlocks) {
+		if (!device.ReadBlocks(block, readBlocks, &buf[0]) || !CheckBlocks(data, &buf[0], block, readBlocks))
+			return -1.0;
+	}
+	return (double)data.size() / (1024.0 * 1024.0) / start.Elapsed();
+}
+
+bool TestBlockDevices() {
+	const int oldFrameCacheSize = g_Config.iDiscFrameCacheSize;
+	g_Config.iDiscFrameCacheSize = 64;
+	std::vector<u8> data = GenerateDiscData();
+
+	// Without threads, ReadBlocks inflates serially.
+	const bool hadThreads = g_threadManager.IsInitialized();
+	std::vector<u8> cso = BuildCSO(data, 2048);
+
+	bool success = [&] {
+		double serialSpeed = hadThreads ? 0.0 : BenchCSOReadBlocks(data, cso);
+		EXPECT_TRUE(serialSpeed >= 0.0);
+		RET(TestCSOReads(data, 2048));
+		RET(TestCSOReads(data, 16384));
+
+		ScopedTestThreads threads;
+		RET(TestCSOReads(data, 2048));
+		RET(TestCSOReads(data, 16384));
+
+		// Past one write batch of frames, with a partial frame at the end.
+		std::vector<u8> zstdData = data;
+		zstdData.insert(zstdData.end(), data.begin(), data.begin() + 61 * 2048);
+		static const u32 zstdBlockCounts[] = { 1, 63, 64, 65, 777, TEST_BLOCKS, TEST_BLOCKS + 61 };
+		for (u32 numBlocks : zstdBlockCounts)
+			RET(TestZstdRoundTrip(zstdData, numBlocks));
+
+		double parallelSpeed = BenchCSOReadBlocks(data, cso);
+		EXPECT_TRUE(parallelSpeed >= 0.0);
+
+		if (hadThreads) {
+			printf("CSO ReadBlocks: %0.1f MB/s\n", parallelSpeed);
+		} else {
+			printf("CSO ReadBlocks: %0.1f MB/s serial, %0.1f MB/s parallel\n", serialSpeed, parallelSpeed);
+		}
+		return true;
+	}();
+
+	// Even if something failed above, don't leave our settings behind for the other tests.
+	g_Config.iDiscFrameCacheSize = oldFrameCacheSize;
+	return success;
+}
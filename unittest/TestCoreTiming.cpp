@@ -0,0 +1,146 @@
+// Copyright (c) 2022- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Common/TimeUtil.h"
+#include "Core/CoreTiming.h"
+#include "Core/MIPS/MIPS.h"
+
+#include "UnitTest.h"
+
+static const int BENCH_EVENTS = 100000;
+
+struct FiredEvent {
+	s64 time;
+	u64 userdata;
+};
+
+static std::vector<FiredEvent> firedEvents;
+
+static void RecordEvent(u64 userdata, int cyclesLate) {
+	firedEvents.push_back(FiredEvent{ (s64)CoreTiming::GetTicks() - cyclesLate, userdata });
+}
+
+static void IgnoreEvent(u64 userdata, int cyclesLate) {
+}
+
+// Simple deterministic generator, we want the same schedule every run.
+static bool TestEventOrder() {
+	int recordEvent = CoreTiming::RegisterEvent("TestRecord", &RecordEvent);
+	firedEvents.clear();
+
+	const int count = 2000;
+	GMRng rng;
+	rng.Init(1234);
+	for (int i = 0; i < count; ++i) {
+		// Lots of collisions, to check that same-time events keep their order.
+		CoreTiming::ScheduleEvent(rng.R32() % 500, recordEvent, i);
+	}
+	// Take a few back out, like a game cancelling alarms.
+	for (int i = 0; i < count; i += 7) {
+		CoreTiming::UnscheduleEvent(recordEvent, i);
+	}
+
+	int expected = count - (count + 6) / 7;
+	for (int i = 0; i < 10000 && (int)firedEvents.size() < expected; ++i) {
+		CoreTiming::Idle();
+		CoreTiming::Advance();
+	}
+
+	EXPECT_EQ_INT((int)firedEvents.size(), expected);
+	EXPECT_FALSE(CoreTiming::IsScheduled(recordEvent));
+	for (size_t i = 0; i < firedEvents.size(); ++i) {
+		EXPECT_TRUE(firedEvents[i].userdata % 7 != 0);
+		if (i == 0)
+			continue;
+		const FiredEvent &prev = firedEvents[i - 1];
+		EXPECT_TRUE(prev.time <= firedEvents[i].time);
+		if (prev.time == firedEvents[i].time) {
+			EXPECT_TRUE(prev.userdata < firedEvents[i].userdata);
+		}
+	}
+
+	return true;
+}
+
+static bool TestUnscheduleResult() {
+	int ignoreEvent = CoreTiming::RegisterEvent("TestIgnore", &IgnoreEvent);
+
+	CoreTiming::ScheduleEvent(1000, ignoreEvent, 1);
+	CoreTiming::ScheduleEvent(3000, ignoreEvent, 1);
+	CoreTiming::ScheduleEvent(2000, ignoreEvent, 2);
+	EXPECT_TRUE(CoreTiming::IsScheduled(ignoreEvent));
+
+	// With duplicates, the last one to fire determines the result.
+	EXPECT_EQ_INT(CoreTiming::UnscheduleEvent(ignoreEvent, 1), 3000);
+	EXPECT_EQ_INT(CoreTiming::UnscheduleEvent(ignoreEvent, 1), 0);
+	EXPECT_TRUE(CoreTiming::IsScheduled(ignoreEvent));
+	CoreTiming::RemoveEvent(ignoreEvent);
+	EXPECT_FALSE(CoreTiming::IsScheduled(ignoreEvent));
+
+	return true;
+}
+
+static bool BenchScheduleUnschedule() {
+	static const int TYPES = 8;
+	// CoreTiming keeps the name pointers.
+	static char names[TYPES][32];
+	int types[TYPES];
+	for (int i = 0; i < TYPES; ++i) {
+		snprintf(names[i], sizeof(names[i]), "BenchEvent%d", i);
+		types[i] = CoreTiming::RegisterEvent(names[i], &IgnoreEvent);
+	}
+
+	GMRng rng;
+	rng.Init(5678);
+	Instant start = Instant::Now();
+	for (int i = 0; i < BENCH_EVENTS; ++i) {
+		CoreTiming::ScheduleEvent(rng.R32() % 10000000, types[i % TYPES], i);
+	}
+	double scheduleTime = start.Elapsed();
+
+	start = Instant::Now();
+	// Unschedule in a scrambled order, so we're not always hitting the front or back.
+	for (int i = 0; i < BENCH_EVENTS; ++i) {
+		int j = (int)(((u64)i * 7919) % BENCH_EVENTS);
+		CoreTiming::UnscheduleEvent(types[j % TYPES], j);
+	}
+	double unscheduleTime = start.Elapsed();
+
+	for (int i = 0; i < TYPES; ++i) {
+		EXPECT_FALSE(CoreTiming::IsScheduled(types[i]));
+	}
+
+	printf("CoreTiming: scheduled %d events in %0.2f ms, unscheduled in %0.2f ms\n", BENCH_EVENTS, scheduleTime * 1000.0, unscheduleTime * 1000.0);
+	return true;
+}
+
+bool TestCoreTiming() {
+	MIPSState *oldMIPS = currentMIPS;
+	currentMIPS = &mipsr4k;
+	CoreTiming::Init();
+
+	bool success = TestEventOrder() && TestUnscheduleResult() && BenchScheduleUnschedule();
+
+	CoreTiming::ClearPendingEvents();
+	CoreTiming::Shutdown();
+	currentMIPS = oldMIPS;
+	return success;
+}
@@ -166,6 +166,35 @@ static const IRVerification tests[] = {
 		},
 		{ &PropagateConstants },
 	},
+	{
+		"PropagateConstantsAcrossExit",
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 5 },
+			{ IROp::ExitToConstIfEq, { 255 }, MIPS_REG_A1, MIPS_REG_A2, 0x08800000 },
+			{ IROp::AddConst, { MIPS_REG_A1 }, MIPS_REG_A0, 0, 1 },
+		},
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 5 },
+			{ IROp::ExitToConstIfEq, { 255 }, MIPS_REG_A1, MIPS_REG_A2, 0x08800000 },
+			{ IROp::SetConst, { MIPS_REG_A1 }, 0, 0, 6 },
+		},
+		{ &PropagateConstants },
+	},
+	{
+		"PropagateConstantsFoldExit",
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 5 },
+			{ IROp::ExitToConstIfLeZ, { 255 }, MIPS_REG_A0, 0, 0x08800000 },
+			{ IROp::AddConst, { MIPS_REG_A1 }, MIPS_REG_A0, 0, 1 },
+			{ IROp::ExitToConstIfGtZ, { 255 }, MIPS_REG_A1, 0, 0x08800100 },
+		},
+		{
+			{ IROp::SetConst, { MIPS_REG_A0 }, 0, 0, 5 },
+			{ IROp::SetConst, { MIPS_REG_A1 }, 0, 0, 6 },
+			{ IROp::ExitToConst, { 255 }, 0, 0, 0x08800100 },
+		},
+		{ &PropagateConstants },
+	},
 };
 
 bool TestIRPassSimplify() {
@@ -0,0 +1,268 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include "ppsspp_config.h"
+
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(RISCV64)
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Core/MemMap.h"
+#include "Core/MIPS/MIPS.h"
+#include "Core/MIPS/IR/IRInst.h"
+#include "Core/MIPS/IR/IRNativeCommon.h"
+#if PPSSPP_ARCH(AMD64)
+#include "Common/x64Emitter.h"
+#include "Core/MIPS/x86/IRToX86.h"
+#elif PPSSPP_ARCH(RISCV64)
+#include "Common/RiscVEmitter.h"
+#include "Core/MIPS/RiscV/IRToRiscV.h"
+#endif
+
+#include "UnitTest.h"
+
+// Runs random IR blocks through both the interpreter and each native backend, and compares the results.
+// Memory ops all point into a small scratch window of PSP RAM, which is compared afterward too.
+
+static const u32 SCRATCH_ADDR = 0x08A00000;
+static const u32 SCRATCH_SIZE = 0x1000;
+
+static u32 RandomValue(GMRng &rng) {
+	switch (rng.R32() % 6) {
+	case 0: return 0;
+	case 1: return 0xFFFFFFFF;
+	case 2: return 0x80000000;
+	case 3: return rng.R32() & 0xFF;
+	default: return rng.R32() ^ (rng.R32() << 16);
+	}
+}
+
+static u32 RandomFloatBits(GMRng &rng) {
+	static const u32 specials[] = { 0x00000000, 0x80000000, 0x7f800000, 0xff800000, 0x3f800000, 0xbf800000, 0x7f7fffff, 0x00000001 };
+	if (rng.R32() % 4 == 0)
+		return specials[rng.R32() % ARRAY_SIZE(specials)];
+	float f = ((int)(rng.R32() % 20000) - 10000) / 37.0f;
+	u32 bits;
+	memcpy(&bits, &f, sizeof(bits));
+	return bits;
+}
+
+static const IROp testOps[] = {
+	IROp::SetConst, IROp::SetConstF, IROp::Mov, IROp::Add, IROp::Sub, IROp::Neg, IROp::Not, IROp::And, IROp::Or, IROp::Xor,
+	IROp::AddConst, IROp::SubConst, IROp::AndConst, IROp::OrConst, IROp::XorConst, IROp::Shl, IROp::Shr, IROp::Sar, IROp::Ror,
+	IROp::ShlImm, IROp::ShrImm, IROp::SarImm, IROp::RorImm, IROp::Slt, IROp::SltConst, IROp::SltU, IROp::SltUConst, IROp::Clz,
+	IROp::MovZ, IROp::MovNZ, IROp::Max, IROp::Min, IROp::BSwap16, IROp::BSwap32, IROp::MtLo, IROp::MtHi, IROp::MfLo, IROp::MfHi,
+	IROp::Mult, IROp::MultU, IROp::Madd, IROp::MaddU, IROp::Msub, IROp::MsubU, IROp::Div, IROp::DivU, IROp::Ext8to32, IROp::Ext16to32,
+	IROp::FAdd, IROp::FSub, IROp::FMul, IROp::FDiv, IROp::FMin, IROp::FMax, IROp::FMov, IROp::FSqrt, IROp::FNeg, IROp::FAbs,
+	IROp::FCvtSW, IROp::FMovFromGPR, IROp::FMovToGPR, IROp::FCmp, IROp::FpCondToReg, IROp::ZeroFpCond, IROp::FRSqrt, IROp::FRecip,
+	IROp::Vec4Init, IROp::Vec4Shuffle, IROp::Vec4Mov, IROp::Vec4Add, IROp::Vec4Sub, IROp::Vec4Mul, IROp::Vec4Div, IROp::Vec4Scale,
+	IROp::Vec4Dot, IROp::Vec4Neg, IROp::Vec4Abs, IROp::Vec4ClampToZero, IROp::Downcount, IROp::FSign, IROp::ReverseBits,
+	IROp::ExitToConstIfEq, IROp::ExitToConstIfNeq, IROp::ExitToConstIfGtZ, IROp::ExitToConstIfGeZ, IROp::ExitToConstIfLtZ, IROp::ExitToConstIfLeZ,
+	IROp::SetPC, IROp::SetPCConst,
+	IROp::Load8, IROp::Load8Ext, IROp::Load16, IROp::Load16Ext, IROp::Load32, IROp::Load32Left, IROp::Load32Right, IROp::LoadFloat,
+	IROp::LoadVec4, IROp::Store8, IROp::Store16, IROp::Store32, IROp::Store32Left, IROp::Store32Right, IROp::StoreFloat, IROp::StoreVec4,
+};
+
+static bool IsMemoryOp(IROp op) {
+	return op >= IROp::Load8 && op <= IROp::StoreVec4;
+}
+
+static std::vector<IRInst> RandomBlock(GMRng &rng) {
+	static const u8 gprs[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, IRTEMP_0, IRTEMP_1, IRREG_LO, IRREG_HI };
+
+	std::vector<IRInst> insts;
+	int count = 1 + rng.R32() % 100;
+	for (int i = 0; i < count; ++i) {
+		IRInst inst{};
+		inst.op = testOps[rng.R32() % ARRAY_SIZE(testOps)];
+		inst.constant = RandomValue(rng);
+		const IRMeta *meta = GetIRMeta(inst.op);
+		u8 *args[3] = { &inst.dest, &inst.src1, &inst.src2 };
+		for (int a = 0; a < 3; ++a) {
+			switch (meta->types[a]) {
+			case 'G': *args[a] = gprs[rng.R32() % ARRAY_SIZE(gprs)]; break;
+			case 'F': *args[a] = rng.R32() % 48; break;
+			case 'V': *args[a] = (rng.R32() % 12) * 4; break;
+			case 'I': *args[a] = rng.R32() % 32; break;
+			default: break;
+			}
+		}
+
+		switch (inst.op) {
+		case IROp::FCmp: inst.dest = rng.R32() % 8; break;
+		case IROp::Vec4Init: inst.src1 = rng.R32() % 7; break;
+		case IROp::Vec4Shuffle:
+			// The frontend never shuffles in place.
+			inst.src2 = rng.R32() & 0xFF;
+			if (inst.dest == inst.src1)
+				inst.dest = (inst.dest + 4) % 48;
+			break;
+		case IROp::RorImm: inst.src2 = 1 + inst.src2 % 31; break;
+		case IROp::Downcount: inst.constant &= 0xFF; break;
+		default: break;
+		}
+		if (meta->flags & IRFLAG_EXIT)
+			inst.constant = 0x08900000 + i * 4;
+		if (IsMemoryOp(inst.op)) {
+			// Point the base at the scratch window, aligned enough for LoadVec4/StoreVec4.
+			IRInst setBase{};
+			setBase.op = IROp::SetConst;
+			setBase.dest = inst.src1;
+			setBase.constant = SCRATCH_ADDR + (rng.R32() % (SCRATCH_SIZE / 2) & ~15);
+			insts.push_back(setBase);
+			inst.constant = (rng.R32() % 64) * 16;
+			if (inst.op == IROp::Load32Left || inst.op == IROp::Load32Right || inst.op == IROp::Store32Left || inst.op == IROp::Store32Right)
+				inst.constant += rng.R32() & 3;
+		}
+		insts.push_back(inst);
+	}
+
+	IRInst exit{};
+	exit.op = IROp::ExitToConst;
+	exit.constant = 0x08804000;
+	insts.push_back(exit);
+	return insts;
+}
+
+static bool FloatBitsMatch(u32 a, u32 b) {
+	// NaN payloads depend on operand order, which the C++ compiler is free to pick.
+	bool nanA = (a & 0x7FFFFFFF) > 0x7F800000;
+	bool nanB = (b & 0x7FFFFFFF) > 0x7F800000;
+	return a == b || (nanA && nanB);
+}
+
+static bool CompareStates(const char *name, const MIPSState &expected, const MIPSState &actual) {
+	// Going through u32 pointers, since IR indexes past the end of r and f.
+	const u32 *regsE = (const u32 *)&expected.r[0];
+	const u32 *regsA = (const u32 *)&actual.r[0];
+	bool success = true;
+	for (int i = 0; i < 256; ++i) {
+		bool isFloat = i >= 32 && i < 32 + 160;
+		bool match = isFloat ? FloatBitsMatch(regsE[i], regsA[i]) : regsE[i] == regsA[i];
+		if (!match) {
+			printf("%s: reg %d should be %08x, was %08x\n", name, i, regsE[i], regsA[i]);
+			success = false;
+		}
+	}
+	EXPECT_EQ_INT(expected.downcount, actual.downcount);
+	return success;
+}
+
+static bool CompareMemory(const char *name, const u32 *expected, const u32 *actual) {
+	bool success = true;
+	for (u32 i = 0; i < SCRATCH_SIZE / 4; ++i) {
+		// Stored floats can be NaNs too.
+		if (!FloatBitsMatch(expected[i], actual[i])) {
+			printf("%s: memory at %08x should be %08x, was %08x\n", name, SCRATCH_ADDR + i * 4, expected[i], actual[i]);
+			success = false;
+		}
+	}
+	return success;
+}
+
+static void LogInstructions(const std::vector<IRInst> &insts) {
+	for (size_t i = 0; i < insts.size(); ++i) {
+		char buf[256];
+		DisassembleIR(buf, sizeof(buf), insts[i]);
+		printf("  %s\n", buf);
+	}
+}
+
+template <typename CodeBlockT>
+static bool TestBackend(const char *name, MIPSComp::IRToNativeInterface &backend, CodeBlockT &code) {
+	using namespace MIPSComp;
+
+	code.AllocCodeSpace(1024 * 1024 * 4);
+	backend.GenerateFixedCode();
+
+	std::unique_ptr<MIPSState> initial(new MIPSState());
+	std::unique_ptr<MIPSState> expected(new MIPSState());
+	std::unique_ptr<MIPSState> actual(new MIPSState());
+	std::vector<u32> initialMem(SCRATCH_SIZE / 4), expectedMem(SCRATCH_SIZE / 4);
+	u32 *scratch = (u32 *)Memory::GetPointerWriteUnchecked(SCRATCH_ADDR);
+
+	GMRng rng;
+	rng.Init(1234);
+	for (int i = 0; i < 2000; ++i) {
+		std::vector<IRInst> insts = RandomBlock(rng);
+
+		u32 *regs = (u32 *)&initial->r[0];
+		for (int r = 1; r < 256; ++r) {
+			bool isFloat = r >= 32 && r < 32 + 160;
+			regs[r] = isFloat ? RandomFloatBits(rng) : RandomValue(rng);
+		}
+		initial->downcount = 1000;
+		*expected = *initial;
+		*actual = *initial;
+		for (u32 &v : initialMem)
+			v = rng.R32() % 2 ? RandomFloatBits(rng) : RandomValue(rng);
+
+		const u8 *entry = backend.ConvertIRToNative(insts.data(), (int)insts.size());
+		if (!entry) {
+			code.ClearCodeSpace(0);
+			backend.GenerateFixedCode();
+			entry = backend.ConvertIRToNative(insts.data(), (int)insts.size());
+		}
+		EXPECT_TRUE(entry != nullptr);
+
+		memcpy(scratch, initialMem.data(), SCRATCH_SIZE);
+		u32 expectedPC = IRInterpret(expected.get(), insts.data(), (int)insts.size());
+		memcpy(expectedMem.data(), scratch, SCRATCH_SIZE);
+		memcpy(scratch, initialMem.data(), SCRATCH_SIZE);
+		u32 actualPC = backend.GetEnterFunc()(actual.get(), entry);
+		if (expectedPC != actualPC || !CompareStates(name, *expected, *actual) || !CompareMemory(name, expectedMem.data(), scratch)) {
+			printf("%s: block %d exited to %08x, expected %08x\n", name, i, actualPC, expectedPC);
+			LogInstructions(insts);
+			code.FreeCodeSpace();
+			return false;
+		}
+	}
+
+	code.FreeCodeSpace();
+	return true;
+}
+
+bool TestIRToNative() {
+	using namespace MIPSComp;
+	InitIR();
+
+	// The backends bake in Memory::base, so this has to come first.
+	Memory::g_MemorySize = Memory::RAM_NORMAL_SIZE;
+	EXPECT_TRUE(Memory::Init());
+
+	bool success = true;
+#if PPSSPP_ARCH(AMD64)
+	Gen::XCodeBlock x64Code;
+	IRToX86 x64Backend;
+	x64Backend.SetCodeBlock(&x64Code);
+	success = TestBackend("IRToX86", x64Backend, x64Code);
+#elif PPSSPP_ARCH(RISCV64)
+	RiscVGen::RiscVCodeBlock riscvCode;
+	IRToRiscV riscvBackend;
+	riscvBackend.SetCodeBlock(&riscvCode);
+	success = TestBackend("IRToRiscV", riscvBackend, riscvCode);
+#endif
+
+	Memory::Shutdown();
+	return success;
+}
+
+#endif
@@ -0,0 +1,231 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Core/FileLoaders/ReadAheadFileLoader.h"
+
+#include "UnitTest.h"
+
+// Should match ReadAheadFileLoader.
+static const s64 BLOCK_SIZE = 65536;
+static const s64 BLOCK_READAHEAD = 8;
+static const int MAX_STREAMS = 4;
+// Bigger than the blocks it keeps, so old ones get dropped along the way.
+static const size_t FILE_SIZE = 10 * 1024 * 1024 + 1000;
+
+// Counts how it was read, to tell read ahead blocks from reads passed straight through.
+class CountingFileLoader : public FileLoader {
+public:
+	CountingFileLoader(const std::vector<u8> &data) : data_(data) {}
+
+	bool Exists() override { return true; }
+	bool IsDirectory() override { return false; }
+	s64 FileSize() override { return (s64)data_.size(); }
+	Path GetPath() const override { return Path("memory.iso"); }
+
+	size_t ReadAt(s64 absolutePos, size_t bytes, size_t count, void *data, Flags flags = Flags::NONE) override {
+		return ReadAt(absolutePos, bytes * count, data, flags) / bytes;
+	}
+	size_t ReadAt(s64 absolutePos, size_t bytes, void *data, Flags flags = Flags::NONE) override {
+		if (bytes == BLOCK_SIZE && (absolutePos & (BLOCK_SIZE - 1)) == 0) {
+			blockReads++;
+			s64 end = absolutePos + BLOCK_SIZE;
+			s64 prev = maxBlockEnd.load();
+			while (end > prev && !maxBlockEnd.compare_exchange_weak(prev, end))
+				continue;
+			if (slow)
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+		} else {
+			directReads++;
+		}
+
+		if (absolutePos >= (s64)data_.size())
+			return 0;
+		bytes = std::min(bytes, (size_t)(data_.size() - absolutePos));
+		memcpy(data, &data_[absolutePos], bytes);
+		return bytes;
+	}
+
+	std::atomic<int> blockReads{};
+	std::atomic<int> directReads{};
+	std::atomic<s64> maxBlockEnd{};
+	bool slow = false;
+
+private:
+	const std::vector<u8> &data_;
+};
+
+static bool CheckRead(ReadAheadFileLoader &loader, const std::vector<u8> &data, s64 pos, size_t bytes, FileLoader::Flags flags = FileLoader::Flags::NONE) {
+	std::vector<u8> buf(bytes);
+	size_t expected = pos >= (s64)data.size() ? 0 : std::min(bytes, (size_t)(data.size() - pos));
+	size_t readSize = loader.ReadAt(pos, bytes, buf.data(), flags);
+	if (readSize != expected || (expected != 0 && memcmp(buf.data(), &data[pos], expected) != 0)) {
+		printf("ReadAheadFileLoader: read at %lld (%d bytes) gave %d bytes, wrong data\n", (long long)pos, (int)bytes, (int)readSize);
+		return false;
+	}
+	return true;
+}
+
+static bool TestSequentialReads(const std::vector<u8> &data) {
+	CountingFileLoader *backend = new CountingFileLoader(data);
+	ReadAheadFileLoader loader(backend);
+
+	// Not block aligned, with the occasional small skip like a demuxer would do.
+	s64 pos = 0;
+	int reads = 0;
+	while (pos < (s64)data.size()) {
+		const size_t bytes = 6000;
+		RET(CheckRead(loader, data, pos, bytes));
+		pos += bytes;
+		if (++reads % 7 == 0)
+			pos += 1000;
+		// It should stay a limited window ahead of the reads.
+		EXPECT_TRUE(backend->maxBlockEnd.load() <= pos + (BLOCK_READAHEAD + 1) * BLOCK_SIZE);
+	}
+
+	// Only the first few, before it noticed the reads were sequential.
+	EXPECT_TRUE(backend->directReads.load() <= 2);
+	// Every block once, even with old blocks being dropped.
+	const int numBlocks = (int)((data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	EXPECT_EQ_INT(backend->blockReads.load(), numBlocks);
+
+	// And reading past the end doesn't read ahead any more.
+	RET(CheckRead(loader, data, (s64)data.size() - 10, 100));
+	RET(CheckRead(loader, data, (s64)data.size() + 10, 100));
+	EXPECT_EQ_INT(backend->blockReads.load(), numBlocks);
+	return true;
+}
+
+static bool TestInterleavedStreams(const std::vector<u8> &data) {
+	CountingFileLoader *backend = new CountingFileLoader(data);
+	ReadAheadFileLoader loader(backend);
+
+	// Like a video and its audio, read in turns from two parts of the file.
+	const s64 videoStart = 4 * BLOCK_SIZE + 123;
+	const s64 audioStart = (s64)data.size() / 2;
+	s64 videoPos = videoStart;
+	s64 audioPos = audioStart;
+	for (int i = 0; i < 300; ++i) {
+		RET(CheckRead(loader, data, videoPos, 8000));
+		videoPos += 8000;
+		RET(CheckRead(loader, data, audioPos, 2000));
+		audioPos += 2000;
+	}
+
+	// Each read directly only until it was noticed (three reads), the rest came from blocks read ahead.
+	EXPECT_TRUE(backend->directReads.load() <= 6);
+	EXPECT_TRUE(backend->blockReads.load() >= (int)((videoPos - videoStart + audioPos - audioStart) / BLOCK_SIZE));
+	return true;
+}
+
+static bool TestRandomReads(const std::vector<u8> &data) {
+	CountingFileLoader *backend = new CountingFileLoader(data);
+	ReadAheadFileLoader loader(backend);
+
+	GMRng rng;
+	rng.Init(1234);
+	s64 lastEnds[MAX_STREAMS];
+	std::fill(lastEnds, lastEnds + MAX_STREAMS, -1);
+	for (int i = 0; i < 500; ++i) {
+		s64 pos = rng.R32() % data.size();
+		size_t bytes = 1 + rng.R32() % 20000;
+		// Make sure none look like they continue a recent read by chance.
+		while (std::any_of(lastEnds, lastEnds + MAX_STREAMS, [&](s64 end) { return pos >= end && pos - end < BLOCK_SIZE; }))
+			pos = (pos + BLOCK_SIZE * 3) % data.size();
+		RET(CheckRead(loader, data, pos, bytes));
+		lastEnds[i % MAX_STREAMS] = pos + bytes;
+	}
+
+	// Nothing worth reading ahead.
+	EXPECT_EQ_INT(backend->blockReads.load(), 0);
+	EXPECT_EQ_INT(backend->directReads.load(), 500);
+
+	// But a prefetch hint reads the blocks, and later reads come from them.
+	const s64 prefetchPos = 10 * BLOCK_SIZE + 100;
+	loader.Prefetch(prefetchPos, 3 * BLOCK_SIZE);
+	RET(CheckRead(loader, data, prefetchPos + 5000, 2 * BLOCK_SIZE));
+	EXPECT_EQ_INT(backend->blockReads.load(), 4);
+	EXPECT_EQ_INT(backend->directReads.load(), 500);
+
+	// Uncached reads always go straight through.
+	RET(CheckRead(loader, data, prefetchPos, 1000, FileLoader::Flags::HINT_UNCACHED));
+	EXPECT_EQ_INT(backend->directReads.load(), 501);
+	return true;
+}
+
+static bool TestConcurrentReads(const std::vector<u8> &data) {
+	CountingFileLoader *backend = new CountingFileLoader(data);
+	// So reads are often still waiting on blocks in flight.
+	backend->slow = true;
+	ReadAheadFileLoader *loader = new ReadAheadFileLoader(backend);
+
+	const int numThreads = 4;
+	std::atomic<bool> failed{};
+	std::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; ++t) {
+		threads.push_back(std::thread([&, t] {
+			GMRng rng;
+			rng.Init(1000 + t);
+			// Each streams its own part of the file, but some also jump around and prefetch.
+			s64 pos = (s64)(data.size() / numThreads) * t;
+			for (int i = 0; i < 300 && !failed; ++i) {
+				size_t bytes = 1 + rng.R32() % 8000;
+				if (t == numThreads - 1 && i % 3 == 0) {
+					s64 randomPos = rng.R32() % data.size();
+					loader->Prefetch(randomPos, bytes * 4);
+					if (!CheckRead(*loader, data, randomPos, bytes))
+						failed = true;
+				} else {
+					if (!CheckRead(*loader, data, pos, bytes))
+						failed = true;
+					pos += bytes;
+				}
+			}
+		}));
+	}
+	for (auto &thread : threads)
+		thread.join();
+	EXPECT_FALSE(failed);
+
+	// Deleting it has to wait for blocks still being read.
+	loader->Prefetch(0, 16 * BLOCK_SIZE);
+	delete loader;
+	return true;
+}
+
+bool TestReadAheadFileLoader() {
+	ScopedTestThreads threads;
+	std::vector<u8> data(FILE_SIZE);
+	GMRng rng;
+	rng.Init(5678);
+	for (size_t i = 0; i < data.size(); ++i)
+		data[i] = (u8)rng.R32();
+
+	RET(TestSequentialReads(data));
+	RET(TestInterleavedStreams(data));
+	RET(TestRandomReads(data));
+	RET(TestConcurrentReads(data));
+	return true;
+}
@@ -0,0 +1,151 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "Common/Data/Random/Rng.h"
+#include "Core/SaveStateRewind.h"
+
+#include "UnitTest.h"
+
+static const size_t STATE_PAGES = 40;
+static const size_t STATE_SIZE = STATE_PAGES * 16384 - 100;
+
+// Touches a few bytes in the given number of pages, so that many pages differ from before.
+static void DirtyPages(std::vector<u8> &state, int pages, GMRng &rng) {
+	for (int i = 0; i < pages; ++i) {
+		size_t offset = (size_t)(rng.R32() % STATE_PAGES) * 16384;
+		for (int j = 0; j < 64 && offset + j < state.size(); ++j)
+			state[offset + j] = (u8)rng.R32();
+	}
+}
+
+class RewindTester {
+public:
+	RewindTester() {
+		state_.resize(STATE_SIZE);
+		rng_.Init(1234);
+		for (size_t i = 0; i < state_.size(); ++i)
+			state_[i] = (u8)(i >> 6);
+	}
+
+	// Every few saves, enough changes to force a new base.
+	bool Save(int i, size_t budget) {
+		DirtyPages(state_, i % 5 == 4 ? (int)STATE_PAGES : 2, rng_);
+		// Changing the size also forces a new base.
+		if (i % 11 == 10)
+			state_.resize(state_.size() == STATE_SIZE ? STATE_SIZE + 5000 : STATE_SIZE);
+
+		bool saved = rewind_.Save([&](std::vector<u8> &data) {
+			data = state_;
+			return true;
+		}, budget);
+		EXPECT_TRUE(saved);
+		expected_.push_back(state_);
+
+		// Eviction only drops from the oldest end.
+		while ((int)expected_.size() > rewind_.Count())
+			expected_.pop_front();
+		EXPECT_EQ_INT(rewind_.Count(), (int)expected_.size());
+
+		size_t used = rewind_.UsedBytes();
+		// Catches the counts wrapping around, too.
+		EXPECT_TRUE(used <= budget || rewind_.Count() == 1);
+		EXPECT_TRUE(used > 0);
+		return true;
+	}
+
+	bool Restore(int count) {
+		size_t lastUsed = rewind_.UsedBytes();
+		for (int i = 0; i < count; ++i) {
+			std::vector<u8> result;
+			EXPECT_TRUE(rewind_.Restore(result));
+			EXPECT_TRUE(result == expected_.back());
+			expected_.pop_back();
+
+			size_t used = rewind_.UsedBytes();
+			EXPECT_TRUE(used < lastUsed);
+			lastUsed = used;
+		}
+		return true;
+	}
+
+	bool RestoreAll() {
+		RET(Restore((int)expected_.size()));
+		std::vector<u8> result;
+		EXPECT_FALSE(rewind_.Restore(result));
+		EXPECT_TRUE(rewind_.Empty());
+		// Everything added must have been subtracted again.
+		EXPECT_TRUE(rewind_.UsedBytes() == 0);
+		return true;
+	}
+
+	int Count() {
+		return rewind_.Count();
+	}
+
+	void Clear() {
+		rewind_.Clear();
+		expected_.clear();
+	}
+
+private:
+	SaveState::StateRingbuffer rewind_;
+	std::deque<std::vector<u8>> expected_;
+	std::vector<u8> state_;
+	GMRng rng_;
+};
+
+bool TestSaveStateRewind() {
+	ScopedTestThreads threads;
+	RewindTester tester;
+	const size_t bigBudget = 256 * 1024 * 1024;
+	// Enough for a couple of bases and their deltas.
+	const size_t smallBudget = STATE_SIZE * 2 + STATE_SIZE / 2;
+
+	bool success = [&] {
+		// Nothing gets evicted, rewind across several bases and keep going.
+		for (int i = 0; i < 12; ++i)
+			RET(tester.Save(i, bigBudget));
+		EXPECT_EQ_INT(tester.Count(), 12);
+		RET(tester.Restore(7));
+		for (int i = 12; i < 20; ++i)
+			RET(tester.Save(i, bigBudget));
+		RET(tester.RestoreAll());
+
+		// Now with eviction, which drops old bases along with their deltas.
+		for (int i = 0; i < 40; ++i)
+			RET(tester.Save(i, smallBudget));
+		EXPECT_TRUE(tester.Count() < 40);
+		RET(tester.Restore(3));
+		for (int i = 40; i < 60; ++i)
+			RET(tester.Save(i, smallBudget));
+		RET(tester.RestoreAll());
+
+		// Even a budget too small for one state keeps the newest.
+		for (int i = 0; i < 6; ++i)
+			RET(tester.Save(i, 1));
+		EXPECT_EQ_INT(tester.Count(), 1);
+		RET(tester.RestoreAll());
+		return true;
+	}();
+
+	tester.Clear();
+	return success;
+}
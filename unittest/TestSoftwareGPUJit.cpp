@@ -15,6 +15,8 @@
 // Official git repository and contact information can be found at
 // https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
 
+#include "ppsspp_config.h"
+#include "Common/CPUDetect.h"
 #include "Common/Data/Random/Rng.h"
 #include "Common/StringUtils.h"
 #include "Core/Config.h"
@@ -161,6 +163,133 @@ static bool TestPixelJit() {
 	return successes == count && !HitAnyAsserts();
 }
 
+static bool TestPixelQuadJit() {
+	using namespace Rasterizer;
+	PixelJitCache *cache = new PixelJitCache();
+	BinManager binner;
+
+	GMRng rng;
+	int tested = 0;
+	int failures = 0;
+	int count = 3000;
+
+	u32 *expected_fb = new u32[512 * 4];
+	u16 *expected_zb = new u16[512 * 4];
+	u32 *actual_fb = new u32[512 * 4];
+	u16 *actual_zb = new u16[512 * 4];
+
+	for (int i = 0; i < count; ) {
+		PixelFuncID id;
+		memset(&id, 0, sizeof(id));
+		id.fullKey = (uint64_t)rng.R32() | ((uint64_t)rng.R32() << 32);
+		// Bias towards states the quad func supports, the rest fall back to single pixels.
+		id.clearMode = false;
+		id.stencilTest = false;
+		id.colorTest = false;
+		id.applyLogicOp = false;
+		id.applyColorWriteMask = false;
+		id.hasAlphaTestMask = false;
+		id.hasStencilTestMask = false;
+		id.stencilTestRef = 0;
+		id.stencilTestFunc = 0;
+		id.sFail = 0;
+		id.zFail = 0;
+		id.zPass = 0;
+		if (id.AlphaTestFunc() == GE_COMP_ALWAYS)
+			id.alphaTestRef = 0;
+		if (!id.alphaBlend) {
+			id.alphaBlendEq = 0;
+			id.alphaBlendSrc = 0;
+			id.alphaBlendDst = 0;
+		}
+
+		std::string desc = DescribePixelFuncID(id);
+		if (startsWith(desc, "INVALID"))
+			continue;
+		i++;
+
+		id.cached.framebufStride = id.useStandardStride ? 512 : 256 + rng.R32() % 257;
+		id.cached.depthbufStride = id.useStandardStride ? 512 : 256 + rng.R32() % 257;
+		id.cached.minz = rng.R32() & 0x7FFF;
+		id.cached.maxz = id.cached.minz + (rng.R32() & 0xFFFF);
+		id.cached.fogColor = rng.R32();
+		id.cached.alphaBlendSrc = rng.R32() & 0x00FFFFFF;
+		id.cached.alphaBlendDst = rng.R32() & 0x00FFFFFF;
+		for (int k = 0; k < 16; ++k)
+			id.cached.ditherMatrix[k] = (int8_t)(rng.R32() % 8) - 4;
+
+		cache->GetSingle(id, &binner);
+		QuadFunc quadFunc = cache->GetQuad(id);
+		SingleFunc genericFunc = cache->GenericSingle(id);
+		// Not all CPUs or states have a quad func.
+		if (!quadFunc)
+			continue;
+
+		for (int k = 0; k < 512 * 4; ++k) {
+			expected_fb[k] = rng.R32();
+			expected_zb[k] = (u16)rng.R32();
+		}
+		memcpy(actual_fb, expected_fb, sizeof(u32) * 512 * 4);
+		memcpy(actual_zb, expected_zb, sizeof(u16) * 512 * 4);
+
+		int x = rng.R32() % 500;
+		int y = rng.R32() % 3;
+		PixelQuadArgs args;
+		for (int l = 0; l < 4; ++l) {
+			int offset = x + (l & 1) + (y + l / 2) * id.cached.depthbufStride;
+			args.color[l] = Math3D::Vec4<int>(rng.R32() % 300 - 20, rng.R32() % 300 - 20, rng.R32() % 300 - 20, rng.R32() % 300 - 20);
+			// Half the time, match the existing depth to exercise the equal comparisons.
+			args.z[l] = (rng.R32() & 1) ? (int)(rng.R32() & 0xFFFF) : expected_zb[offset];
+			args.fog[l] = rng.R32() & 0xFF;
+			args.mask[l] = (rng.R32() & 3) == 0 ? -1 : (int)(rng.R32() & 0x7FFFFFFF);
+		}
+
+		fb.as32 = expected_fb;
+		depthbuf.as16 = expected_zb;
+		for (int l = 0; l < 4; ++l) {
+			if (args.mask[l] >= 0)
+				genericFunc(x + (l & 1), y + l / 2, args.z[l], args.fog[l], ToVec4IntArg(args.color[l]), id);
+		}
+
+		fb.as32 = actual_fb;
+		depthbuf.as16 = actual_zb;
+		quadFunc(x, y, args, id);
+		tested++;
+
+		if (memcmp(expected_fb, actual_fb, sizeof(u32) * 512 * 4) != 0 || memcmp(expected_zb, actual_zb, sizeof(u16) * 512 * 4) != 0) {
+			if (failures == 0)
+				printf("Mismatched pixel quad funcs:\n");
+			if (failures < 10)
+				printf(" * %s (x=%d, y=%d)\n", desc.c_str(), x, y);
+			failures++;
+		}
+	}
+
+	if (failures != 0)
+		printf("PixelQuadFunc mismatches: %d / %d\n", failures, tested);
+
+	if (tested == 0) {
+#if PPSSPP_ARCH(AMD64) && !PPSSPP_PLATFORM(UWP)
+		// With AVX2, plenty of these states should have gotten one.
+		if (cpu_info.bAVX2) {
+			printf("PixelQuadFunc: no quad funcs compiled, even with AVX2\n");
+			failures++;
+		}
+#endif
+		if (failures == 0)
+			printf("PixelQuadFunc: skipped, no quad funcs on this CPU\n");
+	}
+
+	fb.as32 = nullptr;
+	depthbuf.as16 = nullptr;
+	delete [] expected_fb;
+	delete [] expected_zb;
+	delete [] actual_fb;
+	delete [] actual_zb;
+	delete cache;
+	return failures == 0 && !HitAnyAsserts();
+}
+
 bool TestSoftwareGPUJit() {
 	g_Config.bSoftwareRenderingJit = true;
 	ResetHitAnyAsserts();
@@ -173,5 +302,9 @@ bool TestSoftwareGPUJit() {
 		return false;
 	}
 
+	if (!TestPixelQuadJit()) {
+		return false;
+	}
+
 	return true;
 }
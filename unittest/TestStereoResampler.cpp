@@ -0,0 +1,279 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "Common/Math/math_util.h"
+#include "Common/TimeUtil.h"
+#include "Core/Config.h"
+#include "Core/ConfigValues.h"
+#include "Core/HW/StereoResampler.h"
+
+#include "UnitTest.h"
+
+// Everything here goes through a real StereoResampler, pushing like the emulator and mixing like an
+// audio backend, for long enough that the ring buffer wraps many times.
+
+// The PSP side is always 44.1kHz here, since the unit tests don't report a display refresh rate.
+static const int INPUT_RATE = 44100;
+// With extra buffering.
+static const int BUFFER_FRAMES = 8192;
+// Small, to find the fill limit closely.
+static const int FILL_CHUNK = 8;
+static const int MIX_PER_SECOND = 100;
+static const int RUN_SECONDS = 4;
+// Only the end is measured, once the rate is stable.
+static const int MEASURE_FRAMES = 32768;
+static const double AMPLITUDE = 16384.0;
+
+struct ResamplerRun {
+	std::vector<s16> out;
+	// How much was buffered before pushing started to fail.
+	int filledFrames = 0;
+	// Input frames per output frame, at the end.
+	double ratio = 0.0;
+	double nsPerFrame = 0.0;
+};
+
+// Generates a tone per channel, picking up where the last chunk left off.
+class ToneGenerator {
+public:
+	ToneGenerator(double freqL, double freqR) : freqL_(freqL), freqR_(freqR) {}
+
+	void Generate(std::vector<s32> &chunk, int frames) {
+		chunk.resize(frames * 2);
+		for (int i = 0; i < frames; ++i) {
+			double t = (double)(pos_ + i) / INPUT_RATE;
+			chunk[i * 2 + 0] = (s32)floor(AMPLITUDE * sin(2.0 * M_PI * freqL_ * t) + 0.5);
+			chunk[i * 2 + 1] = (s32)floor(AMPLITUDE * sin(2.0 * M_PI * freqR_ * t) + 0.5);
+		}
+	}
+
+	// Only once the resampler took it.
+	void Advance(int frames) {
+		pos_ += frames;
+	}
+
+private:
+	double freqL_;
+	double freqR_;
+	int64_t pos_ = 0;
+};
+
+static ResamplerRun RunResampler(int outputRate, double freqL, double freqR) {
+	ResamplerRun run;
+	StereoResampler resampler;
+	ToneGenerator tone(freqL, freqR);
+	std::vector<s32> chunk;
+
+	// First fill it up as far as it goes, so the buffer starts out full.
+	while (true) {
+		int overruns = resampler.OverrunCount();
+		tone.Generate(chunk, FILL_CHUNK);
+		resampler.PushSamples(chunk.data(), FILL_CHUNK);
+		if (resampler.OverrunCount() != overruns)
+			break;
+		tone.Advance(FILL_CHUNK);
+		run.filledFrames += FILL_CHUNK;
+		if (run.filledFrames > BUFFER_FRAMES)
+			break;
+	}
+
+	// Push more than gets mixed, so it stays full and some pushes get dropped. That keeps the rate
+	// control at its limit, otherwise it dithers between two ratios and smears the tone.
+	const int pushFrames = INPUT_RATE / MIX_PER_SECOND;
+	const int mixFrames = outputRate / MIX_PER_SECOND;
+	const int totalMixes = RUN_SECONDS * MIX_PER_SECOND;
+	const int measureMixes = MEASURE_FRAMES / mixFrames;
+	std::vector<s16> mixed(mixFrames * 2);
+	double mixTime = 0.0;
+	for (int i = 0; i < totalMixes; ++i) {
+		Instant start = Instant::Now();
+		resampler.Mix(mixed.data(), mixFrames, false, outputRate);
+		mixTime += start.Elapsed();
+		if (i >= totalMixes - measureMixes)
+			run.out.insert(run.out.end(), mixed.begin(), mixed.end());
+
+		for (int j = 0; j < 2; ++j) {
+			int overruns = resampler.OverrunCount();
+			tone.Generate(chunk, pushFrames);
+			resampler.PushSamples(chunk.data(), pushFrames);
+			// If it was dropped, push the same audio again next time so there's no discontinuity.
+			if (resampler.OverrunCount() == overruns)
+				tone.Advance(pushFrames);
+		}
+	}
+	run.ratio = resampler.Ratio();
+	run.nsPerFrame = mixTime * 1e9 / ((double)totalMixes * mixFrames);
+	return run;
+}
+
+// Fits a sine at freq (in cycles per output frame), returns the residual and the largest single error.
+static double FitSine(const std::vector<s16> &out, int channel, double freq, double *amplitude, double *maxError) {
+	const int frames = (int)out.size() / 2;
+	double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+	for (int i = 0; i < frames; ++i) {
+		double s = sin(2.0 * M_PI * freq * i);
+		double c = cos(2.0 * M_PI * freq * i);
+		double y = out[i * 2 + channel];
+		ss += s * s;
+		sc += s * c;
+		cc += c * c;
+		ys += y * s;
+		yc += y * c;
+	}
+	double det = ss * cc - sc * sc;
+	double a = (ys * cc - yc * sc) / det;
+	double b = (yc * ss - ys * sc) / det;
+
+	double residual = 0.0;
+	double worst = 0.0;
+	for (int i = 0; i < frames; ++i) {
+		double fit = a * sin(2.0 * M_PI * freq * i) + b * cos(2.0 * M_PI * freq * i);
+		double err = out[i * 2 + channel] - fit;
+		residual += err * err;
+		worst = std::max(worst, fabs(err));
+	}
+	if (amplitude)
+		*amplitude = sqrt(a * a + b * b);
+	if (maxError)
+		*maxError = worst;
+	return residual;
+}
+
+// The ratio is only reported to a few digits, so search for the actual frequency nearby.
+// Returns THD+N in dB, which includes any aliasing, imaging, or glitches.
+static double MeasureTHDN(const std::vector<s16> &out, int channel, double freq, double *maxError) {
+	const double range = freq * 0.00002;
+	const int steps = 10;
+	double best = freq;
+	double bestResidual = FitSine(out, channel, freq, nullptr, nullptr);
+	for (int i = -steps; i <= steps; ++i) {
+		double f = freq + range * i / steps;
+		double r = FitSine(out, channel, f, nullptr, nullptr);
+		if (r < bestResidual) {
+			bestResidual = r;
+			best = f;
+		}
+	}
+
+	// Then narrow it down around the best step.
+	double lo = best - range / steps;
+	double hi = best + range / steps;
+	for (int i = 0; i < 40; ++i) {
+		double m1 = lo + (hi - lo) / 3.0;
+		double m2 = hi - (hi - lo) / 3.0;
+		if (FitSine(out, channel, m1, nullptr, nullptr) < FitSine(out, channel, m2, nullptr, nullptr))
+			hi = m2;
+		else
+			lo = m1;
+	}
+
+	double amplitude;
+	double residual = FitSine(out, channel, (lo + hi) * 0.5, &amplitude, maxError);
+	double signal = amplitude * amplitude * 0.5 * (out.size() / 2);
+	return 10.0 * log10(residual / signal);
+}
+
+static double MeasureLevel(const std::vector<s16> &out, int channel) {
+	double sum = 0.0;
+	for (size_t i = channel; i < out.size(); i += 2)
+		sum += (double)out[i] * out[i];
+	double rms = sqrt(sum / (out.size() / 2));
+	return 20.0 * log10(std::max(rms, 1e-3) / (AMPLITUDE * M_SQRT1_2));
+}
+
+static bool TestResamplerTones(int outputRate, double freq, double thdnLimit) {
+	// Left and right get different tones, so we'd notice any mixing between them.
+	g_Config.iAudioResampler = AUDIO_RESAMPLER_LINEAR;
+	ResamplerRun linear = RunResampler(outputRate, freq, freq * 0.5);
+	g_Config.iAudioResampler = AUDIO_RESAMPLER_SINC;
+	ResamplerRun sinc = RunResampler(outputRate, freq, freq * 0.5);
+
+	double linearMax, sincMaxL, sincMaxR;
+	double linearL = MeasureTHDN(linear.out, 0, freq * linear.ratio / INPUT_RATE, &linearMax);
+	double sincL = MeasureTHDN(sinc.out, 0, freq * sinc.ratio / INPUT_RATE, &sincMaxL);
+	double sincR = MeasureTHDN(sinc.out, 1, freq * 0.5 * sinc.ratio / INPUT_RATE, &sincMaxR);
+	printf("Resampler %d -> %d THD+N at %0.0f Hz: linear %0.1f dB, sinc %0.1f dB (max error %0.0f)\n", INPUT_RATE, outputRate, freq, linearL, sincL, sincMaxL);
+
+	EXPECT_TRUE(sincL < thdnLimit);
+	EXPECT_TRUE(sincR < thdnLimit);
+	EXPECT_TRUE(sincL < linearL);
+	// A glitch at the buffer wraparound would stick out here, even if it barely moves THD+N.
+	EXPECT_TRUE(sincMaxL < AMPLITUDE * 0.01);
+	EXPECT_TRUE(sincMaxR < AMPLITUDE * 0.01);
+
+	// The sinc filter reads a few frames behind, so it can't use the last bit of the buffer.
+	printf("Resampler filled %d frames linear, %d sinc\n", linear.filledFrames, sinc.filledFrames);
+	const int sincLimit = BUFFER_FRAMES - SincResampleFilter::TAPS;
+	EXPECT_TRUE(linear.filledFrames < BUFFER_FRAMES && linear.filledFrames >= BUFFER_FRAMES - FILL_CHUNK);
+	EXPECT_TRUE(sinc.filledFrames < sincLimit && sinc.filledFrames >= sincLimit - FILL_CHUNK);
+	return true;
+}
+
+static bool TestResamplerStopband(int outputRate, double freq, double limit) {
+	// Above the output's Nyquist frequency, so anything left is aliasing.
+	g_Config.iAudioResampler = AUDIO_RESAMPLER_LINEAR;
+	ResamplerRun linear = RunResampler(outputRate, freq, freq);
+	g_Config.iAudioResampler = AUDIO_RESAMPLER_SINC;
+	ResamplerRun sinc = RunResampler(outputRate, freq, freq);
+
+	double linearLevel = MeasureLevel(linear.out, 0);
+	double sincLevel = MeasureLevel(sinc.out, 0);
+	printf("Resampler %d -> %d at %0.0f Hz: linear %0.1f dB, sinc %0.1f dB\n", INPUT_RATE, outputRate, freq, linearLevel, sincLevel);
+	EXPECT_TRUE(sincLevel < limit);
+	EXPECT_TRUE(sincLevel < linearLevel);
+	return true;
+}
+
+bool TestStereoResampler() {
+	const int oldResampler = g_Config.iAudioResampler;
+	const int oldVolume = g_Config.iGlobalVolume;
+	const bool oldExtraBuffering = g_Config.bExtraAudioBuffering;
+	g_Config.iGlobalVolume = VOLUME_FULL;
+	g_Config.bExtraAudioBuffering = true;
+
+	bool success = [] {
+		// Upsampling, like the PSP's 44.1kHz played on a 48kHz device.
+		// Phase rounding error grows with frequency, but it's far better than linear either way.
+		RET(TestResamplerTones(48000, 1000.0, -80.0));
+		RET(TestResamplerTones(48000, 10000.0, -60.0));
+
+		// Downsampling, where the cutoff moves down to below the output's Nyquist frequency.
+		RET(TestResamplerTones(32000, 1000.0, -80.0));
+		RET(TestResamplerTones(32000, 12000.0, -60.0));
+		// With only 16 taps the transition band is wide, so test a bit past it.
+		RET(TestResamplerStopband(32000, 21000.0, -55.0));
+		RET(TestResamplerStopband(22050, 18000.0, -70.0));
+
+		// And the speed per output frame.
+		g_Config.iAudioResampler = AUDIO_RESAMPLER_LINEAR;
+		double linearNs = RunResampler(48000, 1000.0, 500.0).nsPerFrame;
+		g_Config.iAudioResampler = AUDIO_RESAMPLER_SINC;
+		double sincNs = RunResampler(48000, 1000.0, 500.0).nsPerFrame;
+		printf("Resampler speed: linear %0.2f ns/sample, sinc %0.2f ns/sample\n", linearNs, sincNs);
+		return true;
+	}();
+
+	g_Config.iAudioResampler = oldResampler;
+	g_Config.iGlobalVolume = oldVolume;
+	g_Config.bExtraAudioBuffering = oldExtraBuffering;
+	return success;
+}
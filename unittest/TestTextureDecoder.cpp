@@ -0,0 +1,250 @@
+// Copyright (c) 2023- PPSSPP Project.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, version 2.0 or later versions.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License 2.0 for more details.
+
+// A copy of the GPL 2.0 should have been included with the program.
+// If not, see http://www.gnu.org/licenses/
+
+// Official git repository and contact information can be found at
+// https://github.com/hrydgard/ppsspp and http://www.ppsspp.org/.
+
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "Common/Data/Convert/ColorConv.h"
+#include "Common/Data/Convert/SmallDataConvert.h"
+#include "Common/Data/Random/Rng.h"
+#include "Common/MemoryUtil.h"
+#include "Common/TimeUtil.h"
+#include "GPU/Common/TextureDecoder.h"
+
+#include "UnitTest.h"
+
+// Big enough for a 512x512 texture at 32 bits per pixel.
+static const int TEST_PIXELS = 512 * 512;
+
+static void FillRandom(u8 *p, size_t bytes, u32 seed) {
+	GMRng rng;
+	rng.Init(seed);
+	for (size_t i = 0; i < bytes; ++i)
+		p[i] = (u8)rng.R32();
+}
+
+// Runs func until enough time passed to get a stable number, and returns MB/s of output.
+static double Benchmark(size_t outBytes, const std::function<void()> &func) {
+	int runs = 0;
+	Instant start = Instant::Now();
+	double elapsed;
+	do {
+		func();
+		runs++;
+		elapsed = start.Elapsed();
+	} while (elapsed < 0.02);
+	return (double)outBytes * runs / (1024.0 * 1024.0) / elapsed;
+}
+
+template <typename ClutT>
+static void ReferenceDeIndex4(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
+	ClutT alphaSum = (ClutT)-1;
+	for (int i = 0; i < length; ++i) {
+		ClutT color = clut[(indexed[i / 2] >> ((i & 1) * 4)) & 0xF];
+		alphaSum &= color;
+		dest[i] = color;
+	}
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+template <typename ClutT>
+static void ReferenceDeIndex8(ClutT *dest, const u8 *indexed, int length, const ClutT *clut, u32 *outAlphaSum) {
+	ClutT alphaSum = (ClutT)-1;
+	for (int i = 0; i < length; ++i) {
+		ClutT color = clut[indexed[i]];
+		alphaSum &= color;
+		dest[i] = color;
+	}
+	*outAlphaSum &= (u32)alphaSum;
+}
+
+typedef void (*DeIndexFunc16)(u16 *dest, const u8 *indexed, int length, const u16 *clut, u32 *outAlphaSum);
+typedef void (*DeIndexFunc32)(u32 *dest, const u8 *indexed, int length, const u32 *clut, u32 *outAlphaSum);
+
+template <typename ClutT>
+static bool TestDeIndex(const char *name, int bitsPerIndex, void (*func)(ClutT *, const u8 *, int, const ClutT *, u32 *), void (*ref)(ClutT *, const u8 *, int, const ClutT *, u32 *)) {
+	// Twice the entries used, since the 16-bit gather may read past them (like the real CLUT buffer.)
+	std::vector<ClutT> clut(512);
+	std::vector<u8> indexed(TEST_PIXELS + 64);
+	std::vector<ClutT> dest(TEST_PIXELS + 64), expected(TEST_PIXELS + 64);
+	FillRandom((u8 *)clut.data(), clut.size() * sizeof(ClutT), 1234);
+	FillRandom(indexed.data(), indexed.size(), 5678);
+
+	// Odd lengths and offsets cover the tails and unaligned pointers.
+	static const int lengths[] = { 1, 2, 7, 16, 31, 32, 63, 64, 65, 127, 200, 512, 1000 };
+	static const int offsets[] = { 0, 1, 3 };
+	for (int length : lengths) {
+		for (int offset : offsets) {
+			// Full alpha in every color sometimes, so the sum is interesting both ways.
+			for (int fullAlpha = 0; fullAlpha < 2; ++fullAlpha) {
+				std::vector<ClutT> testClut = clut;
+				if (fullAlpha) {
+					for (ClutT &c : testClut)
+						c |= (ClutT)(sizeof(ClutT) == 2 ? 0xF000 : 0xFF000000);
+				}
+				u32 alphaSum = 0xFFFFFFFF, expectedAlphaSum = 0xFFFFFFFF;
+				memset(dest.data(), 0, dest.size() * sizeof(ClutT));
+				memset(expected.data(), 0, expected.size() * sizeof(ClutT));
+				const u8 *src = indexed.data() + offset;
+				func(dest.data() + offset, src, length, testClut.data(), &alphaSum);
+				ref(expected.data() + offset, src, length, testClut.data(), &expectedAlphaSum);
+				if (memcmp(dest.data(), expected.data(), dest.size() * sizeof(ClutT)) != 0 || alphaSum != expectedAlphaSum) {
+					printf("%s: mismatch at length %d, offset %d (alpha %08x, expected %08x)\n", name, length, offset, alphaSum, expectedAlphaSum);
+					return false;
+				}
+			}
+		}
+	}
+
+	u32 alphaSum = 0xFFFFFFFF;
+	const int rowPixels = 512;
+	const int rows = TEST_PIXELS / rowPixels;
+	auto run = [&](void (*f)(ClutT *, const u8 *, int, const ClutT *, u32 *)) {
+		for (int y = 0; y < rows; ++y)
+			f(dest.data() + y * rowPixels, indexed.data() + y * rowPixels * bitsPerIndex / 8, rowPixels, clut.data(), &alphaSum);
+	};
+	double speed = Benchmark(TEST_PIXELS * sizeof(ClutT), [&] { run(func); });
+	double refSpeed = Benchmark(TEST_PIXELS * sizeof(ClutT), [&] { run(ref); });
+	printf("%s: %0.1f MB/s (scalar %0.1f MB/s)\n", name, speed, refSpeed);
+	return true;
+}
+
+typedef void (*Convert16To32Func)(u32 *dst, const u16 *src, u32 numPixels);
+
+static u32 Reference565(u16 c) {
+	return Convert5To8(c & 0x1F) | (Convert6To8((c >> 5) & 0x3F) << 8) | (Convert5To8((c >> 11) & 0x1F) << 16) | 0xFF000000;
+}
+
+static u32 Reference5551(u16 c) {
+	return Convert5To8(c & 0x1F) | (Convert5To8((c >> 5) & 0x1F) << 8) | (Convert5To8((c >> 10) & 0x1F) << 16) | ((c >> 15) ? 0xFF000000 : 0);
+}
+
+static u32 Reference4444(u16 c) {
+	return Convert4To8(c & 0xF) | (Convert4To8((c >> 4) & 0xF) << 8) | (Convert4To8((c >> 8) & 0xF) << 16) | ((u32)Convert4To8(c >> 12) << 24);
+}
+
+static bool TestConvert16To32(const char *name, Convert16To32Func func, u32 (*ref)(u16)) {
+	// The SSE2 path wants aligned pointers, so use aligned memory and test both ways.
+	u16 *src = (u16 *)AllocateAlignedMemory((TEST_PIXELS + 16) * sizeof(u16), 32);
+	u32 *dest = (u32 *)AllocateAlignedMemory((TEST_PIXELS + 16) * sizeof(u32), 32);
+	FillRandom((u8 *)src, (TEST_PIXELS + 16) * sizeof(u16), 4321);
+
+	bool success = true;
+	static const u32 lengths[] = { 1, 7, 8, 15, 16, 17, 33, 100, 512 };
+	for (u32 length : lengths) {
+		for (int offset = 0; offset < 2 && success; ++offset) {
+			memset(dest, 0, (TEST_PIXELS + 16) * sizeof(u32));
+			func(dest + offset, src + offset, length);
+			for (u32 i = 0; i < length + 2; ++i) {
+				u32 expected = i >= (u32)offset && i < length + offset ? ref(src[i]) : 0;
+				if (dest[i] != expected) {
+					printf("%s: mismatch at length %d, offset %d, pixel %d: %08x, expected %08x\n", name, length, offset, i, dest[i], expected);
+					success = false;
+					break;
+				}
+			}
+		}
+	}
+
+	if (success) {
+		double speed = Benchmark(TEST_PIXELS * sizeof(u32), [&] { func(dest, src, TEST_PIXELS); });
+		double refSpeed = Benchmark(TEST_PIXELS * sizeof(u32), [&] {
+			for (int i = 0; i < TEST_PIXELS; ++i)
+				dest[i] = ref(src[i]);
+		});
+		printf("%s: %0.1f MB/s (scalar %0.1f MB/s)\n", name, speed, refSpeed);
+	}
+
+	FreeAlignedMemory(src);
+	FreeAlignedMemory(dest);
+	return success;
+}
+
+static void ReferenceUnswizzle(const u8 *texptr, u8 *dest, int bxc, int byc, u32 pitch) {
+	for (int by = 0; by < byc; ++by) {
+		for (int bx = 0; bx < bxc; ++bx) {
+			for (int n = 0; n < 8; ++n) {
+				memcpy(dest + (by * 8 + n) * pitch + bx * 16, texptr, 16);
+				texptr += 16;
+			}
+		}
+	}
+}
+
+static bool TestSwizzle() {
+	const u32 bufferSize = TEST_PIXELS * sizeof(u32);
+	u8 *swizzled = (u8 *)AllocateAlignedMemory(bufferSize, 16);
+	u8 *linear = (u8 *)AllocateAlignedMemory(bufferSize, 16);
+	u8 *expected = (u8 *)AllocateAlignedMemory(bufferSize, 16);
+	u8 *reswizzled = (u8 *)AllocateAlignedMemory(bufferSize, 16);
+	FillRandom(swizzled, bufferSize, 8765);
+
+	bool success = true;
+	// Odd numbers of blocks across, and a pitch wider than the blocks, like a texture in a larger buffer.
+	static const int sizes[][3] = { { 1, 1, 16 }, { 3, 2, 48 }, { 8, 4, 128 }, { 5, 3, 128 }, { 64, 64, 1024 }, { 128, 16, 2048 } };
+	for (const auto &size : sizes) {
+		const int bxc = size[0], byc = size[1];
+		const u32 pitch = size[2];
+		memset(linear, 0, bufferSize);
+		memset(expected, 0, bufferSize);
+		DoUnswizzleTex16(swizzled, (u32 *)linear, bxc, byc, pitch);
+		ReferenceUnswizzle(swizzled, expected, bxc, byc, pitch);
+		if (memcmp(linear, expected, bufferSize) != 0) {
+			printf("Unswizzle: mismatch at %dx%d blocks, pitch %d\n", bxc, byc, pitch);
+			success = false;
+			break;
+		}
+
+		DoSwizzleTex16((const u32 *)linear, reswizzled, bxc, byc, pitch);
+		if (memcmp(reswizzled, swizzled, bxc * byc * 128) != 0) {
+			printf("Swizzle: mismatch at %dx%d blocks, pitch %d\n", bxc, byc, pitch);
+			success = false;
+			break;
+		}
+	}
+
+	if (success) {
+		// A 512x512 texture at 32 bits per pixel.
+		const int bxc = 512 * 4 / 16, byc = 512 / 8;
+		const u32 pitch = 512 * 4;
+		double speed = Benchmark(bufferSize, [&] { DoUnswizzleTex16(swizzled, (u32 *)linear, bxc, byc, pitch); });
+		double refSpeed = Benchmark(bufferSize, [&] { ReferenceUnswizzle(swizzled, expected, bxc, byc, pitch); });
+		printf("Unswizzle: %0.1f MB/s (scalar %0.1f MB/s)\n", speed, refSpeed);
+		speed = Benchmark(bufferSize, [&] { DoSwizzleTex16((const u32 *)linear, reswizzled, bxc, byc, pitch); });
+		printf("Swizzle: %0.1f MB/s\n", speed);
+	}
+
+	FreeAlignedMemory(swizzled);
+	FreeAlignedMemory(linear);
+	FreeAlignedMemory(expected);
+	FreeAlignedMemory(reswizzled);
+	return success;
+}
+
+bool TestTextureDecoder() {
+	RET(TestSwizzle());
+	RET(TestDeIndex<u16>("CLUT4 16-bit", 4, (DeIndexFunc16)&DeIndexTexture4Simple, &ReferenceDeIndex4<u16>));
+	RET(TestDeIndex<u32>("CLUT4 32-bit", 4, (DeIndexFunc32)&DeIndexTexture4Simple, &ReferenceDeIndex4<u32>));
+	RET(TestDeIndex<u16>("CLUT8 16-bit", 8, (DeIndexFunc16)&DeIndexTexture8Simple, &ReferenceDeIndex8<u16>));
+	RET(TestDeIndex<u32>("CLUT8 32-bit", 8, (DeIndexFunc32)&DeIndexTexture8Simple, &ReferenceDeIndex8<u32>));
+	RET(TestConvert16To32("RGB565 to RGBA8888", &ConvertRGB565ToRGBA8888, &Reference565));
+	RET(TestConvert16To32("RGBA5551 to RGBA8888", &ConvertRGBA5551ToRGBA8888, &Reference5551));
+	RET(TestConvert16To32("RGBA4444 to RGBA8888", &ConvertRGBA4444ToRGBA8888, &Reference4444));
+	return true;
+}
@@ -29,12 +29,19 @@
 
 #include "ppsspp_config.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <cmath>
+#include <deque>
+#include <memory>
 #include <vector>
 #include <string>
 #include <sstream>
+#include <thread>
+#include <zstd.h>
 
 #if PPSSPP_PLATFORM(ANDROID)
 #include <jni.h>
@@ -45,9 +52,13 @@
 #include "Common/Data/Text/Parsers.h"
 #include "Common/Data/Text/WrapText.h"
 #include "Common/Data/Encoding/Utf8.h"
+#include "Common/Data/Format/JSONReader.h"
+#include "Common/Data/Random/Rng.h"
+#include "Common/File/FileUtil.h"
 #include "Common/File/Path.h"
 #include "Common/Input/InputState.h"
 #include "Common/Math/math_util.h"
+#include "Common/Profiler/Profiler.h"
 #include "Common/Render/DrawBuffer.h"
 #include "Common/System/NativeApp.h"
 #include "Common/System/System.h"
@@ -56,11 +67,20 @@
 #include "Common/BitScan.h"
 #include "Common/CPUDetect.h"
 #include "Common/Log.h"
+#include "Common/Thread/ThreadManager.h"
+#include "Common/Thread/ThreadUtil.h"
+#include "Common/TimeUtil.h"
 #include "Core/Config.h"
 #include "Core/FileSystems/ISOFileSystem.h"
+#include "Core/HLE/ThreadQueueList.h"
+#include "Core/HW/SasAudio.h"
 #include "Core/MemMap.h"
 #include "Core/MIPS/MIPSVFPUUtils.h"
+#include "GPU/Common/TextureCacheCommon.h"
 #include "GPU/Common/TextureDecoder.h"
+#include "GPU/Common/TextureScalerCommon.h"
+#include "GPU/Common/VertexCache.h"
+#include "GPU/Debugger/Playback.h"
 
 #include "android/jni/AndroidContentURI.h"
 
@@ -543,6 +563,8 @@ bool TestQuickTexHash() {
 		p[i] = j & 0xFF;
 	}
 	EXPECT_EQ_HEX(StableQuickTexHash(buf, BUF_SIZE), 0x58de8dbc);
+	// Small sizes aren't split.
+	EXPECT_EQ_HEX(ParallelQuickTexHash(buf, BUF_SIZE), 0x58de8dbc);
 
 	return true;
 }
@@ -621,6 +643,115 @@ static bool TestMemMap() {
 	EXPECT_EQ_HEX(Memory::ValidSize(0x00015000, 4), 0);
 	EXPECT_EQ_HEX(Memory::ValidSize(0x04900000, 4), 0);
 
+	// Write tracking, by page.
+	u32 stamp = Memory::NextWriteStamp();
+	EXPECT_FALSE(Memory::WrittenSince(0x08800000, 0x2000, stamp));
+	Memory::MarkWritten(0x08801FFC, 8);
+	EXPECT_TRUE(Memory::WrittenSince(0x08800000, 0x2000, stamp));
+	EXPECT_TRUE(Memory::WrittenSince(0x48802000, 4, stamp));
+	EXPECT_FALSE(Memory::WrittenSince(0x08800000, 0x1000, stamp));
+	EXPECT_FALSE(Memory::WrittenSince(0x08801000, 0x1000, Memory::NextWriteStamp()));
+	// VRAM mirrors share pages.
+	Memory::MarkWritten(0x04600000, 4);
+	EXPECT_TRUE(Memory::WrittenSince(0x04000000, 4, stamp));
+	// Untracked memory is always considered written.
+	EXPECT_TRUE(Memory::WrittenSince(0x00010000, 4, Memory::NextWriteStamp()));
+	stamp = Memory::NextWriteStamp();
+	Memory::MarkAllWritten();
+	EXPECT_TRUE(Memory::WrittenSince(0x08900000, 4, stamp));
+	EXPECT_FALSE(Memory::WrittenSince(0x08900000, 4, Memory::NextWriteStamp()));
+
+	return true;
+}
+
+static bool TestTextureWriteTracking() {
+	// A 256x256 8888 texture, 256KB, of which sizeInRAM only counts the first half.
+	TexCacheEntry entry{};
+	entry.addr = 0x08A00000;
+	entry.format = GE_TFMT_8888;
+	entry.bufw = 256;
+	entry.dim = (8 << 8) | 8;
+	entry.sizeInRAM = (textureBitsPerPixel[GE_TFMT_8888] * 256 * 256 / 2) / 8;
+	entry.hashWriteStamp = Memory::NextWriteStamp();
+	EXPECT_FALSE(entry.WrittenSinceHash());
+
+	// Just past the first half still needs a rehash.
+	Memory::MarkWritten(entry.addr + entry.sizeInRAM + 0x1000, 4);
+	EXPECT_TRUE(entry.WrittenSinceHash());
+
+	entry.hashWriteStamp = Memory::NextWriteStamp();
+	Memory::MarkWritten(entry.addr + 256 * 256 * 4 - 4, 4);
+	EXPECT_TRUE(entry.WrittenSinceHash());
+
+	// But not right after the texture.
+	entry.hashWriteStamp = Memory::NextWriteStamp();
+	Memory::MarkWritten(entry.addr + 256 * 256 * 4, 4);
+	EXPECT_FALSE(entry.WrittenSinceHash());
+	return true;
+}
+
+static bool TestGEDumpConvert() {
+	using namespace GPURecord;
+	const Path v6Path("unittest_gedump_v6.ppdmp");
+	const Path v7Path("unittest_gedump_v7.ppdmp");
+
+	// Seven 9-byte commands don't end on a 16-byte boundary, so the converted pushbuf gets padded.
+	GMRng rng;
+	rng.Init(1234);
+	std::vector<Command> commands;
+	for (u32 i = 0; i < 7; ++i)
+		commands.push_back(Command{ i & 1 ? CommandType::VERTICES : CommandType::REGISTERS, 100 + i * 13, i * 500 });
+	std::vector<u8> pushbuf(5000);
+	for (u8 &b : pushbuf)
+		b = (u8)rng.R32();
+
+	// Written the same way recordings are.
+	Header header{};
+	memcpy(header.magic, HEADER_MAGIC, sizeof(header.magic));
+	header.version = COMPRESSED_VERSION;
+	memcpy(header.gameID, "ULUS10000", sizeof(header.gameID));
+	u32 sz = (u32)commands.size();
+	u32 bufsz = (u32)pushbuf.size();
+	FILE *fp = File::OpenCFile(v6Path, "wb");
+	EXPECT_TRUE(fp != nullptr);
+	auto writeCompressed = [fp](const void *p, size_t size) {
+		std::vector<u8> compressed(ZSTD_compressBound(size));
+		u32 compressedSize = (u32)ZSTD_compress(compressed.data(), compressed.size(), p, size, 6);
+		fwrite(&compressedSize, sizeof(compressedSize), 1, fp);
+		fwrite(compressed.data(), 1, compressedSize, fp);
+	};
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(&sz, sizeof(sz), 1, fp);
+	fwrite(&bufsz, sizeof(bufsz), 1, fp);
+	writeCompressed(commands.data(), sz * sizeof(Command));
+	writeCompressed(pushbuf.data(), bufsz);
+	fclose(fp);
+
+	bool converted = ConvertToUncompressed(v6Path, v7Path);
+	auto readMatches = [&](const Path &path, bool mapped, uint32_t version) {
+		Header readHeader;
+		std::vector<Command> readCommands;
+		std::vector<u8> readPushbuf;
+		if (!ReadDumpFile(path, mapped, readHeader, readCommands, readPushbuf))
+			return false;
+		return readHeader.version == version && memcmp(readHeader.gameID, header.gameID, sizeof(header.gameID)) == 0 &&
+			readCommands.size() == sz && memcmp(readCommands.data(), commands.data(), sz * sizeof(Command)) == 0 && readPushbuf == pushbuf;
+	};
+	bool v6Read = readMatches(v6Path, false, COMPRESSED_VERSION);
+	bool v7Read = readMatches(v7Path, false, UNCOMPRESSED_VERSION);
+	bool v7Mapped = readMatches(v7Path, true, UNCOMPRESSED_VERSION);
+	// Compressed dumps can only be read, not mapped.
+	bool v6Mapped = readMatches(v6Path, true, COMPRESSED_VERSION);
+	u64 v7Size = File::GetFileSize(v7Path);
+	File::Delete(v6Path);
+	File::Delete(v7Path);
+
+	EXPECT_TRUE(converted);
+	EXPECT_TRUE(v6Read);
+	EXPECT_TRUE(v7Read);
+	EXPECT_TRUE(v7Mapped);
+	EXPECT_FALSE(v6Mapped);
+	EXPECT_EQ_INT(v7Size, UncompressedPushbufOffset(sz) + bufsz);
 	return true;
 }
 
@@ -795,6 +926,508 @@ static bool TestSmallDataConvert() {
 	return true;
 }
 
+static bool TestSasMixer() {
+	// The SIMD mixer must match the scalar one exactly, including at the extremes.
+	static const int MAX_COUNT = 67;
+	s16 samples[MAX_COUNT];
+	int envelope[MAX_COUNT];
+	int mixSimd[MAX_COUNT * 2], sendSimd[MAX_COUNT * 2];
+	int mixGeneric[MAX_COUNT * 2], sendGeneric[MAX_COUNT * 2];
+	static const s16 edgeSamples[] = { -32768, 32767, -1, 0, 1 };
+	static const int edgeEnvelope[] = { 0, 0x8000, 0x7FFF, 1, 0x4000 };
+	static const int volumes[] = { 0x1000, -0x1000, 0, 0x7FFF, -0x7FFF, 0x0800, -1 };
+
+	GMRng rng;
+	rng.Init(0x12345678);
+
+	for (int count = 0; count <= MAX_COUNT; ++count) {
+		for (int i = 0; i < count; ++i) {
+			u32 r = rng.R32();
+			samples[i] = (r & 3) == 0 ? edgeSamples[r % ARRAY_SIZE(edgeSamples)] : (s16)rng.R32();
+			r = rng.R32();
+			envelope[i] = (r & 3) == 0 ? edgeEnvelope[r % ARRAY_SIZE(edgeEnvelope)] : (int)(rng.R32() % 0x8001);
+		}
+		for (int i = 0; i < MAX_COUNT * 2; ++i) {
+			mixSimd[i] = mixGeneric[i] = (int)rng.R32() - (1 << 23);
+			sendSimd[i] = sendGeneric[i] = (int)rng.R32() - (1 << 23);
+		}
+
+		int volumeLeft = volumes[rng.R32() % ARRAY_SIZE(volumes)];
+		int volumeRight = volumes[rng.R32() % ARRAY_SIZE(volumes)];
+		int effectLeft = volumes[rng.R32() % ARRAY_SIZE(volumes)];
+		int effectRight = volumes[rng.R32() % ARRAY_SIZE(volumes)];
+		SasMixSamples(mixSimd, sendSimd, samples, envelope, count, volumeLeft, volumeRight, effectLeft, effectRight);
+		SasMixSamplesGeneric(mixGeneric, sendGeneric, samples, envelope, count, volumeLeft, volumeRight, effectLeft, effectRight);
+
+		for (int i = 0; i < MAX_COUNT * 2; ++i) {
+			if (mixSimd[i] != mixGeneric[i] || sendSimd[i] != sendGeneric[i]) {
+				printf("SAS mixer mismatch at %d of %d: mix %d vs %d, send %d vs %d\n", i, count, mixSimd[i], mixGeneric[i], sendSimd[i], sendGeneric[i]);
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool TestThreadQueueList() {
+	// Compare against a simple model, with wakes and sleeps spread across every priority.
+	static const int NUM_THREADS = 512;
+	ThreadQueueList queue;
+	std::deque<SceUID> reference[ThreadQueueList::NUM_QUEUES];
+	int priorities[NUM_THREADS];
+	bool ready[NUM_THREADS]{};
+	for (int i = 0; i < ThreadQueueList::NUM_QUEUES; ++i)
+		queue.prepare(i);
+
+	GMRng rng;
+	rng.Init(0x87654321);
+	auto referenceFirst = [&](int limit) {
+		for (int i = 0; i < limit; ++i) {
+			if (!reference[i].empty())
+				return i;
+		}
+		return -1;
+	};
+
+	for (int i = 0; i < 200000; ++i) {
+		SceUID id = (SceUID)(rng.R32() % NUM_THREADS);
+		int action = rng.R32() % 6;
+		if (!ready[id]) {
+			priorities[id] = rng.R32() % ThreadQueueList::NUM_QUEUES;
+			ready[id] = true;
+			if (action & 1) {
+				queue.push_front(priorities[id], id + 1);
+				reference[priorities[id]].push_front(id + 1);
+			} else {
+				queue.push_back(priorities[id], id + 1);
+				reference[priorities[id]].push_back(id + 1);
+			}
+		} else if (action == 0) {
+			ready[id] = false;
+			queue.remove(priorities[id], id + 1);
+			auto &ref = reference[priorities[id]];
+			ref.erase(std::find(ref.begin(), ref.end(), id + 1));
+		} else if (action == 1) {
+			queue.rotate(priorities[id]);
+			auto &ref = reference[priorities[id]];
+			if (ref.size() > 1) {
+				ref.push_back(ref.front());
+				ref.pop_front();
+			}
+		} else {
+			int first = referenceFirst(ThreadQueueList::NUM_QUEUES);
+			EXPECT_EQ_INT(queue.peek_first(), first == -1 ? 0 : reference[first].front());
+			if (action != 2 && first == -1)
+				continue;
+
+			u32 limit = action == 2 ? rng.R32() % ThreadQueueList::NUM_QUEUES : ThreadQueueList::NUM_QUEUES;
+			int best = referenceFirst(limit);
+			SceUID expected = best == -1 ? 0 : reference[best].front();
+			EXPECT_EQ_INT(action == 2 ? queue.pop_first_better(limit) : queue.pop_first(), expected);
+			if (best != -1) {
+				reference[best].pop_front();
+				ready[expected - 1] = false;
+			}
+		}
+
+		for (int p = 0; p < ThreadQueueList::NUM_QUEUES; p += 17)
+			EXPECT_EQ_INT(queue.empty(p), reference[p].empty());
+	}
+
+	// Now a storm: every thread wakes at a random priority, then they all run and sleep again.
+	// Most time goes to finding the best ready thread, which used to walk every used priority.
+	queue.clear();
+	for (int i = 0; i < ThreadQueueList::NUM_QUEUES; ++i)
+		queue.prepare(i);
+	const int STORMS = 2000;
+	Instant start = Instant::Now();
+	for (int storm = 0; storm < STORMS; ++storm) {
+		for (int i = 0; i < NUM_THREADS; ++i)
+			queue.push_back(rng.R32() % ThreadQueueList::NUM_QUEUES, i + 1);
+		for (int i = 0; i < NUM_THREADS; ++i) {
+			// A running thread checks if anyone better woke up, then yields.
+			queue.pop_first_better(ThreadQueueList::NUM_QUEUES - 1);
+			queue.peek_first();
+		}
+		while (!queue.empty(ThreadQueueList::NUM_QUEUES - 1))
+			queue.pop_first();
+	}
+	double elapsed = start.Elapsed();
+	printf("ThreadQueueList: %0.1f ns per wake/switch\n", elapsed * 1e9 / ((double)STORMS * NUM_THREADS));
+	return true;
+}
+
+static bool TestTextureScaler() {
+	// Scaling on a thread uses a serial scaler, it must match the parallel one.
+	ScopedTestThreads threads;
+
+	static const int W = 64;
+	static const int H = 48;
+	std::vector<u32> src(W * H);
+	for (int y = 0; y < H; ++y) {
+		for (int x = 0; x < W; ++x) {
+			// Blocky, so xBRZ actually finds some edges.
+			u32 block = (u32)((y / 4) * W + x / 4);
+			src[y * W + x] = (block * 2654435761U) | ((block & 1) ? 0xFF000000 : 0);
+		}
+	}
+
+	const int oldType = g_Config.iTexScalingType;
+	const bool oldDeposterize = g_Config.bTexDeposterize;
+	bool success = true;
+	for (int type = TextureScalerCommon::XBRZ; type <= TextureScalerCommon::HYBRID_BICUBIC && success; ++type) {
+		for (int factor = 2; factor <= 4 && success; ++factor) {
+			g_Config.iTexScalingType = type;
+			g_Config.bTexDeposterize = factor == 3;
+			std::vector<u32> parallelOut(W * H * factor * factor), serialOut(W * H * factor * factor);
+			TextureScalerCommon parallel;
+			TextureScalerCommon serial(false);
+			int w1 = W, h1 = H, w2 = W, h2 = H;
+			parallel.ScaleAlways(parallelOut.data(), src.data(), w1, h1, factor);
+			serial.ScaleAlways(serialOut.data(), src.data(), w2, h2, factor);
+			if (w1 != w2 || h1 != h2 || parallelOut != serialOut) {
+				printf("Texture scaler type %d factor %d: serial result differs\n", type, factor);
+				success = false;
+			}
+
+			// Background scaling runs the planned passes a few lines at a time.
+			std::vector<u32> plannedOut(W * H * factor * factor);
+			std::vector<TextureScalerCommon::ScalePass> passes;
+			TextureScalerCommon planned(false);
+			planned.PlanScaleAlways(passes, plannedOut.data(), src.data(), W, H, factor);
+			for (const auto &pass : passes) {
+				for (int line = pass.lower; line < pass.upper; line += 5)
+					pass.loop(line, std::min(line + 5, pass.upper));
+			}
+			if (plannedOut != serialOut) {
+				printf("Texture scaler type %d factor %d: result in pieces differs\n", type, factor);
+				success = false;
+			}
+		}
+	}
+	g_Config.iTexScalingType = oldType;
+	g_Config.bTexDeposterize = oldDeposterize;
+	return success;
+}
+
+// Keeps a worker busy until released, so queued jobs stay queued as long as we need.
+class BlockingTask : public Task {
+public:
+	BlockingTask(std::atomic<int> &running, std::atomic<bool> &release) : running_(running), release_(release) {}
+
+	TaskType Type() const override {
+		return TaskType::CPU_COMPUTE;
+	}
+
+	void Run() override {
+		running_++;
+		while (!release_)
+			sleep_ms(1);
+	}
+
+private:
+	std::atomic<int> &running_;
+	std::atomic<bool> &release_;
+};
+
+static bool WaitForScaleJob(const std::shared_ptr<TextureScaleJob> &job, int timeoutMs = 5000) {
+	for (int i = 0; i < timeoutMs && !job->done; ++i)
+		sleep_ms(1);
+	return job->done;
+}
+
+static bool TestTextureScaleQueue() {
+	// These outlive the threads, which may still be finishing BlockingTasks.
+	std::atomic<int> running{};
+	std::atomic<int> pinnedRan{};
+	std::atomic<bool> release{};
+	ScopedTestThreads threads;
+	const int oldType = g_Config.iTexScalingType;
+	const bool oldDeposterize = g_Config.bTexDeposterize;
+	g_Config.iTexScalingType = TextureScalerCommon::XBRZ;
+	g_Config.bTexDeposterize = false;
+
+	static const int W = 32;
+	static const int H = 32;
+	static const int FACTOR = 2;
+	static const int MAX_JOBS = TextureScaleQueue::MAX_JOBS;
+	std::vector<u32> src(W * H);
+	for (int i = 0; i < W * H; ++i)
+		src[i] = ((i / 4) * 2654435761U) | 0xFF000000;
+	std::vector<u32> expected(W * H * FACTOR * FACTOR);
+	int w = W, h = H;
+	TextureScalerCommon(false).ScaleAlways(expected.data(), src.data(), w, h, FACTOR);
+
+	auto makeJob = [&](u32 fullhash) {
+		std::shared_ptr<TextureScaleJob> job = std::make_shared<TextureScaleJob>();
+		job->fullhash = fullhash;
+		job->w = W;
+		job->h = H;
+		job->scaleFactor = FACTOR;
+		job->pixels = src;
+		return job;
+	};
+
+	const int numWorkers = g_threadManager.GetNumLooperThreads();
+	for (int i = 0; i < numWorkers; ++i)
+		g_threadManager.EnqueueTaskOnThread(i, new BlockingTask(running, release));
+	while (running < numWorkers)
+		sleep_ms(1);
+
+	TextureScaleQueue queue;
+	bool success = [&] {
+		EXPECT_TRUE(queue.CanMakeProgress(1));
+		EXPECT_TRUE(queue.CanStart(1));
+
+		std::vector<std::shared_ptr<TextureScaleJob>> jobs;
+		for (u64 key = 1; key <= MAX_JOBS; ++key) {
+			jobs.push_back(makeJob(0x1000 + (u32)key));
+			queue.Start(key, jobs.back());
+		}
+		// Still scaling, so rebuilding the textures now wouldn't get them any further.
+		EXPECT_FALSE(queue.CanMakeProgress(1));
+		EXPECT_FALSE(queue.CanStart(1));
+		EXPECT_TRUE(queue.TakeFinished(1, 0x1001, W, H, FACTOR) == nullptr);
+		// And no room for more.
+		EXPECT_FALSE(queue.CanMakeProgress(100));
+		EXPECT_FALSE(queue.CanStart(100));
+		// Running ones are never dropped.
+		queue.Decimate(1000, 10);
+		EXPECT_EQ_INT((int)queue.Size(), MAX_JOBS);
+		// Even when forgotten, they still take up room until they're done.
+		queue.Forget(MAX_JOBS);
+		EXPECT_FALSE(queue.CanStart(MAX_JOBS));
+		EXPECT_FALSE(queue.CanStart(100));
+		queue.Decimate(1000, 10);
+		EXPECT_EQ_INT((int)queue.Size(), MAX_JOBS);
+
+		release = true;
+		for (auto &job : jobs)
+			EXPECT_TRUE(WaitForScaleJob(job));
+		EXPECT_TRUE(queue.CanMakeProgress(1));
+		EXPECT_TRUE(queue.CanMakeProgress(2));
+		EXPECT_TRUE(jobs.back()->pixels == expected);
+
+		std::shared_ptr<TextureScaleJob> result = queue.TakeFinished(1, 0x1001, W, H, FACTOR);
+		EXPECT_TRUE(result == jobs[0]);
+		EXPECT_TRUE(result->pixels == expected);
+		EXPECT_TRUE(queue.TakeFinished(1, 0x1001, W, H, FACTOR) == nullptr);
+
+		// The texture changed while it was being scaled, so the result is thrown away.
+		EXPECT_TRUE(queue.TakeFinished(2, 0x2222, W, H, FACTOR) == nullptr);
+		EXPECT_TRUE(queue.CanStart(2));
+		EXPECT_TRUE(queue.TakeFinished(2, 0x1002, W, H, FACTOR) == nullptr);
+		// Same for a different scale factor.
+		EXPECT_TRUE(queue.TakeFinished(3, 0x1003, W, H, FACTOR + 1) == nullptr);
+		EXPECT_EQ_INT((int)queue.Size(), MAX_JOBS - 3);
+
+		// Finished ones that never got picked up get dropped once old enough.  The forgotten one is done, too.
+		queue.Decimate(10, 10);
+		EXPECT_EQ_INT((int)queue.Size(), MAX_JOBS - 4);
+		queue.Decimate(11, 10);
+		EXPECT_EQ_INT((int)queue.Size(), 0);
+
+		// Forgetting one still running is fine, it's let go once it's done.
+		std::shared_ptr<TextureScaleJob> job = makeJob(0x4000);
+		std::weak_ptr<TextureScaleJob> weakJob = job;
+		queue.Start(4, job);
+		queue.Forget(4);
+		EXPECT_TRUE(WaitForScaleJob(job));
+		job.reset();
+		queue.Decimate(12, 10);
+		EXPECT_EQ_INT((int)queue.Size(), 0);
+		for (int i = 0; i < 5000 && !weakJob.expired(); ++i)
+			sleep_ms(1);
+		EXPECT_TRUE(weakJob.expired());
+
+		// A big scale goes a piece at a time, so work pinned to the workers doesn't wait for all of it.
+		std::shared_ptr<TextureScaleJob> bigJob = std::make_shared<TextureScaleJob>();
+		bigJob->w = 512;
+		bigJob->h = 512;
+		bigJob->scaleFactor = 4;
+		bigJob->pixels.resize(512 * 512);
+		for (size_t i = 0; i < bigJob->pixels.size(); ++i)
+			bigJob->pixels[i] = ((u32)(i / 4) * 2654435761U) | 0xFF000000;
+		queue.Start(5, bigJob);
+		for (int i = 0; i < numWorkers; ++i)
+			g_threadManager.EnqueueTaskOnThread(i, new BlockingTask(pinnedRan, release));
+		while (pinnedRan < numWorkers)
+			sleep_ms(1);
+		EXPECT_FALSE(bigJob->done);
+		EXPECT_TRUE(WaitForScaleJob(bigJob, 60000));
+		EXPECT_EQ_INT((int)bigJob->pixels.size(), 2048 * 2048);
+		return true;
+	}();
+
+	release = true;
+	g_Config.iTexScalingType = oldType;
+	g_Config.bTexDeposterize = oldDeposterize;
+	return success;
+}
+
+static bool TestVertexCache() {
+	VertexCache cache;
+	int released = 0;
+	cache.SetReleaseFunc([&](CachedVertexData *data) {
+		released++;
+	});
+
+	// Arrays are tracked by id, and count frames as they're drawn.
+	VertexArrayInfo *vai = cache.GetArray(1, 0);
+	EXPECT_EQ_INT(vai->status, VertexArrayInfo::VAI_NEW);
+	EXPECT_TRUE(cache.GetArray(1, 0) == vai);
+	EXPECT_TRUE(cache.GetArray(1, 1) == vai);
+	EXPECT_EQ_INT(vai->numDraws, 3);
+	EXPECT_EQ_INT(vai->numFrames, 1);
+	cache.MarkUnreliable(vai);
+	EXPECT_EQ_INT(cache.stats.unreliable, 1);
+
+	// Data is shared by content key, and replacing it releases the old backend copy.
+	CachedVertexData *data = cache.Add(0x1234, 1);
+	data->verts.resize(1024);
+	data->backendData = &released;
+	EXPECT_TRUE(cache.Find(0x1234, 2) == data);
+	EXPECT_EQ_INT(data->lastFrame, 2);
+	EXPECT_TRUE(cache.Find(0x5678, 2) == nullptr);
+	data = cache.Add(0x1234, 2);
+	data->backendData = &released;
+	EXPECT_EQ_INT(released, 1);
+	EXPECT_EQ_INT(cache.stats.decodes, 2);
+
+	// Dropping the backend copies keeps the decoded data.
+	cache.ReleaseBackendData();
+	EXPECT_EQ_INT(released, 2);
+	EXPECT_TRUE(data->backendData == nullptr);
+	EXPECT_TRUE(cache.Find(0x1234, 3) == data);
+
+	// Old data goes away, recent data stays.
+	cache.Add(0x5678, 3 + VertexCache::KILL_AGE)->backendData = &released;
+	cache.Decimate(4 + VertexCache::KILL_AGE);
+	EXPECT_TRUE(cache.Find(0x1234, 4 + VertexCache::KILL_AGE) == nullptr);
+	EXPECT_TRUE(cache.Find(0x5678, 4 + VertexCache::KILL_AGE) != nullptr);
+	EXPECT_EQ_INT((int)cache.NumData(), 1);
+	EXPECT_EQ_INT((int)cache.NumArrays(), 1);
+
+	// Over budget, the least recently used data is evicted first.
+	const size_t chunk = VertexCache::MAX_DATA_BYTES / 4;
+	for (int i = 0; i < 6; ++i) {
+		cache.Add(0x10000 + i, 200 + i)->verts.resize(chunk);
+	}
+	cache.Decimate(210);
+	EXPECT_TRUE(cache.DataBytes() <= VertexCache::MAX_DATA_BYTES);
+	EXPECT_TRUE(cache.Find(0x10000, 210) == nullptr);
+	EXPECT_TRUE(cache.Find(0x10005, 210) != nullptr);
+
+	cache.Clear();
+	EXPECT_EQ_INT((int)cache.NumData(), 0);
+	EXPECT_EQ_INT((int)cache.NumArrays(), 0);
+	EXPECT_EQ_INT(released, 3);
+	return true;
+}
+
+static bool TestTracer() {
+	// Nothing is recorded until started.
+	EXPECT_FALSE(Tracer_IsActive());
+	{
+		PROFILE_THIS_SCOPE("before");
+	}
+
+	Tracer_Start();
+	// This one ends after stopping, so it's closed at the end of the trace.
+	ProfileThis *open = new ProfileThis("open");
+	{
+		PROFILE_THIS_SCOPE("outer");
+		PROFILE_COUNTER("count", 42);
+		{
+			PROFILE_THIS_SCOPE("inner");
+		}
+	}
+	std::thread other([] {
+		SetCurrentThreadName("TracerTest");
+		PROFILE_THIS_SCOPE("other");
+	});
+	other.join();
+	Tracer_Stop();
+	delete open;
+	{
+		PROFILE_THIS_SCOPE("after");
+	}
+
+	std::string trace = Tracer_GetChromeJSON();
+	json::JsonReader reader(trace.c_str(), trace.size());
+	EXPECT_TRUE(reader.ok());
+	const JsonNode *events = reader.root().getArray("traceEvents");
+	EXPECT_TRUE(events != nullptr);
+
+	int begins = 0, ends = 0, counters = 0;
+	bool sawOther = false, sawThreadName = false;
+	for (const JsonNode *node : events->value) {
+		json::JsonGet event = node->value;
+		std::string ph = event.getStringOrDie("ph");
+		std::string name = event.getString("name", "");
+		EXPECT_TRUE(name != "before" && name != "after");
+		if (ph == "B") {
+			begins++;
+			sawOther = sawOther || name == "other";
+		} else if (ph == "E") {
+			ends++;
+		} else if (ph == "C") {
+			counters++;
+			EXPECT_EQ_INT(event.getDict("args").getInt("value"), 42);
+		} else if (ph == "M") {
+			sawThreadName = sawThreadName || !strcmp(event.getDict("args").getString("name", ""), "TracerTest");
+		}
+	}
+	EXPECT_EQ_INT(begins, 4);
+	EXPECT_EQ_INT(ends, 4);
+	EXPECT_EQ_INT(counters, 1);
+	EXPECT_TRUE(sawOther);
+	EXPECT_TRUE(sawThreadName);
+
+	// Starting again leaves out the earlier events, even from a thread that's busy recording meanwhile.
+	std::atomic<bool> stopBusy{};
+	Tracer_Start();
+	std::thread busy([&] {
+		while (!stopBusy) {
+			PROFILE_THIS_SCOPE("busy");
+		}
+	});
+	// Reading while it writes, and wraps around its buffer.
+	for (int i = 0; i < 4; ++i)
+		Tracer_GetChromeJSON();
+	Tracer_Start();
+	{
+		PROFILE_THIS_SCOPE("second");
+	}
+	Tracer_Stop();
+	stopBusy = true;
+	busy.join();
+
+	trace = Tracer_GetChromeJSON();
+	json::JsonReader reader2(trace.c_str(), trace.size());
+	EXPECT_TRUE(reader2.ok());
+	events = reader2.root().getArray("traceEvents");
+	EXPECT_TRUE(events != nullptr);
+	bool sawSecond = false;
+	begins = 0;
+	ends = 0;
+	for (const JsonNode *node : events->value) {
+		json::JsonGet event = node->value;
+		std::string ph = event.getStringOrDie("ph");
+		std::string name = event.getString("name", "");
+		if (ph == "B") {
+			EXPECT_TRUE(name == "busy" || name == "second");
+			sawSecond = sawSecond || name == "second";
+			begins++;
+		} else if (ph == "E") {
+			ends++;
+		}
+	}
+	EXPECT_TRUE(sawSecond);
+	EXPECT_EQ_INT(begins, ends);
+	return true;
+}
+
 typedef bool (*TestFunc)();
 struct TestItem {
 	const char *name;
@@ -811,6 +1444,14 @@ bool TestShaderGenerators();
 bool TestSoftwareGPUJit();
 bool TestIRPassSimplify();
 bool TestThreadManager();
+bool TestIRToNative();
+bool TestCoreTiming();
+bool TestBlockDevices();
+bool TestStereoResampler();
+bool TestTextureDecoder();
+bool TestSaveStateRewind();
+bool TestBinManager();
+bool TestReadAheadFileLoader();
 
 TestItem availableTests[] = {
 #if PPSSPP_ARCH(ARM64) || PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(X86)
@@ -833,11 +1474,14 @@ TestItem availableTests[] = {
 	TEST_ITEM(Parsers),
 	TEST_ITEM(IRPassSimplify),
 	TEST_ITEM(Jit),
+	TEST_ITEM(IRSuperblocks),
 	TEST_ITEM(MatrixTranspose),
 	TEST_ITEM(ParseLBN),
 	TEST_ITEM(QuickTexHash),
 	TEST_ITEM(CLZ),
 	TEST_ITEM(MemMap),
+	TEST_ITEM(TextureWriteTracking),
+	TEST_ITEM(GEDumpConvert),
 	TEST_ITEM(ShaderGenerators),
 	TEST_ITEM(SoftwareGPUJit),
 	TEST_ITEM(Path),
@@ -846,6 +1490,22 @@ TestItem availableTests[] = {
 	TEST_ITEM(WrapText),
 	TEST_ITEM(TinySet),
 	TEST_ITEM(SmallDataConvert),
+	TEST_ITEM(SasMixer),
+	TEST_ITEM(ThreadQueueList),
+	TEST_ITEM(VertexCache),
+	TEST_ITEM(Tracer),
+	TEST_ITEM(TextureScaler),
+	TEST_ITEM(TextureScaleQueue),
+	TEST_ITEM(CoreTiming),
+	TEST_ITEM(BlockDevices),
+	TEST_ITEM(StereoResampler),
+	TEST_ITEM(TextureDecoder),
+	TEST_ITEM(SaveStateRewind),
+	TEST_ITEM(BinManager),
+	TEST_ITEM(ReadAheadFileLoader),
+#if PPSSPP_ARCH(AMD64) || PPSSPP_ARCH(RISCV64)
+	TEST_ITEM(IRToNative),
+#endif
 };
 
 int main(int argc, const char *argv[]) {
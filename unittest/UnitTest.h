@@ -9,3 +9,34 @@
 #define EXPECT_EQ_STR(a, b) if (a != b) { printf("%s: Test Fail\n%s\nvs\n%s\n", __FUNCTION__, a.c_str(), b.c_str()); return false; }
 
 #define RET(a) if (!(a)) { return false; }
+
+#include "Common/CPUDetect.h"
+#include "Common/Thread/ThreadManager.h"
+
+// Starts g_threadManager for a test if it isn't running, and puts it back how it was when the test returns,
+// even early or after the test changed the number of threads.
+class ScopedTestThreads {
+public:
+	ScopedTestThreads() : hadThreads_(g_threadManager.IsInitialized()), numThreads_(g_threadManager.GetNumLooperThreads()) {
+		if (!hadThreads_)
+			g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+	}
+	~ScopedTestThreads() {
+		if (!hadThreads_) {
+			if (g_threadManager.IsInitialized())
+				g_threadManager.Teardown();
+		} else if (!g_threadManager.IsInitialized() || g_threadManager.GetNumLooperThreads() != numThreads_) {
+			g_threadManager.Init(cpu_info.num_cores, cpu_info.logical_cpu_count);
+		}
+	}
+	ScopedTestThreads(const ScopedTestThreads &) = delete;
+	ScopedTestThreads &operator=(const ScopedTestThreads &) = delete;
+
+	bool HadThreads() const {
+		return hadThreads_;
+	}
+
+private:
+	bool hadThreads_;
+	int numThreads_;
+};